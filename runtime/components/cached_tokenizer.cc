@@ -0,0 +1,91 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/cached_tokenizer.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "runtime/util/status_macros.h"  // IWYU pragma: keep
+
+namespace litert::lm {
+
+absl::StatusOr<std::vector<int>> CachedTokenizer::TextToTokenIds(
+    absl::string_view text) {
+  const bool cacheable =
+      max_num_entries_ > 0 && text.size() <= max_text_length_;
+  if (cacheable) {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(text);
+    if (it != index_.end()) {
+      // Move the entry to the front to mark it as the most recently used.
+      entries_.splice(entries_.begin(), entries_, it->second);
+      ++num_hits_;
+      return it->second->second;
+    }
+    ++num_misses_;
+  }
+
+  // Run the (potentially slow) tokenizer outside of the lock.
+  ASSIGN_OR_RETURN(std::vector<int> ids, tokenizer_.TextToTokenIds(text));
+  if (!cacheable) {
+    return ids;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  // Another thread may have inserted the same text in the meantime.
+  if (index_.contains(text)) {
+    return ids;
+  }
+  entries_.emplace_front(std::string(text), ids);
+  index_[entries_.front().first] = entries_.begin();
+  while (entries_.size() > max_num_entries_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  return ids;
+}
+
+absl::StatusOr<std::string> CachedTokenizer::TokenIdsToText(
+    const std::vector<int>& token_ids) {
+  return tokenizer_.TokenIdsToText(token_ids);
+}
+
+void CachedTokenizer::Clear() {
+  absl::MutexLock lock(&mutex_);
+  index_.clear();
+  entries_.clear();
+}
+
+int CachedTokenizer::GetNumEntries() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+int64_t CachedTokenizer::GetNumHits() const {
+  absl::MutexLock lock(&mutex_);
+  return num_hits_;
+}
+
+int64_t CachedTokenizer::GetNumMisses() const {
+  absl::MutexLock lock(&mutex_);
+  return num_misses_;
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,103 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_CACHED_TOKENIZER_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_CACHED_TOKENIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"  // from @com_google_absl
+#include "absl/base/thread_annotations.h"  // from @com_google_absl
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "runtime/components/tokenizer.h"
+
+namespace litert::lm {
+
+// A Tokenizer decorator which memoizes the results of TextToTokenIds() in a
+// bounded LRU cache. Multi-turn conversations keep sending the same message
+// chunks (system prompts, earlier turns, template affixes), so serving them
+// from the cache avoids re-running the underlying tokenizer over the whole
+// history on every turn.
+//
+// The wrapped tokenizer is not owned and must outlive this object. All methods
+// are thread-safe as long as the wrapped tokenizer is.
+class CachedTokenizer : public Tokenizer {
+ public:
+  // The default maximum number of cached entries.
+  static constexpr size_t kDefaultMaxNumEntries = 256;
+
+  // Creates a CachedTokenizer on top of the given tokenizer.
+  // - tokenizer: The tokenizer doing the actual encoding / decoding.
+  // - max_num_entries: The maximum number of texts to keep in the cache. The
+  //   least recently used entry is evicted when the cache is full. Setting it
+  //   to 0 disables caching.
+  // - max_text_length: Texts longer than this (in bytes) bypass the cache so
+  //   that a single huge prompt does not pin a lot of memory.
+  explicit CachedTokenizer(Tokenizer* absl_nonnull tokenizer,
+                           size_t max_num_entries = kDefaultMaxNumEntries,
+                           size_t max_text_length = 64 * 1024)
+      : tokenizer_(*tokenizer),
+        max_num_entries_(max_num_entries),
+        max_text_length_(max_text_length) {}
+
+  // Encodes the given text into a sequence of token ids, consulting the cache
+  // first.
+  absl::StatusOr<std::vector<int>> TextToTokenIds(
+      absl::string_view text) override;
+
+  // Decodes the given sequence of token ids into a string. Decoding is not
+  // cached.
+  absl::StatusOr<std::string> TokenIdsToText(
+      const std::vector<int>& token_ids) override;
+
+  absl::StatusOr<int> BosId() const override { return tokenizer_.BosId(); }
+  absl::StatusOr<int> EosId() const override { return tokenizer_.EosId(); }
+
+  // Drops all cached entries.
+  void Clear();
+
+  // Cache statistics, mostly for tests and benchmarks.
+  int GetNumEntries() const;
+  int64_t GetNumHits() const;
+  int64_t GetNumMisses() const;
+
+ private:
+  using Entry = std::pair<std::string, std::vector<int>>;
+
+  Tokenizer& tokenizer_;
+  const size_t max_num_entries_;
+  const size_t max_text_length_;
+
+  mutable absl::Mutex mutex_;
+  // Most recently used entries are at the front.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Keys point into the strings owned by `entries_`, which stay stable while
+  // the corresponding list node is alive.
+  absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t num_hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t num_misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_CACHED_TOKENIZER_H_
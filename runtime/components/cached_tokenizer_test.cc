@@ -0,0 +1,118 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/cached_tokenizer.h"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/components/tokenizer.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Return;
+
+class MockTokenizer : public Tokenizer {
+ public:
+  MOCK_METHOD(absl::StatusOr<std::vector<int>>, TextToTokenIds,
+              (absl::string_view text), (override));
+  MOCK_METHOD(absl::StatusOr<std::string>, TokenIdsToText,
+              (const std::vector<int>& token_ids), (override));
+};
+
+TEST(CachedTokenizerTest, RepeatedTextIsEncodedOnce) {
+  MockTokenizer tokenizer;
+  EXPECT_CALL(tokenizer, TextToTokenIds(Eq("Hello World!")))
+      .WillOnce(Return(std::vector<int>{90, 547, 58}));
+  CachedTokenizer cached_tokenizer(&tokenizer);
+
+  for (int i = 0; i < 3; ++i) {
+    auto ids = cached_tokenizer.TextToTokenIds("Hello World!");
+    ASSERT_OK(ids);
+    EXPECT_THAT(*ids, ElementsAre(90, 547, 58));
+  }
+  EXPECT_EQ(cached_tokenizer.GetNumEntries(), 1);
+  EXPECT_EQ(cached_tokenizer.GetNumHits(), 2);
+  EXPECT_EQ(cached_tokenizer.GetNumMisses(), 1);
+}
+
+TEST(CachedTokenizerTest, EvictsLeastRecentlyUsed) {
+  MockTokenizer tokenizer;
+  EXPECT_CALL(tokenizer, TextToTokenIds(Eq("a")))
+      .WillOnce(Return(std::vector<int>{1}));
+  EXPECT_CALL(tokenizer, TextToTokenIds(Eq("b")))
+      .Times(2)
+      .WillRepeatedly(Return(std::vector<int>{2}));
+  EXPECT_CALL(tokenizer, TextToTokenIds(Eq("c")))
+      .WillOnce(Return(std::vector<int>{3}));
+  CachedTokenizer cached_tokenizer(&tokenizer, /*max_num_entries=*/2);
+
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("a"));
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("b"));
+  // Touch "a" so that "b" becomes the least recently used entry.
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("a"));
+  // Inserting "c" evicts "b".
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("c"));
+  EXPECT_EQ(cached_tokenizer.GetNumEntries(), 2);
+  // "a" is still cached, "b" needs to be encoded again.
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("a"));
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("b"));
+}
+
+TEST(CachedTokenizerTest, LongTextBypassesCache) {
+  MockTokenizer tokenizer;
+  EXPECT_CALL(tokenizer, TextToTokenIds(Eq("too long")))
+      .Times(2)
+      .WillRepeatedly(Return(std::vector<int>{7, 8}));
+  CachedTokenizer cached_tokenizer(&tokenizer, /*max_num_entries=*/4,
+                                   /*max_text_length=*/4);
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("too long"));
+  EXPECT_OK(cached_tokenizer.TextToTokenIds("too long"));
+  EXPECT_EQ(cached_tokenizer.GetNumEntries(), 0);
+}
+
+TEST(CachedTokenizerTest, ErrorsAreNotCached) {
+  MockTokenizer tokenizer;
+  EXPECT_CALL(tokenizer, TextToTokenIds(Eq("bad")))
+      .WillOnce(Return(absl::InternalError("failed")))
+      .WillOnce(Return(std::vector<int>{4}));
+  CachedTokenizer cached_tokenizer(&tokenizer);
+  EXPECT_FALSE(cached_tokenizer.TextToTokenIds("bad").ok());
+  auto ids = cached_tokenizer.TextToTokenIds("bad");
+  ASSERT_OK(ids);
+  EXPECT_THAT(*ids, ElementsAre(4));
+}
+
+TEST(CachedTokenizerTest, DecodeIsForwarded) {
+  MockTokenizer tokenizer;
+  EXPECT_CALL(tokenizer, TokenIdsToText(_))
+      .WillOnce(Return(std::string("Hello")));
+  CachedTokenizer cached_tokenizer(&tokenizer);
+  auto text = cached_tokenizer.TokenIdsToText({90});
+  ASSERT_OK(text);
+  EXPECT_EQ(*text, "Hello");
+}
+
+}  // namespace
+}  // namespace litert::lm
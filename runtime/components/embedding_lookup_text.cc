@@ -2,18 +2,25 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
+#include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "absl/types/span.h"  // from @com_google_absl
 #include "litert/c/litert_common.h"  // from @litert
+#include "litert/c/litert_model.h"  // from @litert
+#include "litert/c/litert_op_code.h"  // from @litert
 #include "litert/cc/litert_compiled_model.h"  // from @litert
 #include "litert/cc/litert_element_type.h"  // from @litert
 #include "litert/cc/litert_environment.h"  // from @litert
@@ -21,25 +28,125 @@
 #include "litert/cc/litert_model.h"  // from @litert
 #include "litert/cc/litert_options.h"  // from @litert
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
+#include "runtime/components/embedding_table.h"
 #include "runtime/util/status_macros.h"  //NOLINT
 
 namespace litert::lm {
 
 using ::litert::TensorBuffer;
 
+namespace {
+
+// The tokens whose embeddings are compared with the model's in
+// MaybeGatherFromTable.
+constexpr int kNumTableCheckTokens = 4;
+
+// Returns the embedding table of `model`, i.e. the constant input of its
+// gather (or of the dequantize before it), if it is stored in a format
+// supported by EmbeddingTable.
+std::optional<EmbeddingTable> FindEmbeddingTable(const litert::Model& model) {
+  auto subgraph = model.MainSubgraph();
+  if (!subgraph) {
+    return std::nullopt;
+  }
+  for (const auto& op : subgraph->Ops()) {
+    if (op.Code() != kLiteRtOpCodeTflGather &&
+        op.Code() != kLiteRtOpCodeTflEmbeddingLookup &&
+        op.Code() != kLiteRtOpCodeTflDequantize) {
+      continue;
+    }
+    for (const auto& input : op.Inputs()) {
+      if (!input.HasWeights()) {
+        continue;
+      }
+      auto tensor_type = input.RankedTensorType();
+      if (!tensor_type || tensor_type->Layout().Rank() < 2) {
+        continue;
+      }
+      const auto dimensions = tensor_type->Layout().Dimensions();
+      int row_size = 1;
+      for (size_t i = 1; i < dimensions.size(); ++i) {
+        row_size *= dimensions[i];
+      }
+
+      EmbeddingTableType table_type;
+      switch (tensor_type->ElementType()) {
+        case litert::ElementType::Float32:
+          table_type = EmbeddingTableType::kFloat32;
+          break;
+        case litert::ElementType::Int8:
+          table_type = EmbeddingTableType::kInt8;
+          break;
+        case litert::ElementType::Int4:
+          table_type = EmbeddingTableType::kInt4;
+          break;
+        default:
+          continue;
+      }
+      std::vector<float> scales;
+      std::vector<int64_t> zero_points;
+      if (input.QTypeId() == kLiteRtQuantizationPerTensor) {
+        const auto quantization = input.PerTensorQuantization();
+        scales = {quantization.scale};
+        zero_points = {quantization.zero_point};
+      } else if (input.QTypeId() == kLiteRtQuantizationPerChannel) {
+        const auto quantization = input.PerChannelQuantization();
+        // Only one scale per row (token) is supported.
+        if (quantization.quantized_dimension != 0) {
+          continue;
+        }
+        scales.assign(quantization.scales,
+                      quantization.scales + quantization.num_channels);
+        zero_points.assign(
+            quantization.zero_points,
+            quantization.zero_points + quantization.num_channels);
+      } else if (table_type != EmbeddingTableType::kFloat32) {
+        continue;
+      }
+      auto table = EmbeddingTable::Create(
+          table_type, input.Weights().Bytes(), dimensions[0], row_size,
+          std::move(scales), std::move(zero_points));
+      if (table.ok()) {
+        return *std::move(table);
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
 absl::Status EmbeddingLookupText::LookupInternal(int token,
                                                  absl::Span<uint8_t> buffer) {
+  if (token < 0) {
+    memcpy(buffer.data(), default_embedding_vector_.data(), buffer.size());
+    return absl::OkStatus();
+  }
+
+  if (table_.has_value() && token < table_->num_rows()) {
+    if (buffer.size() != floats_per_token_output_ * sizeof(float)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The output tensor from the Embedding model must be have the same "
+          "number of bytes as the requested tensor. Requested tensor bytes: ",
+          buffer.size(),
+          ". Output tensor bytes: ", floats_per_token_output_ * sizeof(float)));
+    }
+    // Dequantizes the row straight into the requested buffer.
+    return table_->GatherRow(
+        token, absl::MakeSpan(reinterpret_cast<float*>(buffer.data()),
+                              floats_per_token_output_));
+  }
+  return RunModel(token, buffer);
+}
+
+absl::Status EmbeddingLookupText::RunModel(int token,
+                                           absl::Span<uint8_t> buffer) {
   if (!compiled_model_.has_value() || input_buffers_.size() != 1 ||
       output_buffers_.size() != 1) {
     return absl::InvalidArgumentError(
         "The Embedding model must be initialized before being used.");
   }
 
-  if (token < 0) {
-    memcpy(buffer.data(), default_embedding_vector_.data(), buffer.size());
-    return absl::OkStatus();
-  }
-
   // The input tensor size was verified when the model was loaded.
   input_buffers_[0].Write(absl::MakeSpan(const_cast<const int*>(&token), 1));
 
@@ -226,15 +333,16 @@ absl::Status EmbeddingLookupText::LookupPrefill(absl::Span<const int> tokens,
 }
 
 absl::StatusOr<std::unique_ptr<EmbeddingLookupText>>
-EmbeddingLookupText::Create(const litert::Model* model) {
+EmbeddingLookupText::Create(const litert::Model* model,
+                            bool gather_from_table) {
   LITERT_ASSIGN_OR_RETURN(auto env, ::litert::Environment::Create({}));
   auto handler = std::unique_ptr<EmbeddingLookupText>(
       new EmbeddingLookupText(std::move(env), model));
-  RETURN_IF_ERROR(handler->Initialize());
+  RETURN_IF_ERROR(handler->Initialize(gather_from_table));
   return handler;
 }
 
-absl::Status EmbeddingLookupText::Initialize() {
+absl::Status EmbeddingLookupText::Initialize(bool gather_from_table) {
   LITERT_ASSIGN_OR_RETURN(auto options, Options::Create());
   options.SetHardwareAccelerators(kLiteRtHwAcceleratorCpu);
 
@@ -288,11 +396,61 @@ absl::Status EmbeddingLookupText::Initialize() {
 
   // Initialize the default embedding vector to be the embedding of token 0.
   default_embedding_vector_.resize(floats_per_token_output_);
-  RETURN_IF_ERROR(LookupInternal(
+  RETURN_IF_ERROR(RunModel(
       0, absl::MakeSpan(
              reinterpret_cast<uint8_t*>(default_embedding_vector_.data()),
              floats_per_token_output_ * sizeof(float))));
 
+  if (gather_from_table) {
+    RETURN_IF_ERROR(MaybeGatherFromTable());
+  }
+  return absl::OkStatus();
+}
+
+absl::Status EmbeddingLookupText::MaybeGatherFromTable() {
+  std::optional<EmbeddingTable> table = FindEmbeddingTable(model_);
+  if (!table.has_value() ||
+      static_cast<size_t>(table->row_size()) != floats_per_token_output_) {
+    return absl::OkStatus();
+  }
+
+  // The model may scale the rows of its table, e.g. by sqrt(hidden_size):
+  // the scale is fitted on the embedding of token 0, then the embeddings of
+  // tokens across the table must match the model's.
+  std::vector<float> expected(floats_per_token_output_);
+  std::vector<float> actual(floats_per_token_output_);
+  RETURN_IF_ERROR(table->GatherRow(0, absl::MakeSpan(actual)));
+  double dot = 0.0;
+  double norm = 0.0;
+  for (size_t i = 0; i < actual.size(); ++i) {
+    dot += static_cast<double>(actual[i]) * default_embedding_vector_[i];
+    norm += static_cast<double>(actual[i]) * actual[i];
+  }
+  if (norm > 0.0 && std::abs(dot / norm - 1.0) > 1e-6) {
+    table->set_output_scale(dot / norm);
+  }
+
+  for (int i = 0; i < kNumTableCheckTokens; ++i) {
+    const int token = static_cast<int>(
+        static_cast<int64_t>(table->num_rows() - 1) * i /
+        (kNumTableCheckTokens - 1));
+    RETURN_IF_ERROR(RunModel(
+        token, absl::MakeSpan(reinterpret_cast<uint8_t*>(expected.data()),
+                              expected.size() * sizeof(float))));
+    RETURN_IF_ERROR(table->GatherRow(token, absl::MakeSpan(actual)));
+    float max_value = 1.0f;
+    for (float value : expected) {
+      max_value = std::max(max_value, std::abs(value));
+    }
+    for (size_t j = 0; j < expected.size(); ++j) {
+      if (std::abs(expected[j] - actual[j]) > 1e-5f * max_value) {
+        ABSL_LOG(INFO) << "The embedding table of the model does not match "
+                          "its output, the model is run for each token.";
+        return absl::OkStatus();
+      }
+    }
+  }
+  table_ = std::move(table);
   return absl::OkStatus();
 }
 
@@ -19,6 +19,7 @@
 #include "litert/cc/litert_model.h"  // from @litert
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
 #include "runtime/components/embedding_lookup.h"
+#include "runtime/components/embedding_table.h"
 
 namespace litert::lm {
 
@@ -29,15 +30,21 @@ namespace litert::lm {
 // example, large embedding tables may use too much memory on the accelerator
 // and so they need to be placed on the CPU. Currently there is no mechanism
 // to tell a delegate to move embedding lookups to the CPU.
+//
+// When the embedding model is a lookup in a constant (possibly int8/int4
+// quantized) table, the rows are gathered and dequantized straight from the
+// table in the model file into the output, instead of running the model for
+// each token. This is checked against the model output when loading it.
 class EmbeddingLookupText : public EmbeddingLookup {
  public:
   ~EmbeddingLookupText() = default;
 
   // Creates a EmbeddingLookupText instance. The reference of |model| is kept
   // in the returned instance, so the caller must ensure that |model| outlives
-  // the returned instance.
+  // the returned instance. If |gather_from_table| is false, the model is
+  // always run, even if its table could be gathered from.
   static absl::StatusOr<std::unique_ptr<EmbeddingLookupText>> Create(
-      const litert::Model* absl_nonnull model);
+      const litert::Model* absl_nonnull model, bool gather_from_table = true);
 
   // For a given token, looks up the embedding and stores it in the
   // provided vector. The caller is responsible for ensuring that the vector is
@@ -90,18 +97,29 @@ class EmbeddingLookupText : public EmbeddingLookup {
     return default_embedding_vector_;
   }
 
+  // Returns whether the embeddings are gathered from the table of the model
+  // rather than by running it.
+  bool GathersFromTable() const { return table_.has_value(); }
+
  protected:
   EmbeddingLookupText(litert::Environment env,
                       const litert::Model* absl_nonnull model)
       : env_(std::move(env)), model_(*model) {}
 
   // Loads the provided model. This must be called before Lookup.
-  absl::Status Initialize();
+  absl::Status Initialize(bool gather_from_table);
+
+  // Sets table_ if the embedding table of the model is found and gives the
+  // same embeddings as the model.
+  absl::Status MaybeGatherFromTable();
 
   // Internal implementation of Lookup for both the single and multiple token
   // cases.
   absl::Status LookupInternal(int token, absl::Span<uint8_t> buffer);
 
+  // Runs the model to look up the embedding of a token.
+  absl::Status RunModel(int token, absl::Span<uint8_t> buffer);
+
   // The environment for the embedding lookup.
   litert::Environment env_;
   // The model for the embedding lookup. The actual model instance is owned by
@@ -124,6 +142,9 @@ class EmbeddingLookupText : public EmbeddingLookup {
   // The default embedding vector to use when a token is not found in the
   // lookup table. This is set to the value of token id 0.
   std::vector<float> default_embedding_vector_;
+
+  // The embedding table of the model, if the embeddings are gathered from it.
+  std::optional<EmbeddingTable> table_;
 };
 
 }  // namespace litert::lm
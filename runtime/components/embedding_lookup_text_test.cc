@@ -675,4 +675,25 @@ TEST_F(EmbeddingLookupTextTest, LookupPrefillWithBadOffset) {
               "must not exceed the size of the output tensor")));
 }
 
+TEST_F(EmbeddingLookupTextTest, GatherFromTableMatchesModel) {
+  ASSERT_TRUE(CreateModelFromFile().ok());
+  auto gathered = EmbeddingLookupText::Create(&*model_);
+  ASSERT_TRUE(gathered.ok());
+  auto modeled =
+      EmbeddingLookupText::Create(&*model_, /*gather_from_table=*/false);
+  ASSERT_TRUE(modeled.ok());
+  // The embedding table of the dummy model is gathered from directly.
+  EXPECT_TRUE((*gathered)->GathersFromTable());
+  EXPECT_FALSE((*modeled)->GathersFromTable());
+
+  std::vector<float> gathered_vector(4 * 32);
+  std::vector<float> modeled_vector(4 * 32);
+  for (int token = -1; token < 10; ++token) {
+    ASSERT_OK((*gathered)->LookupDecode(token, gathered_vector));
+    ASSERT_OK((*modeled)->LookupDecode(token, modeled_vector));
+    EXPECT_THAT(gathered_vector,
+                testing::Pointwise(testing::FloatEq(), modeled_vector));
+  }
+}
+
 }  // namespace litert::lm
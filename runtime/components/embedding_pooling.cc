@@ -0,0 +1,82 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/embedding_pooling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+absl::Status PoolHiddenStates(absl::Span<const float> hidden_states,
+                              EmbeddingPooling pooling, bool normalize,
+                              absl::Span<float> embedding) {
+  const size_t hidden_size = embedding.size();
+  if (hidden_size == 0 || hidden_states.empty() ||
+      hidden_states.size() % hidden_size != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The hidden states of size ", hidden_states.size(),
+                     " are not a non-empty [num_tokens, ", hidden_size,
+                     "] tensor."));
+  }
+  const size_t num_tokens = hidden_states.size() / hidden_size;
+  float scale = 1.0f;
+  switch (pooling) {
+    case EmbeddingPooling::kMean:
+      // The rows are accumulated in order, so that the loop over the hidden
+      // size is vectorized.
+      std::fill(embedding.begin(), embedding.end(), 0.0f);
+      for (size_t t = 0; t < num_tokens; ++t) {
+        const float* row = hidden_states.data() + t * hidden_size;
+        for (size_t i = 0; i < hidden_size; ++i) {
+          embedding[i] += row[i];
+        }
+      }
+      scale = 1.0f / num_tokens;
+      break;
+    case EmbeddingPooling::kLastToken:
+      std::copy(hidden_states.end() - hidden_size, hidden_states.end(),
+                embedding.begin());
+      break;
+    case EmbeddingPooling::kFirstToken:
+      std::copy(hidden_states.begin(), hidden_states.begin() + hidden_size,
+                embedding.begin());
+      break;
+    default:
+      return absl::InvalidArgumentError("Unsupported embedding pooling.");
+  }
+  if (normalize) {
+    float squared_norm = 0.0f;
+    for (size_t i = 0; i < hidden_size; ++i) {
+      squared_norm += embedding[i] * embedding[i];
+    }
+    // The mean scale cancels out in the normalization.
+    if (squared_norm > 0.0f) {
+      scale = 1.0f / std::sqrt(squared_norm);
+    }
+  }
+  if (scale != 1.0f) {
+    for (size_t i = 0; i < hidden_size; ++i) {
+      embedding[i] *= scale;
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace litert::lm
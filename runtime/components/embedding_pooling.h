@@ -0,0 +1,50 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_EMBEDDING_POOLING_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_EMBEDDING_POOLING_H_
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// How the hidden states of the tokens of a text are reduced to its embedding.
+enum class EmbeddingPooling {
+  // The mean of the hidden states of all the tokens.
+  kMean,
+  // The hidden state of the last token, e.g. for the decoder-only models
+  // whose last token attends to the whole text.
+  kLastToken,
+  // The hidden state of the first token, e.g. the CLS token of the BERT-style
+  // models.
+  kFirstToken,
+};
+
+// Pools the hidden states of a text into its embedding.
+//   - hidden_states: a 2D tensor (in a flattened buffer) of shape
+//     [num_tokens, hidden_size]. It must not be empty.
+//   - pooling: how the hidden states are reduced.
+//   - normalize: whether the embedding is scaled to a unit L2 norm, e.g. for
+//     the cosine similarity to be a dot product. An all-zero embedding is
+//     left as is.
+//   - embedding: this is an output parameter to store the embedding, of shape
+//     [hidden_size].
+absl::Status PoolHiddenStates(absl::Span<const float> hidden_states,
+                              EmbeddingPooling pooling, bool normalize,
+                              absl::Span<float> embedding);
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_EMBEDDING_POOLING_H_
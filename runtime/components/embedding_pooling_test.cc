@@ -0,0 +1,78 @@
+#include "runtime/components/embedding_pooling.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+// Three tokens with a hidden size of 2.
+const std::vector<float> kHiddenStates = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+
+TEST(EmbeddingPoolingTest, Mean) {
+  std::vector<float> embedding(2);
+  EXPECT_TRUE(PoolHiddenStates(kHiddenStates, EmbeddingPooling::kMean,
+                               /*normalize=*/false,
+                               absl::MakeSpan(embedding))
+                  .ok());
+  EXPECT_THAT(embedding, Pointwise(FloatNear(1e-6f), {3.0f, 4.0f}));
+}
+
+TEST(EmbeddingPoolingTest, LastToken) {
+  std::vector<float> embedding(2);
+  EXPECT_TRUE(PoolHiddenStates(kHiddenStates, EmbeddingPooling::kLastToken,
+                               /*normalize=*/false,
+                               absl::MakeSpan(embedding))
+                  .ok());
+  EXPECT_THAT(embedding, ElementsAre(5.0f, 6.0f));
+}
+
+TEST(EmbeddingPoolingTest, FirstToken) {
+  std::vector<float> embedding(2);
+  EXPECT_TRUE(PoolHiddenStates(kHiddenStates, EmbeddingPooling::kFirstToken,
+                               /*normalize=*/false,
+                               absl::MakeSpan(embedding))
+                  .ok());
+  EXPECT_THAT(embedding, ElementsAre(1.0f, 2.0f));
+}
+
+TEST(EmbeddingPoolingTest, MeanNormalized) {
+  std::vector<float> embedding(2);
+  EXPECT_TRUE(PoolHiddenStates(kHiddenStates, EmbeddingPooling::kMean,
+                               /*normalize=*/true, absl::MakeSpan(embedding))
+                  .ok());
+  // The mean (3, 4) has a norm of 5.
+  EXPECT_THAT(embedding, Pointwise(FloatNear(1e-6f), {0.6f, 0.8f}));
+}
+
+TEST(EmbeddingPoolingTest, NormalizedZeroEmbeddingIsKept) {
+  const std::vector<float> hidden_states = {0.0f, 0.0f};
+  std::vector<float> embedding(2, 1.0f);
+  EXPECT_TRUE(PoolHiddenStates(hidden_states, EmbeddingPooling::kMean,
+                               /*normalize=*/true, absl::MakeSpan(embedding))
+                  .ok());
+  EXPECT_THAT(embedding, ElementsAre(0.0f, 0.0f));
+}
+
+TEST(EmbeddingPoolingTest, InvalidShape) {
+  std::vector<float> embedding(4);
+  EXPECT_EQ(PoolHiddenStates(kHiddenStates, EmbeddingPooling::kMean,
+                             /*normalize=*/false, absl::MakeSpan(embedding))
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(PoolHiddenStates({}, EmbeddingPooling::kMean,
+                             /*normalize=*/false, absl::MakeSpan(embedding))
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace litert::lm
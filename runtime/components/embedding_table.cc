@@ -0,0 +1,156 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/embedding_table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+namespace {
+
+// The loops below are kept simple (contiguous, no branches) so that the
+// compiler vectorizes them.
+
+void DequantizeInt8(const int8_t* values, int size, float zero_point,
+                    float scale, float* output) {
+  for (int i = 0; i < size; ++i) {
+    output[i] = (static_cast<float>(values[i]) - zero_point) * scale;
+  }
+}
+
+// Dequantizes `size` int4 values from the low nibble of `packed[0]`.
+void DequantizeInt4(const uint8_t* packed, int size, float zero_point,
+                    float scale, float* output) {
+  const int num_pairs = size / 2;
+  for (int i = 0; i < num_pairs; ++i) {
+    // Sign-extends the nibbles with arithmetic shifts.
+    const int8_t low = static_cast<int8_t>(packed[i] << 4) >> 4;
+    const int8_t high = static_cast<int8_t>(packed[i]) >> 4;
+    output[2 * i] = (static_cast<float>(low) - zero_point) * scale;
+    output[2 * i + 1] = (static_cast<float>(high) - zero_point) * scale;
+  }
+  if (size % 2 == 1) {
+    const int8_t low = static_cast<int8_t>(packed[num_pairs] << 4) >> 4;
+    output[size - 1] = (static_cast<float>(low) - zero_point) * scale;
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<EmbeddingTable> EmbeddingTable::Create(
+    EmbeddingTableType type, absl::Span<const uint8_t> data, int num_rows,
+    int row_size, std::vector<float> scales,
+    std::vector<int64_t> zero_points) {
+  if (num_rows <= 0 || row_size <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Invalid embedding table shape: [", num_rows, ", ", row_size, "]"));
+  }
+  const size_t num_values = static_cast<size_t>(num_rows) * row_size;
+  size_t expected_size = 0;
+  switch (type) {
+    case EmbeddingTableType::kFloat32:
+      expected_size = num_values * sizeof(float);
+      break;
+    case EmbeddingTableType::kInt8:
+      expected_size = num_values;
+      break;
+    case EmbeddingTableType::kInt4:
+      expected_size = (num_values + 1) / 2;
+      break;
+  }
+  if (data.size() != expected_size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The embedding table has ", data.size(),
+                     " bytes, its shape requires ", expected_size, "."));
+  }
+  if (type == EmbeddingTableType::kFloat32) {
+    if (!scales.empty() || !zero_points.empty()) {
+      return absl::InvalidArgumentError(
+          "A float embedding table is not quantized.");
+    }
+  } else if (scales.size() != 1 &&
+             scales.size() != static_cast<size_t>(num_rows)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("A quantized embedding table needs 1 or ", num_rows,
+                     " scales, got ", scales.size(), "."));
+  }
+  if (!zero_points.empty() && zero_points.size() != scales.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The embedding table has ", scales.size(),
+                     " scales but ", zero_points.size(), " zero points."));
+  }
+  return EmbeddingTable(type, data, num_rows, row_size, std::move(scales),
+                        std::move(zero_points));
+}
+
+absl::Status EmbeddingTable::GatherRow(int token,
+                                       absl::Span<float> output) const {
+  if (token < 0 || token >= num_rows_) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Token ", token, " is out of the embedding table of ",
+                     num_rows_, " rows."));
+  }
+  if (output.size() != static_cast<size_t>(row_size_)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The embedding output has ", output.size(),
+                     " values, the table rows have ", row_size_, "."));
+  }
+  const size_t offset = static_cast<size_t>(token) * row_size_;
+  if (type_ == EmbeddingTableType::kFloat32) {
+    memcpy(output.data(), data_.data() + offset * sizeof(float),
+           row_size_ * sizeof(float));
+    if (output_scale_ != 1.0f) {
+      for (float& value : output) {
+        value *= output_scale_;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  const int quantization_index = scales_.size() == 1 ? 0 : token;
+  const float scale = scales_[quantization_index] * output_scale_;
+  const float zero_point =
+      zero_points_.empty()
+          ? 0.0f
+          : static_cast<float>(zero_points_[quantization_index]);
+  if (type_ == EmbeddingTableType::kInt8) {
+    DequantizeInt8(reinterpret_cast<const int8_t*>(data_.data()) + offset,
+                   row_size_, zero_point, scale, output.data());
+    return absl::OkStatus();
+  }
+
+  // kInt4: a row with an odd offset starts in the high nibble of a byte.
+  const uint8_t* packed = data_.data() + offset / 2;
+  float* output_ptr = output.data();
+  int size = row_size_;
+  if (offset % 2 == 1) {
+    const int8_t high = static_cast<int8_t>(*packed) >> 4;
+    *output_ptr++ = (static_cast<float>(high) - zero_point) * scale;
+    ++packed;
+    --size;
+  }
+  DequantizeInt4(packed, size, zero_point, scale, output_ptr);
+  return absl::OkStatus();
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,83 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_EMBEDDING_TABLE_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_EMBEDDING_TABLE_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// The storage type of the values of an EmbeddingTable.
+enum class EmbeddingTableType {
+  kFloat32,
+  kInt8,
+  // Two values per byte, the first one in the low nibble.
+  kInt4,
+};
+
+// A view of a (possibly quantized) embedding table of shape
+// [num_rows, row_size], e.g. the constant tensor of an embedding model in the
+// memory-mapped model file, which is dequantized on the fly when gathering
+// the rows of tokens. The data is not owned and must outlive the table.
+class EmbeddingTable {
+ public:
+  // Creates a table over `data`. The quantized values are dequantized as
+  // (value - zero_point) * scale, where `scales` and `zero_points` have one
+  // entry for the whole table or one per row, and `zero_points` may be empty
+  // for zeros. `scales` must be empty for kFloat32.
+  static absl::StatusOr<EmbeddingTable> Create(
+      EmbeddingTableType type, absl::Span<const uint8_t> data, int num_rows,
+      int row_size, std::vector<float> scales = {},
+      std::vector<int64_t> zero_points = {});
+
+  int num_rows() const { return num_rows_; }
+  int row_size() const { return row_size_; }
+
+  // Sets a factor applied to the dequantized rows, e.g. when the embedding
+  // model scales its embeddings.
+  void set_output_scale(float output_scale) { output_scale_ = output_scale; }
+
+  // Writes the dequantized row of `token` to `output` of size row_size().
+  absl::Status GatherRow(int token, absl::Span<float> output) const;
+
+ private:
+  EmbeddingTable(EmbeddingTableType type, absl::Span<const uint8_t> data,
+                 int num_rows, int row_size, std::vector<float> scales,
+                 std::vector<int64_t> zero_points)
+      : type_(type),
+        data_(data),
+        num_rows_(num_rows),
+        row_size_(row_size),
+        scales_(std::move(scales)),
+        zero_points_(std::move(zero_points)) {}
+
+  EmbeddingTableType type_;
+  absl::Span<const uint8_t> data_;
+  int num_rows_;
+  int row_size_;
+  std::vector<float> scales_;
+  std::vector<int64_t> zero_points_;
+  float output_scale_ = 1.0f;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_EMBEDDING_TABLE_H_
@@ -0,0 +1,113 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/embedding_table.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+
+absl::Span<const uint8_t> AsBytes(const std::vector<float>& values) {
+  return absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(values.data()),
+                             values.size() * sizeof(float));
+}
+
+TEST(EmbeddingTableTest, GatherRowFloat32) {
+  const std::vector<float> values = {1, 2, 3, 4, 5, 6};
+  ASSERT_OK_AND_ASSIGN(auto table,
+                       EmbeddingTable::Create(EmbeddingTableType::kFloat32,
+                                              AsBytes(values), /*num_rows=*/3,
+                                              /*row_size=*/2));
+  std::vector<float> row(2);
+  ASSERT_OK(table.GatherRow(1, absl::MakeSpan(row)));
+  EXPECT_THAT(row, ElementsAre(3, 4));
+
+  table.set_output_scale(2.0f);
+  ASSERT_OK(table.GatherRow(2, absl::MakeSpan(row)));
+  EXPECT_THAT(row, ElementsAre(10, 12));
+}
+
+TEST(EmbeddingTableTest, GatherRowInt8PerRowScales) {
+  const std::vector<int8_t> values = {1, -2, 3, 4, -128, 127};
+  ASSERT_OK_AND_ASSIGN(
+      auto table,
+      EmbeddingTable::Create(
+          EmbeddingTableType::kInt8,
+          absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(values.data()),
+                              values.size()),
+          /*num_rows=*/2, /*row_size=*/3, /*scales=*/{0.5f, 2.0f},
+          /*zero_points=*/{0, -1}));
+  std::vector<float> row(3);
+  ASSERT_OK(table.GatherRow(0, absl::MakeSpan(row)));
+  EXPECT_THAT(row, ElementsAre(0.5f, -1.0f, 1.5f));
+  ASSERT_OK(table.GatherRow(1, absl::MakeSpan(row)));
+  EXPECT_THAT(row, ElementsAre(10.0f, -254.0f, 256.0f));
+}
+
+TEST(EmbeddingTableTest, GatherRowInt4OddRowSize) {
+  // The values 1, -2, 3, 7, -8, -1, packed two per byte, low nibble first.
+  // The second row starts in the high nibble of the second byte.
+  const std::vector<uint8_t> packed = {0xE1, 0x73, 0xF8};
+  ASSERT_OK_AND_ASSIGN(
+      auto table,
+      EmbeddingTable::Create(EmbeddingTableType::kInt4, packed,
+                             /*num_rows=*/2, /*row_size=*/3,
+                             /*scales=*/{0.5f}));
+  std::vector<float> row(3);
+  ASSERT_OK(table.GatherRow(0, absl::MakeSpan(row)));
+  EXPECT_THAT(row, ElementsAre(0.5f, -1.0f, 1.5f));
+  ASSERT_OK(table.GatherRow(1, absl::MakeSpan(row)));
+  EXPECT_THAT(row, ElementsAre(3.5f, -4.0f, -0.5f));
+}
+
+TEST(EmbeddingTableTest, InvalidArguments) {
+  const std::vector<float> values = {1, 2, 3, 4};
+  EXPECT_EQ(EmbeddingTable::Create(EmbeddingTableType::kFloat32,
+                                   AsBytes(values), /*num_rows=*/3,
+                                   /*row_size=*/2)
+                .status()
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(EmbeddingTable::Create(EmbeddingTableType::kInt8, AsBytes(values),
+                                   /*num_rows=*/4, /*row_size=*/4,
+                                   /*scales=*/{1.0f, 1.0f})
+                .status()
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+
+  ASSERT_OK_AND_ASSIGN(auto table,
+                       EmbeddingTable::Create(EmbeddingTableType::kFloat32,
+                                              AsBytes(values), /*num_rows=*/2,
+                                              /*row_size=*/2));
+  std::vector<float> row(2);
+  EXPECT_EQ(table.GatherRow(2, absl::MakeSpan(row)).code(),
+            absl::StatusCode::kInvalidArgument);
+  std::vector<float> short_row(1);
+  EXPECT_EQ(table.GatherRow(0, absl::MakeSpan(short_row)).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace litert::lm
@@ -0,0 +1,89 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/lora_adapter.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/memory/memory.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/match.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "litert/cc/litert_macros.h"  // from @litert
+#include "litert/cc/litert_model.h"  // from @litert
+
+namespace litert::lm {
+
+// static
+absl::StatusOr<std::unique_ptr<LoRAAdapter>> LoRAAdapter::CreateFromModel(
+    const litert::Model& model) {
+  LITERT_ASSIGN_OR_RETURN(auto subgraph, model.MainSubgraph());
+  absl::flat_hash_map<std::string, absl::Span<const uint8_t>> weights;
+  // The constant tensors are only reachable as op inputs. The other constants
+  // of the adapter graph (e.g. shapes) are skipped by their names.
+  for (const auto& op : subgraph.Ops()) {
+    for (const auto& tensor : op.Inputs()) {
+      if (!tensor.HasWeights() ||
+          !absl::StartsWith(tensor.Name(), kLoRAInputPrefix)) {
+        continue;
+      }
+      const auto bytes = tensor.Weights().Bytes();
+      weights.emplace(tensor.Name(),
+                      absl::Span<const uint8_t>(bytes.data(), bytes.size()));
+    }
+  }
+  return Create(std::move(weights));
+}
+
+// static
+absl::StatusOr<std::unique_ptr<LoRAAdapter>> LoRAAdapter::Create(
+    absl::flat_hash_map<std::string, absl::Span<const uint8_t>> weights) {
+  if (weights.empty()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The LoRA adapter has no tensor named ", kLoRAInputPrefix,
+                     "*."));
+  }
+  for (const auto& [input_name, input_weights] : weights) {
+    if (!absl::StartsWith(input_name, kLoRAInputPrefix)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("The LoRA adapter tensor ", input_name,
+                       " is not named after a LoRA input (", kLoRAInputPrefix,
+                       "*)."));
+    }
+    if (input_weights.empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("The LoRA adapter tensor ", input_name, " is empty."));
+    }
+  }
+  return absl::WrapUnique(new LoRAAdapter(std::move(weights)));
+}
+
+absl::StatusOr<absl::Span<const uint8_t>> LoRAAdapter::GetWeights(
+    absl::string_view input_name) const {
+  auto it = weights_.find(input_name);
+  if (it == weights_.end()) {
+    return absl::NotFoundError(absl::StrCat(
+        "The LoRA adapter has no weights for the input ", input_name, "."));
+  }
+  return it->second;
+}
+
+}  // namespace litert::lm
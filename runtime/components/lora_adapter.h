@@ -0,0 +1,73 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_LORA_ADAPTER_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_LORA_ADAPTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "litert/cc/litert_model.h"  // from @litert
+
+namespace litert::lm {
+
+// The prefix of the names of the LoRA inputs of a base model, e.g.
+// lora_atten_q_a_prime_weight_0. Feeding zeros to them runs the base model.
+constexpr absl::string_view kLoRAInputPrefix = "lora_";
+
+// A LoRA adapter, i.e. the low-rank weights fed to the LoRA inputs of a base
+// model, keyed by input name. The fine-tuned variants of a base model only
+// differ by their adapter, so the base weights are loaded once for all of
+// them.
+//
+// The adapter is stored as a TF Lite model (model type tf_lite_lora in a
+// .litertlm file) holding one constant tensor per LoRA input of the base
+// model, named after the input. The weights are not copied: the model they
+// come from must outlive the adapter.
+class LoRAAdapter {
+ public:
+  // Creates an adapter from the constant tensors of `model` whose names start
+  // with kLoRAInputPrefix.
+  static absl::StatusOr<std::unique_ptr<LoRAAdapter>> CreateFromModel(
+      const litert::Model& model);
+
+  // Creates an adapter from its weights, keyed by LoRA input name.
+  static absl::StatusOr<std::unique_ptr<LoRAAdapter>> Create(
+      absl::flat_hash_map<std::string, absl::Span<const uint8_t>> weights);
+
+  // Returns the weights of the LoRA input `input_name`.
+  absl::StatusOr<absl::Span<const uint8_t>> GetWeights(
+      absl::string_view input_name) const;
+
+  // Returns the number of LoRA inputs the adapter has weights for.
+  size_t NumInputs() const { return weights_.size(); }
+
+ private:
+  explicit LoRAAdapter(
+      absl::flat_hash_map<std::string, absl::Span<const uint8_t>> weights)
+      : weights_(std::move(weights)) {}
+
+  absl::flat_hash_map<std::string, absl::Span<const uint8_t>> weights_;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_LORA_ADAPTER_H_
@@ -0,0 +1,62 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/lora_adapter.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::status::StatusIs;
+
+TEST(LoRAAdapterTest, GetWeights) {
+  const std::vector<uint8_t> a_weights = {1, 2, 3, 4};
+  const std::vector<uint8_t> b_weights = {5, 6};
+  absl::flat_hash_map<std::string, absl::Span<const uint8_t>> lora_weights = {
+      {"lora_atten_q_a_prime_weight_0", a_weights},
+      {"lora_atten_q_b_prime_weight_0", b_weights}};
+  ASSERT_OK_AND_ASSIGN(auto adapter,
+                       LoRAAdapter::Create(std::move(lora_weights)));
+  EXPECT_EQ(adapter->NumInputs(), 2);
+  ASSERT_OK_AND_ASSIGN(auto weights,
+                       adapter->GetWeights("lora_atten_q_b_prime_weight_0"));
+  EXPECT_THAT(weights, ElementsAre(5, 6));
+  EXPECT_THAT(adapter->GetWeights("lora_atten_k_a_prime_weight_0"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(LoRAAdapterTest, InvalidWeights) {
+  const std::vector<uint8_t> weights = {1, 2, 3, 4};
+  EXPECT_THAT(LoRAAdapter::Create({}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(LoRAAdapter::Create({{"atten_q_weight_0", weights}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(LoRAAdapter::Create({{"lora_atten_q_a_prime_weight_0", {}}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace litert::lm
@@ -37,6 +37,9 @@ enum class ModelType {
   kTfLiteEmbedder = 2,
   kTfLitePerLayerEmbedder = 3,
   kTfLiteAux = 4,
+  // A LoRA adapter of the base model. Its constant tensors are the weights of
+  // the LoRA inputs of the base model.
+  kTfLiteLoRA = 5,
 };
 
 // Utility function to convert a string to ModelType. It's case insensitive.
@@ -52,6 +55,8 @@ inline absl::StatusOr<ModelType> StringToModelType(
     return ModelType::kTfLitePerLayerEmbedder;
   } else if (lower_case_model_type_str == "tf_lite_aux") {
     return ModelType::kTfLiteAux;
+  } else if (lower_case_model_type_str == "tf_lite_lora") {
+    return ModelType::kTfLiteLoRA;
   } else {
     return absl::InvalidArgumentError(
         absl::StrCat("Unknown model type: ", model_type_str));
@@ -69,6 +74,8 @@ inline std::string ModelTypeToString(ModelType model_type) {
       return "TF_LITE_PER_LAYER_EMBEDDER";
     case ModelType::kTfLiteAux:
       return "TF_LITE_AUX";
+    case ModelType::kTfLiteLoRA:
+      return "TF_LITE_LORA";
     case ModelType::kUnknown:
       return "UNKNOWN";
     default:
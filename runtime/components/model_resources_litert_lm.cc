@@ -47,8 +47,8 @@ absl::StatusOr<const litert::Model*> ModelResourcesLitertLm::GetTFLiteModel(
     return it->second.get();
   }
 
-  litert::BufferRef<uint8_t> buffer_ref =
-      litert_lm_loader_->GetTFLiteModel(model_type);
+  ASSIGN_OR_RETURN(litert::BufferRef<uint8_t> buffer_ref,  // NOLINT
+                   litert_lm_loader_->GetTFLiteModel(model_type));
   ABSL_LOG(INFO) << "model_type: " << ModelTypeToString(model_type);
   ABSL_LOG(INFO) << "litert model size: " << buffer_ref.Size();
   LITERT_ASSIGN_OR_RETURN(auto model, Model::CreateFromBuffer(buffer_ref));
@@ -58,7 +58,8 @@ absl::StatusOr<const litert::Model*> ModelResourcesLitertLm::GetTFLiteModel(
 
 absl::StatusOr<SentencePieceTokenizer*> ModelResourcesLitertLm::GetTokenizer() {
   if (tokenizer_ == nullptr) {
-    auto buffer_ref = litert_lm_loader_->GetTokenizer();
+    ASSIGN_OR_RETURN(auto buffer_ref,  // NOLINT
+                     litert_lm_loader_->GetTokenizer());
     ASSIGN_OR_RETURN(  // NOLINT
         auto tokenizer,
         SentencePieceTokenizer::CreateFromBuffer(buffer_ref.StrView()));
@@ -70,7 +71,8 @@ absl::StatusOr<SentencePieceTokenizer*> ModelResourcesLitertLm::GetTokenizer() {
 absl::StatusOr<const proto::LlmMetadata*>
 ModelResourcesLitertLm::GetLlmMetadata() {
   if (llm_metadata_ == nullptr) {
-    auto buffer_ref = litert_lm_loader_->GetLlmMetadata();
+    ASSIGN_OR_RETURN(auto buffer_ref,  // NOLINT
+                     litert_lm_loader_->GetLlmMetadata());
     auto llm_metadata = std::make_unique<proto::LlmMetadata>();
     if (!llm_metadata->ParseFromString(std::string(buffer_ref.StrView()))) {  // NOLINT
       return absl::InternalError("Failed to parse LlmMetadata");
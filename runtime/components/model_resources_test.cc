@@ -45,12 +45,11 @@ TEST(ModelResourcesTest, InitializeWithValidLitertLmLoader) {
       "litert_lm/runtime/testdata/test_lm.litertlm";
   auto model_file = ScopedFile::Open(model_path.string());
   ASSERT_TRUE(model_file.ok());
-  LitertLmLoader loader(std::move(model_file.value()));
-  ASSERT_GT(loader.GetTokenizer().Size(), 0);
-  ASSERT_GT(loader.GetTFLiteModel(ModelType::kTfLitePrefillDecode).Size(), 0);
+  auto loader = std::make_unique<LitertLmLoader>(std::move(model_file.value()));
+  ASSERT_GT(loader->GetTokenizer()->Size(), 0);
+  ASSERT_GT(loader->GetTFLiteModel(ModelType::kTfLitePrefillDecode)->Size(), 0);
 
-  auto model_resources = ModelResourcesLitertLm::Create(
-      std::make_unique<LitertLmLoader>(std::move(loader)));
+  auto model_resources = ModelResourcesLitertLm::Create(std::move(loader));
   ASSERT_OK(model_resources);
 
   auto tflite_model =
@@ -112,6 +111,10 @@ TEST(ModelTypeConversionTest, StringToModelType) {
   ASSERT_OK(result);
   EXPECT_EQ(result.value(), ModelType::kTfLitePerLayerEmbedder);
 
+  result = StringToModelType("tf_lite_lora");
+  ASSERT_OK(result);
+  EXPECT_EQ(result.value(), ModelType::kTfLiteLoRA);
+
   result = StringToModelType("unknown");
   EXPECT_FALSE(result.ok());
 }
@@ -122,6 +125,7 @@ TEST(ModelTypeConversionTest, ModelTypeToString) {
   EXPECT_EQ(ModelTypeToString(ModelType::kTfLiteEmbedder), "TF_LITE_EMBEDDER");
   EXPECT_EQ(ModelTypeToString(ModelType::kTfLitePerLayerEmbedder),
             "TF_LITE_PER_LAYER_EMBEDDER");
+  EXPECT_EQ(ModelTypeToString(ModelType::kTfLiteLoRA), "TF_LITE_LORA");
   EXPECT_EQ(ModelTypeToString(ModelType::kUnknown), "UNKNOWN");
 }
 
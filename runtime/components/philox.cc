@@ -0,0 +1,70 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/philox.h"
+
+#include <array>
+#include <cstdint>
+
+namespace litert::lm {
+namespace {
+
+// The constants of Philox-4x32, from the reference implementation (Random123).
+constexpr uint32_t kMultiplier0 = 0xD2511F53;
+constexpr uint32_t kMultiplier1 = 0xCD9E8D57;
+constexpr uint32_t kWeyl0 = 0x9E3779B9;
+constexpr uint32_t kWeyl1 = 0xBB67AE85;
+constexpr int kNumRounds = 10;
+
+// Returns the high and low 32 bits of `a * b`.
+inline void MultiplyHighLow(uint32_t a, uint32_t b, uint32_t& high,
+                            uint32_t& low) {
+  const uint64_t product = static_cast<uint64_t>(a) * b;
+  high = static_cast<uint32_t>(product >> 32);
+  low = static_cast<uint32_t>(product);
+}
+
+}  // namespace
+
+std::array<uint32_t, 4> Philox4x32(const std::array<uint32_t, 4>& counter,
+                                   const std::array<uint32_t, 2>& key) {
+  std::array<uint32_t, 4> block = counter;
+  std::array<uint32_t, 2> round_key = key;
+  for (int round = 0; round < kNumRounds; ++round) {
+    uint32_t high0, low0, high1, low1;
+    MultiplyHighLow(kMultiplier0, block[0], high0, low0);
+    MultiplyHighLow(kMultiplier1, block[2], high1, low1);
+    block = {high1 ^ block[1] ^ round_key[0], low1,
+             high0 ^ block[3] ^ round_key[1], low0};
+    round_key[0] += kWeyl0;
+    round_key[1] += kWeyl1;
+  }
+  return block;
+}
+
+double PhiloxUniform(uint64_t seed, uint32_t sequence_id, uint64_t step) {
+  const std::array<uint32_t, 4> counter = {static_cast<uint32_t>(step),
+                                           static_cast<uint32_t>(step >> 32),
+                                           sequence_id, 0};
+  const std::array<uint32_t, 2> key = {static_cast<uint32_t>(seed),
+                                       static_cast<uint32_t>(seed >> 32)};
+  const std::array<uint32_t, 4> block = Philox4x32(counter, key);
+  // The 53 high bits of the first 64 bits of the block, i.e. as many random
+  // bits as the mantissa of a double holds.
+  const uint64_t bits =
+      (static_cast<uint64_t>(block[0]) << 32 | block[1]) >> 11;
+  return static_cast<double>(bits) * 0x1.0p-53;
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,38 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_PHILOX_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_PHILOX_H_
+
+#include <array>
+#include <cstdint>
+
+namespace litert::lm {
+
+// Computes the Philox-4x32-10 block of `counter` under `key`, i.e. the
+// counter-based random number generator of Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3" (SC 2011). Unlike a sequential generator, any
+// block is computed directly from its counter, without the blocks before it.
+std::array<uint32_t, 4> Philox4x32(const std::array<uint32_t, 4>& counter,
+                                   const std::array<uint32_t, 2>& key);
+
+// Returns a random number uniform in [0, 1), only determined by `seed`, the
+// sequence (e.g. the output candidate) and the decode step it is drawn for.
+// The same draw is thus made for a token whatever the other sequences of the
+// batch, the number of draws made before, or the steps rolled back in between.
+double PhiloxUniform(uint64_t seed, uint32_t sequence_id, uint64_t step);
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_PHILOX_H_
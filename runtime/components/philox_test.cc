@@ -0,0 +1,62 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/philox.h"
+
+#include <cstdint>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+
+// The known answers of Philox-4x32-10 from the reference implementation.
+TEST(PhiloxTest, MatchesTheKnownAnswers) {
+  EXPECT_THAT(Philox4x32({0, 0, 0, 0}, {0, 0}),
+              ElementsAre(0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8));
+  EXPECT_THAT(Philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                         {0xffffffff, 0xffffffff}),
+              ElementsAre(0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd));
+  EXPECT_THAT(Philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                         {0xa4093822, 0x299f31d0}),
+              ElementsAre(0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1));
+}
+
+TEST(PhiloxTest, UniformIsInTheUnitInterval) {
+  double sum = 0.0;
+  for (uint64_t step = 0; step < 1000; ++step) {
+    const double value = PhiloxUniform(/*seed=*/42, /*sequence_id=*/0, step);
+    EXPECT_GE(value, 0.0);
+    EXPECT_LT(value, 1.0);
+    sum += value;
+  }
+  EXPECT_NEAR(sum / 1000, 0.5, 0.05);
+}
+
+TEST(PhiloxTest, UniformOnlyDependsOnSeedSequenceAndStep) {
+  EXPECT_EQ(PhiloxUniform(/*seed=*/1, /*sequence_id=*/2, /*step=*/3),
+            PhiloxUniform(/*seed=*/1, /*sequence_id=*/2, /*step=*/3));
+  EXPECT_NE(PhiloxUniform(/*seed=*/1, /*sequence_id=*/2, /*step=*/3),
+            PhiloxUniform(/*seed=*/2, /*sequence_id=*/2, /*step=*/3));
+  EXPECT_NE(PhiloxUniform(/*seed=*/1, /*sequence_id=*/2, /*step=*/3),
+            PhiloxUniform(/*seed=*/1, /*sequence_id=*/3, /*step=*/3));
+  EXPECT_NE(PhiloxUniform(/*seed=*/1, /*sequence_id=*/2, /*step=*/3),
+            PhiloxUniform(/*seed=*/1, /*sequence_id=*/2, /*step=*/4));
+}
+
+}  // namespace
+}  // namespace litert::lm
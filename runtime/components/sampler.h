@@ -1,11 +1,25 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_SAMPLER_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_SAMPLER_H_
 
+#include <vector>
+
 #include "absl/status/status.h"  // from @com_google_absl
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
 
 namespace litert::lm {
 
+// The log probabilities of a batch of sampled tokens, under the softmax of the
+// whole vocabulary.
+struct SampledLogProbs {
+  // The log probability of the sampled token of each batch, of shape
+  // [batch_size].
+  std::vector<float> log_probs;
+  // The ids and log probabilities of the most likely tokens of each batch, in
+  // decreasing order, of shape [batch_size, num_top_log_probs].
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+};
+
 // A sampler that samples token ids from logits.
 class Sampler {
  public:
@@ -20,6 +34,31 @@ class Sampler {
   virtual absl::Status SampleToIdAndScoreBuffer(
       const TensorBuffer& logits_tensor, TensorBuffer& ids_tensor,
       TensorBuffer* scores_tensor) = 0;
+
+  // Same as SampleToIdAndScoreBuffer, and also computes the log probabilities
+  // of the sampled tokens and of the `num_top_log_probs` most likely tokens of
+  // each batch from the same logits, without copying them again.
+  virtual absl::Status SampleWithLogProbs(const TensorBuffer& logits_tensor,
+                                          TensorBuffer& ids_tensor,
+                                          TensorBuffer* scores_tensor,
+                                          int num_top_log_probs,
+                                          SampledLogProbs& log_probs) {
+    return absl::UnimplementedError(
+        "This sampler does not compute log probabilities.");
+  }
+
+  // Brings the sampler back to its state right after its creation, e.g.
+  // reseeds its random number generator, so that it samples the same tokens
+  // as a new sampler when it is reused by another session.
+  virtual absl::Status Reset() {
+    return absl::UnimplementedError("This sampler cannot be reset.");
+  }
+
+  // Sets the decode step of the tokens sampled by the next call, for the
+  // samplers drawing their random numbers from the step rather than from a
+  // sequential generator, so that a step sampled again, e.g. after a rewind,
+  // gets the same random numbers. It is a no-op for the other samplers.
+  virtual void SetStep(int step) {}
 };
 
 }  // namespace litert::lm
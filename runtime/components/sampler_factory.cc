@@ -64,26 +64,8 @@ class TopKOpenClCApiSampler : public Sampler {
       LiteRtEnvironment env, int batch_size, int vocab_size,
       std::optional<ActivationDataType> activation_data_type,
       proto::SamplerParameters sampler_params) {
-    // Load Sampler C API library and get the symbols.
-    std::unique_ptr<TopKOpenClSamplerCApi> capi;
-    auto capi_or = GetTopKOpenClSamplerCApi();
-    if (capi_or.ok()) {
-      capi = std::move(capi_or.value());
-      ABSL_LOG(INFO) << "Dynamically loaded LiteRtTopKOpenClSampler C API.";
-    } else {
-      if (capi_or.status().code() != absl::StatusCode::kUnavailable) {
-        // Directly return if the error is not due to unavailable dynamic
-        // loading.
-        return capi_or.status();
-      }
-      // If dynamic loading is unavailable, try static loading.
-      auto static_capi_or = GetStaticTopKOpenClSamplerCApi();
-      if (!static_capi_or.ok()) {
-        return capi_or.status();
-      }
-      capi = std::move(static_capi_or.value());
-      ABSL_LOG(INFO) << "Statically linked LiteRtTopKOpenClSampler C API.";
-    }
+    ASSIGN_OR_RETURN(std::shared_ptr<const TopKOpenClSamplerCApi> capi,
+                     GetSharedTopKOpenClSamplerCApi());
 
     // Create sampler.
     LiteRtTopKOpenClSampler_Sampler* sampler = nullptr;
@@ -149,10 +131,44 @@ class TopKOpenClCApiSampler : public Sampler {
           sample_func(sample_func) {}
   };
 
-  TopKOpenClCApiSampler(std::unique_ptr<TopKOpenClSamplerCApi> capi,
+  TopKOpenClCApiSampler(std::shared_ptr<const TopKOpenClSamplerCApi> capi,
                         LiteRtTopKOpenClSampler_Sampler* sampler)
       : capi_(std::move(capi)), sampler_(sampler) {}
 
+  // Returns the C API, loaded by the first call and shared by all the
+  // samplers, i.e. the library is opened and its symbols are looked up once
+  // per process rather than for every sampler (every session). The samplers
+  // only own their state created by `create_func`.
+  static absl::StatusOr<std::shared_ptr<const TopKOpenClSamplerCApi>>
+  GetSharedTopKOpenClSamplerCApi() {
+    static const auto* capi =
+        new absl::StatusOr<std::shared_ptr<const TopKOpenClSamplerCApi>>(
+            LoadTopKOpenClSamplerCApi());
+    return *capi;
+  }
+
+  // Loads the C API dynamically, or falls back to the statically linked one.
+  static absl::StatusOr<std::shared_ptr<const TopKOpenClSamplerCApi>>
+  LoadTopKOpenClSamplerCApi() {
+    auto capi_or = GetTopKOpenClSamplerCApi();
+    if (capi_or.ok()) {
+      ABSL_LOG(INFO) << "Dynamically loaded LiteRtTopKOpenClSampler C API.";
+      return std::move(capi_or.value());
+    }
+    if (capi_or.status().code() != absl::StatusCode::kUnavailable) {
+      // Directly return if the error is not due to unavailable dynamic
+      // loading.
+      return capi_or.status();
+    }
+    // If dynamic loading is unavailable, try static loading.
+    auto static_capi_or = GetStaticTopKOpenClSamplerCApi();
+    if (!static_capi_or.ok()) {
+      return capi_or.status();
+    }
+    ABSL_LOG(INFO) << "Statically linked LiteRtTopKOpenClSampler C API.";
+    return std::move(static_capi_or.value());
+  }
+
   static absl::StatusOr<std::unique_ptr<TopKOpenClSamplerCApi>>
   GetTopKOpenClSamplerCApi() {
     // Load Sampler C API library and get the symbols.
@@ -205,7 +221,7 @@ class TopKOpenClCApiSampler : public Sampler {
         LiteRtTopKOpenClSampler_SampleToIdAndScoreBuffer_Static);
   }
 
-  std::unique_ptr<TopKOpenClSamplerCApi> capi_;
+  std::shared_ptr<const TopKOpenClSamplerCApi> capi_;
   LiteRtTopKOpenClSampler_Sampler* const sampler_;
 };
 
@@ -0,0 +1,216 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This tool measures the cost of the sampler of a new session and of its first
+// decode step, either with a new sampler from CreateSampler() or with a pooled
+// one brought back with Reset().
+//
+// Where libLiteRtTopKOpenClSampler.so is available, it also measures the
+// creation of an OpenCL sampler, either loading the C API for each sampler as
+// before it was shared, or with CreateSampler() sharing it.
+//
+// Example usage:
+// bazel run -c opt :sampler_factory_benchmark -- --vocab_size=262144
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"  // from @com_google_absl
+#include "absl/flags/parse.h"  // from @com_google_absl
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "litert/c/litert_common.h"  // from @litert
+#include "litert/cc/litert_environment.h"  // from @litert
+#include "litert/cc/litert_shared_library.h"  // from @litert
+#include "runtime/components/sampler.h"
+#include "runtime/components/sampler_factory.h"
+#include "runtime/executor/executor_settings_base.h"
+#include "runtime/proto/sampler_params.pb.h"
+#include "runtime/util/convert_tensor_buffer.h"
+#include "runtime/util/litert_status_util.h"
+
+ABSL_FLAG(int, vocab_size, 262144, "The vocabulary size of the logits.");
+
+ABSL_FLAG(int, iterations, 200, "The number of sessions to average.");
+
+namespace {
+
+using ::litert::lm::Backend;
+using ::litert::lm::CopyToTensorBuffer;
+using ::litert::lm::CreateSampler;
+using ::litert::lm::Sampler;
+using ::litert::lm::proto::SamplerParameters;
+
+// Returns the parameters of the samplers, a usual top-p sampling.
+SamplerParameters GetSamplerParams() {
+  SamplerParameters sampler_params;
+  sampler_params.set_type(SamplerParameters::TOP_P);
+  sampler_params.set_k(40);
+  sampler_params.set_p(0.95f);
+  sampler_params.set_temperature(1.0f);
+  sampler_params.set_seed(0);
+  return sampler_params;
+}
+
+// Returns the average time of the sampler setup of a session and of its first
+// sampling step, with a new sampler if `reuse` is false, or with the same
+// sampler reset otherwise.
+absl::Duration TimeSessionSampler(const std::vector<float>& logits,
+                                  bool reuse, int iterations) {
+  const SamplerParameters sampler_params = GetSamplerParams();
+  auto logits_tensor = CopyToTensorBuffer<float>(
+      logits, {1, static_cast<int>(logits.size())});
+  ABSL_CHECK(logits_tensor.HasValue());
+  std::vector<int> ids(1);
+  auto ids_tensor = CopyToTensorBuffer<int>(absl::MakeConstSpan(ids), {1});
+  ABSL_CHECK(ids_tensor.HasValue());
+
+  std::unique_ptr<Sampler> pooled_sampler;
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    std::unique_ptr<Sampler> sampler;
+    if (reuse && pooled_sampler != nullptr) {
+      ABSL_CHECK_OK(pooled_sampler->Reset());
+      sampler = std::move(pooled_sampler);
+    } else {
+      auto new_sampler =
+          CreateSampler(Backend::CPU, /*batch_size=*/1, sampler_params);
+      ABSL_CHECK_OK(new_sampler.status());
+      sampler = std::move(*new_sampler);
+    }
+    ABSL_CHECK_OK(sampler->SampleToIdAndScoreBuffer(
+        *logits_tensor, *ids_tensor, /*scores_tensor=*/nullptr));
+    if (reuse) {
+      pooled_sampler = std::move(sampler);
+    }
+  }
+  return (absl::Now() - start) / iterations;
+}
+
+// The TopKOpenClSampler C API functions, as declared in sampler_factory.cc.
+using OpenClSamplerCreate = int (*)(LiteRtEnvironment env, int batch_size,
+                                    int vocab_size,
+                                    const void* activation_data_type,
+                                    const void* sampler_params,
+                                    void** sampler_out, char** error_msg);
+using OpenClSamplerDestroy = void (*)(void* sampler);
+using OpenClSamplerSample = int (*)(void* sampler,
+                                    LiteRtTensorBuffer logits_tensor,
+                                    LiteRtTensorBuffer ids_tensor,
+                                    const LiteRtTensorBuffer* scores_tensor,
+                                    char** error_msg);
+
+// Returns the average time of creating and destroying an OpenCL sampler which
+// opens the C API library and looks up its functions itself, as each sampler
+// did before the C API was shared. It must run before any CreateSampler() of
+// the GPU backend, which keeps the library open.
+absl::StatusOr<absl::Duration> TimeOpenClSamplerWithOwnCApi(
+    LiteRtEnvironment env, int vocab_size, int iterations) {
+  const SamplerParameters sampler_params = GetSamplerParams();
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto lib, litert::SharedLibrary::Load(
+                      "libLiteRtTopKOpenClSampler.so",
+                      litert::RtldFlags::Lazy().Local()));
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto create_func, lib.LookupSymbol<OpenClSamplerCreate>(
+                              "LiteRtTopKOpenClSampler_Create"));
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto destroy_func, lib.LookupSymbol<OpenClSamplerDestroy>(
+                               "LiteRtTopKOpenClSampler_Destroy"));
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto sample_func,
+        lib.LookupSymbol<OpenClSamplerSample>(
+            "LiteRtTopKOpenClSampler_SampleToIdAndScoreBuffer"));
+    ABSL_CHECK(sample_func != nullptr);
+    void* sampler = nullptr;
+    char* error_msg = nullptr;
+    const int error_code = create_func(
+        env, /*batch_size=*/1, vocab_size, /*activation_data_type=*/nullptr,
+        &sampler_params, &sampler, &error_msg);
+    if (error_code != 0) {
+      absl::Status status(static_cast<absl::StatusCode>(error_code),
+                          error_msg);
+      free(error_msg);
+      return status;
+    }
+    destroy_func(sampler);
+  }
+  return (absl::Now() - start) / iterations;
+}
+
+// Returns the average time of creating and destroying an OpenCL sampler with
+// CreateSampler(), which loads the C API once for all the samplers.
+absl::Duration TimeOpenClSamplerWithSharedCApi(LiteRtEnvironment env,
+                                               int vocab_size,
+                                               int iterations) {
+  const SamplerParameters sampler_params = GetSamplerParams();
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    auto sampler = CreateSampler(Backend::GPU, /*batch_size=*/1,
+                                 sampler_params, env, vocab_size);
+    ABSL_CHECK_OK(sampler.status());
+  }
+  return (absl::Now() - start) / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const int vocab_size = absl::GetFlag(FLAGS_vocab_size);
+  const int iterations = absl::GetFlag(FLAGS_iterations);
+
+  std::vector<float> logits(vocab_size);
+  for (int i = 0; i < vocab_size; ++i) {
+    logits[i] = static_cast<float>(i % 1000) / 100.0f;
+  }
+
+  std::cout << absl::StrFormat("%16s %14s\n", "sampler", "us/session");
+  const absl::Duration created =
+      TimeSessionSampler(logits, /*reuse=*/false, iterations);
+  std::cout << absl::StrFormat("%16s %14.1f\n", "cpu created",
+                               absl::ToDoubleMicroseconds(created));
+  const absl::Duration reused =
+      TimeSessionSampler(logits, /*reuse=*/true, iterations);
+  std::cout << absl::StrFormat("%16s %14.1f\n", "cpu reused",
+                               absl::ToDoubleMicroseconds(reused));
+
+  // The OpenCL samplers are only created, since the sampling itself does not
+  // depend on how the C API is loaded.
+  auto env = litert::Environment::Create({});
+  ABSL_CHECK(env.HasValue());
+  const absl::StatusOr<absl::Duration> own_capi =
+      TimeOpenClSamplerWithOwnCApi(env->Get(), vocab_size, iterations);
+  if (!own_capi.ok()) {
+    std::cout << "OpenCL sampler unavailable: " << own_capi.status() << "\n";
+    return 0;
+  }
+  std::cout << absl::StrFormat("%16s %14.1f\n", "gpu own C API",
+                               absl::ToDoubleMicroseconds(*own_capi));
+  const absl::Duration shared_capi =
+      TimeOpenClSamplerWithSharedCApi(env->Get(), vocab_size, iterations);
+  std::cout << absl::StrFormat("%16s %14.1f\n", "gpu shared C API",
+                               absl::ToDoubleMicroseconds(shared_capi));
+  return 0;
+}
@@ -1,12 +1,14 @@
 #include "runtime/components/sampling_cpu_util.h"
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <limits>
 #include <numeric>
-#include <random>
+#include <utility>
 #include <vector>
 
 #include "absl/random/random.h"  // from @com_google_absl
@@ -17,6 +19,266 @@
 #include "absl/types/span.h"  // from @com_google_absl
 
 namespace litert::lm {
+namespace {
+
+// The number of accumulators of the vectorized reductions, enough for 256-bit
+// registers.
+constexpr int kNumLanes = 8;
+
+// The smallest argument of ExpNonPositive, above which exp() is a normal float.
+constexpr float kMinExpArgument = -87.0f;
+
+// Returns exp(x) for kMinExpArgument <= x <= 0, within a relative error of
+// 1e-6. Unlike std::exp, it has no branch or call, so that the loops over the
+// vocabulary using it are vectorized.
+inline float ExpNonPositive(float x) {
+  constexpr float kLog2E = 1.44269504088896341f;
+  // ln(2) split in a part exact in float and the rest, for the reduction.
+  constexpr float kLn2High = 0.693145751953125f;
+  constexpr float kLn2Low = 1.428606765330187e-6f;
+  // Adding and subtracting 1.5 * 2^23 rounds to the nearest integer.
+  constexpr float kRound = 12582912.0f;
+  // exp(x) = 2^n * exp(r), with |r| <= ln(2) / 2.
+  const float n = (x * kLog2E + kRound) - kRound;
+  const float r = x - n * kLn2High - n * kLn2Low;
+  // The Taylor series of exp(r), up to r^6.
+  float p = 1.0f / 720;
+  p = p * r + 1.0f / 120;
+  p = p * r + 1.0f / 24;
+  p = p * r + 1.0f / 6;
+  p = p * r + 0.5f;
+  p = p * r + 1.0f;
+  p = p * r + 1.0f;
+  const float scale =
+      std::bit_cast<float>((static_cast<int32_t>(n) + 127) << 23);
+  return p * scale;
+}
+
+// The number of logits of the chunks the vocabulary is read by. A chunk stays
+// in the L1 cache between the reductions over it.
+constexpr int kChunkSize = 1024;
+
+// Orders (logit, id) pairs by decreasing logit, and the ties by increasing id
+// like std::max_element.
+bool GreaterLogit(const std::pair<float, int>& a,
+                  const std::pair<float, int>& b) {
+  return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+// Returns the max of the logits. It reduces into kNumLanes independent
+// accumulators, so that it is vectorized.
+float MaxOfLogits(const float* logits, int size) {
+  const int vectorized_size = size - size % kNumLanes;
+  float max_lanes[kNumLanes];
+  std::fill(max_lanes, max_lanes + kNumLanes,
+            -std::numeric_limits<float>::infinity());
+  for (int i = 0; i < vectorized_size; i += kNumLanes) {
+    for (int j = 0; j < kNumLanes; ++j) {
+      max_lanes[j] =
+          logits[i + j] > max_lanes[j] ? logits[i + j] : max_lanes[j];
+    }
+  }
+  float max_logit = *std::max_element(max_lanes, max_lanes + kNumLanes);
+  for (int i = vectorized_size; i < size; ++i) {
+    max_logit = std::max(max_logit, logits[i]);
+  }
+  return max_logit;
+}
+
+// Returns the sum of exp(logit - max_logit) over the logits, where max_logit is
+// at least their max. The logits too far below the max count as
+// kMinExpArgument, which is negligible. It is vectorized like MaxOfLogits, and
+// the clamping is a loop of its own to be vectorized too.
+float SumOfExps(const float* logits, int size, float max_logit) {
+  const int vectorized_size = size - size % kNumLanes;
+  float sum_lanes[kNumLanes] = {};
+  float shifted[kNumLanes];
+  for (int i = 0; i < vectorized_size; i += kNumLanes) {
+    for (int j = 0; j < kNumLanes; ++j) {
+      shifted[j] = std::max(logits[i + j] - max_logit, kMinExpArgument);
+    }
+    for (int j = 0; j < kNumLanes; ++j) {
+      sum_lanes[j] += ExpNonPositive(shifted[j]);
+    }
+  }
+  float sum_of_exps = std::accumulate(sum_lanes, sum_lanes + kNumLanes, 0.0f);
+  for (int i = vectorized_size; i < size; ++i) {
+    sum_of_exps +=
+        ExpNonPositive(std::max(logits[i] - max_logit, kMinExpArgument));
+  }
+  return sum_of_exps;
+}
+
+// Reads the logits of a row once, chunk by chunk, and returns their
+// log-sum-exp, i.e. the log normalizer of their softmax at temperature 1. The
+// sum of the exponentials is shifted by the running max to avoid overflows,
+// and rescaled when a chunk raises the max. Along the way, it fills `top` with
+// the `num_top` largest (logit, id) pairs of the row in decreasing order of
+// logit, and `indices`, if not null, with 0, 1, 2, ...
+float ScanRow(const float* row, int vocab_size, int num_top,
+              std::vector<std::pair<float, int>>& top, int* indices) {
+  top.clear();
+  float max_logit = -std::numeric_limits<float>::infinity();
+  float sum_of_exps = 0.0f;
+  for (int start = 0; start < vocab_size; start += kChunkSize) {
+    const int size = std::min(kChunkSize, vocab_size - start);
+    const float* chunk = row + start;
+    if (indices != nullptr) {
+      std::iota(indices + start, indices + start + size, start);
+    }
+    const float chunk_max = MaxOfLogits(chunk, size);
+    if (chunk_max > max_logit) {
+      sum_of_exps *=
+          ExpNonPositive(std::max(max_logit - chunk_max, kMinExpArgument));
+      max_logit = chunk_max;
+    }
+    sum_of_exps += SumOfExps(chunk, size, max_logit);
+    // The heap of the top tokens is only updated for the rare chunks with a
+    // logit beating the smallest of them. The others are skipped at once.
+    if (num_top == 0 ||
+        (top.size() == num_top && chunk_max <= top.front().first)) {
+      continue;
+    }
+    for (int i = start; i < start + size; ++i) {
+      if (top.size() < num_top) {
+        top.emplace_back(row[i], i);
+        std::push_heap(top.begin(), top.end(), GreaterLogit);
+      } else if (row[i] > top.front().first) {
+        std::pop_heap(top.begin(), top.end(), GreaterLogit);
+        top.back() = {row[i], i};
+        std::push_heap(top.begin(), top.end(), GreaterLogit);
+      }
+    }
+  }
+  // Sorting the min-heap with its comparator orders it by decreasing logit.
+  std::sort_heap(top.begin(), top.end(), GreaterLogit);
+  return max_logit + std::log(sum_of_exps);
+}
+
+// Rearranges the ids of a row in `indices` so that the k ones with the highest
+// logits come first, in O(N) average time. The element at indices[k] is not
+// necessarily the (k+1)th largest.
+void PartitionTopK(const float* row, int k, std::vector<int>& indices) {
+  std::nth_element(
+      indices.begin(), indices.begin() + k, indices.end(),
+      [row](int i1, int i2) { return row[i1] > row[i2]; });
+}
+
+absl::Status ValidateSamplingInputs(absl::Span<const float> logits, int k,
+                                    float p,
+                                    absl::Span<const double> random_values,
+                                    int batch_size) {
+  if (logits.empty()) {
+    return absl::InvalidArgumentError("Logits vector cannot be empty.");
+  }
+  if (logits.size() % batch_size != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Logits vector size must be a multiple of batch "
+                        "size. But got %d and "
+                        "%d.",
+                        logits.size(), batch_size));
+  }
+  if (k <= 0) {
+    return absl::InvalidArgumentError("k must be greater than 0.");
+  }
+  if (p < 0.0 || p > 1.0) {
+    return absl::InvalidArgumentError("p must be in the range [0.0, 1.0].");
+  }
+  if (random_values.size() != batch_size) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("There must be one random value per batch. But got "
+                        "%d and %d.",
+                        random_values.size(), batch_size));
+  }
+  return absl::OkStatus();
+}
+
+// Samples a token id of each batch among its top k ones, given by
+// `topk_indices` of shape [batch_size, k], as TopKTopPSampling does.
+absl::StatusOr<std::vector<int>> SampleFromTopK(
+    absl::Span<const float> logits, absl::Span<const int> topk_indices, int k,
+    float p, float temperature, absl::Span<const double> random_values,
+    int batch_size, std::vector<float>& sampled_scores) {
+  const int vocab_size = logits.size() / batch_size;
+  std::vector<float> max_logit_values;
+  auto probabilities =
+      Softmax(logits, topk_indices, temperature, batch_size, max_logit_values);
+  if (!probabilities.ok()) return probabilities.status();
+
+  std::vector<int> sampled_ids;
+  if (k == 1) {  // Greedy sampling. Return the topk_indices directly.
+    sampled_ids.assign(topk_indices.begin(), topk_indices.end());
+    sampled_scores = std::vector<float>(batch_size, 1.0f);
+    return sampled_ids;
+  }
+  sampled_ids.resize(batch_size);
+  sampled_scores.resize(batch_size);
+  // The positions of the top k of a batch, in decreasing probability order.
+  std::vector<int> order(k);
+  for (int b = 0; b < batch_size; ++b) {
+    // Define the comparator for descending probability
+    auto desc_prob_comp = [&probabilities, k, b](int i1, int i2) {
+      return (*probabilities)[b * k + i1] > (*probabilities)[b * k + i2];
+    };
+
+    // Sort Only the Top-K.
+    // O(k log k) time complexity.
+    // Sorts the positions of the top k in the batch, so that the
+    // probabilities and the indices at the same position stay paired.
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), desc_prob_comp);
+
+    // Determine Top-P Cutoff Index within Top-K.
+    // O(k) time complexity.
+    double cumulative_prob = 0.0;
+    double nucleus_sum = 0.0;
+    int final_nucleus_size = 0;  // Actual number of elements to sample from
+
+    for (int i = 0; i < k; ++i) {
+      // Check if adding this probability would exceed the threshold p. It
+      // stops when cumulative_prob >= p.
+      cumulative_prob += (*probabilities)[b * k + order[i]];
+      nucleus_sum += (*probabilities)[b * k + order[i]];
+      final_nucleus_size = i + 1;  // Include this element
+
+      if (cumulative_prob >= p) {
+        break;  // Found the smallest set within Top-K satisfying Top-P
+      }
+    }
+    // final_nucleus_size now holds min(p_cutoff_within_top_k, k)
+
+    // Handle Edge Case: Zero Nucleus Sum.
+    if (nucleus_sum <= std::numeric_limits<double>::epsilon()) {
+      // Fallback: Return the index with the absolute highest probability
+      // (indices[0] after sorting top-k).
+      sampled_ids[b] = topk_indices[b * k + order[0]];
+      sampled_scores[b] = std::exp(
+          (logits[b * vocab_size + sampled_ids[b]] - max_logit_values[b]) /
+          temperature);
+      continue;
+    }
+
+    // O(final_nucleus_size) which is O(k) time complexity.
+    const double random_sample = random_values[b] * nucleus_sum;
+    double current_cumulative = 0.0;
+    for (int i = 0; i < final_nucleus_size; ++i) {
+      current_cumulative += (*probabilities)[b * k + order[i]];
+      // The last element is taken if the rounding errors leave the random
+      // sample above the cumulative sum.
+      if (random_sample <= current_cumulative ||
+          i == final_nucleus_size - 1) {
+        sampled_ids[b] = topk_indices[b * k + order[i]];
+        sampled_scores[b] = std::exp(
+            (logits[b * vocab_size + sampled_ids[b]] - max_logit_values[b]) /
+            temperature);
+        break;
+      }
+    }
+  }
+  return sampled_ids;
+}
+
+}  // namespace
 
 absl::StatusOr<std::vector<int>> TopKIndicies(absl::Span<const float> logits,
                                               int k, int batch_size) {
@@ -44,18 +306,7 @@ absl::StatusOr<std::vector<int>> TopKIndicies(absl::Span<const float> logits,
     for (int b = 0; b < batch_size; ++b) {
       // Fill with 0, 1, 2,...
       std::iota(indices.begin(), indices.end(), 0);
-
-      // Define the comparator for descending probability
-      auto desc_prob_comp = [&logits, vocab_size, b](int i1, int i2) {
-        return logits[b * vocab_size + i1] > logits[b * vocab_size + i2];
-      };
-      // Partition Top-K.
-      // O(N) average time complexity.
-      // Rearranges 'indices' such that the k elements with the highest
-      // probabilities are in the range [indices.begin(), indices.begin() +
-      // k). The element at indices[k] is not necessarily the (k+1)th largest.
-      std::nth_element(indices.begin(), indices.begin() + k, indices.end(),
-                       desc_prob_comp);
+      PartitionTopK(logits.data() + b * vocab_size, k, indices);
       std::copy(indices.begin(), indices.begin() + k,
                 output_indices.begin() + b * k);
     }
@@ -136,22 +387,21 @@ absl::StatusOr<std::vector<float>> Softmax(
 absl::StatusOr<std::vector<int>> TopKTopPSampling(
     absl::Span<const float> logits, int k, float p, float temperature,
     absl::BitGen& rng, int batch_size, std::vector<float>& sampled_scores) {
-  if (logits.empty()) {
-    return absl::InvalidArgumentError("Logits vector cannot be empty.");
-  }
-  if (logits.size() % batch_size != 0) {
-    return absl::InvalidArgumentError(
-        absl::StrFormat("Logits vector size must be a multiple of batch "
-                        "size. But got %d and "
-                        "%d.",
-                        logits.size(), batch_size));
-  }
-  if (k <= 0) {
-    return absl::InvalidArgumentError("k must be greater than 0.");
-  }
-  if (p < 0.0 || p > 1.0) {
-    return absl::InvalidArgumentError("p must be in the range [0.0, 1.0].");
+  std::vector<double> random_values(batch_size);
+  for (double& random_value : random_values) {
+    random_value = absl::Uniform<double>(rng, 0.0, 1.0);
   }
+  return TopKTopPSampling(logits, k, p, temperature, random_values, batch_size,
+                          sampled_scores);
+}
+
+absl::StatusOr<std::vector<int>> TopKTopPSampling(
+    absl::Span<const float> logits, int k, float p, float temperature,
+    absl::Span<const double> random_values, int batch_size,
+    std::vector<float>& sampled_scores) {
+  auto status =
+      ValidateSamplingInputs(logits, k, p, random_values, batch_size);
+  if (!status.ok()) return status;
   const int vocab_size = logits.size() / batch_size;
   // Ensure k is not larger than the number of probabilities
   k = std::min(k, vocab_size);
@@ -159,77 +409,122 @@ absl::StatusOr<std::vector<int>> TopKTopPSampling(
   auto topk_indices = TopKIndicies(logits, k, batch_size);
   if (!topk_indices.ok()) return topk_indices.status();
 
-  std::vector<float> max_logit_values;
-  auto probabilities =
-      Softmax(logits, *topk_indices, temperature, batch_size, max_logit_values);
-  if (!probabilities.ok()) return probabilities.status();
+  return SampleFromTopK(logits, *topk_indices, k, p, temperature,
+                        random_values, batch_size, sampled_scores);
+}
 
-  std::vector<int> sampled_ids;
-  if (k == 1) {  // Greedy sampling. Return the topk_indices directly.
-    sampled_ids.assign(topk_indices->begin(), topk_indices->end());
-    sampled_scores = std::vector<float>(batch_size, 1.0f);
-    return sampled_ids;
+absl::StatusOr<std::vector<int>> TopKTopPSamplingWithLogProbs(
+    absl::Span<const float> logits, int k, float p, float temperature,
+    absl::Span<const double> random_values, int batch_size,
+    std::vector<float>& sampled_scores, int num_top,
+    std::vector<float>& sampled_log_probs, std::vector<int>& top_ids,
+    std::vector<float>& top_log_probs) {
+  auto status =
+      ValidateSamplingInputs(logits, k, p, random_values, batch_size);
+  if (!status.ok()) return status;
+  if (num_top < 0) {
+    return absl::InvalidArgumentError("num_top cannot be negative.");
   }
-  sampled_ids.resize(batch_size);
-  sampled_scores.resize(batch_size);
-  for (int b = 0; b < batch_size; ++b) {
-    // Define the comparator for descending probability
-    auto desc_prob_comp = [&probabilities, k, b](int i1, int i2) {
-      return (*probabilities)[b * k + i1] > (*probabilities)[b * k + i2];
-    };
-
-    // Sort Only the Top-K.
-    // O(k log k) time complexity.
-    // Sorts only the first k indices, which now correspond to the top k
-    // probabilities.
-    std::sort((*topk_indices).begin() + b * k,
-              (*topk_indices).begin() + (b * 1) * k, desc_prob_comp);
-
-    // Determine Top-P Cutoff Index within Top-K.
-    // O(k) time complexity.
-    double cumulative_prob = 0.0;
-    double nucleus_sum = 0.0;
-    int final_nucleus_size = 0;  // Actual number of elements to sample from
-
-    for (int i = 0; i < k; ++i) {
-      // Check if adding this probability would exceed the threshold p. It
-      // stops when cumulative_prob >= p.
-      cumulative_prob += (*probabilities)[b * k + i];
-      nucleus_sum += (*probabilities)[b * k + i];
-      final_nucleus_size = i + 1;  // Include this element
+  const int vocab_size = logits.size() / batch_size;
+  k = std::min(k, vocab_size);
+  num_top = std::min(num_top, vocab_size);
+  top_ids.resize(batch_size * num_top);
+  top_log_probs.resize(batch_size * num_top);
 
-      if (cumulative_prob >= p) {
-        break;  // Found the smallest set within Top-K satisfying Top-P
+  // The top k and the log normalizer of each batch are found in the same pass
+  // over its logits. With k == 1, the scan itself keeps the max logit as the
+  // first top token, and gathers the top tokens. Otherwise, the scan fills the
+  // ids to partition, and the top tokens are the first ones of the top k,
+  // unless there are more of them than k, in which case the scan gathers them.
+  std::vector<int> topk_indices(batch_size * k);
+  std::vector<float> log_normalizers(batch_size);
+  std::vector<int> indices(k == 1 ? 0 : vocab_size);
+  std::vector<std::pair<float, int>> top;
+  for (int b = 0; b < batch_size; ++b) {
+    const float* row = logits.data() + b * vocab_size;
+    if (k == 1) {
+      log_normalizers[b] = ScanRow(row, vocab_size, std::max(num_top, 1), top,
+                                   /*indices=*/nullptr);
+      topk_indices[b] = top[0].second;
+    } else {
+      log_normalizers[b] = ScanRow(row, vocab_size, num_top > k ? num_top : 0,
+                                   top, indices.data());
+      PartitionTopK(row, k, indices);
+      std::copy(indices.begin(), indices.begin() + k,
+                topk_indices.begin() + b * k);
+      if (num_top <= k) {
+        top.clear();
+        for (int i = 0; i < k; ++i) {
+          top.emplace_back(row[indices[i]], indices[i]);
+        }
+        std::partial_sort(top.begin(), top.begin() + num_top, top.end(),
+                          GreaterLogit);
       }
     }
-    // final_nucleus_size now holds min(p_cutoff_within_top_k, k)
-
-    // Handle Edge Case: Zero Nucleus Sum.
-    if (nucleus_sum <= std::numeric_limits<double>::epsilon()) {
-      // Fallback: Return the index with the absolute highest probability
-      // (indices[0] after sorting top-k).
-      sampled_ids[b] = (*topk_indices)[b * k];
-      sampled_scores[b] = std::exp(
-          (logits[b * vocab_size + sampled_ids[b]] - max_logit_values[b]) /
-          temperature);
-      continue;
+    for (int i = 0; i < num_top; ++i) {
+      top_ids[b * num_top + i] = top[i].second;
+      top_log_probs[b * num_top + i] = top[i].first - log_normalizers[b];
     }
+  }
 
-    // O(final_nucleus_size) which is O(k) time complexity.
-    std::uniform_real_distribution<double> dist(0.0, nucleus_sum);
-    double random_sample = dist(rng);
-    double current_cumulative = 0.0;
-    for (int i = 0; i < final_nucleus_size; ++i) {
-      current_cumulative += (*probabilities)[b * k + i];
-      if (random_sample <= current_cumulative) {
-        sampled_ids[b] = (*topk_indices)[b * k + i];
-        sampled_scores[b] = std::exp(
-            (logits[b * vocab_size + sampled_ids[b]] - max_logit_values[b]) /
-            temperature);
-      }
-    }
+  auto sampled_ids = SampleFromTopK(logits, topk_indices, k, p, temperature,
+                                    random_values, batch_size, sampled_scores);
+  if (!sampled_ids.ok()) return sampled_ids.status();
+  // The log probabilities are only computed for the sampled ids.
+  sampled_log_probs.resize(batch_size);
+  for (int b = 0; b < batch_size; ++b) {
+    sampled_log_probs[b] =
+        logits[b * vocab_size + (*sampled_ids)[b]] - log_normalizers[b];
   }
   return sampled_ids;
 }
 
+absl::Status ComputeLogProbs(absl::Span<const float> logits,
+                             absl::Span<const int> sampled_ids, int num_top,
+                             int batch_size,
+                             std::vector<float>& sampled_log_probs,
+                             std::vector<int>& top_ids,
+                             std::vector<float>& top_log_probs) {
+  if (logits.empty()) {
+    return absl::InvalidArgumentError("Logits vector cannot be empty.");
+  }
+  if (logits.size() % batch_size != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Logits vector size must be a multiple of batch "
+                        "size. But got %d and %d.",
+                        logits.size(), batch_size));
+  }
+  if (sampled_ids.size() != batch_size) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected %d sampled ids, but got %d.", batch_size,
+                        sampled_ids.size()));
+  }
+  if (num_top < 0) {
+    return absl::InvalidArgumentError("num_top cannot be negative.");
+  }
+  const int vocab_size = logits.size() / batch_size;
+  num_top = std::min(num_top, vocab_size);
+  sampled_log_probs.resize(batch_size);
+  top_ids.resize(batch_size * num_top);
+  top_log_probs.resize(batch_size * num_top);
+
+  std::vector<std::pair<float, int>> top;
+  for (int b = 0; b < batch_size; ++b) {
+    const float* row = logits.data() + b * vocab_size;
+    if (sampled_ids[b] < 0 || sampled_ids[b] >= vocab_size) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Sampled id %d is out of the vocabulary of size %d.",
+          sampled_ids[b], vocab_size));
+    }
+    const float log_normalizer =
+        ScanRow(row, vocab_size, num_top, top, /*indices=*/nullptr);
+    sampled_log_probs[b] = row[sampled_ids[b]] - log_normalizer;
+    for (int i = 0; i < num_top; ++i) {
+      top_ids[b * num_top + i] = top[i].second;
+      top_log_probs[b * num_top + i] = top[i].first - log_normalizer;
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace litert::lm
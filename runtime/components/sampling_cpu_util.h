@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "absl/random/random.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/types/span.h"  // from @com_google_absl
 
@@ -47,6 +48,46 @@ absl::StatusOr<std::vector<int>> TopKTopPSampling(
     absl::Span<const float> logits, int k, float p, float temperature,
     absl::BitGen& rng, int batch_size, std::vector<float>& sampled_scores);
 
+// Same as above, but with the random number of each batch given in
+// `random_values`, of shape [batch_size] and uniform in [0, 1), e.g. drawn by
+// a counter-based generator so that the sampling is reproducible.
+absl::StatusOr<std::vector<int>> TopKTopPSampling(
+    absl::Span<const float> logits, int k, float p, float temperature,
+    absl::Span<const double> random_values, int batch_size,
+    std::vector<float>& sampled_scores);
+
+// Same as above, and also computes the log probabilities of the sampled ids
+// and of the `num_top` most likely tokens, as ComputeLogProbs does. The
+// log-sum-exp of each batch is accumulated in the pass over the logits that
+// selects the top k, so the logits are read once. The log probabilities are
+// then only computed for the sampled ids and the top tokens.
+absl::StatusOr<std::vector<int>> TopKTopPSamplingWithLogProbs(
+    absl::Span<const float> logits, int k, float p, float temperature,
+    absl::Span<const double> random_values, int batch_size,
+    std::vector<float>& sampled_scores, int num_top,
+    std::vector<float>& sampled_log_probs, std::vector<int>& top_ids,
+    std::vector<float>& top_log_probs);
+
+// Computes the log probabilities of the sampled ids and of the most likely
+// tokens, under the softmax of the whole vocabulary (at temperature 1).
+//   - logits: a 2D tensor (in a flattened buffer) of shape
+//     [batch_size, vocab_size]. It is read in place and once, chunk by chunk,
+//     for both the log-sum-exp and the top tokens.
+//   - sampled_ids: the sampled token id of each batch, of shape [batch_size].
+//   - num_top: the number of most likely tokens to return per batch.
+//   - batch_size: the batch size of the logits.
+//   - sampled_log_probs: this is an output parameter to store the log
+//     probabilities of the sampled ids, of shape [batch_size].
+//   - top_ids, top_log_probs: these are output parameters to store the ids and
+//     log probabilities of the `num_top` most likely tokens of each batch, in
+//     decreasing order, of shape [batch_size, num_top].
+absl::Status ComputeLogProbs(absl::Span<const float> logits,
+                             absl::Span<const int> sampled_ids, int num_top,
+                             int batch_size,
+                             std::vector<float>& sampled_log_probs,
+                             std::vector<int>& top_ids,
+                             std::vector<float>& top_log_probs);
+
 }  // namespace litert::lm
 
 #endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_SAMPLING_CPU_UTIL_H_
@@ -0,0 +1,103 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This tool measures the cost of the CPU sampling of one decode step, with and
+// without the log probabilities of the sampled token and of the top N tokens.
+//
+// Example usage:
+// bazel run -c opt :sampling_cpu_util_benchmark -- --vocab_size=262144
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"  // from @com_google_absl
+#include "absl/flags/parse.h"  // from @com_google_absl
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/random/random.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/components/sampling_cpu_util.h"
+
+ABSL_FLAG(int, vocab_size, 262144, "The vocabulary size of the logits.");
+
+ABSL_FLAG(int, iterations, 200, "The number of sampling steps to average.");
+
+namespace {
+
+using ::litert::lm::TopKTopPSampling;
+using ::litert::lm::TopKTopPSamplingWithLogProbs;
+
+// Returns the average time of a sampling step with top-k `k`, and with the
+// log probabilities of `num_top` tokens if `num_top` is not negative.
+absl::Duration TimeSampling(absl::Span<const float> logits, int k,
+                            int num_top, int iterations) {
+  absl::BitGen rng;
+  std::vector<double> random_values(1);
+  std::vector<float> sampled_scores;
+  std::vector<float> sampled_log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    random_values[0] = absl::Uniform<double>(rng, 0.0, 1.0);
+    auto sampled_ids =
+        num_top >= 0
+            ? TopKTopPSamplingWithLogProbs(
+                  logits, k, /*p=*/0.95f, /*temperature=*/1.0f, random_values,
+                  /*batch_size=*/1, sampled_scores, num_top, sampled_log_probs,
+                  top_ids, top_log_probs)
+            : TopKTopPSampling(logits, k, /*p=*/0.95f, /*temperature=*/1.0f,
+                               random_values, /*batch_size=*/1,
+                               sampled_scores);
+    ABSL_CHECK_OK(sampled_ids.status());
+  }
+  return (absl::Now() - start) / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const int vocab_size = absl::GetFlag(FLAGS_vocab_size);
+  const int iterations = absl::GetFlag(FLAGS_iterations);
+
+  // Logits in the range of a real model's, with a few likely tokens.
+  absl::BitGen rng;
+  std::vector<float> logits(vocab_size);
+  for (float& logit : logits) {
+    logit = absl::Gaussian<float>(rng, 0.0f, 3.0f);
+  }
+
+  std::cout << absl::StrFormat("%6s %8s %12s %10s\n", "top-k", "logprobs",
+                               "us/step", "overhead");
+  for (int k : {1, 40}) {
+    const absl::Duration baseline =
+        TimeSampling(logits, k, /*num_top=*/-1, iterations);
+    std::cout << absl::StrFormat("%6d %8s %12.1f %10s\n", k, "off",
+                                 absl::ToDoubleMicroseconds(baseline), "");
+    for (int num_top : {0, 1, 5, 20}) {
+      const absl::Duration duration =
+          TimeSampling(logits, k, num_top, iterations);
+      std::cout << absl::StrFormat(
+          "%6d %8s %12.1f %9.1f%%\n", k, absl::StrCat("top ", num_top),
+          absl::ToDoubleMicroseconds(duration),
+          100.0 * (duration - baseline) / baseline);
+    }
+  }
+  return 0;
+}
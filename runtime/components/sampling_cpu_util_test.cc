@@ -1,5 +1,6 @@
 #include "runtime/components/sampling_cpu_util.h"
 
+#include <cmath>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -11,6 +12,8 @@ namespace litert::lm {
 namespace {
 
 using ::testing::ElementsAre;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
 using ::testing::UnorderedElementsAre;
 
 TEST(SamplingCpuUtilTest, TopKIndicies_BatchSize1) {
@@ -141,5 +144,182 @@ TEST(SamplingCpuUtilTest, TopKTopPSampling_BatchSize2) {
   EXPECT_THAT(sampled_scores, ElementsAre(1.0, 1.0, 1.0));
 }
 
+TEST(SamplingCpuUtilTest, TopKTopPSampling_GivenRandomValues) {
+  // The probabilities of the ids 0, 1, 2, 3 are 0.1, 0.2, 0.3, 0.4 in each
+  // batch, so the cumulative probabilities in decreasing order are 0.4 (id 3),
+  // 0.7 (id 2), 0.9 (id 1) and 1.0 (id 0).
+  std::vector<float> logits;
+  for (int b = 0; b < 3; ++b) {
+    for (float probability : {0.1f, 0.2f, 0.3f, 0.4f}) {
+      logits.push_back(std::log(probability));
+    }
+  }
+  const std::vector<double> random_values = {0.1, 0.5, 0.95};
+  std::vector<float> sampled_scores;
+  auto sampled_ids = TopKTopPSampling(
+      absl::MakeConstSpan(logits), /*k=*/4, /*p=*/1.0,
+      /*temperature=*/1.0f, absl::MakeConstSpan(random_values),
+      /*batch_size=*/3, sampled_scores);
+  ASSERT_TRUE(sampled_ids.ok());
+  EXPECT_THAT((*sampled_ids), ElementsAre(3, 2, 0));
+
+  // One random value per batch is required.
+  sampled_ids = TopKTopPSampling(
+      absl::MakeConstSpan(logits), /*k=*/4, /*p=*/1.0,
+      /*temperature=*/1.0f, absl::MakeConstSpan(random_values).subspan(1),
+      /*batch_size=*/3, sampled_scores);
+  EXPECT_FALSE(sampled_ids.ok());
+}
+
+TEST(SamplingCpuUtilTest, ComputeLogProbs_BatchSize2) {
+  const std::vector<float> logits = {0.0, 1.0, 2.0, 1.0,   //
+                                     3.0, 0.0, 0.0, 0.0};
+  const std::vector<int> sampled_ids = {3, 0};
+  std::vector<float> sampled_log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  EXPECT_TRUE(ComputeLogProbs(absl::MakeConstSpan(logits),
+                              absl::MakeConstSpan(sampled_ids), /*num_top=*/2,
+                              /*batch_size=*/2, sampled_log_probs, top_ids,
+                              top_log_probs)
+                  .ok());
+  const float log_sum_0 = std::log(1 + 2 * std::exp(1.0f) + std::exp(2.0f));
+  const float log_sum_1 = std::log(std::exp(3.0f) + 3);
+  EXPECT_THAT(sampled_log_probs,
+              Pointwise(FloatNear(1e-5), {1.0f - log_sum_0, 3.0f - log_sum_1}));
+  // The ties are in any order.
+  EXPECT_EQ(top_ids[0], 2);
+  EXPECT_THAT(top_ids[1], testing::AnyOf(1, 3));
+  EXPECT_EQ(top_ids[2], 0);
+  EXPECT_THAT(top_log_probs,
+              Pointwise(FloatNear(1e-5), {2.0f - log_sum_0, 1.0f - log_sum_0,
+                                          3.0f - log_sum_1, -log_sum_1}));
+}
+
+TEST(SamplingCpuUtilTest, ComputeLogProbs_NumTopLargerThanVocab) {
+  const std::vector<float> logits = {0.0, 0.0};
+  const std::vector<int> sampled_ids = {1};
+  std::vector<float> sampled_log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  EXPECT_TRUE(ComputeLogProbs(absl::MakeConstSpan(logits),
+                              absl::MakeConstSpan(sampled_ids), /*num_top=*/5,
+                              /*batch_size=*/1, sampled_log_probs, top_ids,
+                              top_log_probs)
+                  .ok());
+  EXPECT_THAT(sampled_log_probs,
+              Pointwise(FloatNear(1e-5), {std::log(0.5f)}));
+  EXPECT_THAT(top_ids, UnorderedElementsAre(0, 1));
+}
+
+TEST(SamplingCpuUtilTest, ComputeLogProbs_InvalidInputs) {
+  const std::vector<float> logits = {0.0, 1.0, 2.0};
+  std::vector<float> sampled_log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  const std::vector<int> out_of_vocab = {3};
+  EXPECT_FALSE(ComputeLogProbs(absl::MakeConstSpan(logits),
+                               absl::MakeConstSpan(out_of_vocab),
+                               /*num_top=*/1, /*batch_size=*/1,
+                               sampled_log_probs, top_ids, top_log_probs)
+                   .ok());
+  const std::vector<int> too_many_ids = {0, 1};
+  EXPECT_FALSE(ComputeLogProbs(absl::MakeConstSpan(logits),
+                               absl::MakeConstSpan(too_many_ids),
+                               /*num_top=*/1, /*batch_size=*/1,
+                               sampled_log_probs, top_ids, top_log_probs)
+                   .ok());
+}
+
+TEST(SamplingCpuUtilTest, TopKTopPSamplingWithLogProbs_MatchesTwoPasses) {
+  // Several chunks of logits, the last one partial, with the max of the
+  // second batch in its last chunk.
+  constexpr int kVocabSize = 3001;
+  absl::BitGen rng;
+  std::vector<float> logits(2 * kVocabSize);
+  for (float& logit : logits) {
+    logit = absl::Gaussian<float>(rng, 0.0f, 3.0f);
+  }
+  logits[2 * kVocabSize - 1] = 20.0f;
+  const std::vector<double> random_values = {0.3, 0.8};
+  for (int k : {1, 3, 40}) {
+    for (int num_top : {0, 1, 5}) {
+      std::vector<float> sampled_scores;
+      auto sampled_ids = TopKTopPSampling(
+          absl::MakeConstSpan(logits), k, /*p=*/0.9, /*temperature=*/0.7f,
+          absl::MakeConstSpan(random_values), /*batch_size=*/2,
+          sampled_scores);
+      ASSERT_TRUE(sampled_ids.ok());
+      std::vector<float> sampled_log_probs;
+      std::vector<int> top_ids;
+      std::vector<float> top_log_probs;
+      ASSERT_TRUE(ComputeLogProbs(absl::MakeConstSpan(logits),
+                                  absl::MakeConstSpan(*sampled_ids), num_top,
+                                  /*batch_size=*/2, sampled_log_probs, top_ids,
+                                  top_log_probs)
+                      .ok());
+
+      std::vector<float> fused_sampled_scores;
+      std::vector<float> fused_sampled_log_probs;
+      std::vector<int> fused_top_ids;
+      std::vector<float> fused_top_log_probs;
+      auto fused_sampled_ids = TopKTopPSamplingWithLogProbs(
+          absl::MakeConstSpan(logits), k, /*p=*/0.9, /*temperature=*/0.7f,
+          absl::MakeConstSpan(random_values), /*batch_size=*/2,
+          fused_sampled_scores, num_top, fused_sampled_log_probs,
+          fused_top_ids, fused_top_log_probs);
+      ASSERT_TRUE(fused_sampled_ids.ok());
+      EXPECT_EQ(*fused_sampled_ids, *sampled_ids);
+      for (int b = 0; b < 2; ++b) {
+        double sum_of_exps = 0.0;
+        for (int i = b * kVocabSize; i < (b + 1) * kVocabSize; ++i) {
+          sum_of_exps += std::exp(static_cast<double>(logits[i]));
+        }
+        EXPECT_NEAR(fused_sampled_log_probs[b],
+                    logits[b * kVocabSize + (*sampled_ids)[b]] -
+                        std::log(sum_of_exps),
+                    1e-4);
+      }
+      EXPECT_THAT(fused_sampled_scores,
+                  Pointwise(FloatNear(1e-6), sampled_scores));
+      EXPECT_THAT(fused_sampled_log_probs,
+                  Pointwise(FloatNear(1e-4), sampled_log_probs));
+      EXPECT_EQ(fused_top_ids, top_ids);
+      EXPECT_THAT(fused_top_log_probs,
+                  Pointwise(FloatNear(1e-4), top_log_probs));
+    }
+  }
+
+  std::vector<float> sampled_scores;
+  std::vector<float> sampled_log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  EXPECT_FALSE(TopKTopPSamplingWithLogProbs(
+                   absl::MakeConstSpan(logits), /*k=*/1, /*p=*/0.9,
+                   /*temperature=*/1.0f, absl::MakeConstSpan(random_values),
+                   /*batch_size=*/2, sampled_scores, /*num_top=*/-1,
+                   sampled_log_probs, top_ids, top_log_probs)
+                   .ok());
+}
+
+TEST(SamplingCpuUtilTest, TopKTopPSamplingWithLogProbs_GreedyTies) {
+  // The first of the max logits is sampled, as with std::max_element.
+  const std::vector<float> logits = {0.0, 2.0, 1.0, 2.0};
+  const std::vector<double> random_values = {0.5};
+  std::vector<float> sampled_scores;
+  std::vector<float> sampled_log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  auto sampled_ids = TopKTopPSamplingWithLogProbs(
+      absl::MakeConstSpan(logits), /*k=*/1, /*p=*/1.0, /*temperature=*/1.0f,
+      absl::MakeConstSpan(random_values), /*batch_size=*/1, sampled_scores,
+      /*num_top=*/3, sampled_log_probs, top_ids, top_log_probs);
+  ASSERT_TRUE(sampled_ids.ok());
+  EXPECT_THAT(*sampled_ids, ElementsAre(1));
+  EXPECT_THAT(top_ids, ElementsAre(1, 3, 2));
+  const float log_sum = std::log(1 + std::exp(1.0f) + 2 * std::exp(2.0f));
+  EXPECT_THAT(sampled_log_probs, Pointwise(FloatNear(1e-5), {2.0f - log_sum}));
+}
+
 }  // namespace
 }  // namespace litert::lm
@@ -1,6 +1,8 @@
 #include "runtime/components/token_id_util.h"
 
 #include <algorithm>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"  // from @com_google_absl
@@ -10,20 +12,162 @@
 
 namespace litert::lm {
 
-absl::Status PreprocessTokenIds(std::vector<int>& token_ids, int start_token_id,
-                                int max_num_tokens,
-                                float context_length_ratio_threhold) {
-  if (token_ids.size() + 1 > max_num_tokens * context_length_ratio_threhold) {
-    return absl::InvalidArgumentError(absl::StrFormat(
-        "The input context length is too long. The input token length is %d "
-        "and the max_num_tokens is %d.",
-        token_ids.size() + 1, max_num_tokens));
+namespace {
+
+// Replaces the token ids with the start token (if any) followed by the token
+// ids outside of [erase_begin, erase_end). Each kept token is moved at most
+// once: the start token takes one of the erased slots when there is one.
+void CompactTokenIds(std::vector<int>& token_ids,
+                     std::optional<int> start_token_id, int erase_begin,
+                     int erase_end) {
+  if (!start_token_id.has_value()) {
+    token_ids.erase(token_ids.begin() + erase_begin,
+                    token_ids.begin() + erase_end);
+    return;
+  }
+  if (erase_begin == erase_end) {
+    token_ids.insert(token_ids.begin(), *start_token_id);
+    return;
+  }
+  std::copy_backward(token_ids.begin(), token_ids.begin() + erase_begin,
+                     token_ids.begin() + erase_begin + 1);
+  token_ids[0] = *start_token_id;
+  token_ids.erase(token_ids.begin() + erase_begin + 1,
+                  token_ids.begin() + erase_end);
+}
+
+absl::Status TooLongError(int num_tokens, int max_num_tokens) {
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "The input context length is too long. The input token length is %d "
+      "and the max_num_tokens is %d.",
+      num_tokens, max_num_tokens));
+}
+
+// Fits the token ids to the context. The first `num_leading_start_tokens`
+// (0 or 1) token ids are a start token already in place, which is kept, and
+// `start_token_id` is prepended otherwise, if set. The indices of
+// `turn_starts` and of the erased ranges count the leading start token.
+absl::Status FitTokenIds(std::vector<int>& token_ids,
+                         int num_leading_start_tokens,
+                         std::optional<int> start_token_id,
+                         int max_num_tokens,
+                         const ContextOverflowOptions& overflow_options,
+                         absl::Span<const int> turn_starts) {
+  const int offset = num_leading_start_tokens;
+  const int num_tokens = static_cast<int>(token_ids.size()) - offset;
+  const int num_start_tokens = offset + (start_token_id.has_value() ? 1 : 0);
+  if (num_tokens + num_start_tokens <= max_num_tokens) {
+    if (start_token_id.has_value()) {
+      CompactTokenIds(token_ids, start_token_id, 0, 0);
+    }
+    return absl::OkStatus();
+  }
+  // The number of tokens that can be kept besides the start token.
+  const int budget = max_num_tokens - num_start_tokens;
+  if (budget <= 0) {
+    return TooLongError(num_tokens + num_start_tokens, max_num_tokens);
+  }
+
+  int num_head_tokens = 0;
+  switch (overflow_options.policy) {
+    case ContextOverflowPolicy::kError:
+      return TooLongError(num_tokens + num_start_tokens, max_num_tokens);
+    case ContextOverflowPolicy::kKeepHeadAndTail:
+      num_head_tokens = std::clamp(overflow_options.num_head_tokens, 0, budget);
+      break;
+    case ContextOverflowPolicy::kMiddleOut:
+      num_head_tokens = (budget + 1) / 2;
+      break;
+    case ContextOverflowPolicy::kDropOldestTurns: {
+      if (turn_starts.empty()) {
+        return absl::InvalidArgumentError(
+            "Cannot drop the oldest turns without the turn boundaries.");
+      }
+      // The tokens before the first turn are always kept.
+      const int num_leading_tokens = turn_starts.front() - offset;
+      for (int turn_start : turn_starts.subspan(1)) {
+        const int num_turn_tokens =
+            static_cast<int>(token_ids.size()) - turn_start;
+        if (num_leading_tokens + num_turn_tokens <= budget) {
+          CompactTokenIds(token_ids, start_token_id, turn_starts.front(),
+                          turn_start);
+          return absl::OkStatus();
+        }
+      }
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "The input context length is too long even with only the last turn "
+          "kept. The input token length is %d and the max_num_tokens is %d.",
+          num_tokens + num_start_tokens, max_num_tokens));
+    }
+    case ContextOverflowPolicy::kCallback: {
+      if (!overflow_options.compression_callback) {
+        return absl::InvalidArgumentError(
+            "No context compression callback is set.");
+      }
+      // The callback is given the token ids without the start token.
+      std::vector<int> callback_turn_starts(turn_starts.begin(),
+                                            turn_starts.end());
+      for (int& turn_start : callback_turn_starts) {
+        turn_start -= offset;
+      }
+      std::vector<int> callback_token_ids;
+      if (offset == 0) {
+        callback_token_ids = std::move(token_ids);
+      } else {
+        callback_token_ids.assign(token_ids.begin() + offset, token_ids.end());
+      }
+      auto compressed_token_ids = overflow_options.compression_callback(
+          std::move(callback_token_ids), callback_turn_starts, budget);
+      if (!compressed_token_ids.ok()) {
+        return compressed_token_ids.status();
+      }
+      if (compressed_token_ids->size() > static_cast<size_t>(budget)) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "The compressed context is still too long: %d tokens for at most "
+            "%d tokens.",
+            compressed_token_ids->size(), budget));
+      }
+      if (offset == 0) {
+        token_ids = *std::move(compressed_token_ids);
+        if (start_token_id.has_value()) {
+          CompactTokenIds(token_ids, start_token_id, 0, 0);
+        }
+      } else {
+        token_ids.resize(offset);
+        token_ids.insert(token_ids.end(), compressed_token_ids->begin(),
+                         compressed_token_ids->end());
+      }
+      return absl::OkStatus();
+    }
   }
-  // Prepend the start token id to the token ids.
-  token_ids.insert(token_ids.begin(), start_token_id);
+  CompactTokenIds(token_ids, start_token_id, offset + num_head_tokens,
+                  offset + num_tokens - (budget - num_head_tokens));
   return absl::OkStatus();
 }
 
+}  // namespace
+
+absl::Status FitTokenIdsToContext(
+    std::vector<int>& token_ids, std::optional<int> start_token_id,
+    int max_num_tokens, const ContextOverflowOptions& overflow_options,
+    absl::Span<const int> turn_starts) {
+  return FitTokenIds(token_ids, /*num_leading_start_tokens=*/0,
+                     start_token_id, max_num_tokens, overflow_options,
+                     turn_starts);
+}
+
+absl::Status FitTokenIdsWithStartTokenToContext(
+    std::vector<int>& token_ids, int max_num_tokens,
+    const ContextOverflowOptions& overflow_options,
+    absl::Span<const int> turn_starts) {
+  if (token_ids.empty()) {
+    return absl::InvalidArgumentError("The start token is missing.");
+  }
+  return FitTokenIds(token_ids, /*num_leading_start_tokens=*/1,
+                     /*start_token_id=*/std::nullopt, max_num_tokens,
+                     overflow_options, turn_starts);
+}
+
 absl::StatusOr<bool> StopTokenFound(absl::Span<const int> decoded_token_ids,
                                     const std::vector<int>& stop_token_ids,
                                     std::vector<bool>& stop_token_found) {
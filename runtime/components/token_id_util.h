@@ -1,6 +1,8 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_TOKEN_ID_UTIL_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_TOKEN_ID_UTIL_H_
 
+#include <functional>
+#include <optional>
 #include <vector>
 
 #include "absl/status/status.h"  // from @com_google_absl
@@ -9,21 +11,68 @@
 
 namespace litert::lm {
 
-// Preprocesses the token ids before feeding them to the LLM.
-// - token_ids: The token ids to be preprocessed.
-// - start_token_id: The token id of the start token. It is used to be prepended
-//   to the token ids.
-// - max_num_tokens: The maximum number of tokens the model can hold (i.e. the
-//   length of the kv-cache). Setting it to be 0 means no limit.
-// - context_length_ratio_threhold: The threshold of the ratio of input context
-//   length to the max_num_tokens. If the ratio is larger than the threshold,
-//   the function will return an error, indicating that there is not enough
-//   space for the model to generate the output. For example, if the max_num
-//   tokens is 1024 and the context_length_ratio_threhold is 0.9, the function
-//   will return an error if the input token length is 922 (922 > 1024 * 0.9).
-absl::Status PreprocessTokenIds(std::vector<int>& token_ids, int start_token_id,
-                                int max_num_tokens,
-                                float context_length_ratio_threhold = 0.9f);
+// The policy applied when the input token ids do not fit in the context.
+enum class ContextOverflowPolicy {
+  // Returns an InvalidArgumentError.
+  kError,
+  // Keeps the first `num_head_tokens` tokens (e.g. the system prompt) and
+  // fills the rest of the context with the most recent tokens.
+  kKeepHeadAndTail,
+  // Drops the oldest turns as a whole, keeping the tokens before the first
+  // turn (e.g. the system prompt). Fails if the last turn alone does not fit.
+  // Only the conversations know the turns, so the sessions reject it.
+  kDropOldestTurns,
+  // Drops the tokens in the middle, keeping as many tokens from the beginning
+  // as from the end.
+  kMiddleOut,
+  // Calls the compression callback, e.g. to summarize the older turns.
+  kCallback,
+};
+
+// Compresses the token ids (without the start token) so that they fit in
+// `max_num_tokens`. `turn_starts` are the indices of the first token of each
+// turn, if known.
+using ContextCompressionCallback =
+    std::function<absl::StatusOr<std::vector<int>>(
+        std::vector<int> token_ids, absl::Span<const int> turn_starts,
+        int max_num_tokens)>;
+
+// Options for handling the input token ids which do not fit in the context.
+struct ContextOverflowOptions {
+  ContextOverflowPolicy policy = ContextOverflowPolicy::kError;
+  // The number of leading tokens kept by kKeepHeadAndTail.
+  int num_head_tokens = 0;
+  // The callback used by kCallback.
+  ContextCompressionCallback compression_callback;
+};
+
+// Prepends the start token to the token ids and, if the result is longer than
+// `max_num_tokens`, trims the token ids according to the overflow policy. The
+// start token is never trimmed. Token ids that already fit are only prepended
+// the start token, and trimmed token ids are compacted together with the start
+// token in a single pass. The prepend shifts all the token ids: callers which
+// build the token ids use FitTokenIdsWithStartTokenToContext() instead, and
+// callers which copy them, e.g. to the prefill buffer, write the start token
+// there with no `start_token_id` here and one less `max_num_tokens`.
+// - token_ids: The token ids to be fitted, without the start token.
+// - start_token_id: The start token to prepend, if any.
+// - max_num_tokens: The maximum number of tokens, including the start token.
+// - overflow_options: How to trim the token ids that do not fit.
+// - turn_starts: The sorted indices in `token_ids` of the first token of each
+//   turn. Only kDropOldestTurns and kCallback use them.
+absl::Status FitTokenIdsToContext(
+    std::vector<int>& token_ids, std::optional<int> start_token_id,
+    int max_num_tokens, const ContextOverflowOptions& overflow_options,
+    absl::Span<const int> turn_starts = {});
+
+// Same as FitTokenIdsToContext(), but `token_ids` already starts with the start
+// token, e.g. pushed before the other token ids when building them, so that
+// token ids that already fit are left untouched. `turn_starts` are indices in
+// `token_ids`, i.e. count the start token.
+absl::Status FitTokenIdsWithStartTokenToContext(
+    std::vector<int>& token_ids, int max_num_tokens,
+    const ContextOverflowOptions& overflow_options,
+    absl::Span<const int> turn_starts = {});
 
 // Checks if the stop token is found in the decoded token ids.
 // - decoded_token_ids: The decoded token ids. The size of the vector span is
@@ -0,0 +1,101 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This tool measures the cost of fitting long inputs which need no trimming to
+// the context, from building the token ids to the start token being in front
+// of them. The start token is either prepended by FitTokenIdsToContext(), or
+// pushed before the token ids for FitTokenIdsWithStartTokenToContext().
+//
+// Example usage:
+// bazel run -c opt :token_id_util_benchmark -- --num_tokens=131072
+
+#include <iostream>
+#include <vector>
+
+#include "absl/flags/flag.h"  // from @com_google_absl
+#include "absl/flags/parse.h"  // from @com_google_absl
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/components/token_id_util.h"
+
+ABSL_FLAG(int, num_tokens, 131072, "The largest number of input tokens.");
+
+ABSL_FLAG(int, iterations, 200, "The number of fits to average.");
+
+namespace {
+
+using ::litert::lm::ContextOverflowOptions;
+using ::litert::lm::ContextOverflowPolicy;
+using ::litert::lm::FitTokenIdsToContext;
+using ::litert::lm::FitTokenIdsWithStartTokenToContext;
+
+constexpr int kStartTokenId = 2;
+
+// Returns the average time of building `input` as token ids and fitting them
+// to a context just large enough, with the start token prepended by the fit if
+// `prepend`, or pushed before the input otherwise.
+absl::Duration TimeFit(const std::vector<int>& input, bool prepend,
+                       int iterations) {
+  ContextOverflowOptions options;
+  options.policy = ContextOverflowPolicy::kMiddleOut;
+  const int max_num_tokens = input.size() + 1;
+  size_t checksum = 0;
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    std::vector<int> token_ids;
+    if (prepend) {
+      token_ids.assign(input.begin(), input.end());
+      ABSL_CHECK_OK(FitTokenIdsToContext(token_ids, kStartTokenId,
+                                         max_num_tokens, options));
+    } else {
+      token_ids.reserve(input.size() + 1);
+      token_ids.push_back(kStartTokenId);
+      token_ids.insert(token_ids.end(), input.begin(), input.end());
+      ABSL_CHECK_OK(FitTokenIdsWithStartTokenToContext(
+          token_ids, max_num_tokens, options));
+    }
+    checksum += token_ids.front() + token_ids.size();
+  }
+  const absl::Duration duration = (absl::Now() - start) / iterations;
+  ABSL_CHECK_EQ(checksum, iterations * (kStartTokenId + input.size() + 1));
+  return duration;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const int max_num_tokens = absl::GetFlag(FLAGS_num_tokens);
+  const int iterations = absl::GetFlag(FLAGS_iterations);
+
+  std::cout << absl::StrFormat("%10s %14s %14s %8s\n", "tokens",
+                               "prepend us", "in place us", "speedup");
+  for (int num_tokens = 1024; num_tokens <= max_num_tokens; num_tokens *= 2) {
+    std::vector<int> input(num_tokens);
+    for (int i = 0; i < num_tokens; ++i) {
+      input[i] = 100 + i % 1000;
+    }
+    const absl::Duration prepend =
+        TimeFit(input, /*prepend=*/true, iterations);
+    const absl::Duration in_place =
+        TimeFit(input, /*prepend=*/false, iterations);
+    std::cout << absl::StrFormat("%10d %14.1f %14.1f %7.2fx\n", num_tokens,
+                                 absl::ToDoubleMicroseconds(prepend),
+                                 absl::ToDoubleMicroseconds(in_place),
+                                 absl::FDivDuration(prepend, in_place));
+  }
+  return 0;
+}
@@ -1,10 +1,13 @@
 #include "runtime/components/token_id_util.h"
 
+#include <optional>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "runtime/util/test_utils.h"  // NOLINT
 
 namespace litert::lm {
@@ -14,22 +17,133 @@ using ::testing::ElementsAre;
 using ::testing::status::IsOkAndHolds;
 using ::testing::status::StatusIs;
 
-TEST(TokenIdUtilTest, PreprocessTokenIds) {
-  std::vector<int> token_ids = {1, 2, 3, 4, 5};
-  EXPECT_OK(PreprocessTokenIds(token_ids, /*start_token_id=*/0,
-                               /*max_num_tokens=*/10,
-                               /*context_length_ratio_threhold=*/0.9f));
-  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 3, 4, 5));
+TEST(TokenIdUtilTest, FitTokenIdsToContextKeepsFittingTokenIds) {
+  std::vector<int> token_ids = {1, 2, 3};
+  ContextOverflowOptions options;
+  options.policy = ContextOverflowPolicy::kMiddleOut;
+  EXPECT_OK(FitTokenIdsToContext(token_ids, /*start_token_id=*/std::nullopt,
+                                 /*max_num_tokens=*/3, options));
+  EXPECT_THAT(token_ids, ElementsAre(1, 2, 3));
+  EXPECT_OK(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                 /*max_num_tokens=*/4, options));
+  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 3));
 }
 
-TEST(TokenIdUtilTest, PreprocessTokenIdsExceeedThreshold) {
-  std::vector<int> token_ids = {1, 2, 3, 4, 5, 6, 7, 8, 9};
-  EXPECT_THAT(PreprocessTokenIds(token_ids, /*start_token_id=*/0,
-                                 /*max_num_tokens=*/10,
-                                 /*context_length_ratio_threhold=*/0.9f),
+TEST(TokenIdUtilTest, FitTokenIdsToContextKeepHeadAndTail) {
+  std::vector<int> token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+  ContextOverflowOptions options;
+  options.policy = ContextOverflowPolicy::kKeepHeadAndTail;
+  options.num_head_tokens = 2;
+  EXPECT_OK(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                 /*max_num_tokens=*/5, options));
+  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 7, 8));
+
+  // Without a head, only the most recent tokens are kept.
+  token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+  options.num_head_tokens = 0;
+  EXPECT_OK(FitTokenIdsToContext(token_ids, /*start_token_id=*/std::nullopt,
+                                 /*max_num_tokens=*/3, options));
+  EXPECT_THAT(token_ids, ElementsAre(6, 7, 8));
+}
+
+TEST(TokenIdUtilTest, FitTokenIdsToContextDropOldestTurns) {
+  // A system prompt {1, 2} followed by the turns {3, 4}, {5, 6, 7} and {8}.
+  const std::vector<int> turn_starts = {2, 4, 7};
+  std::vector<int> token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+  ContextOverflowOptions options;
+  options.policy = ContextOverflowPolicy::kDropOldestTurns;
+  EXPECT_OK(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                 /*max_num_tokens=*/7, options, turn_starts));
+  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 5, 6, 7, 8));
+
+  token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+  EXPECT_OK(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                 /*max_num_tokens=*/6, options, turn_starts));
+  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 8));
+
+  // The last turn alone does not fit.
+  token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+  EXPECT_THAT(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                   /*max_num_tokens=*/3, options, turn_starts),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  // The turns are unknown.
+  EXPECT_THAT(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                   /*max_num_tokens=*/6, options),
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST(TokenIdUtilTest, FitTokenIdsToContextCallback) {
+  std::vector<int> token_ids = {1, 2, 3, 4, 5, 6};
+  int callback_max_num_tokens = 0;
+  ContextOverflowOptions options;
+  options.policy = ContextOverflowPolicy::kCallback;
+  options.compression_callback =
+      [&](std::vector<int> token_ids, absl::Span<const int> turn_starts,
+          int max_num_tokens) -> absl::StatusOr<std::vector<int>> {
+    EXPECT_THAT(turn_starts, ElementsAre(0, 3));
+    callback_max_num_tokens = max_num_tokens;
+    // Replaces the first turn with a "summary" token.
+    return std::vector<int>{42, token_ids[4], token_ids[5]};
+  };
+  EXPECT_OK(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                 /*max_num_tokens=*/4, options,
+                                 /*turn_starts=*/{0, 3}));
+  EXPECT_THAT(token_ids, ElementsAre(0, 42, 5, 6));
+  // The budget excludes the start token.
+  EXPECT_EQ(callback_max_num_tokens, 3);
+
+  // The compressed token ids must fit.
+  token_ids = {1, 2, 3, 4, 5, 6};
+  EXPECT_THAT(FitTokenIdsToContext(token_ids, /*start_token_id=*/0,
+                                   /*max_num_tokens=*/3, options,
+                                   /*turn_starts=*/{0, 3}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(TokenIdUtilTest, FitTokenIdsWithStartTokenToContext) {
+  // The token ids already fit, with the start token in place.
+  std::vector<int> token_ids = {0, 1, 2, 3};
+  const int* data = token_ids.data();
+  ContextOverflowOptions options;
+  options.policy = ContextOverflowPolicy::kMiddleOut;
+  EXPECT_OK(FitTokenIdsWithStartTokenToContext(token_ids,
+                                               /*max_num_tokens=*/4, options));
+  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 3));
+  EXPECT_EQ(token_ids.data(), data);
+
+  // The start token is kept when trimming.
+  token_ids = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  options.policy = ContextOverflowPolicy::kKeepHeadAndTail;
+  options.num_head_tokens = 2;
+  EXPECT_OK(FitTokenIdsWithStartTokenToContext(token_ids,
+                                               /*max_num_tokens=*/5, options));
+  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 7, 8));
+
+  // The turn starts count the start token.
+  token_ids = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  options.policy = ContextOverflowPolicy::kDropOldestTurns;
+  EXPECT_OK(FitTokenIdsWithStartTokenToContext(token_ids,
+                                               /*max_num_tokens=*/6, options,
+                                               /*turn_starts=*/{3, 5, 8}));
+  EXPECT_THAT(token_ids, ElementsAre(0, 1, 2, 8));
+
+  // The callback is given the token ids without the start token.
+  token_ids = {0, 1, 2, 3, 4, 5, 6};
+  options.policy = ContextOverflowPolicy::kCallback;
+  options.compression_callback =
+      [](std::vector<int> token_ids, absl::Span<const int> turn_starts,
+         int max_num_tokens) -> absl::StatusOr<std::vector<int>> {
+    EXPECT_THAT(token_ids, ElementsAre(1, 2, 3, 4, 5, 6));
+    EXPECT_THAT(turn_starts, ElementsAre(0, 3));
+    EXPECT_EQ(max_num_tokens, 3);
+    return std::vector<int>{42, token_ids[4], token_ids[5]};
+  };
+  EXPECT_OK(FitTokenIdsWithStartTokenToContext(token_ids,
+                                               /*max_num_tokens=*/4, options,
+                                               /*turn_starts=*/{1, 4}));
+  EXPECT_THAT(token_ids, ElementsAre(0, 42, 5, 6));
+}
+
 TEST(TokenIdUtilTest, StopTokenFoundTrue) {
   std::vector<int> decoded_token_ids = {0, 2, 0, 4, 5};
   std::vector<bool> stop_token_found = {false, true, false, true, true};
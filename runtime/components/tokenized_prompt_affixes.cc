@@ -0,0 +1,123 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/tokenized_prompt_affixes.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/components/tokenizer.h"
+#include "runtime/util/status_macros.h"  // IWYU pragma: keep
+
+namespace litert::lm {
+namespace {
+
+// Representative texts used to check whether the tokenizer merges characters
+// across an affix boundary: word characters, leading/trailing whitespace,
+// newlines, digits and punctuation.
+constexpr absl::string_view kBoundaryProbes[] = {"a", " a", "a ", "\n",
+                                                 "1", "."};
+
+// Returns true if tokenizing `affix` next to each probe yields the same ids as
+// concatenating the separately tokenized pieces.
+absl::StatusOr<bool> IsTokenAligned(Tokenizer& tokenizer,
+                                    absl::string_view affix,
+                                    const std::vector<int>& affix_ids,
+                                    bool is_prefix) {
+  if (affix.empty()) {
+    return true;
+  }
+  for (absl::string_view probe : kBoundaryProbes) {
+    ASSIGN_OR_RETURN(std::vector<int> probe_ids,
+                     tokenizer.TextToTokenIds(probe));
+    const std::string concatenated_text =
+        is_prefix ? absl::StrCat(affix, probe) : absl::StrCat(probe, affix);
+    ASSIGN_OR_RETURN(std::vector<int> expected_ids,
+                     tokenizer.TextToTokenIds(concatenated_text));
+    std::vector<int> concatenated_ids = is_prefix ? affix_ids : probe_ids;
+    const std::vector<int>& tail = is_prefix ? probe_ids : affix_ids;
+    concatenated_ids.insert(concatenated_ids.end(), tail.begin(), tail.end());
+    if (concatenated_ids != expected_ids) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+// static
+absl::StatusOr<TokenizedPromptAffixes> TokenizedPromptAffixes::Create(
+    Tokenizer& tokenizer, absl::string_view prefix, absl::string_view suffix) {
+  TokenizedPromptAffixes affixes;
+  affixes.prefix_ = std::string(prefix);
+  affixes.suffix_ = std::string(suffix);
+  if (!prefix.empty()) {
+    ASSIGN_OR_RETURN(affixes.prefix_ids_, tokenizer.TextToTokenIds(prefix));
+  }
+  if (!suffix.empty()) {
+    ASSIGN_OR_RETURN(affixes.suffix_ids_, tokenizer.TextToTokenIds(suffix));
+  }
+  ASSIGN_OR_RETURN(affixes.prefix_token_aligned_,
+                   IsTokenAligned(tokenizer, prefix, affixes.prefix_ids_,
+                                  /*is_prefix=*/true));
+  ASSIGN_OR_RETURN(affixes.suffix_token_aligned_,
+                   IsTokenAligned(tokenizer, suffix, affixes.suffix_ids_,
+                                  /*is_prefix=*/false));
+  return affixes;
+}
+
+absl::Status TokenizedPromptAffixes::AppendEncoded(
+    Tokenizer& tokenizer, absl::string_view text,
+    std::vector<int>& token_ids) const {
+  // Merge the text with an affix at the text level only for the boundaries
+  // where the tokenizer may merge characters across them.
+  std::vector<int> text_ids;
+  if (prefix_token_aligned_ && suffix_token_aligned_) {
+    ASSIGN_OR_RETURN(text_ids, tokenizer.TextToTokenIds(text));
+  } else if (prefix_token_aligned_) {
+    ASSIGN_OR_RETURN(text_ids,
+                     tokenizer.TextToTokenIds(absl::StrCat(text, suffix_)));
+  } else if (suffix_token_aligned_) {
+    ASSIGN_OR_RETURN(text_ids,
+                     tokenizer.TextToTokenIds(absl::StrCat(prefix_, text)));
+  } else {
+    ASSIGN_OR_RETURN(text_ids, tokenizer.TextToTokenIds(
+                                   absl::StrCat(prefix_, text, suffix_)));
+  }
+
+  token_ids.reserve(token_ids.size() + prefix_ids_.size() + text_ids.size() +
+                    suffix_ids_.size());
+  if (prefix_token_aligned_) {
+    token_ids.insert(token_ids.end(), prefix_ids_.begin(), prefix_ids_.end());
+  }
+  token_ids.insert(token_ids.end(), text_ids.begin(), text_ids.end());
+  if (suffix_token_aligned_) {
+    token_ids.insert(token_ids.end(), suffix_ids_.begin(), suffix_ids_.end());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<int>> TokenizedPromptAffixes::Encode(
+    Tokenizer& tokenizer, absl::string_view text) const {
+  std::vector<int> token_ids;
+  RETURN_IF_ERROR(AppendEncoded(tokenizer, text, token_ids));
+  return token_ids;
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,85 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_TOKENIZED_PROMPT_AFFIXES_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_TOKENIZED_PROMPT_AFFIXES_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/components/tokenizer.h"
+
+namespace litert::lm {
+
+// A prompt template prefix/suffix pair which is tokenized once and then reused
+// for every message wrapped with it. Encoding a message only runs the
+// tokenizer on the message text itself and concatenates the token ids of the
+// affixes, instead of re-tokenizing the whole formatted string.
+//
+// Token-id concatenation is only equivalent to tokenizing the concatenated text
+// when the tokenizer does not merge characters across the boundary (e.g. the
+// affix ends/starts with a special token such as "<start_of_turn>"). Create()
+// probes each boundary with a few representative strings; a boundary that
+// fails the probe is merged at the text level instead. The probes are not
+// exhaustive: the result matches what tokenizing the formatted text would
+// produce only if the tokenizer is context-free at the affix boundaries, i.e.
+// if the tokens on either side of a boundary that passed the probes do not
+// depend on the text on its other side.
+//
+// Example:
+//   ASSIGN_OR_RETURN(auto affixes, TokenizedPromptAffixes::Create(
+//       tokenizer, "<start_of_turn>user\n", "<end_of_turn>\n"));
+//   std::vector<int> ids;
+//   RETURN_IF_ERROR(affixes.AppendEncoded(tokenizer, "Hello!", ids));
+class TokenizedPromptAffixes {
+ public:
+  // Tokenizes the prefix and suffix and checks whether their boundaries with
+  // the wrapped text can be concatenated in token space.
+  static absl::StatusOr<TokenizedPromptAffixes> Create(
+      Tokenizer& tokenizer, absl::string_view prefix, absl::string_view suffix);
+
+  // Encodes `text` wrapped with the prefix and suffix, and appends the
+  // resulting token ids to `token_ids`.
+  absl::Status AppendEncoded(Tokenizer& tokenizer, absl::string_view text,
+                             std::vector<int>& token_ids) const;
+
+  // Same as AppendEncoded() but returns a new vector.
+  absl::StatusOr<std::vector<int>> Encode(Tokenizer& tokenizer,
+                                          absl::string_view text) const;
+
+  const std::vector<int>& GetPrefixIds() const { return prefix_ids_; }
+  const std::vector<int>& GetSuffixIds() const { return suffix_ids_; }
+
+  // Whether the prefix/suffix token ids can be concatenated with the token ids
+  // of the wrapped text without changing the tokenization.
+  bool IsPrefixTokenAligned() const { return prefix_token_aligned_; }
+  bool IsSuffixTokenAligned() const { return suffix_token_aligned_; }
+
+ private:
+  TokenizedPromptAffixes() = default;
+
+  std::string prefix_;
+  std::string suffix_;
+  std::vector<int> prefix_ids_;
+  std::vector<int> suffix_ids_;
+  bool prefix_token_aligned_ = true;
+  bool suffix_token_aligned_ = true;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_TOKENIZED_PROMPT_AFFIXES_H_
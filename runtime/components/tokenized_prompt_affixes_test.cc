@@ -0,0 +1,115 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/components/tokenized_prompt_affixes.h"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/components/tokenizer.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+// A byte level tokenizer which maps every byte to its value, except that two
+// consecutive newlines are merged into a single token (1000). The merge rule
+// makes a boundary ending with "\n" unsafe for token-space concatenation.
+class FakeMergingTokenizer : public Tokenizer {
+ public:
+  absl::StatusOr<std::vector<int>> TextToTokenIds(
+      absl::string_view text) override {
+    ++num_encode_calls_;
+    std::vector<int> ids;
+    for (int i = 0; i < text.size(); ++i) {
+      if (text[i] == '\n' && i + 1 < text.size() && text[i + 1] == '\n') {
+        ids.push_back(1000);
+        ++i;
+      } else {
+        ids.push_back(static_cast<unsigned char>(text[i]));
+      }
+    }
+    return ids;
+  }
+
+  absl::StatusOr<std::string> TokenIdsToText(
+      const std::vector<int>& token_ids) override {
+    std::string text;
+    for (int id : token_ids) {
+      text += id == 1000 ? std::string("\n\n") : std::string(1, id);
+    }
+    return text;
+  }
+
+  int num_encode_calls_ = 0;
+};
+
+TEST(TokenizedPromptAffixesTest, AlignedAffixesAreConcatenatedInTokenSpace) {
+  FakeMergingTokenizer tokenizer;
+  auto affixes = TokenizedPromptAffixes::Create(tokenizer, "<u>", "</u>");
+  ASSERT_OK(affixes);
+  EXPECT_TRUE(affixes->IsPrefixTokenAligned());
+  EXPECT_TRUE(affixes->IsSuffixTokenAligned());
+
+  tokenizer.num_encode_calls_ = 0;
+  auto ids = affixes->Encode(tokenizer, "hi");
+  ASSERT_OK(ids);
+  // Only the input text is tokenized.
+  EXPECT_EQ(tokenizer.num_encode_calls_, 1);
+  EXPECT_EQ(*ids, *tokenizer.TextToTokenIds("<u>hi</u>"));
+}
+
+TEST(TokenizedPromptAffixesTest, UnalignedBoundaryIsMergedAsText) {
+  FakeMergingTokenizer tokenizer;
+  auto affixes = TokenizedPromptAffixes::Create(tokenizer, "<u>\n", "\n</u>");
+  ASSERT_OK(affixes);
+  EXPECT_FALSE(affixes->IsPrefixTokenAligned());
+  EXPECT_FALSE(affixes->IsSuffixTokenAligned());
+
+  for (absl::string_view text : {"\nhi\n", "hi", "\n"}) {
+    auto ids = affixes->Encode(tokenizer, text);
+    ASSERT_OK(ids);
+    EXPECT_EQ(*ids,
+              *tokenizer.TextToTokenIds(absl::StrCat("<u>\n", text, "\n</u>")))
+        << text;
+  }
+}
+
+TEST(TokenizedPromptAffixesTest, EmptyAffixes) {
+  FakeMergingTokenizer tokenizer;
+  auto affixes = TokenizedPromptAffixes::Create(tokenizer, "", "");
+  ASSERT_OK(affixes);
+  EXPECT_TRUE(affixes->GetPrefixIds().empty());
+  EXPECT_TRUE(affixes->GetSuffixIds().empty());
+  auto ids = affixes->Encode(tokenizer, "hi");
+  ASSERT_OK(ids);
+  EXPECT_EQ(*ids, std::vector<int>({'h', 'i'}));
+}
+
+TEST(TokenizedPromptAffixesTest, AppendEncodedKeepsExistingIds) {
+  FakeMergingTokenizer tokenizer;
+  auto affixes = TokenizedPromptAffixes::Create(tokenizer, "[", "]");
+  ASSERT_OK(affixes);
+  std::vector<int> ids = {1, 2};
+  ASSERT_OK(affixes->AppendEncoded(tokenizer, "x", ids));
+  EXPECT_EQ(ids, std::vector<int>({1, 2, '[', 'x', ']'}));
+}
+
+}  // namespace
+}  // namespace litert::lm
@@ -1,6 +1,7 @@
 #include "runtime/components/top_p_cpu_sampler.h"
 
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -12,6 +13,7 @@
 #include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_macros.h"  // from @litert
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
+#include "runtime/components/philox.h"
 #include "runtime/components/sampling_cpu_util.h"
 #include "runtime/util/convert_tensor_buffer.h"
 #include "runtime/util/tensor_buffer_util.h"
@@ -58,9 +60,32 @@ absl::StatusOr<std::unique_ptr<TopPSampler>> TopPSampler::Create(
   return absl::WrapUnique(new TopPSampler(k, p, temperature, batch_size, seed));
 }
 
+absl::Status TopPSampler::Reset() {
+  step_ = 0;
+  return absl::OkStatus();
+}
+
 absl::Status TopPSampler::SampleToIdAndScoreBuffer(
     const TensorBuffer& logits_tensor, TensorBuffer& ids_tensor,
     TensorBuffer* scores_tensor) {
+  return Sample(logits_tensor, ids_tensor, scores_tensor,
+                /*num_top_log_probs=*/0, /*log_probs=*/nullptr);
+}
+
+absl::Status TopPSampler::SampleWithLogProbs(const TensorBuffer& logits_tensor,
+                                             TensorBuffer& ids_tensor,
+                                             TensorBuffer* scores_tensor,
+                                             int num_top_log_probs,
+                                             SampledLogProbs& log_probs) {
+  return Sample(logits_tensor, ids_tensor, scores_tensor, num_top_log_probs,
+                &log_probs);
+}
+
+absl::Status TopPSampler::Sample(const TensorBuffer& logits_tensor,
+                                 TensorBuffer& ids_tensor,
+                                 TensorBuffer* scores_tensor,
+                                 int num_top_log_probs,
+                                 SampledLogProbs* log_probs) {
   auto status = ValidateTensor(logits_tensor, /*max_num_dims=*/2, batch_size_,
                                "input logits");
   if (!status.ok()) {
@@ -86,9 +111,22 @@ absl::Status TopPSampler::SampleToIdAndScoreBuffer(
   } else {
     logits_data = logits_data_or.Value();
   }
+  for (int b = 0; b < batch_size_; ++b) {
+    random_values_[b] =
+        PhiloxUniform(static_cast<uint64_t>(seed_), /*sequence_id=*/b, step_);
+  }
+  ++step_;
   std::vector<float> sampled_scores;
-  auto sampled_ids = TopKTopPSampling(logits_data, k_, p_, temperature_,
-                                      generator_, batch_size_, sampled_scores);
+  // The log probabilities are computed in the same pass over the logits as
+  // the sampling.
+  auto sampled_ids =
+      log_probs != nullptr
+          ? TopKTopPSamplingWithLogProbs(
+                logits_data, k_, p_, temperature_, random_values_, batch_size_,
+                sampled_scores, num_top_log_probs, log_probs->log_probs,
+                log_probs->top_ids, log_probs->top_log_probs)
+          : TopKTopPSampling(logits_data, k_, p_, temperature_,
+                             random_values_, batch_size_, sampled_scores);
   if (!sampled_ids.ok()) {
     return sampled_ids.status();
   }
@@ -1,11 +1,10 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_TOP_P_CPU_SAMPLER_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_COMPONENTS_TOP_P_CPU_SAMPLER_H_
 
+#include <cstdint>
 #include <memory>
-#include <utility>
 #include <vector>
 
-#include "absl/random/random.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
@@ -20,6 +19,10 @@ class TopPSampler : public Sampler {
   // - p: The top-p probability mass to consider.
   // - batch_size: The batch size of the input logits.
   // - seed: The seed for the random number generator.
+  // The random number of each token is drawn by a counter-based generator
+  // (Philox) from the seed, the index of the token in the batch and the
+  // decode step, so that the sampling is reproducible whatever the batching
+  // or the steps sampled again.
   static absl::StatusOr<std::unique_ptr<TopPSampler>> Create(int k, float p,
                                                              float temperature,
                                                              int batch_size,
@@ -35,21 +38,49 @@ class TopPSampler : public Sampler {
                                         TensorBuffer& ids_tensor,
                                         TensorBuffer* scores_tensor) override;
 
+  // Same as SampleToIdAndScoreBuffer, and also computes the log probabilities
+  // of the sampled tokens and of the `num_top_log_probs` most likely tokens
+  // over the whole vocabulary, on the logits read for the sampling.
+  absl::Status SampleWithLogProbs(const TensorBuffer& logits_tensor,
+                                  TensorBuffer& ids_tensor,
+                                  TensorBuffer* scores_tensor,
+                                  int num_top_log_probs,
+                                  SampledLogProbs& log_probs) override;
+
+  // Brings the step of the next sampling back to 0.
+  absl::Status Reset() override;
+
+  // Sets the step of the next sampling, which is incremented after each
+  // sampling otherwise.
+  void SetStep(int step) override { step_ = step; }
+
  private:
   explicit TopPSampler(int k, float p, float temperature, int batch_size,
                        int seed)
-      : k_(k), p_(p), temperature_(temperature), batch_size_(batch_size) {
-    absl::SeedSeq proper_seed_seq({seed});
-    absl::BitGen rng(proper_seed_seq);
-    generator_ = std::move(rng);
-  }
+      : k_(k),
+        p_(p),
+        temperature_(temperature),
+        batch_size_(batch_size),
+        seed_(seed),
+        random_values_(batch_size) {}
+
+  // Samples the token ids, and computes their log probabilities if
+  // `log_probs` is not null.
+  absl::Status Sample(const TensorBuffer& logits_tensor,
+                      TensorBuffer& ids_tensor, TensorBuffer* scores_tensor,
+                      int num_top_log_probs, SampledLogProbs* log_probs);
 
   // The parameters for the sampler.
   const int k_;
   const float p_;
   const float temperature_;
   const int batch_size_;
-  absl::BitGen generator_;
+  const int seed_;
+  // The decode step of the next sampling, from which its random numbers are
+  // drawn.
+  uint64_t step_ = 0;
+  // The random number of each batch of the current sampling.
+  std::vector<double> random_values_;
 
   // The logits data to be used for sampling. Having it as a member to avoid
   // re-allocating the vector for each sampling call.
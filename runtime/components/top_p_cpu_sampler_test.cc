@@ -1,5 +1,6 @@
 #include "runtime/components/top_p_cpu_sampler.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <utility>
@@ -75,5 +76,150 @@ TEST(TopPSamplerTest, SampleToIdAndScoreBuffer_BatchSize2) {
   EXPECT_THAT(*scores, testing::ElementsAre(std::log(1.0f), std::log(1.0f)));
 }
 
+TEST(TopPSamplerTest, SampleWithLogProbs_BatchSize2) {
+  auto sampler_or = TopPSampler::Create(/*k=*/1, /*p=*/0.5, /*temperature=*/1.0,
+                                        /*batch_size=*/2, /*seed=*/1);
+  EXPECT_TRUE(sampler_or.ok());
+  auto sampler = std::move(sampler_or.value());
+
+  const std::vector<float> logits = {0.0, 0.0, 10.0, 0.0, 11.0, 12.0, 1.0, 2.0};
+  auto logits_tensor = CopyToTensorBuffer<float>(logits, {2, 4});
+
+  std::vector<int> ids_vector(2);
+  auto ids_tensor =
+      CopyToTensorBuffer<int>(absl::MakeConstSpan(ids_vector), {2});
+  SampledLogProbs log_probs;
+  auto status = sampler->SampleWithLogProbs(*logits_tensor, *ids_tensor,
+                                            /*scores_tensor=*/nullptr,
+                                            /*num_top_log_probs=*/2, log_probs);
+  EXPECT_TRUE(status.ok());
+
+  auto ids = CopyFromTensorBuffer<int>(*ids_tensor);
+  EXPECT_TRUE(ids.HasValue());
+  EXPECT_THAT(*ids, testing::ElementsAre(2, 1));
+  // The log probabilities are over the whole vocabulary.
+  const float log_sum_0 = std::log(3 + std::exp(10.0f));
+  const float log_sum_1 =
+      std::log(std::exp(11.0f) + std::exp(12.0f) + std::exp(1.0f) +
+               std::exp(2.0f));
+  EXPECT_THAT(log_probs.log_probs,
+              testing::Pointwise(testing::FloatNear(1e-4),
+                                 {10.0f - log_sum_0, 12.0f - log_sum_1}));
+  EXPECT_THAT(log_probs.top_ids, testing::ElementsAre(2, testing::_, 1, 0));
+  EXPECT_NEAR(log_probs.top_log_probs[3], 11.0f - log_sum_1, 1e-4);
+}
+
+TEST(TopPSamplerTest, ResetSamplesTheSameTokensAgain) {
+  auto sampler_or = TopPSampler::Create(/*k=*/4, /*p=*/1.0, /*temperature=*/1.0,
+                                        /*batch_size=*/1, /*seed=*/7);
+  EXPECT_TRUE(sampler_or.ok());
+  auto sampler = std::move(sampler_or.value());
+
+  // Uniform logits, so that the sampled ids only depend on the generator.
+  const std::vector<float> logits = {1.0, 1.0, 1.0, 1.0};
+  auto logits_tensor = CopyToTensorBuffer<float>(logits, {1, 4});
+  std::vector<int> ids_vector(1);
+  auto ids_tensor =
+      CopyToTensorBuffer<int>(absl::MakeConstSpan(ids_vector), {1});
+  auto sample_ids = [&]() {
+    std::vector<int> sampled_ids;
+    for (int i = 0; i < 16; ++i) {
+      EXPECT_TRUE(sampler
+                      ->SampleToIdAndScoreBuffer(*logits_tensor, *ids_tensor,
+                                                 /*scores_tensor=*/nullptr)
+                      .ok());
+      sampled_ids.push_back((*CopyFromTensorBuffer<int>(*ids_tensor))[0]);
+    }
+    return sampled_ids;
+  };
+
+  const std::vector<int> first_ids = sample_ids();
+  EXPECT_TRUE(sampler->Reset().ok());
+  EXPECT_EQ(sample_ids(), first_ids);
+}
+
+// Samples `num_steps` steps from uniform logits, so that the sampled ids only
+// depend on the random numbers, and returns the ids of each step.
+std::vector<std::vector<int>> SampleUniformSteps(TopPSampler& sampler,
+                                                 int batch_size,
+                                                 int num_steps) {
+  constexpr int kVocabSize = 8;
+  const std::vector<float> logits(batch_size * kVocabSize, 1.0f);
+  auto logits_tensor =
+      CopyToTensorBuffer<float>(logits, {batch_size, kVocabSize});
+  std::vector<int> ids_vector(batch_size);
+  auto ids_tensor =
+      CopyToTensorBuffer<int>(absl::MakeConstSpan(ids_vector), {batch_size});
+  std::vector<std::vector<int>> sampled_ids;
+  for (int i = 0; i < num_steps; ++i) {
+    EXPECT_TRUE(sampler
+                    .SampleToIdAndScoreBuffer(*logits_tensor, *ids_tensor,
+                                              /*scores_tensor=*/nullptr)
+                    .ok());
+    sampled_ids.push_back(*CopyFromTensorBuffer<int>(*ids_tensor));
+  }
+  return sampled_ids;
+}
+
+TEST(TopPSamplerTest, SamplesDependOnTheSeed) {
+  auto sampler_1 = TopPSampler::Create(/*k=*/8, /*p=*/1.0, /*temperature=*/1.0,
+                                       /*batch_size=*/1, /*seed=*/1);
+  auto sampler_2 = TopPSampler::Create(/*k=*/8, /*p=*/1.0, /*temperature=*/1.0,
+                                       /*batch_size=*/1, /*seed=*/2);
+  ASSERT_TRUE(sampler_1.ok());
+  ASSERT_TRUE(sampler_2.ok());
+  const std::vector<std::vector<int>> ids_1 =
+      SampleUniformSteps(**sampler_1, /*batch_size=*/1, /*num_steps=*/32);
+  EXPECT_NE(ids_1, SampleUniformSteps(**sampler_2, /*batch_size=*/1,
+                                      /*num_steps=*/32));
+  // The random numbers of the steps are not all the same either.
+  EXPECT_LT(std::count(ids_1.begin(), ids_1.end(), ids_1[0]), 32);
+}
+
+TEST(TopPSamplerTest, RewoundStepsSampleTheSameTokensAgain) {
+  auto sampler = TopPSampler::Create(/*k=*/8, /*p=*/1.0, /*temperature=*/1.0,
+                                     /*batch_size=*/2, /*seed=*/3);
+  ASSERT_TRUE(sampler.ok());
+  const std::vector<std::vector<int>> ids =
+      SampleUniformSteps(**sampler, /*batch_size=*/2, /*num_steps=*/16);
+
+  // Steps 10 to 15 sampled again, e.g. after a rollback to step 10.
+  (*sampler)->SetStep(10);
+  EXPECT_EQ(SampleUniformSteps(**sampler, /*batch_size=*/2, /*num_steps=*/6),
+            std::vector<std::vector<int>>(ids.begin() + 10, ids.end()));
+
+  // Another sampler with the same seed, e.g. of a restored session, resumed
+  // at step 4.
+  auto restored_sampler =
+      TopPSampler::Create(/*k=*/8, /*p=*/1.0, /*temperature=*/1.0,
+                          /*batch_size=*/2, /*seed=*/3);
+  ASSERT_TRUE(restored_sampler.ok());
+  (*restored_sampler)->SetStep(4);
+  EXPECT_EQ(
+      SampleUniformSteps(**restored_sampler, /*batch_size=*/2,
+                         /*num_steps=*/12),
+      std::vector<std::vector<int>>(ids.begin() + 4, ids.end()));
+}
+
+TEST(TopPSamplerTest, SamplesOfASequenceDoNotDependOnTheBatch) {
+  auto single_sampler =
+      TopPSampler::Create(/*k=*/8, /*p=*/1.0, /*temperature=*/1.0,
+                          /*batch_size=*/1, /*seed=*/5);
+  auto batch_sampler =
+      TopPSampler::Create(/*k=*/8, /*p=*/1.0, /*temperature=*/1.0,
+                          /*batch_size=*/3, /*seed=*/5);
+  ASSERT_TRUE(single_sampler.ok());
+  ASSERT_TRUE(batch_sampler.ok());
+  const std::vector<std::vector<int>> single_ids =
+      SampleUniformSteps(**single_sampler, /*batch_size=*/1,
+                         /*num_steps=*/16);
+  const std::vector<std::vector<int>> batch_ids =
+      SampleUniformSteps(**batch_sampler, /*batch_size=*/3,
+                         /*num_steps=*/16);
+  for (int step = 0; step < 16; ++step) {
+    EXPECT_EQ(batch_ids[step][0], single_ids[step][0]);
+  }
+}
+
 }  // namespace
 }  // namespace litert::lm
@@ -0,0 +1,333 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/core/beam_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "litert/cc/litert_tensor_buffer.h"  // from @litert
+#include "runtime/components/sampling_cpu_util.h"
+#include "runtime/components/tokenizer.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/executor/llm_executor.h"
+#include "runtime/executor/llm_executor_io_types.h"
+#include "runtime/proto/sampler_params.pb.h"
+#include "runtime/util/convert_tensor_buffer.h"
+#include "runtime/util/litert_status_util.h"
+#include "runtime/util/status_macros.h"  // IWYU pragma: keep
+
+namespace litert::lm {
+namespace {
+
+// The default exponent of the length normalization, i.e. the score is the
+// average log probability per token.
+constexpr float kDefaultLengthPenalty = 1.0f;
+
+// Returns log(sum(exp(logits))) in a numerically stable way.
+float LogSumExp(absl::Span<const float> logits) {
+  const float max_logit = *std::max_element(logits.begin(), logits.end());
+  if (!std::isfinite(max_logit)) {
+    return max_logit;
+  }
+  float sum = 0.0f;
+  for (float logit : logits) {
+    sum += std::exp(logit - max_logit);
+  }
+  return max_logit + std::log(sum);
+}
+
+// Brings the executor to the state right after the prompt followed by
+// `token_ids`, with the last token pending. Only the tokens after the prefix
+// shared with the `resident_ids` (the tokens currently following the prompt)
+// are prefilled.
+absl::Status FeedBeam(LlmExecutor& executor, int prompt_length,
+                      const std::vector<int>& token_ids,
+                      std::vector<int>& resident_ids) {
+  if (token_ids.empty()) {
+    // The first step decodes from the last token of the prompt.
+    return absl::OkStatus();
+  }
+  // At least the last token is fed again to have it pending.
+  const int max_common_length =
+      std::min(resident_ids.size(), token_ids.size() - 1);
+  const int common_length =
+      std::mismatch(token_ids.begin(), token_ids.begin() + max_common_length,
+                    resident_ids.begin())
+          .first -
+      token_ids.begin();
+  ASSIGN_OR_RETURN(int current_step, executor.GetCurrentStep());
+  if (current_step != prompt_length + common_length) {
+    RETURN_IF_ERROR(executor.RewindTo(prompt_length + common_length));
+  }
+  const std::vector<int> new_ids(token_ids.begin() + common_length,
+                                 token_ids.end());
+  LITERT_ASSIGN_OR_RETURN_ABSL(
+      auto ids_buffer,
+      CopyToTensorBuffer<int>(new_ids, {1, static_cast<int>(new_ids.size())}));
+  RETURN_IF_ERROR(executor.Prefill(ExecutorInputs(
+      ExecutorTextData(std::move(ids_buffer)), std::nullopt, std::nullopt)));
+  resident_ids = token_ids;
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+// static
+absl::StatusOr<BeamSearch> BeamSearch::Create(
+    const proto::BeamSearchParameters& beam_search_params,
+    int num_output_candidates,
+    const std::vector<std::vector<int>>& stop_token_ids) {
+  if (beam_search_params.beam_width() < 1) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Beam width must be at least 1, but got: ",
+                     beam_search_params.beam_width()));
+  }
+  if (num_output_candidates < 1 ||
+      num_output_candidates > beam_search_params.beam_width()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Number of output candidates must be in [1, beam width], but got: ",
+        num_output_candidates));
+  }
+  return BeamSearch(beam_search_params.beam_width(),
+                    beam_search_params.has_length_penalty()
+                        ? beam_search_params.length_penalty()
+                        : kDefaultLengthPenalty,
+                    beam_search_params.early_stopping(), num_output_candidates,
+                    stop_token_ids);
+}
+
+BeamSearch::BeamSearch(int beam_width, float length_penalty,
+                       bool early_stopping, int num_output_candidates,
+                       const std::vector<std::vector<int>>& stop_token_ids)
+    : beam_width_(beam_width),
+      length_penalty_(length_penalty),
+      early_stopping_(early_stopping),
+      num_output_candidates_(num_output_candidates),
+      stop_token_ids_(stop_token_ids),
+      beams_(1) {}
+
+absl::Status BeamSearch::Step(absl::Span<const float> logits) {
+  if (done_) {
+    return absl::FailedPreconditionError("The beam search is already done.");
+  }
+  const int num_beams = beams_.size();
+  if (logits.empty() || logits.size() % num_beams != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Logits size ", logits.size(),
+                     " is not a multiple of the number of beams ", num_beams));
+  }
+  const int vocab_size = logits.size() / num_beams;
+  // Twice the beam width guarantees enough running candidates even if all the
+  // beams are finished by a stop token.
+  const int k = std::min(2 * beam_width_, vocab_size);
+  ASSIGN_OR_RETURN(std::vector<int> top_k_ids,
+                   TopKIndicies(logits, k, num_beams));
+
+  struct Candidate {
+    int beam_index;
+    int token_id;
+    float log_prob;
+  };
+  std::vector<Candidate> candidates;
+  candidates.reserve(num_beams * k);
+  for (int b = 0; b < num_beams; ++b) {
+    absl::Span<const float> beam_logits =
+        logits.subspan(b * vocab_size, vocab_size);
+    const float log_normalizer = LogSumExp(beam_logits);
+    for (int i = 0; i < k; ++i) {
+      const int token_id = top_k_ids[b * k + i];
+      const float log_prob =
+          beams_[b].log_prob + beam_logits[token_id] - log_normalizer;
+      if (std::isfinite(log_prob)) {
+        candidates.push_back({b, token_id, log_prob});
+      }
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     return a.log_prob > b.log_prob;
+                   });
+
+  std::vector<BeamHypothesis> next_beams;
+  next_beams.reserve(beam_width_);
+  for (const Candidate& candidate : candidates) {
+    if (next_beams.size() == beam_width_) {
+      break;
+    }
+    BeamHypothesis hypothesis;
+    hypothesis.token_ids = beams_[candidate.beam_index].token_ids;
+    hypothesis.token_ids.push_back(candidate.token_id);
+    hypothesis.log_prob = candidate.log_prob;
+    hypothesis.score = Score(hypothesis.log_prob, hypothesis.token_ids.size());
+    hypothesis.num_stop_tokens = CountStopTokens(hypothesis.token_ids);
+    if (hypothesis.num_stop_tokens > 0) {
+      AddFinished(std::move(hypothesis));
+    } else {
+      next_beams.push_back(std::move(hypothesis));
+    }
+  }
+  beams_ = std::move(next_beams);
+
+  if (beams_.empty()) {
+    done_ = true;
+  } else if (finished_.size() == beam_width_) {
+    // The running hypotheses are sorted, so only the best one can still beat
+    // the worst finished hypothesis.
+    done_ = early_stopping_ || beams_.front().score <= finished_.back().score;
+  }
+  return absl::OkStatus();
+}
+
+std::vector<BeamHypothesis> BeamSearch::GetBestHypotheses() const {
+  std::vector<BeamHypothesis> hypotheses = finished_;
+  if (hypotheses.size() < num_output_candidates_) {
+    hypotheses.insert(hypotheses.end(), beams_.begin(), beams_.end());
+    std::stable_sort(hypotheses.begin(), hypotheses.end(),
+                     [](const BeamHypothesis& a, const BeamHypothesis& b) {
+                       return a.score > b.score;
+                     });
+  }
+  if (hypotheses.size() > num_output_candidates_) {
+    hypotheses.resize(num_output_candidates_);
+  }
+  return hypotheses;
+}
+
+int BeamSearch::CountStopTokens(const std::vector<int>& token_ids) const {
+  for (const auto& stop_sequence : stop_token_ids_) {
+    if (!stop_sequence.empty() && stop_sequence.size() <= token_ids.size() &&
+        std::equal(stop_sequence.rbegin(), stop_sequence.rend(),
+                   token_ids.rbegin())) {
+      return stop_sequence.size();
+    }
+  }
+  return 0;
+}
+
+float BeamSearch::Score(float log_prob, int length) const {
+  return log_prob / std::pow(static_cast<float>(length), length_penalty_);
+}
+
+void BeamSearch::AddFinished(BeamHypothesis hypothesis) {
+  if (finished_.size() == beam_width_ &&
+      hypothesis.score <= finished_.back().score) {
+    return;
+  }
+  auto it = std::upper_bound(
+      finished_.begin(), finished_.end(), hypothesis.score,
+      [](float score, const BeamHypothesis& h) { return score > h.score; });
+  finished_.insert(it, std::move(hypothesis));
+  if (finished_.size() > beam_width_) {
+    finished_.pop_back();
+  }
+}
+
+absl::StatusOr<Responses> DecodeBeamSearch(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const proto::BeamSearchParameters& beam_search_params,
+    const std::vector<std::vector<int>>& stop_token_ids,
+    int num_output_candidates, std::optional<BenchmarkInfo>& benchmark_info,
+    const DecodeLimits& limits) {
+  ASSIGN_OR_RETURN(auto beam_search,
+                   BeamSearch::Create(beam_search_params,
+                                      num_output_candidates, stop_token_ids));
+  ASSIGN_OR_RETURN(const int prompt_length, executor.GetCurrentStep());
+  ASSIGN_OR_RETURN(auto executor_settings, executor.GetExecutorSettings());
+  const int max_num_tokens = executor_settings.GetMaxNumTokens();
+  if (benchmark_info.has_value()) {
+    RETURN_IF_ERROR(benchmark_info->TimeDecodeTurnStart());
+  }
+
+  // The generated token ids following the prompt in the KV cache.
+  std::vector<int> resident_ids;
+  std::vector<float> logits;
+  int num_decoded_tokens = 0;
+  for (int step = 0;
+       !beam_search.IsDone() && prompt_length + step < max_num_tokens &&
+       (limits.max_num_steps <= 0 || step < limits.max_num_steps);
+       ++step) {
+    if (absl::Status status = limits.Check(); !status.ok()) {
+      // Leave the executor as before the decode, so the session can go on.
+      RETURN_IF_ERROR(executor.RewindTo(prompt_length));
+      return status;
+    }
+    const std::vector<BeamHypothesis>& beams = beam_search.GetBeams();
+    std::vector<int> visit_order(beams.size());
+    std::iota(visit_order.begin(), visit_order.end(), 0);
+    std::sort(visit_order.begin(), visit_order.end(), [&beams](int a, int b) {
+      return beams[a].token_ids < beams[b].token_ids;
+    });
+    logits.clear();
+    for (int beam_index : visit_order) {
+      RETURN_IF_ERROR(FeedBeam(executor, prompt_length,
+                               beams[beam_index].token_ids, resident_ids));
+      ASSIGN_OR_RETURN(auto logits_buffer,
+                       executor.DecodeLogits(ExecutorInputs()));
+      LITERT_ASSIGN_OR_RETURN_ABSL(auto beam_logits,
+                                   CopyFromTensorBuffer<float>(logits_buffer));
+      if (logits.empty()) {
+        logits.resize(beams.size() * beam_logits.size());
+      }
+      RET_CHECK_EQ(logits.size(), beams.size() * beam_logits.size());
+      std::copy(beam_logits.begin(), beam_logits.end(),
+                logits.begin() + beam_index * beam_logits.size());
+      ++num_decoded_tokens;
+    }
+    RETURN_IF_ERROR(beam_search.Step(logits));
+  }
+
+  Responses responses(num_output_candidates);
+  std::vector<std::string>& response_texts =
+      responses.GetMutableResponseTexts();
+  std::vector<float>& scores = responses.GetMutableScores();
+  const std::vector<BeamHypothesis> hypotheses =
+      beam_search.GetBestHypotheses();
+  for (int i = 0; i < hypotheses.size(); ++i) {
+    const std::vector<int>& token_ids = hypotheses[i].token_ids;
+    ASSIGN_OR_RETURN(
+        response_texts[i],
+        tokenizer.TokenIdsToText(std::vector<int>(
+            token_ids.begin(), token_ids.end() - hypotheses[i].num_stop_tokens)));
+    scores[i] = hypotheses[i].score;
+  }
+  // The best hypothesis is truncated if it used up the steps without reaching
+  // the stop tokens.
+  responses.SetTruncated(
+      !hypotheses.empty() && hypotheses[0].num_stop_tokens == 0 &&
+      limits.max_num_steps > 0 &&
+      static_cast<int>(hypotheses[0].token_ids.size()) >=
+          limits.max_num_steps);
+  // Leave the best hypothesis in the KV cache so the session can continue
+  // from it.
+  if (!hypotheses.empty()) {
+    RETURN_IF_ERROR(FeedBeam(executor, prompt_length, hypotheses[0].token_ids,
+                             resident_ids));
+  }
+  if (benchmark_info.has_value()) {
+    RETURN_IF_ERROR(benchmark_info->TimeDecodeTurnEnd(num_decoded_tokens));
+  }
+  return responses;
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,142 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_BEAM_SEARCH_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_BEAM_SEARCH_H_
+
+#include <optional>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/components/tokenizer.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/executor/llm_executor.h"
+#include "runtime/proto/sampler_params.pb.h"
+
+namespace litert::lm {
+
+// A hypothesis of the beam search, i.e. a decoded token sequence.
+struct BeamHypothesis {
+  // The decoded token ids, including the trailing stop tokens if finished.
+  std::vector<int> token_ids;
+  // The number of trailing stop token ids. It is 0 for running hypotheses.
+  int num_stop_tokens = 0;
+  // The sum of the log probabilities of the decoded token ids.
+  float log_prob = 0.0f;
+  // The length-penalized log probability used to rank the hypotheses.
+  float score = 0.0f;
+};
+
+// Keeps track of the running and finished hypotheses of a beam search. The
+// class only does the bookkeeping on the logits; running the model for each
+// beam is left to the caller (see DecodeBeamSearch below).
+//
+// Example:
+//   ASSIGN_OR_RETURN(auto beam_search, BeamSearch::Create(params, 2, stops));
+//   while (!beam_search.IsDone()) {
+//     // Compute the logits of the next token of each of GetBeams().
+//     RETURN_IF_ERROR(beam_search.Step(logits));
+//   }
+//   std::vector<BeamHypothesis> n_best = beam_search.GetBestHypotheses();
+class BeamSearch {
+ public:
+  // Creates a BeamSearch object.
+  // - beam_search_params: The beam width, length penalty and early stopping.
+  // - num_output_candidates: The number of hypotheses to return. It must not
+  //   exceed the beam width.
+  // - stop_token_ids: The token id sequences finishing a hypothesis.
+  static absl::StatusOr<BeamSearch> Create(
+      const proto::BeamSearchParameters& beam_search_params,
+      int num_output_candidates,
+      const std::vector<std::vector<int>>& stop_token_ids);
+
+  // Returns the running hypotheses, best first. The search starts from a
+  // single empty hypothesis.
+  const std::vector<BeamHypothesis>& GetBeams() const { return beams_; }
+
+  // Extends the running hypotheses by one token.
+  // - logits: The logits of the next token of each running hypothesis, i.e. a
+  //   flattened [GetBeams().size(), vocab_size] buffer in the order of
+  //   GetBeams().
+  absl::Status Step(absl::Span<const float> logits);
+
+  // Returns true when no running hypothesis is worth extending anymore.
+  bool IsDone() const { return done_; }
+
+  // Returns the `num_output_candidates` best hypotheses, best first. Running
+  // hypotheses are included when fewer hypotheses are finished, e.g. when the
+  // search is stopped early by the maximum number of tokens.
+  std::vector<BeamHypothesis> GetBestHypotheses() const;
+
+ private:
+  BeamSearch(int beam_width, float length_penalty, bool early_stopping,
+             int num_output_candidates,
+             const std::vector<std::vector<int>>& stop_token_ids);
+
+  // Returns the number of trailing token ids matching a stop token sequence.
+  int CountStopTokens(const std::vector<int>& token_ids) const;
+
+  // Returns the length-penalized score of `log_prob` for `length` tokens.
+  float Score(float log_prob, int length) const;
+
+  // Adds a finished hypothesis, keeping only the `beam_width_` best ones.
+  void AddFinished(BeamHypothesis hypothesis);
+
+  const int beam_width_;
+  const float length_penalty_;
+  const bool early_stopping_;
+  const int num_output_candidates_;
+  const std::vector<std::vector<int>> stop_token_ids_;
+
+  // The running hypotheses, sorted by descending log probability.
+  std::vector<BeamHypothesis> beams_;
+  // The finished hypotheses, sorted by descending score.
+  std::vector<BeamHypothesis> finished_;
+  bool done_ = false;
+};
+
+// Runs the beam search decoding from the prompt prefilled in the executor and
+// returns the n best hypotheses, with their length-penalized log
+// probabilities as scores.
+//
+// The beams share the single KV cache lane of the executor: each beam is
+// brought in by rewinding the executor to the prefix it shares with the
+// previously visited beam (see LlmExecutorBase::RewindTo) and prefilling the
+// rest, so the prompt is processed once and only the diverging tails of the
+// beams are recomputed. The beams are visited in lexicographic order to
+// maximize the shared prefixes. Once done, the executor holds the prompt
+// followed by the best hypothesis, with its last token pending, as after
+// Decode().
+// - executor: The initialized LLM Executor to call. It must support
+//   RewindTo() and DecodeLogits().
+// - tokenizer: The tokenizer to decode the token ids into text.
+// - beam_search_params: The parameters of the beam search.
+// - stop_token_ids: The token id sequences finishing a hypothesis. They are
+//   not part of the response texts.
+// - num_output_candidates: The number of hypotheses to return.
+// - benchmark_info: The benchmark info to record the performance metrics.
+// - limits: Checked before each step. Once cancelled or past the deadline,
+//   the executor is rewound to the prompt and the error is returned.
+absl::StatusOr<Responses> DecodeBeamSearch(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const proto::BeamSearchParameters& beam_search_params,
+    const std::vector<std::vector<int>>& stop_token_ids,
+    int num_output_candidates, std::optional<BenchmarkInfo>& benchmark_info,
+    const DecodeLimits& limits = DecodeLimits());
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_BEAM_SEARCH_H_
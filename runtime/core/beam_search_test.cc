@@ -0,0 +1,308 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/core/beam_search.h"
+
+#include <cmath>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "litert/cc/litert_tensor_buffer.h"  // from @litert
+#include "runtime/components/tokenizer.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/executor/executor_settings_base.h"
+#include "runtime/executor/llm_executor.h"
+#include "runtime/executor/llm_executor_io_types.h"
+#include "runtime/executor/llm_executor_settings.h"
+#include "runtime/proto/sampler_params.pb.h"
+#include "runtime/util/convert_tensor_buffer.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr int kPromptTokenId = 0;
+constexpr int kStopTokenId = 3;
+
+// The next token probabilities of a toy bigram model, indexed by the last
+// token id. Greedy decoding picks 1 and then stops with a probability of
+// 0.5 * 0.4 = 0.2, while the sequence starting with the less likely 2 stops
+// with a probability of 0.4 * 0.9 = 0.36.
+const std::vector<std::vector<float>>& NextTokenProbs() {
+  static const auto* probs = new std::vector<std::vector<float>>{
+      /*0=*/{0.0f, 0.5f, 0.4f, 0.1f},
+      /*1=*/{0.0f, 0.3f, 0.3f, 0.4f},
+      /*2=*/{0.0f, 0.05f, 0.05f, 0.9f},
+      /*3=*/{0.25f, 0.25f, 0.25f, 0.25f},
+  };
+  return *probs;
+}
+
+std::vector<float> NextTokenLogits(int last_token_id) {
+  std::vector<float> logits;
+  for (float prob : NextTokenProbs()[last_token_id]) {
+    logits.push_back(std::log(prob));
+  }
+  return logits;
+}
+
+// Computes the logits of the running beams of `beam_search`.
+std::vector<float> BeamLogits(const BeamSearch& beam_search) {
+  std::vector<float> logits;
+  for (const BeamHypothesis& beam : beam_search.GetBeams()) {
+    std::vector<float> beam_logits = NextTokenLogits(
+        beam.token_ids.empty() ? kPromptTokenId : beam.token_ids.back());
+    logits.insert(logits.end(), beam_logits.begin(), beam_logits.end());
+  }
+  return logits;
+}
+
+proto::BeamSearchParameters CreateParams(int beam_width) {
+  proto::BeamSearchParameters params;
+  params.set_beam_width(beam_width);
+  return params;
+}
+
+TEST(BeamSearchTest, CreateFailsWithInvalidParams) {
+  EXPECT_THAT(BeamSearch::Create(CreateParams(0), /*num_output_candidates=*/1,
+                                 {{kStopTokenId}}),
+              testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(BeamSearch::Create(CreateParams(2), /*num_output_candidates=*/3,
+                                 {{kStopTokenId}}),
+              testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(BeamSearchTest, WidthOneIsGreedy) {
+  ASSERT_OK_AND_ASSIGN(auto beam_search,
+                       BeamSearch::Create(CreateParams(1),
+                                          /*num_output_candidates=*/1,
+                                          {{kStopTokenId}}));
+  while (!beam_search.IsDone()) {
+    ASSERT_OK(beam_search.Step(BeamLogits(beam_search)));
+  }
+  std::vector<BeamHypothesis> hypotheses = beam_search.GetBestHypotheses();
+  ASSERT_EQ(hypotheses.size(), 1);
+  EXPECT_THAT(hypotheses[0].token_ids, ElementsAre(1, kStopTokenId));
+  EXPECT_EQ(hypotheses[0].num_stop_tokens, 1);
+  EXPECT_NEAR(hypotheses[0].log_prob, std::log(0.2f), 1e-5);
+}
+
+TEST(BeamSearchTest, FindsMoreLikelySequenceThanGreedy) {
+  ASSERT_OK_AND_ASSIGN(auto beam_search,
+                       BeamSearch::Create(CreateParams(2),
+                                          /*num_output_candidates=*/2,
+                                          {{kStopTokenId}}));
+  ASSERT_OK(beam_search.Step(BeamLogits(beam_search)));
+  ASSERT_EQ(beam_search.GetBeams().size(), 2);
+  EXPECT_THAT(beam_search.GetBeams()[0].token_ids, ElementsAre(1));
+  EXPECT_THAT(beam_search.GetBeams()[1].token_ids, ElementsAre(2));
+
+  ASSERT_OK(beam_search.Step(BeamLogits(beam_search)));
+  // Both finished hypotheses beat the running ones.
+  EXPECT_TRUE(beam_search.IsDone());
+  EXPECT_THAT(beam_search.Step(BeamLogits(beam_search)),
+              testing::status::StatusIs(absl::StatusCode::kFailedPrecondition));
+
+  std::vector<BeamHypothesis> hypotheses = beam_search.GetBestHypotheses();
+  ASSERT_EQ(hypotheses.size(), 2);
+  EXPECT_THAT(hypotheses[0].token_ids, ElementsAre(2, kStopTokenId));
+  EXPECT_NEAR(hypotheses[0].log_prob, std::log(0.36f), 1e-5);
+  EXPECT_NEAR(hypotheses[0].score, std::log(0.36f) / 2, 1e-5);
+  EXPECT_THAT(hypotheses[1].token_ids, ElementsAre(1, kStopTokenId));
+  EXPECT_NEAR(hypotheses[1].log_prob, std::log(0.2f), 1e-5);
+}
+
+TEST(BeamSearchTest, MultiTokenStopSequence) {
+  ASSERT_OK_AND_ASSIGN(auto beam_search,
+                       BeamSearch::Create(CreateParams(1),
+                                          /*num_output_candidates=*/1,
+                                          {{1, kStopTokenId}}));
+  while (!beam_search.IsDone()) {
+    ASSERT_OK(beam_search.Step(BeamLogits(beam_search)));
+  }
+  std::vector<BeamHypothesis> hypotheses = beam_search.GetBestHypotheses();
+  ASSERT_EQ(hypotheses.size(), 1);
+  EXPECT_THAT(hypotheses[0].token_ids, ElementsAre(1, kStopTokenId));
+  EXPECT_EQ(hypotheses[0].num_stop_tokens, 2);
+}
+
+TEST(BeamSearchTest, RunningHypothesesAreReturnedWhenNotFinished) {
+  ASSERT_OK_AND_ASSIGN(auto beam_search,
+                       BeamSearch::Create(CreateParams(2),
+                                          /*num_output_candidates=*/2,
+                                          {{kStopTokenId}}));
+  // Stop after the first step, e.g. when running out of KV cache.
+  ASSERT_OK(beam_search.Step(BeamLogits(beam_search)));
+  EXPECT_FALSE(beam_search.IsDone());
+  std::vector<BeamHypothesis> hypotheses = beam_search.GetBestHypotheses();
+  ASSERT_EQ(hypotheses.size(), 2);
+  EXPECT_THAT(hypotheses[0].token_ids, ElementsAre(1));
+  EXPECT_EQ(hypotheses[0].num_stop_tokens, 0);
+  EXPECT_THAT(hypotheses[1].token_ids, ElementsAre(2));
+}
+
+TEST(BeamSearchTest, EarlyStopping) {
+  // The log probabilities of the next token of each running beam.
+  const auto log_probs = [](const std::vector<float>& probs) {
+    std::vector<float> logits;
+    for (float prob : probs) {
+      logits.push_back(std::log(prob));
+    }
+    return logits;
+  };
+  for (bool early_stopping : {false, true}) {
+    proto::BeamSearchParameters params = CreateParams(2);
+    params.set_early_stopping(early_stopping);
+    params.set_length_penalty(0.0f);
+    ASSERT_OK_AND_ASSIGN(auto beam_search,
+                         BeamSearch::Create(params, /*num_output_candidates=*/1,
+                                            {{kStopTokenId}}));
+    ASSERT_OK(beam_search.Step(log_probs({0.0f, 0.6f, 0.4f, 0.0f})));
+    // The candidates are "1 1" (0.33), "2 <stop>" (0.32), "1 <stop>" (0.27)
+    // and "2 2" (0.08): two hypotheses are finished, but "1 1" can still beat
+    // the worst of them.
+    ASSERT_OK(beam_search.Step(log_probs(
+        {0.0f, 0.55f, 0.0f, 0.45f, 0.0f, 0.0f, 0.2f, 0.8f})));
+    EXPECT_EQ(beam_search.IsDone(), early_stopping);
+    std::vector<BeamHypothesis> hypotheses = beam_search.GetBestHypotheses();
+    ASSERT_EQ(hypotheses.size(), 1);
+    EXPECT_THAT(hypotheses[0].token_ids, ElementsAre(2, kStopTokenId));
+    EXPECT_NEAR(hypotheses[0].score, std::log(0.32f), 1e-5);
+  }
+}
+
+// A tokenizer mapping the token ids of the toy model to letters.
+class LetterTokenizer : public Tokenizer {
+ public:
+  absl::StatusOr<std::vector<int>> TextToTokenIds(
+      absl::string_view text) override {
+    std::vector<int> token_ids;
+    for (char c : text) {
+      token_ids.push_back(c - 'a');
+    }
+    return token_ids;
+  }
+
+  absl::StatusOr<std::string> TokenIdsToText(
+      const std::vector<int>& token_ids) override {
+    std::string text;
+    for (int token_id : token_ids) {
+      text.push_back('a' + token_id);
+    }
+    return text;
+  }
+};
+
+// An executor running the toy bigram model. It follows the KV cache semantics
+// of the compiled model executors: a prefill leaves its last token pending,
+// and the tokens are dropped by RewindTo().
+class BigramExecutor : public LlmExecutor {
+ public:
+  absl::Status Prefill(const ExecutorInputs& inputs) override {
+    ASSIGN_OR_RETURN(auto token_ids_ptr, inputs.GetTextTokenIdsPtr());
+    auto token_ids = CopyFromTensorBuffer<int>(*token_ids_ptr);
+    if (!token_ids) {
+      return absl::InternalError(token_ids.Error().Message());
+    }
+    token_ids_.insert(token_ids_.end(), token_ids->begin(), token_ids->end());
+    num_prefilled_tokens_ += token_ids->size();
+    return absl::OkStatus();
+  }
+
+  absl::Status Decode(::litert::TensorBuffer& output_tokens) override {
+    return absl::UnimplementedError("Decode is not supported.");
+  }
+
+  absl::StatusOr<::litert::TensorBuffer> DecodeLogits(
+      const ExecutorInputs& inputs) override {
+    auto logits = CopyToTensorBuffer<float>(
+        NextTokenLogits(token_ids_.back()),
+        {1, 1, static_cast<int>(NextTokenProbs().size())});
+    if (!logits) {
+      return absl::InternalError(logits.Error().Message());
+    }
+    return std::move(*logits);
+  }
+
+  absl::string_view ExecutorBackendName() const override {
+    return "BigramExecutor";
+  }
+
+  absl::StatusOr<int> GetCurrentStep() const override {
+    return token_ids_.size();
+  }
+
+  absl::StatusOr<LlmExecutorSettings> GetExecutorSettings() const override {
+    ASSIGN_OR_RETURN(auto model_assets, ModelAssets::Create("dummy"));
+    ASSIGN_OR_RETURN(auto settings, LlmExecutorSettings::CreateDefault(
+                                        model_assets, Backend::CPU));
+    settings.SetMaxNumTokens(16);
+    return settings;
+  }
+
+  absl::Status RewindTo(int step) override {
+    if (step < 0 || step > token_ids_.size()) {
+      return absl::InvalidArgumentError(absl::StrCat("Invalid step ", step));
+    }
+    token_ids_.resize(step);
+    return absl::OkStatus();
+  }
+
+  const std::vector<int>& GetTokenIds() const { return token_ids_; }
+  int GetNumPrefilledTokens() const { return num_prefilled_tokens_; }
+
+ private:
+  std::vector<int> token_ids_;
+  int num_prefilled_tokens_ = 0;
+};
+
+TEST(DecodeBeamSearchTest, ReturnsNBestAndKeepsBestInKvCache) {
+  BigramExecutor executor;
+  LetterTokenizer tokenizer;
+  auto prompt = CopyToTensorBuffer<int>({kPromptTokenId}, {1, 1});
+  ASSERT_TRUE(prompt.HasValue());
+  ASSERT_OK(executor.Prefill(ExecutorInputs(
+      ExecutorTextData(std::move(*prompt)), std::nullopt, std::nullopt)));
+
+  std::optional<BenchmarkInfo> benchmark_info;
+  ASSERT_OK_AND_ASSIGN(
+      Responses responses,
+      DecodeBeamSearch(executor, tokenizer, CreateParams(2), {{kStopTokenId}},
+                       /*num_output_candidates=*/2, benchmark_info));
+  ASSERT_EQ(responses.GetNumOutputCandidates(), 2);
+  // The stop tokens are not part of the texts.
+  EXPECT_EQ(*responses.GetResponseTextAt(0), "c");
+  EXPECT_NEAR(*responses.GetScoreAt(0), std::log(0.36f) / 2, 1e-5);
+  EXPECT_EQ(*responses.GetResponseTextAt(1), "b");
+  EXPECT_NEAR(*responses.GetScoreAt(1), std::log(0.2f) / 2, 1e-5);
+
+  // The prompt is prefilled once. Each beam of the second step prefills its
+  // single token, and the stop token of the best hypothesis is fed at last.
+  EXPECT_EQ(executor.GetNumPrefilledTokens(), 1 + 2 + 1);
+  EXPECT_THAT(executor.GetTokenIds(),
+              ElementsAre(kPromptTokenId, 2, kStopTokenId));
+}
+
+}  // namespace
+}  // namespace litert::lm
@@ -0,0 +1,412 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/core/conversation_basic.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/log/absl_log.h"  // from @com_google_absl
+#include "absl/memory/memory.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "runtime/components/sampler.h"
+#include "runtime/components/sampler_factory.h"
+#include "runtime/components/stop_token_detector.h"
+#include "runtime/components/token_id_util.h"
+#include "runtime/components/tokenized_prompt_affixes.h"
+#include "runtime/components/tokenizer.h"
+#include "runtime/core/pipeline.h"
+#include "runtime/engine/engine.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/executor/executor_settings_base.h"
+#include "runtime/executor/llm_executor.h"
+#include "runtime/framework/threadpool.h"
+#include "runtime/proto/llm_metadata.pb.h"
+#include "runtime/util/convert_tensor_buffer.h"
+#include "runtime/util/status_macros.h"  // IWYU pragma: keep
+
+namespace litert::lm {
+namespace {
+
+void AppendIds(const std::vector<int>& ids, std::vector<int>& token_ids) {
+  token_ids.insert(token_ids.end(), ids.begin(), ids.end());
+}
+
+// Removes the stop token sequence the decoded ids end with, if any.
+void StripStopTokens(const std::vector<std::vector<int>>& stop_token_ids,
+                     std::vector<int>& decoded_ids) {
+  for (const auto& stop_sequence : stop_token_ids) {
+    if (!stop_sequence.empty() && stop_sequence.size() <= decoded_ids.size() &&
+        std::equal(stop_sequence.rbegin(), stop_sequence.rend(),
+                   decoded_ids.rbegin())) {
+      decoded_ids.resize(decoded_ids.size() - stop_sequence.size());
+      return;
+    }
+  }
+}
+
+// Forwards the streamed responses to another observer and accumulates the
+// text of the first candidate in `reply`, with whether it is truncated.
+class AccumulatingObserver : public InferenceObservable {
+ public:
+  AccumulatingObserver(InferenceObservable& observer, Responses& reply)
+      : observer_(observer), reply_(reply) {}
+
+  void OnNext(const Responses& responses) override {
+    if (auto text = responses.GetResponseTextAt(0); text.ok()) {
+      absl::StrAppend(&reply_.GetMutableResponseTexts()[0], *text);
+    }
+    reply_.SetTruncated(responses.IsTruncated());
+    observer_.OnNext(responses);
+  }
+  void OnDone() override { observer_.OnDone(); }
+  void OnError(const absl::Status& status) override {
+    observer_.OnError(status);
+  }
+
+ private:
+  InferenceObservable& observer_;
+  Responses& reply_;
+};
+
+}  // namespace
+
+// static
+absl::StatusOr<std::unique_ptr<ConversationBasic>> ConversationBasic::Create(
+    LlmExecutor* executor, Tokenizer* tokenizer,
+    const SessionConfig& session_config,
+    std::optional<BenchmarkInfo> benchmark_info,
+    ThreadPool* worker_thread_pool, MemoryReservation memory_reservation) {
+  auto sampler_backend = session_config.GetSamplerBackend();
+  std::unique_ptr<Sampler> sampler;
+  // If use CPU sampling, we create it here; For GPU sampling, we let executor
+  // create it internally.
+  if (sampler_backend == Backend::CPU) {
+    ASSIGN_OR_RETURN(sampler,
+                     CreateSampler(sampler_backend, /*batch_size=*/1,
+                                   session_config.GetSamplerParams()));
+  } else if (sampler_backend != Backend::GPU) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unsupported sampler backend: ", sampler_backend));
+  }
+
+  StopTokenDetector stop_token_detector(/*batch_size=*/1);
+  for (const auto& stop_token_sequence : session_config.GetStopTokenIds()) {
+    RETURN_IF_ERROR(
+        stop_token_detector.AddStopTokenSequence(stop_token_sequence));
+  }
+  const proto::PromptTemplates& prompt_templates =
+      session_config.GetPromptTemplates();
+  ASSIGN_OR_RETURN(auto system_affixes,
+                   TokenizedPromptAffixes::Create(
+                       *tokenizer, prompt_templates.system().prefix(),
+                       prompt_templates.system().suffix()));
+  ASSIGN_OR_RETURN(auto user_affixes,
+                   TokenizedPromptAffixes::Create(
+                       *tokenizer, prompt_templates.user().prefix(),
+                       prompt_templates.user().suffix()));
+  ASSIGN_OR_RETURN(auto model_affixes,
+                   TokenizedPromptAffixes::Create(
+                       *tokenizer, prompt_templates.model().prefix(),
+                       prompt_templates.model().suffix()));
+  return absl::WrapUnique(new ConversationBasic(
+      executor, tokenizer, std::move(sampler), session_config, benchmark_info,
+      worker_thread_pool, stop_token_detector,
+      RoleAffixes{std::move(system_affixes), std::move(user_affixes),
+                  std::move(model_affixes)},
+      std::move(memory_reservation)));
+}
+
+ConversationBasic::~ConversationBasic() {
+  auto status = executor_.ReleaseSequence(sequence_id_);
+  if (absl::IsUnimplemented(status)) {
+    status = executor_.Reset();
+  }
+  if (!status.ok()) {
+    ABSL_LOG(ERROR) << "Failed to release the executor sequence: " << status;
+  }
+}
+
+absl::Status ConversationBasic::ActivateOnExecutor() {
+  RETURN_IF_ERROR(executor_.SetActiveLoRA(session_config_.GetLoRAName()));
+  absl::Status status = executor_.SetActiveSequence(sequence_id_);
+  if (!absl::IsUnimplemented(status)) {
+    return status;
+  }
+  // Without the sequences support, the KV cache is only kept while no other
+  // session uses the executor. The sessions reset it when they are done, so
+  // the KV cache is dropped if the executor is not where it was left.
+  absl::StatusOr<int> current_step = executor_.GetCurrentStep();
+  if (!current_step.ok() ||
+      *current_step != static_cast<int>(resident_token_ids_.size())) {
+    return TruncateKvCache(0);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<int>> ConversationBasic::EncodeHistory(
+    const std::vector<Message>& messages) {
+  if (messages.empty()) {
+    return absl::InvalidArgumentError("Messages are empty.");
+  }
+  if (messages.back().role == "assistant") {
+    return absl::InvalidArgumentError(
+        "The last message must not be from the assistant.");
+  }
+  // The start token is pushed first rather than prepended once the history is
+  // encoded, which would shift all of it.
+  std::vector<int> token_ids = {session_config_.GetStartTokenId()};
+  // The start of each turn, i.e. of each user message, where the history can
+  // be trimmed when it does not fit in the context.
+  std::vector<int> turn_starts;
+  // Only the replies which are still part of the history are worth keeping.
+  absl::flat_hash_map<std::string, std::vector<int>> used_replies;
+  for (const Message& message : messages) {
+    if (message.role == "system") {
+      RETURN_IF_ERROR(role_affixes_.system.AppendEncoded(
+          tokenizer_, message.content, token_ids));
+    } else if (message.role == "user") {
+      turn_starts.push_back(token_ids.size());
+      RETURN_IF_ERROR(role_affixes_.user.AppendEncoded(
+          tokenizer_, message.content, token_ids));
+    } else if (message.role == "assistant") {
+      auto it = generated_replies_.find(message.content);
+      if (it == generated_replies_.end()) {
+        RETURN_IF_ERROR(role_affixes_.model.AppendEncoded(
+            tokenizer_, message.content, token_ids));
+        continue;
+      }
+      // Use the sampled ids rather than re-tokenizing the reply, as the
+      // tokenizer does not necessarily produce the same ids for the text.
+      AppendIds(role_affixes_.model.GetPrefixIds(), token_ids);
+      AppendIds(it->second, token_ids);
+      AppendIds(role_affixes_.model.GetSuffixIds(), token_ids);
+      used_replies.insert(*it);
+    } else {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported message role: ", message.role));
+    }
+  }
+  generated_replies_ = std::move(used_replies);
+  // The model turn prefix to start generating the reply from.
+  AppendIds(role_affixes_.model.GetPrefixIds(), token_ids);
+
+  // At least one step is left for the decoding.
+  ASSIGN_OR_RETURN(auto executor_settings, executor_.GetExecutorSettings());
+  RETURN_IF_ERROR(FitTokenIdsWithStartTokenToContext(
+      token_ids, executor_settings.GetMaxNumTokens() - 1,
+      session_config_.GetContextOverflowOptions(), turn_starts));
+  return token_ids;
+}
+
+absl::Status ConversationBasic::TruncateKvCache(int length) {
+  absl::Status status = executor_.RewindTo(length);
+  if (absl::IsUnimplemented(status)) {
+    status = executor_.Reset();
+    length = 0;
+  }
+  RETURN_IF_ERROR(status);
+  resident_token_ids_.resize(length);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<int> ConversationBasic::SyncKvCache(
+    const std::vector<int>& token_ids) {
+  const int max_common_length =
+      std::min(token_ids.size(), resident_token_ids_.size());
+  int common_length = std::mismatch(token_ids.begin(),
+                                    token_ids.begin() + max_common_length,
+                                    resident_token_ids_.begin())
+                          .first -
+                      token_ids.begin();
+  // At least one token must be prefilled to have a token to decode from.
+  common_length =
+      std::min(common_length, static_cast<int>(token_ids.size()) - 1);
+
+  if (common_length < resident_token_ids_.size()) {
+    // The history diverged from what is in the KV cache: truncate the cache
+    // back to the common prefix, or drop it if the executor cannot rewind.
+    ABSL_LOG(INFO) << "Conversation history diverged at token "
+                   << common_length << " of " << resident_token_ids_.size()
+                   << ".";
+    RETURN_IF_ERROR(TruncateKvCache(common_length));
+    common_length = resident_token_ids_.size();
+  }
+
+  num_reused_tokens_ = common_length;
+  num_prefilled_tokens_ = token_ids.size() - common_length;
+  std::vector<int> new_token_ids(token_ids.begin() + common_length,
+                                 token_ids.end());
+  // The start token is already part of the history ids.
+  absl::StatusOr<int> last_token_id =
+      Prefill(executor_, tokenizer_, std::move(new_token_ids),
+              /*bos_token_id=*/std::nullopt,
+              /*wait_for_completion=*/true, benchmark_info_,
+              ContextOverflowOptions(), cancel_);
+  if (!last_token_id.ok()) {
+    // A cancelled or failed prefill may have filled part of the KV cache.
+    RETURN_IF_ERROR(TruncateKvCache(resident_token_ids_.size()));
+    return last_token_id.status();
+  }
+  resident_token_ids_ = token_ids;
+  return last_token_id;
+}
+
+DecodeLimits ConversationBasic::GetDecodeLimits() const {
+  return {.cancel = cancel_,
+          .deadline = deadline_,
+          .max_num_steps = session_config_.GetMaxOutputTokens()};
+}
+
+absl::StatusOr<Responses> ConversationBasic::DecodeReply(
+    int last_token_id, std::vector<int>& decoded_ids) {
+  if (sampler_ == nullptr) {
+    return Decode(executor_, tokenizer_, stop_token_detector_, benchmark_info_,
+                  &decoded_ids, GetDecodeLimits());
+  }
+  auto decoded_ids_buffer =
+      CopyToTensorBuffer<int>({last_token_id}, {/*batch_size=*/1, 1});
+  return DecodeCustomSampling(executor_, tokenizer_, stop_token_detector_,
+                              /*num_output_candidates=*/1, *sampler_,
+                              *decoded_ids_buffer, benchmark_info_,
+                              &decoded_ids, GetDecodeLimits(),
+                              session_config_.GetNumTopLogProbs());
+}
+
+absl::Status ConversationBasic::DecodeReplyStreaming(
+    int last_token_id, std::vector<int>& decoded_ids,
+    InferenceObservable* observer) {
+  if (sampler_ == nullptr && session_config_.GetPipelinedDecodeDepth() > 0) {
+    if (decode_consumer_thread_pool_ == nullptr) {
+      decode_consumer_thread_pool_ = std::make_unique<ThreadPool>(
+          /*name_prefix=*/"decode_consumer", /*max_num_threads=*/1);
+    }
+    return DecodeStreamingPipelined(
+        executor_, tokenizer_, stop_token_detector_, benchmark_info_, observer,
+        session_config_.GetPipelinedDecodeDepth(),
+        decode_consumer_thread_pool_.get(), &decoded_ids, GetDecodeLimits());
+  }
+  if (sampler_ == nullptr) {
+    return DecodeStreaming(executor_, tokenizer_, stop_token_detector_,
+                           benchmark_info_, observer, &decoded_ids,
+                           GetDecodeLimits());
+  }
+  auto decoded_ids_buffer =
+      CopyToTensorBuffer<int>({last_token_id}, {/*batch_size=*/1, 1});
+  return DecodeCustomSamplingStreaming(
+      executor_, tokenizer_, stop_token_detector_,
+      /*num_output_candidates=*/1, *sampler_, *decoded_ids_buffer,
+      benchmark_info_, observer, &decoded_ids, GetDecodeLimits(),
+      session_config_.GetNumTopLogProbs());
+}
+
+absl::StatusOr<int> ConversationBasic::PrefillTurn(
+    const std::vector<Message>& messages) {
+  if (absl::Now() >= deadline_) {
+    return absl::DeadlineExceededError("The prefill deadline is exceeded.");
+  }
+  ASSIGN_OR_RETURN(std::vector<int> token_ids, EncodeHistory(messages));
+  RETURN_IF_ERROR(ActivateOnExecutor());
+  ASSIGN_OR_RETURN(int last_token_id, SyncKvCache(token_ids));
+  ABSL_LOG(INFO) << "GenerateReply: reused " << num_reused_tokens_
+                 << " tokens, prefilled " << num_prefilled_tokens_
+                 << " tokens.";
+  return last_token_id;
+}
+
+absl::StatusOr<Responses> ConversationBasic::GenerateReplyInternal(
+    const std::vector<Message>& messages, InferenceObservable* observer) {
+  absl::StatusOr<int> last_token_id = PrefillTurn(messages);
+  if (!last_token_id.ok()) {
+    if (observer != nullptr) {
+      observer->OnError(last_token_id.status());
+    }
+    return last_token_id.status();
+  }
+
+  std::vector<int> decoded_ids;
+  absl::StatusOr<Responses> responses = Responses(/*num_output_candidates=*/1);
+  if (observer == nullptr) {
+    responses = DecodeReply(*last_token_id, decoded_ids);
+  } else {
+    AccumulatingObserver accumulating_observer(*observer, *responses);
+    if (absl::Status status = DecodeReplyStreaming(*last_token_id, decoded_ids,
+                                                   &accumulating_observer);
+        !status.ok()) {
+      responses = status;
+    }
+  }
+  // With executor-side sampling, the last sampled token is kept by the
+  // executor as the next input. With external sampling it is dropped, so it
+  // is not part of the KV cache.
+  const int num_resident_decoded_ids =
+      sampler_ == nullptr || decoded_ids.empty() ? decoded_ids.size()
+                                                 : decoded_ids.size() - 1;
+  resident_token_ids_.insert(resident_token_ids_.end(), decoded_ids.begin(),
+                             decoded_ids.begin() + num_resident_decoded_ids);
+  if (!responses.ok()) {
+    return responses.status();
+  }
+
+  ASSIGN_OR_RETURN(absl::string_view reply, responses->GetResponseTextAt(0));
+  StripStopTokens(session_config_.GetStopTokenIds(), decoded_ids);
+  generated_replies_[std::string(reply)] = std::move(decoded_ids);
+  return responses;
+}
+
+absl::StatusOr<Responses> ConversationBasic::GenerateReply(
+    const std::vector<Message>& messages) {
+  absl::StatusOr<Responses> responses;
+  RETURN_IF_ERROR(worker_thread_pool_.Schedule([this, &messages, &responses]() {
+    responses = this->GenerateReplyInternal(messages);
+  }));
+  RETURN_IF_ERROR(worker_thread_pool_.WaitUntilDone(Engine::kDefaultTimeout));
+  return responses;
+}
+
+absl::Status ConversationBasic::GenerateReplyStream(
+    const std::vector<Message>& messages, InferenceObservable* observer) {
+  if (observer == nullptr) {
+    return absl::InvalidArgumentError(
+        "Observer must be provided for streaming.");
+  }
+  absl::StatusOr<Responses> responses;
+  RETURN_IF_ERROR(
+      worker_thread_pool_.Schedule([this, &messages, observer, &responses]() {
+        responses = this->GenerateReplyInternal(messages, observer);
+      }));
+  RETURN_IF_ERROR(worker_thread_pool_.WaitUntilDone(Engine::kDefaultTimeout));
+  return responses.status();
+}
+
+absl::StatusOr<BenchmarkInfo> ConversationBasic::GetBenchmarkInfo() {
+  if (benchmark_info_.has_value()) {
+    return benchmark_info_.value();
+  }
+  return absl::InternalError(
+      "Benchmark is not enabled. Please make sure the BenchmarkParams is set "
+      "in the EngineSettings.");
+}
+
+}  // namespace litert::lm
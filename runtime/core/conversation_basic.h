@@ -0,0 +1,222 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_CONVERSATION_BASIC_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_CONVERSATION_BASIC_H_
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"  // from @com_google_absl
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/components/sampler.h"
+#include "runtime/components/stop_token_detector.h"
+#include "runtime/components/tokenized_prompt_affixes.h"
+#include "runtime/components/tokenizer.h"
+#include "runtime/engine/engine.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/executor/llm_executor.h"
+#include "runtime/framework/threadpool.h"
+#include "runtime/util/memory_tracker.h"
+
+namespace litert::lm {
+
+// ConversationBasic is a basic implementation of Engine::Conversation.
+//
+// On every turn the full message history is encoded into token ids (the
+// messages are wrapped with the pre-tokenized prompt template of their role,
+// and the replies generated by this conversation map back to the exact token
+// ids that were sampled). The ids are then compared with the tokens resident
+// in the KV cache: the common prefix is kept, and only the remaining tokens
+// are prefilled before decoding the reply. A client resending the whole chat
+// on each turn therefore only pays for the new messages.
+//
+// A history that does not fit in the context is trimmed according to the
+// context overflow options of the session config, where the turns start at the
+// user messages.
+class ConversationBasic : public Engine::Conversation {
+ public:
+  // Creates a ConversationBasic object.
+  // - executor: The initialized LLM Executor to call.
+  // - tokenizer: The tokenizer to encode/decode the text into token ids.
+  // - session_config: The config providing the prompt templates, the stop
+  //   tokens, the start token and the sampler parameters.
+  // - memory_reservation: The memory accounted to the conversation, released
+  //   when the conversation is destroyed.
+  static absl::StatusOr<std::unique_ptr<ConversationBasic>> Create(
+      LlmExecutor* absl_nonnull executor, Tokenizer* absl_nonnull tokenizer,
+      const SessionConfig& session_config,
+      std::optional<BenchmarkInfo> benchmark_info,
+      ThreadPool* absl_nonnull worker_thread_pool,
+      MemoryReservation memory_reservation = MemoryReservation());
+
+  virtual ~ConversationBasic();
+
+  absl::StatusOr<Responses> GenerateReply(
+      const std::vector<Message>& messages) override;
+
+  absl::Status GenerateReplyStream(const std::vector<Message>& messages,
+                                   InferenceObservable* observer) override;
+
+  void SetCancelFlag(const std::atomic_bool* cancel) override {
+    cancel_ = cancel;
+  }
+
+  void SetDeadline(absl::Time deadline) override { deadline_ = deadline; }
+
+  absl::StatusOr<BenchmarkInfo> GetBenchmarkInfo() override;
+
+  // Returns the token ids currently resident in the KV cache, i.e. the
+  // encoded history of the last turn followed by the generated reply.
+  const std::vector<int>& GetResidentTokenIds() const {
+    return resident_token_ids_;
+  }
+
+  // Returns the number of resident tokens reused by the last turn.
+  int GetNumReusedTokens() const { return num_reused_tokens_; }
+
+  // Returns the number of tokens prefilled by the last turn.
+  int GetNumPrefilledTokens() const { return num_prefilled_tokens_; }
+
+ private:
+  // The pre-tokenized prompt templates of each role.
+  struct RoleAffixes {
+    TokenizedPromptAffixes system;
+    TokenizedPromptAffixes user;
+    TokenizedPromptAffixes model;
+  };
+
+  explicit ConversationBasic(LlmExecutor* absl_nonnull executor,
+                             Tokenizer* absl_nonnull tokenizer,
+                             std::unique_ptr<Sampler> sampler,
+                             const SessionConfig& session_config,
+                             std::optional<BenchmarkInfo> benchmark_info,
+                             ThreadPool* absl_nonnull worker_thread_pool,
+                             const StopTokenDetector& stop_token_detector,
+                             RoleAffixes role_affixes,
+                             MemoryReservation memory_reservation)
+      : executor_(*executor),
+        tokenizer_(*tokenizer),
+        sampler_(std::move(sampler)),
+        session_config_(session_config),
+        benchmark_info_(benchmark_info),
+        worker_thread_pool_(*worker_thread_pool),
+        stop_token_detector_(stop_token_detector),
+        role_affixes_(std::move(role_affixes)),
+        memory_reservation_(std::move(memory_reservation)) {}
+
+  // Encodes the full history followed by the model turn prefix.
+  absl::StatusOr<std::vector<int>> EncodeHistory(
+      const std::vector<Message>& messages);
+
+  // Brings the KV cache to `token_ids` by keeping the common prefix with the
+  // resident tokens and prefilling the rest. Returns the last token id.
+  absl::StatusOr<int> SyncKvCache(const std::vector<int>& token_ids);
+
+  // Truncates the KV cache and the resident token ids to `length` tokens, or
+  // drops them if the executor cannot rewind.
+  absl::Status TruncateKvCache(int length);
+
+  // Encodes the history and syncs the KV cache with it. Returns the last
+  // token id.
+  absl::StatusOr<int> PrefillTurn(const std::vector<Message>& messages);
+
+  // Decodes the reply and appends the sampled token ids to `decoded_ids`.
+  absl::StatusOr<Responses> DecodeReply(int last_token_id,
+                                        std::vector<int>& decoded_ids);
+
+  // Returns the limits of the decodes from the cancel flag, the deadline and
+  // the session config.
+  DecodeLimits GetDecodeLimits() const;
+
+  // Selects the adapter and the sequence of the conversation on the executor,
+  // which is shared by the sessions.
+  absl::Status ActivateOnExecutor();
+
+  // Same as DecodeReply, but the reply is streamed through `observer`.
+  absl::Status DecodeReplyStreaming(int last_token_id,
+                                    std::vector<int>& decoded_ids,
+                                    InferenceObservable* observer);
+
+  // The internal function running a whole turn on the worker thread. The
+  // reply is streamed through `observer` if not null.
+  absl::StatusOr<Responses> GenerateReplyInternal(
+      const std::vector<Message>& messages,
+      InferenceObservable* absl_nullable observer = nullptr);
+
+  // The executor used for run the LLM for prefill/decode.
+  LlmExecutor& executor_;
+
+  // The sequence of the conversation on the executor.
+  const int sequence_id_ = NewExecutorSequenceId();
+
+  // The tokenizer used for converting between text to token ids.
+  Tokenizer& tokenizer_;
+
+  // The sampler used for sampling the next token id from the logits. It is
+  // null when the sampling is done inside the executor.
+  std::unique_ptr<Sampler> sampler_;
+
+  // The session config used for the conversation.
+  SessionConfig session_config_;
+
+  // The benchmark info used for the conversation.
+  std::optional<BenchmarkInfo> benchmark_info_;
+
+  // The thread pool used for the conversation.
+  ThreadPool& worker_thread_pool_;
+
+  // The thread handling the tokens of the pipelined decodes, created by the
+  // first one and kept for the next ones.
+  std::unique_ptr<ThreadPool> decode_consumer_thread_pool_;
+
+  // The stop token detector used for the conversation.
+  StopTokenDetector stop_token_detector_;
+
+  // The pre-tokenized prompt templates of each role.
+  RoleAffixes role_affixes_;
+
+  // The memory accounted to the conversation, e.g. for its sampler.
+  MemoryReservation memory_reservation_;
+
+  // The token ids fed to the executor so far, in order.
+  std::vector<int> resident_token_ids_;
+
+  // The replies generated by this conversation, keyed by the returned text.
+  // The values are the sampled token ids without the trailing stop tokens, so
+  // that a resent reply is encoded exactly as it sits in the KV cache.
+  absl::flat_hash_map<std::string, std::vector<int>> generated_replies_;
+
+  // Statistics of the last turn.
+  int num_reused_tokens_ = 0;
+  int num_prefilled_tokens_ = 0;
+
+  // The flag cancelling the prefills and decodes, if any.
+  const std::atomic_bool* cancel_ = nullptr;
+
+  // The deadline of the prefills and decodes.
+  absl::Time deadline_ = absl::InfiniteFuture();
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_CONVERSATION_BASIC_H_
@@ -0,0 +1,307 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/core/conversation_basic.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/components/token_id_util.h"
+#include "runtime/components/tokenizer.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/executor/fake_llm_executor.h"
+#include "runtime/framework/threadpool.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+constexpr int kStartTokenId = 2;
+constexpr int kStopTokenId = '|';
+
+// A byte level tokenizer mapping every character to its value.
+class ByteTokenizer : public Tokenizer {
+ public:
+  absl::StatusOr<std::vector<int>> TextToTokenIds(
+      absl::string_view text) override {
+    return std::vector<int>(text.begin(), text.end());
+  }
+
+  absl::StatusOr<std::string> TokenIdsToText(
+      const std::vector<int>& token_ids) override {
+    return std::string(token_ids.begin(), token_ids.end());
+  }
+};
+
+std::vector<int> Ids(absl::string_view text) {
+  return std::vector<int>(text.begin(), text.end());
+}
+
+std::vector<int> Concat(std::vector<int> a, const std::vector<int>& b) {
+  a.insert(a.end(), b.begin(), b.end());
+  return a;
+}
+
+class ConversationBasicTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    session_config_.SetStartTokenId(kStartTokenId);
+    session_config_.GetMutableStopTokenIds() = {{kStopTokenId}};
+    auto& templates = session_config_.GetMutablePromptTemplates();
+    templates.mutable_user()->set_prefix("U:");
+    templates.mutable_user()->set_suffix("\n");
+    // The model turn is closed by the stop token, like "<end_of_turn>".
+    templates.mutable_model()->set_prefix("M:");
+    templates.mutable_model()->set_suffix("|\n");
+
+    worker_thread_pool_ = std::make_unique<ThreadPool>(/*name_prefix=*/"engine",
+                                                       /*max_num_threads=*/1);
+  }
+
+  ByteTokenizer tokenizer_;
+  SessionConfig session_config_ = SessionConfig::CreateDefault();
+  std::unique_ptr<ThreadPool> worker_thread_pool_;
+};
+
+TEST_F(ConversationBasicTest, OnlyPrefillsNewMessages) {
+  const std::vector<int> first_turn =
+      Concat({kStartTokenId}, Ids("U:hi\nM:"));
+  const std::vector<int> second_turn = Ids("\nU:yo\nM:");
+  FakeLlmExecutor executor(
+      /*vocab_size=*/256, /*prefill_tokens_set=*/{first_turn, second_turn},
+      /*decode_tokens_set=*/{{'o'}, {'k'}, {'|'}, {'s'}, {'|'}});
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+
+  std::vector<Message> messages = {{"user", "hi"}};
+  ASSERT_OK_AND_ASSIGN(auto responses, conversation->GenerateReply(messages));
+  ASSERT_OK_AND_ASSIGN(absl::string_view reply,
+                       responses.GetResponseTextAt(0));
+  EXPECT_EQ(reply, "ok|");
+  EXPECT_EQ(conversation->GetNumReusedTokens(), 0);
+  EXPECT_EQ(conversation->GetNumPrefilledTokens(), first_turn.size());
+
+  // The client resends the whole history. Only the new user message (and the
+  // newline closing the previous model turn) is prefilled.
+  messages.push_back({"assistant", std::string(reply)});
+  messages.push_back({"user", "yo"});
+  ASSERT_OK_AND_ASSIGN(responses, conversation->GenerateReply(messages));
+  ASSERT_OK_AND_ASSIGN(reply, responses.GetResponseTextAt(0));
+  EXPECT_EQ(reply, "s|");
+  EXPECT_EQ(conversation->GetNumReusedTokens(), first_turn.size() + 3);
+  EXPECT_EQ(conversation->GetNumPrefilledTokens(), second_turn.size());
+  EXPECT_THAT(conversation->GetResidentTokenIds(),
+              ElementsAreArray(Concat(Concat(first_turn, Ids("ok|")),
+                                      Concat(second_turn, Ids("s|")))));
+}
+
+TEST_F(ConversationBasicTest, StartsOverWhenAnotherSessionResetTheExecutor) {
+  const std::vector<int> first_turn =
+      Concat({kStartTokenId}, Ids("U:hi\nM:"));
+  const std::vector<int> history =
+      Concat(Concat(first_turn, Ids("ok|")), Ids("\nU:yo\nM:"));
+  FakeLlmExecutor executor(
+      /*vocab_size=*/256, /*prefill_tokens_set=*/{first_turn, history},
+      /*decode_tokens_set=*/{{'o'}, {'k'}, {'|'}, {'s'}, {'|'}});
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+
+  std::vector<Message> messages = {{"user", "hi"}};
+  ASSERT_OK(conversation->GenerateReply(messages));
+  // The fake executor has no sequences, so a session resets it when done.
+  ASSERT_OK(executor.Reset());
+
+  messages.push_back({"assistant", "ok|"});
+  messages.push_back({"user", "yo"});
+  ASSERT_OK(conversation->GenerateReply(messages));
+  EXPECT_EQ(conversation->GetNumReusedTokens(), 0);
+  EXPECT_EQ(conversation->GetNumPrefilledTokens(), history.size());
+}
+
+// Collects the streamed text.
+class CollectingObserver : public InferenceObservable {
+ public:
+  void OnNext(const Responses& responses) override {
+    text_ += *responses.GetResponseTextAt(0);
+  }
+  void OnDone() override { done_ = true; }
+  void OnError(const absl::Status& status) override { status_ = status; }
+
+  const std::string& text() const { return text_; }
+  bool done() const { return done_; }
+  const absl::Status& status() const { return status_; }
+
+ private:
+  std::string text_;
+  bool done_ = false;
+  absl::Status status_;
+};
+
+TEST_F(ConversationBasicTest, StreamedReplyIsReused) {
+  const std::vector<int> first_turn =
+      Concat({kStartTokenId}, Ids("U:hi\nM:"));
+  const std::vector<int> second_turn = Ids("\nU:yo\nM:");
+  FakeLlmExecutor executor(
+      /*vocab_size=*/256, /*prefill_tokens_set=*/{first_turn, second_turn},
+      /*decode_tokens_set=*/{{'o'}, {'k'}, {'|'}, {'s'}, {'|'}});
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+
+  std::vector<Message> messages = {{"user", "hi"}};
+  CollectingObserver observer;
+  ASSERT_OK(conversation->GenerateReplyStream(messages, &observer));
+  EXPECT_TRUE(observer.done());
+  EXPECT_EQ(observer.text(), "ok|");
+
+  // The streamed reply is recognized when it is resent.
+  messages.push_back({"assistant", observer.text()});
+  messages.push_back({"user", "yo"});
+  ASSERT_OK(conversation->GenerateReply(messages));
+  EXPECT_EQ(conversation->GetNumReusedTokens(), first_turn.size() + 3);
+  EXPECT_EQ(conversation->GetNumPrefilledTokens(), second_turn.size());
+}
+
+TEST_F(ConversationBasicTest, CancelledPrefill) {
+  FakeLlmExecutor executor(
+      /*vocab_size=*/256,
+      /*prefill_tokens_set=*/{Concat({kStartTokenId}, Ids("U:hi\nM:"))},
+      /*decode_tokens_set=*/{{'|'}});
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+  std::atomic_bool cancel = true;
+  conversation->SetCancelFlag(&cancel);
+  CollectingObserver observer;
+  EXPECT_THAT(conversation->GenerateReplyStream({{"user", "hi"}}, &observer),
+              testing::status::StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_THAT(observer.status(),
+              testing::status::StatusIs(absl::StatusCode::kCancelled));
+
+  // The conversation is still usable.
+  cancel = false;
+  ASSERT_OK(conversation->GenerateReply({{"user", "hi"}}));
+}
+
+TEST_F(ConversationBasicTest, DivergedHistoryRewindsToCommonPrefix) {
+  const std::vector<int> first_turn =
+      Concat({kStartTokenId}, Ids("U:hi\nM:"));
+  // Only the tokens after the common prefix "<bos>U:h" are prefilled again.
+  const std::vector<int> edited_turn = Ids("ey\nM:");
+  FakeLlmExecutor executor(
+      /*vocab_size=*/256, /*prefill_tokens_set=*/{first_turn, edited_turn},
+      /*decode_tokens_set=*/{{'o'}, {'|'}, {'n'}, {'|'}});
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+
+  ASSERT_OK(conversation->GenerateReply({{"user", "hi"}}));
+  // The client edited the first message.
+  ASSERT_OK_AND_ASSIGN(auto responses,
+                       conversation->GenerateReply({{"user", "hey"}}));
+  ASSERT_OK_AND_ASSIGN(absl::string_view reply,
+                       responses.GetResponseTextAt(0));
+  EXPECT_EQ(reply, "n|");
+  EXPECT_EQ(conversation->GetNumReusedTokens(), 4);
+  EXPECT_EQ(conversation->GetNumPrefilledTokens(), edited_turn.size());
+  EXPECT_EQ(*executor.GetCurrentStep(), 4 + edited_turn.size() + 2);
+}
+
+TEST_F(ConversationBasicTest, DropsOldestTurnsWhenHistoryOverflows) {
+  session_config_.GetMutableContextOverflowOptions().policy =
+      ContextOverflowPolicy::kDropOldestTurns;
+  const std::vector<int> first_turn =
+      Concat({kStartTokenId}, Ids("U:hi\nM:"));
+  // Only the start token and the last turn fit in the context. The tokens
+  // after the common prefix "<bos>U:" are prefilled.
+  const std::vector<int> last_turn = Ids("U:yo\nM:");
+  FakeLlmExecutor executor(
+      /*vocab_size=*/256, /*prefill_tokens_set=*/{first_turn, Ids("yo\nM:")},
+      /*decode_tokens_set=*/{{'o'}, {'k'}, {'|'}, {'s'}, {'|'}});
+  executor.GetMutableExecutorSettings().value()->SetMaxNumTokens(12);
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+
+  ASSERT_OK(conversation->GenerateReply({{"user", "hi"}}));
+  ASSERT_OK_AND_ASSIGN(
+      auto responses,
+      conversation->GenerateReply(
+          {{"user", "hi"}, {"assistant", "ok|"}, {"user", "yo"}}));
+  ASSERT_OK_AND_ASSIGN(absl::string_view reply,
+                       responses.GetResponseTextAt(0));
+  EXPECT_EQ(reply, "s|");
+  EXPECT_EQ(conversation->GetNumReusedTokens(), 3);
+  EXPECT_EQ(conversation->GetNumPrefilledTokens(), last_turn.size() - 2);
+  EXPECT_THAT(conversation->GetResidentTokenIds(),
+              ElementsAreArray(
+                  Concat(Concat({kStartTokenId}, last_turn), Ids("s|"))));
+}
+
+TEST_F(ConversationBasicTest, HistoryOverflowFailsByDefault) {
+  FakeLlmExecutor executor(/*vocab_size=*/256, /*prefill_tokens_set=*/{},
+                           /*decode_tokens_set=*/{});
+  executor.GetMutableExecutorSettings().value()->SetMaxNumTokens(4);
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+  EXPECT_EQ(conversation->GenerateReply({{"user", "hi"}}).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(ConversationBasicTest, InvalidMessages) {
+  FakeLlmExecutor executor(/*vocab_size=*/256, /*prefill_tokens_set=*/{},
+                           /*decode_tokens_set=*/{});
+  ASSERT_OK_AND_ASSIGN(
+      auto conversation,
+      ConversationBasic::Create(&executor, &tokenizer_, session_config_,
+                                /*benchmark_info=*/std::nullopt,
+                                worker_thread_pool_.get()));
+  EXPECT_EQ(conversation->GenerateReply({}).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(conversation->GenerateReply({{"assistant", "hi"}}).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(conversation->GenerateReply({{"tool", "hi"}}).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace litert::lm
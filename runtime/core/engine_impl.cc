@@ -14,6 +14,8 @@
 
 // TODO(b/417209286): Remove this once the model assets are stored in the
 // litertlm file format.
+#include <atomic>
+#include <cstddef>
 #include <filesystem>  // NOLINT: Required for path manipulation.
 #include <memory>
 #include <optional>
@@ -21,17 +23,24 @@
 #include <utility>
 #include <vector>
 
+#include "absl/functional/any_invocable.h"  // from @com_google_absl
 #include "absl/log/absl_check.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/log/check.h"  // from @com_google_absl
 #include "absl/log/log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/components/cached_tokenizer.h"
 #include "runtime/components/model_resources.h"
 #include "runtime/components/sentencepiece_tokenizer.h"
+#include "runtime/components/tokenizer.h"
+#include "runtime/core/conversation_basic.h"
+#include "runtime/core/pipeline.h"
 #include "runtime/core/session_factory.h"
+#include "runtime/core/session_pool.h"
 #include "runtime/engine/engine.h"
 #include "runtime/engine/engine_settings.h"
 #include "runtime/engine/io_types.h"
@@ -41,18 +50,21 @@
 #include "runtime/executor/llm_executor_settings.h"
 #include "runtime/executor/llm_litert_compiled_model_executor.h"
 #include "runtime/executor/llm_litert_npu_compiled_model_executor.h"
+#include "runtime/executor/weight_cache_manager.h"
 #include "runtime/framework/threadpool.h"
 #include "runtime/proto/llm_metadata.pb.h"
 #include "runtime/proto/sampler_params.pb.h"
 #include "runtime/util/file_format_util.h"
+#include "runtime/util/memory_tracker.h"
 #include "runtime/util/status_macros.h"  // NOLINT
 
 namespace litert::lm {
 namespace {
 
 // Builds the LiteRT compiled model executor.
-absl::StatusOr<std::unique_ptr<LlmExecutor>> BuildLitertCompiledModelExecutor(
-    LlmExecutorSettings executor_settings, ModelResources& model_resources) {
+absl::StatusOr<std::unique_ptr<LlmLiteRtCompiledModelExecutor>>
+BuildLitertCompiledModelExecutor(LlmExecutorSettings executor_settings,
+                                 ModelResources& model_resources) {
   if (executor_settings.GetModelAssets().HasScopedFile()) {
     return absl::InvalidArgumentError("Model must be passed as a single path.");
   }
@@ -74,6 +86,19 @@ constexpr absl::string_view kVocabName = "gemma3_tokenizer.spiece";
 using ::odml::infra::LlmLiteRtNpuCompiledModelExecutor::ModelQuantization::
     kAllQuantized;
 
+// Returns the memory of the sampler of a session decoding `batch_size`
+// candidates, i.e. the logits it copies to the host for each step.
+absl::StatusOr<size_t> EstimateSamplerMemoryBytes(LlmExecutor& executor,
+                                                  Backend sampler_backend,
+                                                  int batch_size) {
+  if (sampler_backend != Backend::CPU) {
+    // The sampling is done by the executor, with its own buffers.
+    return 0;
+  }
+  ASSIGN_OR_RETURN(int vocab_size, executor.GetVocabSize());
+  return static_cast<size_t>(batch_size) * vocab_size * sizeof(float);
+}
+
 }  // namespace
 
 class EngineImpl : public Engine {
@@ -83,7 +108,11 @@ class EngineImpl : public Engine {
   }
 
   explicit EngineImpl(EngineSettings engine_settings)
-      : engine_settings_(std::move(engine_settings)) {
+      : engine_settings_(std::move(engine_settings)),
+        memory_tracker_(std::make_unique<MemoryTracker>(
+            engine_settings_.GetMemoryBudgetBytes())),
+        session_pool_(std::make_unique<SessionPool>(
+            engine_settings_.GetSessionPoolSize())) {
     if (engine_settings_.IsBenchmarkEnabled()) {
       benchmark_info_ = std::make_optional<BenchmarkInfo>(
           engine_settings_.GetBenchmarkParams().value());
@@ -122,10 +151,22 @@ class EngineImpl : public Engine {
       auto executor = BuildLitertCompiledModelExecutor(
           engine_settings_.GetMainExecutorSettings(), *litert_model_resources_);
       ABSL_QCHECK_OK(executor);
+      const std::optional<WeightCacheStats> weight_cache_stats =
+          (*executor)->GetWeightCacheStats();
       executor_ = std::move(*executor);
       if (benchmark_info_.has_value()) {
         ABSL_CHECK_OK(
             benchmark_info_->TimeInitPhaseEnd("Executor initialization"));
+        if (weight_cache_stats.has_value()) {
+          ABSL_CHECK_OK(benchmark_info_->AddInitPhase(
+              weight_cache_stats->hit ? "Weight cache hit"
+                                      : "Weight cache miss",
+              weight_cache_stats->init_duration));
+          if (weight_cache_stats->hit) {
+            ABSL_CHECK_OK(benchmark_info_->AddInitPhase(
+                "Weight cache time saved", weight_cache_stats->time_saved));
+          }
+        }
         ABSL_CHECK_OK(
             benchmark_info_->TimeInitPhaseStart("Tokenizer initialization"));
       }
@@ -181,11 +222,54 @@ class EngineImpl : public Engine {
       }
     }
 
+    // The buffers of the executor are allocated once and shared by all the
+    // sessions, so they are accounted to the engine regardless of the budget.
+    auto executor_memory_usage = executor_->GetMemoryUsage();
+    if (executor_memory_usage.ok()) {
+      for (const auto& [component, bytes] : *executor_memory_usage) {
+        engine_memory_reservations_.push_back(
+            memory_tracker_->Track("engine", component, bytes));
+      }
+    } else {
+      ABSL_LOG(INFO) << "The memory of the executor is not accounted: "
+                     << executor_memory_usage.status();
+    }
+    // The KV caches of the sequences grow with the sessions, so they are
+    // accounted by the executor as they are saved, against the budget.
+    executor_->SetMemoryTracker(memory_tracker_.get());
+
     // Creating the thread pool of a single thread to execute the works.
     worker_thread_pool_ = std::make_unique<ThreadPool>(/*name_prefix=*/"engine",
                                                        /*max_num_threads=*/1);
   }
 
+  // Completes the initialization with the steps which can fail without
+  // aborting, so that Engine::CreateEngine returns their status.
+  absl::Status Initialize() {
+    // Share a single encode cache across all the sessions so that repeated
+    // message chunks (e.g. system prompts) are only tokenized once.
+    Tokenizer* tokenizer = tokenizer_without_model_resources_.get();
+    if (tokenizer == nullptr) {
+      RET_CHECK(litert_model_resources_ != nullptr);
+      ASSIGN_OR_RETURN(tokenizer, litert_model_resources_->GetTokenizer());
+    }
+    cached_tokenizer_ = std::make_unique<CachedTokenizer>(tokenizer);
+
+    // The adapters share the weights of the main model, only their LoRA
+    // weights are loaded.
+    for (const auto& [name, model_assets] :
+         engine_settings_.GetLoRAAdapters()) {
+      absl::Status status = executor_->LoadLoRA(name, model_assets);
+      if (!status.ok()) {
+        return absl::Status(
+            status.code(),
+            absl::StrCat("Failed to load the LoRA adapter ", name, ": ",
+                         status.message()));
+      }
+    }
+    return absl::OkStatus();
+  }
+
   // Method to create the Session.
   absl::StatusOr<std::unique_ptr<Session>> CreateSession(
       const SessionConfig& session_config) const override {
@@ -193,21 +277,129 @@ class EngineImpl : public Engine {
     // TODO(b/418794726): Move this logics to be part of the SessionConfig
     // class.
     RETURN_IF_ERROR(config.MaybeUpdateAndValidate(engine_settings_));  // NOLINT
-    auto* tokenizer = tokenizer_without_model_resources_.get();
-    if (tokenizer == nullptr) {
-      ABSL_CHECK(litert_model_resources_ != nullptr);
-      ASSIGN_OR_RETURN(tokenizer, litert_model_resources_->GetTokenizer());  // NOLINT
-    }
-    return InitializeSession(executor_.get(), tokenizer, config,
-                             benchmark_info_, worker_thread_pool_.get());
+    ASSIGN_OR_RETURN(MemoryReservation memory_reservation,
+                     ReserveSessionMemory(config.GetSamplerBackend(),
+                                          config.GetNumOutputCandidates()));
+    return InitializeSession(executor_.get(), cached_tokenizer_.get(), config,
+                             benchmark_info_, worker_thread_pool_.get(),
+                             std::move(memory_reservation),
+                             session_pool_.get());
   }
+  absl::StatusOr<std::unique_ptr<Conversation>> CreateConversation(
+      const SessionConfig& session_config) const override {
+    SessionConfig config = session_config;
+    RETURN_IF_ERROR(config.MaybeUpdateAndValidate(engine_settings_));  // NOLINT
+    ASSIGN_OR_RETURN(MemoryReservation memory_reservation,
+                     ReserveSessionMemory(config.GetSamplerBackend(),
+                                          /*batch_size=*/1));
+    return ConversationBasic::Create(executor_.get(), cached_tokenizer_.get(),
+                                     config, benchmark_info_,
+                                     worker_thread_pool_.get(),
+                                     std::move(memory_reservation));
+  }
+  absl::StatusOr<std::vector<std::vector<float>>> Embed(
+      const std::vector<InputData>& texts,
+      const EmbeddingOptions& options) override {
+    ASSIGN_OR_RETURN(std::vector<std::vector<int>> token_ids,
+                     TokenizeTexts(texts));
+    absl::StatusOr<std::vector<std::vector<float>>> embeddings;
+    RETURN_IF_ERROR(RunOnBaseModel([&]() -> absl::Status {
+      ASSIGN_OR_RETURN(embeddings,
+                       litert::lm::Embed(*executor_, token_ids, options));
+      return absl::OkStatus();
+    }));
+    return embeddings;
+  }
+
+  absl::StatusOr<std::vector<std::vector<TokenLogProb>>> PredictNextTokens(
+      const std::vector<InputData>& prompts, int num_top) override {
+    ASSIGN_OR_RETURN(std::vector<std::vector<int>> token_ids,
+                     TokenizeTexts(prompts));
+    absl::StatusOr<std::vector<std::vector<TokenLogProb>>> next_tokens;
+    RETURN_IF_ERROR(RunOnBaseModel([&]() -> absl::Status {
+      ASSIGN_OR_RETURN(next_tokens, litert::lm::PredictNextTokens(
+                                        *executor_, *cached_tokenizer_,
+                                        token_ids, num_top));
+      return absl::OkStatus();
+    }));
+    return next_tokens;
+  }
+
+  absl::StatusOr<MemoryUsage> GetMemoryUsage() const override {
+    return memory_tracker_->GetUsage();
+  }
+
+  absl::StatusOr<SessionPoolStats> GetSessionPoolStats() const override {
+    return session_pool_->GetStats();
+  }
+
   absl::Status WaitUntilDone(absl::Duration timeout) override {
     return worker_thread_pool_->WaitUntilDone(timeout);
   }
 
  private:
+  // Reserves the memory of a new session or conversation against the budget,
+  // under a name of its own. It fails once the budget is used up, including
+  // by the KV caches saved for the other sessions.
+  absl::StatusOr<MemoryReservation> ReserveSessionMemory(
+      Backend sampler_backend, int batch_size) const {
+    ASSIGN_OR_RETURN(size_t bytes,
+                     EstimateSamplerMemoryBytes(*executor_, sampler_backend,
+                                                batch_size));
+    return memory_tracker_->Reserve(
+        absl::StrCat("session_", next_session_id_.fetch_add(1)),
+        MemoryComponent::kSampler, bytes);
+  }
+
+  // Tokenizes the texts prefilled on their own, i.e. not added to a session,
+  // each starting with the start token like the prompts of the sessions.
+  absl::StatusOr<std::vector<std::vector<int>>> TokenizeTexts(
+      const std::vector<InputData>& texts) const {
+    SessionConfig config = SessionConfig::CreateDefault();
+    RETURN_IF_ERROR(config.MaybeUpdateAndValidate(engine_settings_));
+    std::vector<std::vector<int>> token_ids;
+    token_ids.reserve(texts.size());
+    for (const auto& text : texts) {
+      std::optional<std::string> text_string = ToString(text);
+      if (!text_string.has_value()) {
+        return absl::InvalidArgumentError("Only texts are supported.");
+      }
+      std::vector<int>& ids = token_ids.emplace_back();
+      ids.push_back(config.GetStartTokenId());
+      ASSIGN_OR_RETURN(std::vector<int> text_ids,
+                       cached_tokenizer_->TextToTokenIds(*text_string));
+      ids.insert(ids.end(), text_ids.begin(), text_ids.end());
+    }
+    return token_ids;
+  }
+
+  // Runs `work` with the base model on the worker thread, between the works
+  // of the sessions, and waits for it.
+  absl::Status RunOnBaseModel(absl::AnyInvocable<absl::Status()> work) {
+    absl::Status status;
+    RETURN_IF_ERROR(worker_thread_pool_->Schedule([&]() {
+      // The sessions select their adapter before each of their works.
+      status = executor_->SetActiveLoRA(std::nullopt);
+      if (status.ok()) {
+        status = work();
+      }
+    }));
+    RETURN_IF_ERROR(worker_thread_pool_->WaitUntilDone(Engine::kDefaultTimeout));
+    return status;
+  }
+
   // Stored engine settings.
   EngineSettings engine_settings_;
+  // The memory accounted to the engine and its sessions. It outlives the
+  // reservations of the engine and of the sessions.
+  std::unique_ptr<MemoryTracker> memory_tracker_;
+  // The memory of the executor, accounted to the engine.
+  std::vector<MemoryReservation> engine_memory_reservations_;
+  // The id of the next session, naming its memory in the tracker.
+  mutable std::atomic<int> next_session_id_ = 0;
+  // The resources of the destroyed sessions, kept for the next ones. It
+  // outlives the sessions, like the executor.
+  std::unique_ptr<SessionPool> session_pool_;
   // Shared executor for all sessions.
   std::unique_ptr<LlmExecutor> executor_;
   // Default stop token ids for all sessions loaded from the model file.
@@ -215,6 +407,9 @@ class EngineImpl : public Engine {
   std::unique_ptr<ModelResources> litert_model_resources_;
   // It's for NPU path. Once NPU read litertlm file, this will be removed.
   std::unique_ptr<SentencePieceTokenizer> tokenizer_without_model_resources_;
+  // The tokenizer handed to the sessions. It wraps the tokenizer above (or the
+  // one owned by the model resources) with an LRU encode cache.
+  std::unique_ptr<CachedTokenizer> cached_tokenizer_;
   proto::SamplerParameters sampler_params_;
 
   // Benchmark info for the engine.
@@ -228,6 +423,7 @@ class EngineImpl : public Engine {
 absl::StatusOr<std::unique_ptr<Engine>> Engine::CreateEngine(
     EngineSettings settings_struct) {
   auto llm_impl = std::make_unique<EngineImpl>(std::move(settings_struct));
+  RETURN_IF_ERROR(llm_impl->Initialize());
   return llm_impl;
 };
 
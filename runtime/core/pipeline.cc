@@ -15,29 +15,40 @@
 #include "runtime/core/pipeline.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
 #include "absl/base/nullability.h"  // from @com_google_absl
+#include "absl/functional/function_ref.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/str_replace.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "absl/synchronization/notification.h"  // from @com_google_absl
 #include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_macros.h"  // from @litert
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
+#include "runtime/components/embedding_pooling.h"
 #include "runtime/components/sampler.h"
+#include "runtime/components/sampling_cpu_util.h"
 #include "runtime/components/stop_token_detector.h"
+#include "runtime/components/token_id_util.h"
 #include "runtime/components/tokenizer.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/llm_executor.h"
 #include "runtime/executor/llm_executor_io_types.h"
+#include "runtime/framework/spsc_queue.h"
+#include "runtime/framework/threadpool.h"
 #include "runtime/util/convert_tensor_buffer.h"
 #include "runtime/util/litert_status_util.h"
 #include "runtime/util/status_macros.h"  //NOLINT
@@ -61,28 +72,101 @@ int TryGetMaxNumTokens(const LlmExecutor& executor) {
   return settings->GetMaxNumTokens();
 }
 
+// Why the decoding loop stops.
+enum class StopReason {
+  // The decoding goes on.
+  kNone,
+  // The stop tokens or the benchmark ended the decoding.
+  kDone,
+  // The max number of steps of the limits ended the decoding, i.e. the
+  // response is truncated.
+  kMaxNumSteps,
+  // The KV cache has no room for the next step.
+  kKvCacheFull,
+};
+
 // Check whether the decoding loop should stop.
-bool ShouldStop(bool hit_stop_tokens, int benchmark_decode_token_count,
-                int num_decoded_steps, int current_step, int max_num_tokens,
-                InferenceObservable* observer) {
+StopReason ShouldStop(bool hit_stop_tokens, int benchmark_decode_token_count,
+                      int num_decoded_steps, int current_step,
+                      int max_num_tokens, const DecodeLimits& limits) {
   // Stopping conditions.
   if (hit_stop_tokens && benchmark_decode_token_count == 0) {
     // Only early stop if no decode step
     // is requested by benchmark.
-    return true;
+    return StopReason::kDone;
   } else if (benchmark_decode_token_count > 0 &&
              num_decoded_steps >= benchmark_decode_token_count) {
     // Stop when the number of decode steps is equal to the
     // benchmark_decode_token_count (when specified).
-    return true;
+    return StopReason::kDone;
+  } else if (limits.max_num_steps > 0 &&
+             num_decoded_steps >= limits.max_num_steps) {
+    // Stop when the caller's budget of output tokens is spent.
+    return StopReason::kMaxNumSteps;
   } else if (current_step >= max_num_tokens) {
     // Reaching maximum number of kv-cache size.
-    if (observer != nullptr) {
-      observer->OnError(absl::InternalError("Maximum kv-cache size reached."));
-    }
-    return true;
+    return StopReason::kKvCacheFull;
   }
-  return false;
+  return StopReason::kNone;
+}
+
+// Reports the end of a streamed decode to the observer.
+void NotifyDecodeEnd(StopReason stop_reason, InferenceObservable& observer) {
+  if (stop_reason == StopReason::kKvCacheFull) {
+    observer.OnError(absl::InternalError("Maximum kv-cache size reached."));
+  } else {
+    observer.OnDone();
+  }
+}
+
+// Returns the token id with its text and log probability.
+absl::StatusOr<TokenLogProb> MakeTokenLogProb(Tokenizer& tokenizer,
+                                              int token_id, float log_prob) {
+  ASSIGN_OR_RETURN(std::string token, tokenizer.TokenIdsToText({token_id}));
+  return TokenLogProb{.token_id = token_id,
+                      .token = absl::StrReplaceAll(token, {{"▁", " "}}),
+                      .log_prob = log_prob};
+}
+
+// Returns the logits predicting each of the token ids from the tokens before
+// it, the first one following `last_token_id`, pending in the executor. The
+// logits are in the shape of [token_ids.size(), vocab_size].
+absl::StatusOr<std::vector<float>> GetTeacherForcedLogits(
+    LlmExecutor& executor, int last_token_id,
+    const std::vector<int>& token_ids, const DecodeLimits& limits) {
+  LITERT_ASSIGN_OR_RETURN_ABSL(
+      auto ids_buffer,
+      CopyToTensorBuffer<int>(token_ids,
+                              {1, static_cast<int>(token_ids.size())}));
+  absl::StatusOr<litert::TensorBuffer> prefill_logits =
+      executor.PrefillLogits(ExecutorInputs(
+          ExecutorTextData(std::move(ids_buffer)), std::nullopt, std::nullopt));
+  if (prefill_logits.ok()) {
+    LITERT_ASSIGN_OR_RETURN_ABSL(auto logits,
+                                 CopyFromTensorBuffer<float>(*prefill_logits));
+    return logits;
+  }
+  if (!absl::IsUnimplemented(prefill_logits.status())) {
+    return prefill_logits.status();
+  }
+  // Without the logits of all the positions, the tokens are decoded one by
+  // one, each fed as the input of the next step.
+  std::vector<float> logits;
+  int input_id = last_token_id;
+  for (int token_id : token_ids) {
+    RETURN_IF_ERROR(limits.Check());
+    LITERT_ASSIGN_OR_RETURN_ABSL(auto input_buffer,
+                                 CopyToTensorBuffer<int>({input_id}, {1, 1}));
+    ASSIGN_OR_RETURN(auto step_logits_buffer,
+                     executor.DecodeLogits(ExecutorInputs(
+                         ExecutorTextData(std::move(input_buffer)),
+                         std::nullopt, std::nullopt)));
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto step_logits, CopyFromTensorBuffer<float>(step_logits_buffer));
+    logits.insert(logits.end(), step_logits.begin(), step_logits.end());
+    input_id = token_id;
+  }
+  return logits;
 }
 
 // A wrapper class to run one step of the decode process. It allows us to reduce
@@ -94,12 +178,14 @@ class DecodeExternalSampling {
                          Tokenizer* absl_nonnull tokenizer,
                          int num_output_candidates, Sampler& sampler,
                          const StopTokenDetector& stop_token_detector,
-                         std::optional<BenchmarkInfo>& benchmark_info)
+                         std::optional<BenchmarkInfo>& benchmark_info,
+                         std::optional<int> num_top_log_probs)
       : executor_(*executor),
         tokenizer_(*tokenizer),
         num_output_candidates_(num_output_candidates),
         sampler_(sampler),
         benchmark_info_(benchmark_info),
+        num_top_log_probs_(num_top_log_probs),
         stop_token_detector_(stop_token_detector) {
     auto scores_tensor = CreateTensorBuffer<float>({num_output_candidates_});
     scores_tensor_ = std::move(*scores_tensor);
@@ -120,8 +206,21 @@ class DecodeExternalSampling {
       RETURN_IF_ERROR(benchmark_info_->TimeMarkDelta("executor_decode"));
       RETURN_IF_ERROR(benchmark_info_->TimeMarkDelta("sampling"));
     }
-    RETURN_IF_ERROR(sampler_.SampleToIdAndScoreBuffer(
-        output_logits, decoded_ids, &scores_tensor_));
+    // The random numbers of the sampled tokens are drawn from their position
+    // in the sequence, so that the same position sampled again, e.g. after a
+    // rewind, gets the same ones.
+    if (absl::StatusOr<int> step = executor_.GetCurrentStep(); step.ok()) {
+      sampler_.SetStep(*step);
+    }
+    if (num_top_log_probs_.has_value()) {
+      RETURN_IF_ERROR(sampler_.SampleWithLogProbs(output_logits, decoded_ids,
+                                                  &scores_tensor_,
+                                                  *num_top_log_probs_,
+                                                  log_probs_));
+    } else {
+      RETURN_IF_ERROR(sampler_.SampleToIdAndScoreBuffer(
+          output_logits, decoded_ids, &scores_tensor_));
+    }
     if (benchmark_info_.has_value()) {
       RETURN_IF_ERROR(benchmark_info_->TimeMarkDelta("sampling"));
     }
@@ -129,17 +228,20 @@ class DecodeExternalSampling {
                      tokenizer_.TensorBufferToText(decoded_ids));
 
     // Update the stop_tokens_found vector with the latest decoded ids.
-    LITERT_ASSIGN_OR_RETURN_ABSL(auto decoded_ids_span,
+    LITERT_ASSIGN_OR_RETURN_ABSL(decoded_ids_span_,
                                  ReferTensorBufferAsSpan<int>(decoded_ids));
     LITERT_ASSIGN_OR_RETURN_ABSL(
         scores_span_, ReferTensorBufferAsSpan<float>(scores_tensor_));
-    RETURN_IF_ERROR(stop_token_detector_.ProcessTokens(decoded_ids_span));
+    RETURN_IF_ERROR(stop_token_detector_.ProcessTokens(decoded_ids_span_));
     ASSIGN_OR_RETURN(bool hit_stop_tokens, stop_token_detector_.AllDone());
     return hit_stop_tokens;
   }
 
   absl::Span<float> GetScores() { return scores_span_; }
 
+  // Returns the token ids sampled in the last step, one per candidate.
+  absl::Span<const int> GetDecodedIds() const { return decoded_ids_span_; }
+
   const std::vector<std::string>& GetResultTokens() const {
     return result_tokens_;
   }
@@ -148,15 +250,38 @@ class DecodeExternalSampling {
     return stop_token_detector_.GetStopTokensFound();
   }
 
+  // Appends the log probabilities of the token sampled in the last step for
+  // the given candidate, if requested.
+  absl::Status AppendLogProbs(int candidate,
+                              std::vector<DecodedTokenLogProbs>& log_probs) {
+    if (!num_top_log_probs_.has_value()) {
+      return absl::OkStatus();
+    }
+    DecodedTokenLogProbs& decoded = log_probs.emplace_back();
+    ASSIGN_OR_RETURN(decoded.token,
+                     MakeTokenLogProb(tokenizer_, decoded_ids_span_[candidate],
+                                      log_probs_.log_probs[candidate]));
+    const int num_top = log_probs_.top_ids.size() / num_output_candidates_;
+    for (int i = candidate * num_top; i < (candidate + 1) * num_top; ++i) {
+      ASSIGN_OR_RETURN(decoded.top_tokens.emplace_back(),
+                       MakeTokenLogProb(tokenizer_, log_probs_.top_ids[i],
+                                        log_probs_.top_log_probs[i]));
+    }
+    return absl::OkStatus();
+  }
+
  private:
   LlmExecutor& executor_;
   Tokenizer& tokenizer_;
   const int num_output_candidates_;
   Sampler& sampler_;
   std::optional<BenchmarkInfo> benchmark_info_;
+  const std::optional<int> num_top_log_probs_;
+  SampledLogProbs log_probs_;
   litert::TensorBuffer scores_tensor_;
   std::vector<std::string> result_tokens_;
   absl::Span<float> scores_span_;
+  absl::Span<int> decoded_ids_span_;
   StopTokenDetector stop_token_detector_;
 };
 
@@ -197,6 +322,8 @@ class DecodeInternalSamplingOneStep {
       return absl::InternalError("Unexpected number of decoded tokens.");
     }
 
+    decoded_ids_span_ = output_tokens_span;
+
     ASSIGN_OR_RETURN(result_tokens_,
                      tokenizer_.TensorBufferToText(output_tokens_));
     RETURN_IF_ERROR(stop_token_detector_.ProcessTokens(output_tokens_span));
@@ -206,6 +333,9 @@ class DecodeInternalSamplingOneStep {
 
   absl::Span<float> GetScores() { return scores_span_; }
 
+  // Returns the token ids sampled in the last step, one per candidate.
+  absl::Span<const int> GetDecodedIds() const { return decoded_ids_span_; }
+
   const std::vector<std::string>& GetResultTokens() const {
     return result_tokens_;
   }
@@ -223,45 +353,126 @@ class DecodeInternalSamplingOneStep {
   litert::TensorBuffer output_tokens_;
   std::vector<std::string> result_tokens_;
   absl::Span<float> scores_span_;
+  absl::Span<int> decoded_ids_span_;
   StopTokenDetector stop_token_detector_;
 };
 
-}  // namespace
+// Lets the two threads of a pipelined decode wait for each other. Each one
+// calls Notify() after changing what the other one may wait for, i.e. after
+// pushing to or popping from their queue, or giving up.
+class PipelineWaiter {
+ public:
+  // Calls `try_once` until it succeeds or `give_up` returns true. It yields
+  // for a few attempts, enough to cover the handling of a token, and then
+  // blocks until the next Notify(), e.g. while waiting for a decode step.
+  // Returns whether `try_once` succeeded.
+  bool WaitUntil(absl::FunctionRef<bool()> try_once,
+                 absl::FunctionRef<bool()> give_up) {
+    constexpr int kNumYields = 100;
+    for (int attempt = 0; attempt < kNumYields; ++attempt) {
+      if (try_once()) {
+        return true;
+      }
+      if (give_up()) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    absl::MutexLock lock(&mutex_);
+    num_blocked_.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence of Notify(): either the other thread sees the
+    // blocked thread, or the blocked thread sees its change below.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool succeeded = false;
+    while (true) {
+      const int64_t generation = generation_;
+      if (try_once()) {
+        succeeded = true;
+        break;
+      }
+      if (give_up()) {
+        break;
+      }
+      while (generation_ == generation) {
+        cond_var_.Wait(&mutex_);
+      }
+    }
+    num_blocked_.fetch_sub(1, std::memory_order_relaxed);
+    return succeeded;
+  }
 
-absl::StatusOr<int> Prefill(LlmExecutor& executor, Tokenizer& tokenizer,
-                            absl::string_view prompt, int bos_token_id,
-                            bool wait_for_completion,
-                            std::optional<BenchmarkInfo>& benchmark_info) {
+  // Wakes up the other thread if it is blocked in WaitUntil(). It only takes
+  // the mutex if the other thread is blocked.
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_blocked_.load(std::memory_order_relaxed) > 0) {
+      absl::MutexLock lock(&mutex_);
+      ++generation_;
+      cond_var_.SignalAll();
+    }
+  }
+
+ private:
+  std::atomic<int> num_blocked_ = 0;
+  absl::Mutex mutex_;
+  absl::CondVar cond_var_;
+  // Incremented by each Notify() waking up a blocked thread.
+  int64_t generation_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Prefills the given token ids. The prefill turn of the benchmark (if any) is
+// expected to be started by the caller.
+absl::StatusOr<int> PrefillTokenIds(
+    LlmExecutor& executor, std::vector<int> ids,
+    std::optional<int> bos_token_id, bool wait_for_completion,
+    std::optional<BenchmarkInfo>& benchmark_info,
+    const ContextOverflowOptions& context_overflow_options,
+    const std::atomic_bool* cancel) {
   int benchmark_prefill_token_count = 0;
   if (benchmark_info.has_value()) {
     benchmark_prefill_token_count =
         benchmark_info->GetBenchmarkParams().num_prefill_tokens();
-    RETURN_IF_ERROR(benchmark_info->TimePrefillTurnStart());
   }
-  ASSIGN_OR_RETURN(std::vector<int> ids, tokenizer.TextToTokenIds(prompt));
+  const int max_num_tokens = TryGetMaxNumTokens(executor);
+  // The start token is written to the prefill buffer in front of the ids,
+  // rather than prepended to them, which would shift all of them.
+  int num_start_tokens = 0;
   if (benchmark_prefill_token_count > 0) {
     // If benchmark is enabled, we will use the benchmark prefill token count
     // to set the prefill token count.
     ids.resize(benchmark_prefill_token_count);
   } else {
-    ids.insert(ids.begin(), bos_token_id);
+    num_start_tokens = bos_token_id.has_value() ? 1 : 0;
+    // The ids are appended to the tokens already in the KV cache, and at least
+    // one more step is left for the decoding.
+    const int num_cached_tokens = executor.GetCurrentStep().value_or(0);
+    RETURN_IF_ERROR(FitTokenIdsToContext(
+        ids, /*start_token_id=*/std::nullopt,
+        max_num_tokens - num_cached_tokens - 1 - num_start_tokens,
+        context_overflow_options));
   }
-  const int max_num_tokens = TryGetMaxNumTokens(executor);
-  if (ids.size() >= max_num_tokens) {
+  const int num_prefill_tokens = num_start_tokens + ids.size();
+  if (num_prefill_tokens >= max_num_tokens) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Input token ids are too long. Exceeding the maximum number of tokens "
         "allowed: ",
-        ids.size(), " >= ", max_num_tokens));
+        num_prefill_tokens, " >= ", max_num_tokens));
+  }
+  if (num_prefill_tokens == 0) {
+    return absl::InternalError("Input token ids are empty.");
   }
-  ASSIGN_OR_RETURN(auto ids_buffer, tokenizer.TokenIdsToTensorBuffer(ids));
+  LITERT_ASSIGN_OR_RETURN_ABSL(
+      auto ids_buffer, CreateTensorBuffer<int>({1, num_prefill_tokens}));
   LITERT_ASSIGN_OR_RETURN_ABSL(auto ids_buffer_span,
                                ReferTensorBufferAsSpan<int>(ids_buffer));
-  if (ids_buffer_span.empty()) {
-    return absl::InternalError("Input token ids are empty.");
+  if (num_start_tokens > 0) {
+    ids_buffer_span[0] = *bos_token_id;
   }
+  std::copy(ids.begin(), ids.end(), ids_buffer_span.begin() + num_start_tokens);
   const int last_token_id = ids_buffer_span.back();
   ExecutorPrefillParams params;
   params.SetWaitForCompletion(wait_for_completion);
+  params.SetCancelFlag(cancel);
   RETURN_IF_ERROR(
       executor.Prefill(ExecutorInputs(ExecutorTextData(std::move(ids_buffer)),
                                       std::nullopt, std::nullopt),
@@ -272,9 +483,40 @@ absl::StatusOr<int> Prefill(LlmExecutor& executor, Tokenizer& tokenizer,
   return last_token_id;
 }
 
+}  // namespace
+
+absl::StatusOr<int> Prefill(LlmExecutor& executor, Tokenizer& tokenizer,
+                            absl::string_view prompt, int bos_token_id,
+                            bool wait_for_completion,
+                            std::optional<BenchmarkInfo>& benchmark_info) {
+  if (benchmark_info.has_value()) {
+    RETURN_IF_ERROR(benchmark_info->TimePrefillTurnStart());
+  }
+  ASSIGN_OR_RETURN(std::vector<int> ids, tokenizer.TextToTokenIds(prompt));
+  return PrefillTokenIds(executor, std::move(ids), bos_token_id,
+                         wait_for_completion, benchmark_info,
+                         ContextOverflowOptions(), /*cancel=*/nullptr);
+}
+
+absl::StatusOr<int> Prefill(
+    LlmExecutor& executor, Tokenizer& tokenizer, std::vector<int> token_ids,
+    std::optional<int> bos_token_id, bool wait_for_completion,
+    std::optional<BenchmarkInfo>& benchmark_info,
+    const ContextOverflowOptions& context_overflow_options,
+    const std::atomic_bool* cancel) {
+  if (benchmark_info.has_value()) {
+    RETURN_IF_ERROR(benchmark_info->TimePrefillTurnStart());
+  }
+  return PrefillTokenIds(executor, std::move(token_ids), bos_token_id,
+                         wait_for_completion, benchmark_info,
+                         context_overflow_options, cancel);
+}
+
 absl::StatusOr<Responses> Decode(LlmExecutor& executor, Tokenizer& tokenizer,
                                  const StopTokenDetector& stop_token_detector,
-                                 std::optional<BenchmarkInfo>& benchmark_info) {
+                                 std::optional<BenchmarkInfo>& benchmark_info,
+                                 std::vector<int>* decoded_token_ids,
+                                 const DecodeLimits& limits) {
   int benchmark_decode_token_count = 0;
   if (benchmark_info.has_value()) {
     benchmark_decode_token_count =
@@ -294,18 +536,23 @@ absl::StatusOr<Responses> Decode(LlmExecutor& executor, Tokenizer& tokenizer,
       &executor, &tokenizer, num_output_candidates, stop_token_detector,
       benchmark_info);
   while (true) {
+    RETURN_IF_ERROR(limits.Check());
     auto hit_stop_tokens = run_one_step.Run();
     if (!hit_stop_tokens.ok()) {
       return hit_stop_tokens.status();
     }
     response_texts[0] +=
         absl::StrReplaceAll(run_one_step.GetResultTokens()[0], {{"▁", " "}});
+    if (decoded_token_ids != nullptr) {
+      decoded_token_ids->push_back(run_one_step.GetDecodedIds()[0]);
+    }
     num_decoded_steps++;
 
-    if (ShouldStop(*hit_stop_tokens, benchmark_decode_token_count,
-                   num_decoded_steps, executor.GetCurrentStep().value(),
-                   max_num_tokens,
-                   /*observer=*/nullptr)) {
+    const StopReason stop_reason = ShouldStop(
+        *hit_stop_tokens, benchmark_decode_token_count, num_decoded_steps,
+        executor.GetCurrentStep().value(), max_num_tokens, limits);
+    if (stop_reason != StopReason::kNone) {
+      responses.SetTruncated(stop_reason == StopReason::kMaxNumSteps);
       break;
     }
   }
@@ -319,7 +566,9 @@ absl::StatusOr<Responses> Decode(LlmExecutor& executor, Tokenizer& tokenizer,
 absl::Status DecodeStreaming(LlmExecutor& executor, Tokenizer& tokenizer,
                              const StopTokenDetector& stop_token_detector,
                              std::optional<BenchmarkInfo>& benchmark_info,
-                             InferenceObservable* observer) {
+                             InferenceObservable* observer,
+                             std::vector<int>* decoded_token_ids,
+                             const DecodeLimits& limits) {
   if (observer == nullptr) {
     return absl::InvalidArgumentError(
         "Observer must be provided for streaming.");
@@ -339,7 +588,12 @@ absl::Status DecodeStreaming(LlmExecutor& executor, Tokenizer& tokenizer,
   DecodeInternalSamplingOneStep run_one_step(
       &executor, &tokenizer, num_output_candidates, stop_token_detector,
       benchmark_info);
-  while (true) {
+  StopReason stop_reason = StopReason::kNone;
+  while (stop_reason == StopReason::kNone) {
+    if (absl::Status status = limits.Check(); !status.ok()) {
+      observer->OnError(status);
+      return status;
+    }
     Responses responses(num_output_candidates);
     std::vector<std::string>& response_texts =
         responses.GetMutableResponseTexts();
@@ -350,20 +604,161 @@ absl::Status DecodeStreaming(LlmExecutor& executor, Tokenizer& tokenizer,
     }
     response_texts[0] +=
         absl::StrReplaceAll(run_one_step.GetResultTokens()[0], {{"▁", " "}});
+    if (decoded_token_ids != nullptr) {
+      decoded_token_ids->push_back(run_one_step.GetDecodedIds()[0]);
+    }
     num_decoded_steps++;
+    stop_reason = ShouldStop(*hit_stop_tokens, benchmark_decode_token_count,
+                             num_decoded_steps,
+                             executor.GetCurrentStep().value(), max_num_tokens,
+                             limits);
+    responses.SetTruncated(stop_reason == StopReason::kMaxNumSteps);
     observer->OnNext(responses);
+  }
+  if (benchmark_info.has_value()) {
+    RETURN_IF_ERROR(benchmark_info->TimeDecodeTurnEnd(num_decoded_steps *
+                                                      num_output_candidates));
+  }
+  NotifyDecodeEnd(stop_reason, *observer);
+  return absl::OkStatus();
+}
 
-    if (ShouldStop(*hit_stop_tokens, benchmark_decode_token_count,
-                   num_decoded_steps, executor.GetCurrentStep().value(),
-                   max_num_tokens, observer)) {
+absl::Status DecodeStreamingPipelined(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const StopTokenDetector& stop_token_detector,
+    std::optional<BenchmarkInfo>& benchmark_info,
+    InferenceObservable* observer, int depth,
+    ThreadPool* absl_nonnull consumer_thread_pool,
+    std::vector<int>* decoded_token_ids, const DecodeLimits& limits) {
+  if (observer == nullptr) {
+    return absl::InvalidArgumentError(
+        "Observer must be provided for streaming.");
+  }
+  if (depth < 1) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The pipeline depth must be positive, but got: ", depth));
+  }
+  int benchmark_decode_token_count = 0;
+  if (benchmark_info.has_value()) {
+    benchmark_decode_token_count =
+        benchmark_info->GetBenchmarkParams().num_decode_tokens();
+    RETURN_IF_ERROR(benchmark_info->TimeDecodeTurnStart());
+  }
+  const int max_num_tokens = TryGetMaxNumTokens(executor);
+  ASSIGN_OR_RETURN(const int start_step, executor.GetCurrentStep());
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto output_tokens,
+                               CreateTensorBuffer<int>({1, 1}));
+
+  // The decoded tokens, followed by nullopt after the last one.
+  SpscQueue<std::optional<int>> queue(depth);
+  PipelineWaiter waiter;
+  // Set by the consumer when it stops taking tokens.
+  std::atomic_bool consumer_done = false;
+  // Notified by the consumer once it no longer touches the state above.
+  absl::Notification consumer_finished;
+  // Written by the consumer, read once it is done.
+  absl::Status consumer_status;
+  int num_consumed_steps = 0;
+  bool hit_stop_tokens = false;
+
+  RETURN_IF_ERROR(consumer_thread_pool->Schedule([&]() {
+    StopTokenDetector detector = stop_token_detector;
+    consumer_status = [&]() -> absl::Status {
+      while (true) {
+        std::optional<int> token_id;
+        waiter.WaitUntil([&]() { return queue.TryPop(token_id); },
+                         /*give_up=*/[]() { return false; });
+        waiter.Notify();
+        if (!token_id.has_value()) {
+          return absl::OkStatus();
+        }
+        ++num_consumed_steps;
+        ASSIGN_OR_RETURN(std::string token,
+                         tokenizer.TokenIdsToText({*token_id}));
+        if (decoded_token_ids != nullptr) {
+          decoded_token_ids->push_back(*token_id);
+        }
+        RETURN_IF_ERROR(
+            detector.ProcessTokens(absl::MakeConstSpan(&*token_id, 1)));
+        ASSIGN_OR_RETURN(hit_stop_tokens, detector.AllDone());
+        // The producer is ahead, so whether this token ends a truncated
+        // response is decided from the step it was decoded at.
+        const StopReason stop_reason = ShouldStop(
+            hit_stop_tokens, benchmark_decode_token_count, num_consumed_steps,
+            start_step + num_consumed_steps, max_num_tokens, limits);
+        Responses responses(/*num_output_candidates=*/1);
+        responses.GetMutableResponseTexts()[0] =
+            absl::StrReplaceAll(token, {{"▁", " "}});
+        responses.SetTruncated(stop_reason == StopReason::kMaxNumSteps);
+        observer->OnNext(responses);
+        if (hit_stop_tokens && benchmark_decode_token_count == 0) {
+          return absl::OkStatus();
+        }
+      }
+    }();
+    consumer_done.store(true, std::memory_order_release);
+    waiter.Notify();
+    consumer_finished.Notify();
+  }));
+
+  auto is_consumer_done = [&]() {
+    return consumer_done.load(std::memory_order_acquire);
+  };
+  absl::Status producer_status;
+  int num_decoded_steps = 0;
+  StopReason stop_reason = StopReason::kNone;
+  while (stop_reason == StopReason::kNone && !is_consumer_done()) {
+    producer_status = limits.Check();
+    if (!producer_status.ok()) {
+      break;
+    }
+    producer_status = executor.Decode(output_tokens);
+    if (!producer_status.ok()) {
       break;
     }
+    auto output_tokens_span = ReferTensorBufferAsSpan<int>(output_tokens);
+    if (!output_tokens_span.HasValue()) {
+      producer_status = ToAbslStatus(output_tokens_span.Error());
+      break;
+    }
+    const int token_id = (*output_tokens_span)[0];
+    ++num_decoded_steps;
+    if (!waiter.WaitUntil([&]() { return queue.TryPush(token_id); },
+                          is_consumer_done)) {
+      break;
+    }
+    waiter.Notify();
+    stop_reason = ShouldStop(/*hit_stop_tokens=*/false,
+                             benchmark_decode_token_count, num_decoded_steps,
+                             executor.GetCurrentStep().value(), max_num_tokens,
+                             limits);
+  }
+  if (waiter.WaitUntil([&]() { return queue.TryPush(std::nullopt); },
+                       is_consumer_done)) {
+    waiter.Notify();
+  }
+  consumer_finished.WaitForNotification();
+
+  // The steps decoded after the ones the consumer took, i.e. past the stop
+  // tokens or an error, are not part of the sequence.
+  if (num_consumed_steps < num_decoded_steps) {
+    RETURN_IF_ERROR(executor.RewindTo(start_step + num_consumed_steps));
+  }
+  // Once the stop tokens are hit, the errors of the steps past them, e.g. a
+  // cancellation, do not matter.
+  if (consumer_status.ok() && hit_stop_tokens &&
+      benchmark_decode_token_count == 0) {
+    stop_reason = StopReason::kDone;
+  } else if (!producer_status.ok() || !consumer_status.ok()) {
+    const absl::Status& status =
+        consumer_status.ok() ? producer_status : consumer_status;
+    observer->OnError(status);
+    return status;
   }
   if (benchmark_info.has_value()) {
-    RETURN_IF_ERROR(benchmark_info->TimeDecodeTurnEnd(num_decoded_steps *
-                                                      num_output_candidates));
+    RETURN_IF_ERROR(benchmark_info->TimeDecodeTurnEnd(num_consumed_steps));
   }
-  observer->OnDone();
+  NotifyDecodeEnd(stop_reason, *observer);
   return absl::OkStatus();
 }
 
@@ -371,7 +766,9 @@ absl::StatusOr<Responses> DecodeCustomSampling(
     LlmExecutor& executor, Tokenizer& tokenizer,
     const StopTokenDetector& stop_token_detector, int num_output_candidates,
     Sampler& sampler, litert::TensorBuffer& decoded_ids,
-    std::optional<BenchmarkInfo>& benchmark_info) {
+    std::optional<BenchmarkInfo>& benchmark_info,
+    std::vector<int>* decoded_token_ids, const DecodeLimits& limits,
+    std::optional<int> num_top_log_probs) {
   int benchmark_decode_token_count = 0;
   if (benchmark_info.has_value()) {
     benchmark_decode_token_count =
@@ -386,12 +783,16 @@ absl::StatusOr<Responses> DecodeCustomSampling(
   std::vector<int> num_decoded_tokens(num_output_candidates, 0);
   int num_decode_steps = 0;
   const int max_num_tokens = TryGetMaxNumTokens(executor);
-  DecodeExternalSampling run_one_step(&executor, &tokenizer,
-                                      num_output_candidates, sampler,
-                                      stop_token_detector, benchmark_info);
+  DecodeExternalSampling run_one_step(
+      &executor, &tokenizer, num_output_candidates, sampler,
+      stop_token_detector, benchmark_info, num_top_log_probs);
 
   while (true) {
+    RETURN_IF_ERROR(limits.Check());
     ASSIGN_OR_RETURN(bool hit_stop_tokens, run_one_step.Run(decoded_ids));
+    if (decoded_token_ids != nullptr) {
+      decoded_token_ids->push_back(run_one_step.GetDecodedIds()[0]);
+    }
 
     // Append the results to the final results vector. Note that only the
     // candidates that have not reached the stop token are added to the final
@@ -407,13 +808,18 @@ absl::StatusOr<Responses> DecodeCustomSampling(
             run_one_step.GetResultTokens()[j], {{"▁", " "}});
         num_decoded_tokens[j]++;
         scores[j] += run_one_step.GetScores()[j];
+        if (num_top_log_probs.has_value()) {
+          RETURN_IF_ERROR(run_one_step.AppendLogProbs(
+              j, responses.GetMutableTokenLogProbs()[j]));
+        }
       }
     }
     num_decode_steps++;
-    if (ShouldStop(hit_stop_tokens, benchmark_decode_token_count,
-                   num_decode_steps, executor.GetCurrentStep().value(),
-                   max_num_tokens,
-                   /*observer=*/nullptr)) {
+    const StopReason stop_reason = ShouldStop(
+        hit_stop_tokens, benchmark_decode_token_count, num_decode_steps,
+        executor.GetCurrentStep().value(), max_num_tokens, limits);
+    if (stop_reason != StopReason::kNone) {
+      responses.SetTruncated(stop_reason == StopReason::kMaxNumSteps);
       break;
     }
   }
@@ -436,7 +842,8 @@ absl::Status DecodeCustomSamplingStreaming(
     const StopTokenDetector& stop_token_detector, int num_output_candidates,
     Sampler& sampler, litert::TensorBuffer& decoded_ids,
     std::optional<BenchmarkInfo>& benchmark_info,
-    InferenceObservable* observer) {
+    InferenceObservable* observer, std::vector<int>* decoded_token_ids,
+    const DecodeLimits& limits, std::optional<int> num_top_log_probs) {
   if (observer == nullptr) {
     return absl::InvalidArgumentError(
         "Observer must be provided for streaming.");
@@ -451,17 +858,25 @@ absl::Status DecodeCustomSamplingStreaming(
   // maximum number of kv-cache steps.
   int num_decode_steps = 0;
   const int max_num_tokens = TryGetMaxNumTokens(executor);
-  DecodeExternalSampling run_one_step(&executor, &tokenizer,
-                                      num_output_candidates, sampler,
-                                      stop_token_detector, benchmark_info);
+  DecodeExternalSampling run_one_step(
+      &executor, &tokenizer, num_output_candidates, sampler,
+      stop_token_detector, benchmark_info, num_top_log_probs);
 
   // Enter the loop to run the decode process.
-  while (true) {
+  StopReason stop_reason = StopReason::kNone;
+  while (stop_reason == StopReason::kNone) {
+    if (absl::Status status = limits.Check(); !status.ok()) {
+      observer->OnError(status);
+      return status;
+    }
     absl::StatusOr<bool> hit_stop_tokens = run_one_step.Run(decoded_ids);
     if (!hit_stop_tokens.ok()) {
       observer->OnError(hit_stop_tokens.status());
       return hit_stop_tokens.status();
     }
+    if (decoded_token_ids != nullptr) {
+      decoded_token_ids->push_back(run_one_step.GetDecodedIds()[0]);
+    }
 
     Responses responses(num_output_candidates);
     std::vector<float>& scores = responses.GetMutableScores();
@@ -478,22 +893,127 @@ absl::Status DecodeCustomSamplingStreaming(
         response_texts[j] += absl::StrReplaceAll(
             run_one_step.GetResultTokens()[j], {{"▁", " "}});
         scores[j] += run_one_step.GetScores()[j];
+        if (num_top_log_probs.has_value()) {
+          if (absl::Status status = run_one_step.AppendLogProbs(
+                  j, responses.GetMutableTokenLogProbs()[j]);
+              !status.ok()) {
+            observer->OnError(status);
+            return status;
+          }
+        }
       }
     }
     num_decode_steps++;
+    stop_reason = ShouldStop(*hit_stop_tokens, benchmark_decode_token_count,
+                             num_decode_steps,
+                             executor.GetCurrentStep().value(), max_num_tokens,
+                             limits);
+    responses.SetTruncated(stop_reason == StopReason::kMaxNumSteps);
     observer->OnNext(responses);
-    if (ShouldStop(*hit_stop_tokens, benchmark_decode_token_count,
-                   num_decode_steps, executor.GetCurrentStep().value(),
-                   max_num_tokens, observer)) {
-      break;
-    }
   }
   if (benchmark_info.has_value()) {
     RETURN_IF_ERROR(benchmark_info->TimeDecodeTurnEnd(num_decode_steps *
                                                       num_output_candidates));
   }
-  observer->OnDone();
+  NotifyDecodeEnd(stop_reason, *observer);
   return absl::OkStatus();
 }
 
+absl::StatusOr<std::vector<ContinuationScore>> Score(
+    LlmExecutor& executor, Tokenizer& tokenizer, int last_prefill_token_id,
+    const std::vector<std::vector<int>>& continuations,
+    const DecodeLimits& limits) {
+  ASSIGN_OR_RETURN(const int prompt_length, executor.GetCurrentStep());
+  const int max_num_tokens = TryGetMaxNumTokens(executor);
+  std::vector<ContinuationScore> scores;
+  scores.reserve(continuations.size());
+  std::vector<float> log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  for (const std::vector<int>& token_ids : continuations) {
+    ContinuationScore& score = scores.emplace_back();
+    const int num_tokens = token_ids.size();
+    if (num_tokens == 0) {
+      continue;
+    }
+    if (prompt_length + num_tokens > max_num_tokens) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The continuation of ", num_tokens,
+          " tokens does not fit in the context after the prompt of ",
+          prompt_length, " tokens."));
+    }
+    RETURN_IF_ERROR(limits.Check());
+    absl::StatusOr<std::vector<float>> logits = GetTeacherForcedLogits(
+        executor, last_prefill_token_id, token_ids, limits);
+    // The continuations all follow the prompt, whose KV cache is kept.
+    RETURN_IF_ERROR(executor.RewindTo(prompt_length));
+    if (!logits.ok()) {
+      return logits.status();
+    }
+    RETURN_IF_ERROR(ComputeLogProbs(*logits, token_ids, /*num_top=*/0,
+                                    /*batch_size=*/num_tokens, log_probs,
+                                    top_ids, top_log_probs));
+    for (int i = 0; i < num_tokens; ++i) {
+      ASSIGN_OR_RETURN(score.token_log_probs.emplace_back(),
+                       MakeTokenLogProb(tokenizer, token_ids[i], log_probs[i]));
+      score.total_log_prob += log_probs[i];
+    }
+  }
+  return scores;
+}
+
+absl::StatusOr<std::vector<std::vector<TokenLogProb>>> PredictNextTokens(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const std::vector<std::vector<int>>& token_ids, int num_top) {
+  if (num_top <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The number of top tokens must be positive: ", num_top));
+  }
+  ASSIGN_OR_RETURN(auto last_logits, executor.PrefillLastLogits(token_ids));
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto logits,
+                               CopyFromTensorBuffer<float>(last_logits));
+  const int num_prompts = token_ids.size();
+  // Only the top tokens are needed, so the first token stands in for the
+  // sampled ids.
+  const std::vector<int> sampled_ids(num_prompts, 0);
+  std::vector<float> sampled_log_probs;
+  std::vector<int> top_ids;
+  std::vector<float> top_log_probs;
+  RETURN_IF_ERROR(ComputeLogProbs(logits, sampled_ids, num_top,
+                                  /*batch_size=*/num_prompts,
+                                  sampled_log_probs, top_ids, top_log_probs));
+  std::vector<std::vector<TokenLogProb>> next_tokens(num_prompts);
+  for (int i = 0; i < num_prompts; ++i) {
+    for (int j = i * num_top; j < (i + 1) * num_top; ++j) {
+      ASSIGN_OR_RETURN(next_tokens[i].emplace_back(),
+                       MakeTokenLogProb(tokenizer, top_ids[j],
+                                        top_log_probs[j]));
+    }
+  }
+  return next_tokens;
+}
+
+absl::StatusOr<std::vector<std::vector<float>>> Embed(
+    LlmExecutor& executor, const std::vector<std::vector<int>>& token_ids,
+    const EmbeddingOptions& options) {
+  std::vector<std::vector<float>> embeddings(token_ids.size());
+  RETURN_IF_ERROR(executor.PrefillHiddenStates(
+      token_ids,
+      [&](int index, absl::Span<const float> hidden_states) -> absl::Status {
+        const int num_tokens = token_ids[index].size();
+        if (hidden_states.size() % num_tokens != 0) {
+          return absl::InternalError(absl::StrCat(
+              "The hidden states of size ", hidden_states.size(),
+              " do not match the ", num_tokens, " tokens."));
+        }
+        // The pooling runs right away, so that the hidden states of a
+        // sequence are not kept past its embedding.
+        std::vector<float>& embedding = embeddings[index];
+        embedding.resize(hidden_states.size() / num_tokens);
+        return PoolHiddenStates(hidden_states, options.pooling,
+                                options.normalize, absl::MakeSpan(embedding));
+      }));
+  return embeddings;
+}
+
 }  // namespace litert::lm
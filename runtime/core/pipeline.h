@@ -17,18 +17,23 @@
 
 #include <stdbool.h>
 
+#include <atomic>
 #include <memory>
 #include <optional>
+#include <vector>
 
+#include "absl/base/nullability.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
 #include "runtime/components/sampler.h"
 #include "runtime/components/stop_token_detector.h"
+#include "runtime/components/token_id_util.h"
 #include "runtime/components/tokenizer.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/llm_executor.h"
+#include "runtime/framework/threadpool.h"
 
 namespace litert::lm {
 
@@ -46,25 +51,75 @@ absl::StatusOr<int> Prefill(LlmExecutor& executor, Tokenizer& tokenizer,
                             bool wait_for_completion,
                             std::optional<BenchmarkInfo>& benchmark_info);
 
+// Same as above, but takes the already tokenized prompt. It allows callers to
+// assemble the prompt in token space (e.g. from pre-tokenized prompt template
+// affixes) instead of re-tokenizing the whole formatted text.
+// - token_ids: The token ids of the input prompt, without the start token.
+// - bos_token_id: The start token inserted before the token ids, if any. It is
+//   left unset when appending to a sequence that is already in the KV cache.
+// - context_overflow_options: How to trim the token ids that do not fit in the
+//   space left in the KV cache. By default, an error is returned.
+absl::StatusOr<int> Prefill(
+    LlmExecutor& executor, Tokenizer& tokenizer, std::vector<int> token_ids,
+    std::optional<int> bos_token_id, bool wait_for_completion,
+    std::optional<BenchmarkInfo>& benchmark_info,
+    const ContextOverflowOptions& context_overflow_options =
+        ContextOverflowOptions(),
+    const std::atomic_bool* absl_nullable cancel = nullptr);
+
 // Runs the pipeline to decode the input prompt.
 // - executor: The initialized LLM Executor to call.
 // - tokenizer: The tokenizer to decode the token ids into text.
 // - stop_token_ids: The token ids to stop the decoding process.
 // - benchmark_info: The benchmark info to record the performance metrics.
+// - decoded_token_ids: If not null, the sampled token ids (including the stop
+//   tokens) are appended to it.
+// - limits: The cancellation, deadline and maximum number of steps, checked
+//   before each decode step.
 // TODO(b/397975034): support batched output and update the logic to avoid
 // detokenizing the stop tokens.
-absl::StatusOr<Responses> Decode(LlmExecutor& executor, Tokenizer& tokenizer,
-                                 const StopTokenDetector& stop_token_detector,
-                                 std::optional<BenchmarkInfo>& benchmark_info);
+absl::StatusOr<Responses> Decode(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const StopTokenDetector& stop_token_detector,
+    std::optional<BenchmarkInfo>& benchmark_info,
+    std::vector<int>* absl_nullable decoded_token_ids = nullptr,
+    const DecodeLimits& limits = DecodeLimits());
 
 // Runs the pipeline to decode the input prompt. The function is similar to
 // Decode, but it outputs the result using the observer to achieve streaming
 // behavior.
-// - observer: The inference observer to receive the intermediate results.
-absl::Status DecodeStreaming(LlmExecutor& executor, Tokenizer& tokenizer,
-                             const StopTokenDetector& stop_token_detector,
-                             std::optional<BenchmarkInfo>& benchmark_info,
-                             InferenceObservable* observer);
+// - observer: The inference observer to receive the intermediate results. It
+//   gets either OnDone() or OnError() at the end.
+absl::Status DecodeStreaming(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const StopTokenDetector& stop_token_detector,
+    std::optional<BenchmarkInfo>& benchmark_info,
+    InferenceObservable* observer,
+    std::vector<int>* absl_nullable decoded_token_ids = nullptr,
+    const DecodeLimits& limits = DecodeLimits());
+
+// Runs the pipeline to decode the input prompt like DecodeStreaming, with the
+// decode steps overlapped with the handling of their tokens. The calling
+// thread runs the decode steps back to back, while a second thread checks the
+// tokens for the stop tokens, detokenizes them and calls the observer, so
+// that a slow observer does not delay the next step. Each thread yields
+// briefly and then blocks while waiting for the other one.
+// - depth: The maximum number of decoded tokens waiting for the second
+//   thread. The calling thread decodes up to `depth` + 1 steps past the stop
+//   tokens before it learns about them, and these steps are then rolled back.
+// - consumer_thread_pool: The pool running the second thread, kept by the
+//   caller across the decodes so that no thread is started per decode. The
+//   decode waits for its work on the pool, but not for the other works.
+// The observer is called on the second thread, then gets either OnDone() or
+// OnError() on the calling thread at the end.
+absl::Status DecodeStreamingPipelined(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const StopTokenDetector& stop_token_detector,
+    std::optional<BenchmarkInfo>& benchmark_info,
+    InferenceObservable* observer, int depth,
+    ThreadPool* absl_nonnull consumer_thread_pool,
+    std::vector<int>* absl_nullable decoded_token_ids = nullptr,
+    const DecodeLimits& limits = DecodeLimits());
 
 // Runs the pipeline to decode the input prompt.
 // - executor: The initialized LLM Executor to call.
@@ -74,22 +129,76 @@ absl::Status DecodeStreaming(LlmExecutor& executor, Tokenizer& tokenizer,
 // - sampler: The sampler to sample the token ids from the logits.
 // - decoded_ids: The decoded token ids from the external sampling process.
 // - benchmark_info: The benchmark info to record the performance metrics.
+// - decoded_token_ids: If not null, the sampled token ids of the first
+//   candidate (including the stop tokens) are appended to it.
+// - limits: The cancellation, deadline and maximum number of steps, checked
+//   before each decode step.
+// - num_top_log_probs: If set, the responses carry the log probability of
+//   each decoded token and of the `num_top_log_probs` most likely tokens of
+//   its step, computed by the sampler.
 absl::StatusOr<Responses> DecodeCustomSampling(
     LlmExecutor& executor, Tokenizer& tokenizer,
     const StopTokenDetector& stop_token_detector, int num_output_candidates,
     Sampler& sampler, litert::TensorBuffer& decoded_ids,
-    std::optional<BenchmarkInfo>& benchmark_info);
+    std::optional<BenchmarkInfo>& benchmark_info,
+    std::vector<int>* absl_nullable decoded_token_ids = nullptr,
+    const DecodeLimits& limits = DecodeLimits(),
+    std::optional<int> num_top_log_probs = std::nullopt);
 
 // Runs the pipeline to decode the input prompt. The function is similar to
 // DecodeCustomSampling, but it outputs the result using the observer to achieve
 // streaming behavior.
-// - observer: The inference observer to receive the intermediate results.
+// - observer: The inference observer to receive the intermediate results. It
+//   gets either OnDone() or OnError() at the end.
 absl::Status DecodeCustomSamplingStreaming(
     LlmExecutor& executor, Tokenizer& tokenizer,
     const StopTokenDetector& stop_token_detector, int num_output_candidates,
     Sampler& sampler, litert::TensorBuffer& decoded_ids,
     std::optional<BenchmarkInfo>& benchmark_info,
-    InferenceObservable* observer);
+    InferenceObservable* observer,
+    std::vector<int>* absl_nullable decoded_token_ids = nullptr,
+    const DecodeLimits& limits = DecodeLimits(),
+    std::optional<int> num_top_log_probs = std::nullopt);
+
+// Runs the pipeline to score the continuations of the prompt in the executor,
+// i.e. to compute the log probabilities of their tokens given the prompt.
+// - executor: The LLM Executor right after the prefill of the prompt.
+// - tokenizer: The tokenizer to decode the token ids into text.
+// - last_prefill_token_id: The last token id of the prompt, returned by the
+//   prefill.
+// - continuations: The token ids of each continuation.
+// - limits: The cancellation and deadline, checked before each continuation
+//   and each decode step.
+// A continuation is scored in one prefill with the logits of all its positions
+// if the executor supports it, and decoded token by token otherwise. The
+// executor is rewound to the end of the prompt after each continuation.
+absl::StatusOr<std::vector<ContinuationScore>> Score(
+    LlmExecutor& executor, Tokenizer& tokenizer, int last_prefill_token_id,
+    const std::vector<std::vector<int>>& continuations,
+    const DecodeLimits& limits = DecodeLimits());
+
+// Runs the pipeline to predict the next token of independent prompts, e.g. to
+// classify a batch of short messages by the likelihood of label tokens. The
+// prompts are prefilled packed together, and are not added to the sequence of
+// the executor.
+// - executor: The LLM Executor, whose sequence is left unchanged.
+// - tokenizer: The tokenizer to decode the token ids into text.
+// - token_ids: The token ids of each prompt. They must not be empty.
+// - num_top: The number of most likely next tokens returned per prompt.
+// Returns the `num_top` most likely next tokens of each prompt, in decreasing
+// order of probability.
+absl::StatusOr<std::vector<std::vector<TokenLogProb>>> PredictNextTokens(
+    LlmExecutor& executor, Tokenizer& tokenizer,
+    const std::vector<std::vector<int>>& token_ids, int num_top);
+
+// Runs the pipeline to embed token sequences, i.e. to pool the hidden states
+// of their tokens into one vector per sequence.
+// - executor: The LLM Executor, whose sequence is left unchanged.
+// - token_ids: The token ids of each sequence. They must not be empty.
+// - options: How the hidden states are pooled and normalized.
+absl::StatusOr<std::vector<std::vector<float>>> Embed(
+    LlmExecutor& executor, const std::vector<std::vector<int>>& token_ids,
+    const EmbeddingOptions& options = EmbeddingOptions());
 
 }  // namespace litert::lm
 
@@ -1,5 +1,6 @@
 #include "runtime/core/pipeline.h"
 
+#include <atomic>
 #include <filesystem>  // NOLINT: Required for path manipulation.
 #include <memory>
 #include <optional>
@@ -10,18 +11,25 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/components/sampler.h"
 #include "runtime/components/sentencepiece_tokenizer.h"
 #include "runtime/components/stop_token_detector.h"
 #include "runtime/components/tokenizer.h"
 #include "runtime/components/top_p_cpu_sampler.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/fake_llm_executor.h"
+#include "runtime/framework/threadpool.h"
 #include "runtime/util/convert_tensor_buffer.h"
 #include "runtime/util/test_utils.h"  // NOLINT
 
 namespace litert::lm {
 namespace {
 
+using ::testing::ElementsAre;
+using ::testing::FloatEq;
+using ::testing::FloatNear;
 using ::testing::status::StatusIs;
 
 constexpr char kTestdataDir[] =
@@ -37,11 +45,26 @@ class TestObserver : public InferenceObservable {
     for (int i = 0; i < responses.GetNumOutputCandidates(); ++i) {
       responses_[i] += *(responses.GetResponseTextAt(i));
     }
+    truncated_ = responses.IsTruncated();
+  }
+  void OnDone() override { ++num_done_; }
+  void OnError(const absl::Status& status) override {
+    ++num_errors_;
+    last_error_ = status;
   }
   const std::vector<std::string>& GetResponses() const { return responses_; }
+  int num_done() const { return num_done_; }
+  int num_errors() const { return num_errors_; }
+  const absl::Status& last_error() const { return last_error_; }
+  // Whether the last responses were truncated.
+  bool truncated() const { return truncated_; }
 
  private:
   std::vector<std::string> responses_;
+  bool truncated_ = false;
+  int num_done_ = 0;
+  int num_errors_ = 0;
+  absl::Status last_error_;
 };
 
 class PipelineTest : public testing::Test {
@@ -70,6 +93,8 @@ class PipelineTest : public testing::Test {
 
   std::unique_ptr<Tokenizer> tokenizer_;
   std::unique_ptr<FakeLlmExecutor> executor_;
+  ThreadPool consumer_thread_pool_{/*name_prefix=*/"decode_consumer",
+                                   /*max_num_threads=*/1};
 };
 
 TEST_F(PipelineTest, PrefillTooLong) {
@@ -102,6 +127,7 @@ TEST_F(PipelineTest, Decode) {
       Decode(*executor_, *tokenizer_, stop_token_detector, benchmark_info);
   EXPECT_OK(responses);
   EXPECT_EQ(*(responses->GetResponseTextAt(0)), " How's it going?!");
+  EXPECT_FALSE(responses->IsTruncated());
 }
 
 TEST_F(PipelineTest, DecodeReachMaxNumTokens) {
@@ -138,6 +164,252 @@ TEST_F(PipelineTest, DecodeStreamingReachMaxNumTokens) {
                             benchmark_info, &observer));
   // The response is truncated at the max number of tokens.
   EXPECT_EQ(observer.GetResponses()[0], " How's");
+  // The end of the decode is reported once, as an error.
+  EXPECT_EQ(observer.num_done(), 0);
+  EXPECT_EQ(observer.num_errors(), 1);
+}
+
+TEST_F(PipelineTest, DecodeMaxNumSteps) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  std::vector<int> decoded_token_ids;
+  auto responses =
+      Decode(*executor_, *tokenizer_, stop_token_detector, benchmark_info,
+             &decoded_token_ids, DecodeLimits{.max_num_steps = 3});
+  EXPECT_OK(responses);
+  EXPECT_EQ(*(responses->GetResponseTextAt(0)), " How's");
+  EXPECT_TRUE(responses->IsTruncated());
+  EXPECT_EQ(decoded_token_ids.size(), 3);
+}
+
+TEST_F(PipelineTest, DecodeCancelled) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  std::atomic_bool cancel = true;
+  EXPECT_THAT(Decode(*executor_, *tokenizer_, stop_token_detector,
+                     benchmark_info, /*decoded_token_ids=*/nullptr,
+                     DecodeLimits{.cancel = &cancel}),
+              StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST_F(PipelineTest, DecodeDeadlineExceeded) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  EXPECT_THAT(Decode(*executor_, *tokenizer_, stop_token_detector,
+                     benchmark_info, /*decoded_token_ids=*/nullptr,
+                     DecodeLimits{.deadline = absl::Now() - absl::Seconds(1)}),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+TEST_F(PipelineTest, DecodeStreamingMaxNumSteps) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  TestObserver observer(/*num_candidates=*/1);
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  EXPECT_OK(DecodeStreaming(*executor_, *tokenizer_, stop_token_detector,
+                            benchmark_info, &observer,
+                            /*decoded_token_ids=*/nullptr,
+                            DecodeLimits{.max_num_steps = 3}));
+  EXPECT_EQ(observer.GetResponses()[0], " How's");
+  EXPECT_TRUE(observer.truncated());
+  EXPECT_EQ(observer.num_done(), 1);
+  EXPECT_EQ(observer.num_errors(), 0);
+}
+
+TEST_F(PipelineTest, DecodeStreamingCancelled) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  TestObserver observer(/*num_candidates=*/1);
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  std::atomic_bool cancel = true;
+  EXPECT_THAT(DecodeStreaming(*executor_, *tokenizer_, stop_token_detector,
+                              benchmark_info, &observer,
+                              /*decoded_token_ids=*/nullptr,
+                              DecodeLimits{.cancel = &cancel}),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(observer.num_done(), 0);
+  EXPECT_EQ(observer.num_errors(), 1);
+  EXPECT_THAT(observer.last_error(), StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST_F(PipelineTest, DecodeStreamingPipelined) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  TestObserver observer(/*num_candidates=*/1);
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  std::vector<int> decoded_token_ids;
+  // The executor may decode past the stop token, whose failure is ignored as
+  // the fake executor has no more tokens.
+  EXPECT_OK(DecodeStreamingPipelined(
+      *executor_, *tokenizer_, stop_token_detector, benchmark_info, &observer,
+      /*depth=*/2, &consumer_thread_pool_, &decoded_token_ids));
+  EXPECT_EQ(observer.GetResponses()[0], " How's it going?!");
+  EXPECT_THAT(decoded_token_ids,
+              ElementsAre(224, 24, 8, 66, 246, 18, 2295, 2294));
+  // The steps decoded past the stop token are rolled back.
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 8);
+  EXPECT_FALSE(observer.truncated());
+  EXPECT_EQ(observer.num_done(), 1);
+  EXPECT_EQ(observer.num_errors(), 0);
+  // The consumer thread is kept for the next decodes.
+  EXPECT_EQ(consumer_thread_pool_.num_threads(), 1);
+}
+
+TEST_F(PipelineTest, DecodeStreamingPipelinedMaxNumSteps) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  TestObserver observer(/*num_candidates=*/1);
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  EXPECT_OK(DecodeStreamingPipelined(
+      *executor_, *tokenizer_, stop_token_detector, benchmark_info, &observer,
+      /*depth=*/2, &consumer_thread_pool_, /*decoded_token_ids=*/nullptr,
+      DecodeLimits{.max_num_steps = 3}));
+  EXPECT_EQ(observer.GetResponses()[0], " How's");
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 3);
+  EXPECT_TRUE(observer.truncated());
+  EXPECT_EQ(observer.num_done(), 1);
+  EXPECT_EQ(observer.num_errors(), 0);
+}
+
+TEST_F(PipelineTest, DecodeStreamingPipelinedCancelled) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  TestObserver observer(/*num_candidates=*/1);
+  StopTokenDetector stop_token_detector(1);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({2294}));
+  std::atomic_bool cancel = true;
+  EXPECT_THAT(DecodeStreamingPipelined(
+                  *executor_, *tokenizer_, stop_token_detector, benchmark_info,
+                  &observer, /*depth=*/2, &consumer_thread_pool_,
+                  /*decoded_token_ids=*/nullptr,
+                  DecodeLimits{.cancel = &cancel}),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(observer.num_done(), 0);
+  EXPECT_EQ(observer.num_errors(), 1);
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 0);
+}
+
+TEST_F(PipelineTest, Score) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  ASSERT_OK_AND_ASSIGN(
+      int last_prefill_token_id,
+      Prefill(*executor_, *tokenizer_, "Hello World!",
+              /*bos_token_id=*/2, /*wait_for_completion=*/true,
+              benchmark_info));
+  // The fake executor predicts the decode tokens at the positions of the
+  // continuations, in order: " How's" for the first one and " it going" for
+  // the last one.
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<ContinuationScore> scores,
+      Score(*executor_, *tokenizer_, last_prefill_token_id,
+            /*continuations=*/{{224, 24, 8}, {}, {66, 18}}));
+  ASSERT_EQ(scores.size(), 3);
+  ASSERT_EQ(scores[0].token_log_probs.size(), 3);
+  EXPECT_EQ(scores[0].token_log_probs[0].token_id, 224);
+  EXPECT_EQ(scores[0].token_log_probs[0].token, " How");
+  EXPECT_FLOAT_EQ(scores[0].token_log_probs[0].log_prob, 0.0f);
+  EXPECT_FLOAT_EQ(scores[0].total_log_prob, 0.0f);
+  EXPECT_TRUE(scores[1].token_log_probs.empty());
+  EXPECT_FLOAT_EQ(scores[1].total_log_prob, 0.0f);
+  // The first token matches, the second one does not.
+  ASSERT_EQ(scores[2].token_log_probs.size(), 2);
+  EXPECT_FLOAT_EQ(scores[2].token_log_probs[0].log_prob, 0.0f);
+  EXPECT_LT(scores[2].token_log_probs[1].log_prob, -1000.0f);
+  EXPECT_LT(scores[2].total_log_prob, -1000.0f);
+  // The executor is left after the prompt.
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 8);
+}
+
+TEST_F(PipelineTest, ScoreWithoutPrefillLogits) {
+  executor_->DisablePrefillLogits();
+  std::optional<BenchmarkInfo> benchmark_info;
+  ASSERT_OK_AND_ASSIGN(
+      int last_prefill_token_id,
+      Prefill(*executor_, *tokenizer_, "Hello World!",
+              /*bos_token_id=*/2, /*wait_for_completion=*/true,
+              benchmark_info));
+  // The continuation is decoded token by token.
+  ASSERT_OK_AND_ASSIGN(std::vector<ContinuationScore> scores,
+                       Score(*executor_, *tokenizer_, last_prefill_token_id,
+                             /*continuations=*/{{224, 24}}));
+  ASSERT_EQ(scores.size(), 1);
+  ASSERT_EQ(scores[0].token_log_probs.size(), 2);
+  EXPECT_EQ(scores[0].token_log_probs[1].token_id, 24);
+  EXPECT_FLOAT_EQ(scores[0].total_log_prob, 0.0f);
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 8);
+}
+
+TEST_F(PipelineTest, ScoreTooLong) {
+  executor_->GetMutableExecutorSettings().value()->SetMaxNumTokens(10);
+  std::optional<BenchmarkInfo> benchmark_info;
+  ASSERT_OK_AND_ASSIGN(
+      int last_prefill_token_id,
+      Prefill(*executor_, *tokenizer_, "Hello World!",
+              /*bos_token_id=*/2, /*wait_for_completion=*/true,
+              benchmark_info));
+  EXPECT_THAT(Score(*executor_, *tokenizer_, last_prefill_token_id,
+                    /*continuations=*/{{224, 24, 8}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(PipelineTest, ScoreCancelled) {
+  std::optional<BenchmarkInfo> benchmark_info;
+  ASSERT_OK_AND_ASSIGN(
+      int last_prefill_token_id,
+      Prefill(*executor_, *tokenizer_, "Hello World!",
+              /*bos_token_id=*/2, /*wait_for_completion=*/true,
+              benchmark_info));
+  std::atomic_bool cancel = true;
+  EXPECT_THAT(Score(*executor_, *tokenizer_, last_prefill_token_id,
+                    /*continuations=*/{{224}}, DecodeLimits{.cancel = &cancel}),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 8);
+}
+
+TEST_F(PipelineTest, PredictNextTokens) {
+  // The fake executor predicts the decode tokens, one per prompt.
+  ASSERT_OK_AND_ASSIGN(auto next_tokens,
+                       PredictNextTokens(*executor_, *tokenizer_,
+                                         /*token_ids=*/{{90, 547}, {58}},
+                                         /*num_top=*/1));
+  ASSERT_EQ(next_tokens.size(), 2);
+  ASSERT_EQ(next_tokens[0].size(), 1);
+  EXPECT_EQ(next_tokens[0][0].token_id, 224);
+  EXPECT_FLOAT_EQ(next_tokens[0][0].log_prob, 0.0f);
+  ASSERT_EQ(next_tokens[1].size(), 1);
+  EXPECT_EQ(next_tokens[1][0].token_id, 24);
+  // The executor is left as it was.
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 0);
+
+  EXPECT_THAT(PredictNextTokens(*executor_, *tokenizer_,
+                                /*token_ids=*/{{90}}, /*num_top=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(PipelineTest, Embed) {
+  // The fake hidden state of each token is {token id, position}.
+  ASSERT_OK_AND_ASSIGN(
+      auto embeddings,
+      Embed(*executor_, /*token_ids=*/{{3, 1}, {2}},
+            EmbeddingOptions{.pooling = EmbeddingPooling::kMean,
+                             .normalize = false}));
+  EXPECT_THAT(embeddings, ElementsAre(ElementsAre(FloatEq(2.0f), FloatEq(0.5f)),
+                                      ElementsAre(FloatEq(2.0f), FloatEq(0.0f))));
+  // The executor is left as it was.
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 0);
+}
+
+TEST_F(PipelineTest, EmbedLastTokenNormalized) {
+  ASSERT_OK_AND_ASSIGN(
+      auto embeddings,
+      Embed(*executor_, /*token_ids=*/{{3, 1}, {2}},
+            EmbeddingOptions{.pooling = EmbeddingPooling::kLastToken}));
+  EXPECT_THAT(embeddings,
+              ElementsAre(ElementsAre(FloatNear(0.7071068f, 1e-6f),
+                                      FloatNear(0.7071068f, 1e-6f)),
+                          ElementsAre(FloatEq(1.0f), FloatEq(0.0f))));
 }
 
 class PipelineCustomSamplingTest : public testing::Test {
@@ -217,6 +489,86 @@ TEST_F(PipelineCustomSamplingTest, DecodeCustomSampling) {
   EXPECT_EQ(*(responses->GetScoreAt(1)), 0.0f);
 }
 
+// A sampler recording the steps it is set to before sampling with a
+// TopPSampler.
+class StepRecordingSampler : public Sampler {
+ public:
+  explicit StepRecordingSampler(std::unique_ptr<Sampler> sampler)
+      : sampler_(std::move(sampler)) {}
+
+  absl::Status SampleToIdAndScoreBuffer(const TensorBuffer& logits_tensor,
+                                        TensorBuffer& ids_tensor,
+                                        TensorBuffer* scores_tensor) override {
+    return sampler_->SampleToIdAndScoreBuffer(logits_tensor, ids_tensor,
+                                              scores_tensor);
+  }
+
+  void SetStep(int step) override {
+    steps_.push_back(step);
+    sampler_->SetStep(step);
+  }
+
+  const std::vector<int>& steps() const { return steps_; }
+
+ private:
+  std::unique_ptr<Sampler> sampler_;
+  std::vector<int> steps_;
+};
+
+TEST_F(PipelineCustomSamplingTest, DecodeCustomSamplingSetsTheSampledSteps) {
+  auto sampler_or = TopPSampler::Create(/*k=*/1, /*p=*/0.5, /*temperature=*/1.0,
+                                        /*batch_size=*/2, /*seed=*/1);
+  EXPECT_TRUE(sampler_or.ok());
+  StepRecordingSampler sampler(std::move(sampler_or.value()));
+
+  auto decoded_ids = CreateTensorBuffer<int>({2, 1});
+  std::optional<BenchmarkInfo> benchmark_info;
+  StopTokenDetector stop_token_detector(2);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({0}));
+  auto responses = DecodeCustomSampling(
+      *executor_, *tokenizer_, stop_token_detector,
+      /*num_output_candidates=*/2, sampler, *decoded_ids, benchmark_info);
+  EXPECT_OK(responses);
+  // Each sampled token draws from its position in the sequence, i.e. the
+  // step of the executor after the decode step producing its logits.
+  ASSERT_FALSE(sampler.steps().empty());
+  for (int i = 0; i < sampler.steps().size(); ++i) {
+    EXPECT_EQ(sampler.steps()[i], i + 1);
+  }
+}
+
+TEST_F(PipelineCustomSamplingTest, DecodeCustomSamplingWithLogProbs) {
+  auto sampler_or = TopPSampler::Create(/*k=*/1, /*p=*/0.5, /*temperature=*/1.0,
+                                        /*batch_size=*/2, /*seed=*/1);
+  EXPECT_TRUE(sampler_or.ok());
+  std::unique_ptr<TopPSampler> sampler = std::move(sampler_or.value());
+
+  auto decoded_ids = CreateTensorBuffer<int>({2, 1});
+  std::optional<BenchmarkInfo> benchmark_info;
+  StopTokenDetector stop_token_detector(2);
+  EXPECT_OK(stop_token_detector.AddStopTokenSequence({0}));
+  auto responses = DecodeCustomSampling(
+      *executor_, *tokenizer_, stop_token_detector,
+      /*num_output_candidates=*/2, *sampler, *decoded_ids, benchmark_info,
+      /*decoded_token_ids=*/nullptr, DecodeLimits(), /*num_top_log_probs=*/2);
+  EXPECT_OK(responses);
+  ASSERT_OK_AND_ASSIGN(const std::vector<DecodedTokenLogProbs>* log_probs,
+                       responses->GetTokenLogProbsAt(0));
+  // One entry per decoded token, without the stop token.
+  ASSERT_EQ(log_probs->size(), 8);
+  const DecodedTokenLogProbs& first = (*log_probs)[0];
+  EXPECT_EQ(first.token.token_id, 224);
+  EXPECT_EQ(first.token.token, " How");
+  // The fake executor puts all the probability on the decoded token.
+  EXPECT_EQ(first.token.log_prob, 0.0f);
+  ASSERT_EQ(first.top_tokens.size(), 2);
+  EXPECT_EQ(first.top_tokens[0].token_id, 224);
+  EXPECT_EQ(first.top_tokens[0].log_prob, 0.0f);
+  EXPECT_LT(first.top_tokens[1].log_prob, -1000.0f);
+  ASSERT_OK_AND_ASSIGN(log_probs, responses->GetTokenLogProbsAt(1));
+  EXPECT_EQ(log_probs->size(), 7);
+}
+
 TEST_F(PipelineCustomSamplingTest, DecodeCustomSamplingReachMaxNumTokens) {
   // Set the max number of tokens to 3.
   executor_->GetMutableExecutorSettings().value()->SetMaxNumTokens(3);
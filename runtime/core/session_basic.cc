@@ -12,30 +12,79 @@
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
 #include "absl/time/time.h"  // from @com_google_absl
 #include "runtime/components/sampler.h"
 #include "runtime/components/sampler_factory.h"
 #include "runtime/components/stop_token_detector.h"
+#include "runtime/components/token_id_util.h"
+#include "runtime/components/tokenized_prompt_affixes.h"
 #include "runtime/components/tokenizer.h"
+#include "runtime/core/beam_search.h"
 #include "runtime/core/pipeline.h"
+#include "runtime/core/session_pool.h"
 #include "runtime/engine/engine.h"
 #include "runtime/engine/engine_settings.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/executor_settings_base.h"
 #include "runtime/executor/llm_executor.h"
 #include "runtime/framework/threadpool.h"
+#include "runtime/proto/llm_metadata.pb.h"
 #include "runtime/proto/sampler_params.pb.h"
 #include "runtime/util/convert_tensor_buffer.h"
 #include "runtime/util/status_macros.h"  // IWYU pragma: keep
 
 namespace litert::lm {
+namespace {
+
+// Releases the sequence of a session on the executor, or resets the executor
+// if it does not support the sequences.
+void ReleaseExecutorSequence(LlmExecutor& executor, int sequence_id) {
+  absl::Status status = executor.ReleaseSequence(sequence_id);
+  if (absl::IsUnimplemented(status)) {
+    status = executor.Reset();
+  }
+  if (!status.ok()) {
+    ABSL_LOG(ERROR) << "Failed to release the executor sequence: " << status;
+  }
+}
+
+}  // namespace
 
 // static
 absl::StatusOr<std::unique_ptr<SessionBasic>> SessionBasic::Create(
     LlmExecutor* executor, Tokenizer* tokenizer,
     const SessionConfig& session_config,
     std::optional<BenchmarkInfo> benchmark_info,
-    ThreadPool* worker_thread_pool) {
+    ThreadPool* worker_thread_pool, MemoryReservation memory_reservation,
+    SessionPool* session_pool) {
+  if (benchmark_info.has_value()) {
+    ABSL_LOG(INFO) << "Benchmark is enabled.";
+  }
+  // Each input is fitted to the context on its own, so there are no turns to
+  // drop.
+  if (session_config.GetContextOverflowOptions().policy ==
+      ContextOverflowPolicy::kDropOldestTurns) {
+    return absl::InvalidArgumentError(
+        "Dropping the oldest turns is only supported by the conversations.");
+  }
+  std::unique_ptr<SessionResources> resources;
+  if (session_pool != nullptr) {
+    resources = session_pool->Acquire(session_config);
+  }
+  if (resources == nullptr) {
+    ASSIGN_OR_RETURN(resources, CreateResources(*tokenizer, session_config));
+  }
+  return absl::WrapUnique(new SessionBasic(
+      executor, tokenizer, std::move(*resources), session_config,
+      benchmark_info, worker_thread_pool, std::move(memory_reservation),
+      session_pool));
+}
+
+// static
+absl::StatusOr<std::unique_ptr<SessionResources>>
+SessionBasic::CreateResources(Tokenizer& tokenizer,
+                              const SessionConfig& session_config) {
   auto sampler_backend = session_config.GetSamplerBackend();
   std::unique_ptr<Sampler> sampler;
   // If use CPU sampling, we create it here; For GPU sampling, we let executor
@@ -50,41 +99,77 @@ absl::StatusOr<std::unique_ptr<SessionBasic>> SessionBasic::Create(
         absl::StrCat("Unsupported sampler backend: ", sampler_backend));
   }
 
-  if (benchmark_info.has_value()) {
-    ABSL_LOG(INFO) << "Benchmark is enabled.";
-  }
   StopTokenDetector stop_token_detector(
       session_config.GetNumOutputCandidates());
   for (const auto& stop_token_sequence : session_config.GetStopTokenIds()) {
     RETURN_IF_ERROR(
         stop_token_detector.AddStopTokenSequence(stop_token_sequence));
   }
-  return absl::WrapUnique(new SessionBasic(
-      executor, tokenizer, std::move(sampler), session_config, benchmark_info,
-      worker_thread_pool, stop_token_detector));
+  const proto::PromptTemplates& prompt_templates =
+      session_config.GetPromptTemplates();
+  ASSIGN_OR_RETURN(
+      auto user_turn_affixes,
+      TokenizedPromptAffixes::Create(
+          tokenizer, prompt_templates.user().prefix(),
+          absl::StrCat(prompt_templates.user().suffix(),
+                       prompt_templates.model().prefix())));
+  return std::make_unique<SessionResources>(
+      SessionResources{.sampler = std::move(sampler),
+                       .stop_token_detector = std::move(stop_token_detector),
+                       .user_turn_affixes = std::move(user_turn_affixes)});
 }
 
 SessionBasic::~SessionBasic() {
-  auto status = executor_.Reset();
+  if (session_pool_ != nullptr) {
+    session_pool_->Release(
+        session_config_,
+        std::make_unique<SessionResources>(SessionResources{
+            .sampler = std::move(sampler_),
+            .stop_token_detector = std::move(stop_token_detector_),
+            .user_turn_affixes = std::move(user_turn_affixes_)}));
+  }
+  // The release is scheduled rather than done here, so that the caller does
+  // not wait for it, and that it does not run under the works scheduled
+  // before.
+  LlmExecutor& executor = executor_;
+  const int sequence_id = sequence_id_;
+  auto status = worker_thread_pool_.Schedule([&executor, sequence_id]() {
+    ReleaseExecutorSequence(executor, sequence_id);
+  });
   if (!status.ok()) {
-    ABSL_LOG(ERROR) << "Failed to reset executor: " << status;
+    ReleaseExecutorSequence(executor_, sequence_id_);
   }
 }
 
+absl::Status SessionBasic::ActivateOnExecutor() {
+  // The executor is shared by the sessions, which may use different adapters.
+  RETURN_IF_ERROR(executor_.SetActiveLoRA(session_config_.GetLoRAName()));
+  absl::Status status = executor_.SetActiveSequence(sequence_id_);
+  // Without the sequences support, the sessions run one after the other, each
+  // starting from an empty executor.
+  return absl::IsUnimplemented(status) ? absl::OkStatus() : status;
+}
+
 absl::Status SessionBasic::PrefillInternal(absl::string_view input,
                                            bool wait_for_completion) {
   // TODO(b/397975034): Consider to utilize a prompt formatting logic in a
   // separate library/class.
-  // Update the input with prompt formatting.
-  std::string formatted_input =
-      absl::StrCat(session_config_.GetPromptTemplates().user().prefix(), input,
-                   session_config_.GetPromptTemplates().user().suffix(),
-                   session_config_.GetPromptTemplates().model().prefix());
-  ABSL_LOG(INFO) << "PrefillInternal: " << formatted_input;
+  // Wrap the input with the pre-tokenized prompt template in token space so
+  // that only the input itself needs to be tokenized.
+  ASSIGN_OR_RETURN(std::vector<int> token_ids,
+                   user_turn_affixes_.Encode(tokenizer_, input));
+  ABSL_LOG(INFO) << "PrefillInternal: " << input << " (" << token_ids.size()
+                 << " tokens with prompt template)";
+  if (absl::Now() >= deadline_) {
+    return absl::DeadlineExceededError("The prefill deadline is exceeded.");
+  }
+  RETURN_IF_ERROR(ActivateOnExecutor());
   ASSIGN_OR_RETURN(last_prefill_token_id_,
-                   Prefill(executor_, tokenizer_, formatted_input,
+                   Prefill(executor_, tokenizer_, std::move(token_ids),
                            session_config_.GetStartTokenId(),
-                           wait_for_completion, benchmark_info_));
+                           wait_for_completion, benchmark_info_,
+                           session_config_.GetContextOverflowOptions(),
+                           cancel_));
   return absl::OkStatus();
 }
 
@@ -125,11 +210,26 @@ absl::Status SessionBasic::RunPrefillAsync(
   return absl::OkStatus();
 }
 
+DecodeLimits SessionBasic::GetDecodeLimits() const {
+  return {.cancel = cancel_,
+          .deadline = deadline_,
+          .max_num_steps = session_config_.GetMaxOutputTokens()};
+}
+
 absl::StatusOr<Responses> SessionBasic::DecodeInternal() {
+  RETURN_IF_ERROR(ActivateOnExecutor());
+  if (session_config_.GetBeamSearchParams().beam_width() > 1) {
+    return DecodeBeamSearch(executor_, tokenizer_,
+                            session_config_.GetBeamSearchParams(),
+                            session_config_.GetStopTokenIds(),
+                            session_config_.GetNumOutputCandidates(),
+                            benchmark_info_, GetDecodeLimits());
+  }
   if (sampler_ == nullptr) {
     ASSIGN_OR_RETURN(
         auto responses,
-        Decode(executor_, tokenizer_, stop_token_detector_, benchmark_info_));
+        Decode(executor_, tokenizer_, stop_token_detector_, benchmark_info_,
+               /*decoded_token_ids=*/nullptr, GetDecodeLimits()));
     return responses;
   } else {
     std::vector<int> decoded_ids(session_config_.GetNumOutputCandidates(),
@@ -140,16 +240,45 @@ absl::StatusOr<Responses> SessionBasic::DecodeInternal() {
         auto responses,
         DecodeCustomSampling(executor_, tokenizer_, stop_token_detector_,
                              /*num_output_candidates=*/1, *sampler_,
-                             *decoded_ids_buffer, benchmark_info_));
+                             *decoded_ids_buffer, benchmark_info_,
+                             /*decoded_token_ids=*/nullptr, GetDecodeLimits(),
+                             session_config_.GetNumTopLogProbs()));
     return responses;
   }
 }
 
 absl::Status SessionBasic::DecodeInternalStreaming(
     InferenceObservable* observer) {
-  if (sampler_ == nullptr) {
-    RETURN_IF_ERROR(DecodeStreaming(executor_, tokenizer_, stop_token_detector_,
-                                    benchmark_info_, observer));
+  if (session_config_.GetBeamSearchParams().beam_width() > 1) {
+    // The hypotheses are only known once the search is done, so the responses
+    // are sent all at once.
+    absl::StatusOr<Responses> responses = DecodeInternal();
+    if (!responses.ok()) {
+      observer->OnError(responses.status());
+      return responses.status();
+    }
+    observer->OnNext(*responses);
+    observer->OnDone();
+    return absl::OkStatus();
+  }
+  if (absl::Status status = ActivateOnExecutor(); !status.ok()) {
+    observer->OnError(status);
+    return status;
+  }
+  if (sampler_ == nullptr && session_config_.GetPipelinedDecodeDepth() > 0) {
+    if (decode_consumer_thread_pool_ == nullptr) {
+      decode_consumer_thread_pool_ = std::make_unique<ThreadPool>(
+          /*name_prefix=*/"decode_consumer", /*max_num_threads=*/1);
+    }
+    RETURN_IF_ERROR(DecodeStreamingPipelined(
+        executor_, tokenizer_, stop_token_detector_, benchmark_info_, observer,
+        session_config_.GetPipelinedDecodeDepth(),
+        decode_consumer_thread_pool_.get(), /*decoded_token_ids=*/nullptr,
+        GetDecodeLimits()));
+  } else if (sampler_ == nullptr) {
+    RETURN_IF_ERROR(DecodeStreaming(
+        executor_, tokenizer_, stop_token_detector_, benchmark_info_, observer,
+        /*decoded_token_ids=*/nullptr, GetDecodeLimits()));
   } else {
     std::vector<int> decoded_ids(session_config_.GetNumOutputCandidates(),
                                  last_prefill_token_id_);
@@ -158,7 +287,8 @@ absl::Status SessionBasic::DecodeInternalStreaming(
     RETURN_IF_ERROR(DecodeCustomSamplingStreaming(
         executor_, tokenizer_, stop_token_detector_,
         /*num_output_candidates=*/1, *sampler_, *decoded_ids_buffer,
-        benchmark_info_, observer));
+        benchmark_info_, observer, /*decoded_token_ids=*/nullptr,
+        GetDecodeLimits(), session_config_.GetNumTopLogProbs()));
   }
   return absl::OkStatus();
 }
@@ -179,6 +309,40 @@ absl::Status SessionBasic::RunDecodeAsync(InferenceObservable* observer) {
   });
 }
 
+absl::StatusOr<std::vector<ContinuationScore>> SessionBasic::ScoreInternal(
+    const std::vector<std::vector<int>>& continuation_ids) {
+  RETURN_IF_ERROR(ActivateOnExecutor());
+  return litert::lm::Score(executor_, tokenizer_, last_prefill_token_id_,
+                           continuation_ids, GetDecodeLimits());
+}
+
+absl::StatusOr<std::vector<ContinuationScore>> SessionBasic::Score(
+    const std::vector<InputData>& prompt,
+    const std::vector<InputData>& continuations) {
+  if (continuations.empty()) {
+    return absl::InvalidArgumentError("No continuation to score.");
+  }
+  std::vector<std::vector<int>> continuation_ids;
+  continuation_ids.reserve(continuations.size());
+  for (const auto& continuation : continuations) {
+    std::optional<std::string> text = ToString(continuation);
+    if (!text.has_value()) {
+      return absl::InvalidArgumentError(
+          "Only text continuations can be scored.");
+    }
+    ASSIGN_OR_RETURN(continuation_ids.emplace_back(),
+                     tokenizer_.TextToTokenIds(*text));
+  }
+  RETURN_IF_ERROR(RunPrefill(prompt));
+  absl::StatusOr<std::vector<ContinuationScore>> scores;
+  RETURN_IF_ERROR(worker_thread_pool_.Schedule(
+      [this, &continuation_ids, &scores]() {
+        scores = this->ScoreInternal(continuation_ids);
+      }));
+  RETURN_IF_ERROR(worker_thread_pool_.WaitUntilDone(Engine::kDefaultTimeout));
+  return scores;
+}
+
 absl::StatusOr<Responses> SessionBasic::GenerateContent(
     const std::vector<InputData>& contents) {
   RETURN_IF_ERROR(RunPrefill(contents));
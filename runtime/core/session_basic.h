@@ -15,6 +15,7 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_SESSION_BASIC_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_SESSION_BASIC_H_
 
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -24,15 +25,19 @@
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
 #include "runtime/components/sampler.h"
 #include "runtime/components/stop_token_detector.h"
+#include "runtime/components/tokenized_prompt_affixes.h"
 #include "runtime/components/tokenizer.h"
+#include "runtime/core/session_pool.h"
 #include "runtime/engine/engine.h"
 #include "runtime/engine/engine_settings.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/llm_executor.h"
 #include "runtime/framework/threadpool.h"
 #include "runtime/proto/sampler_params.pb.h"
+#include "runtime/util/memory_tracker.h"
 
 namespace litert::lm {
 
@@ -48,12 +53,23 @@ class SessionBasic : public Engine::Session {
   // - sampler_params: The sampler parameters used for decoding. Note that if
   //   the sampler_params.type is TYPE_UNSPECIFIED, the sampling logic will be
   //   handled by the LLM Executor.
+  // - memory_reservation: The memory accounted to the session, released when
+  //   the session is destroyed.
+  // - session_pool: The pool the resources of the session (e.g. the sampler)
+  //   are taken from if possible, and given back to when the session is
+  //   destroyed. It must outlive the session.
   static absl::StatusOr<std::unique_ptr<SessionBasic>> Create(
       LlmExecutor* absl_nonnull executor, Tokenizer* absl_nonnull tokenizer,
       const SessionConfig& session_config,
       std::optional<BenchmarkInfo> benchmark_info,
-      ThreadPool* absl_nonnull worker_thread_pool);
-
+      ThreadPool* absl_nonnull worker_thread_pool,
+      MemoryReservation memory_reservation = MemoryReservation(),
+      SessionPool* absl_nullable session_pool = nullptr);
+
+  // Gives the resources back to the session pool, if any, and releases the
+  // sequence of the session on the executor, with its saved KV cache and its
+  // memory in the tracker, on the worker thread, after the works already
+  // scheduled. The executors without the sequences support are reset instead.
   virtual ~SessionBasic();
 
   absl::StatusOr<Responses> GenerateContent(
@@ -71,23 +87,41 @@ class SessionBasic : public Engine::Session {
   absl::Status RunDecodeAsync(
       InferenceObservable* observer) override;
 
+  absl::StatusOr<std::vector<ContinuationScore>> Score(
+      const std::vector<InputData>& prompt,
+      const std::vector<InputData>& continuations) override;
+
+  void SetCancelFlag(const std::atomic_bool* cancel) override {
+    cancel_ = cancel;
+  }
+
+  void SetDeadline(absl::Time deadline) override { deadline_ = deadline; }
+
   absl::StatusOr<BenchmarkInfo> GetBenchmarkInfo() override;
 
  private:
   explicit SessionBasic(LlmExecutor* absl_nonnull executor,
                         Tokenizer* absl_nonnull tokenizer,
-                        std::unique_ptr<Sampler> sampler,
+                        SessionResources resources,
                         const SessionConfig& session_config,
                         std::optional<BenchmarkInfo> benchmark_info,
                         ThreadPool* absl_nonnull worker_thread_pool,
-                        const StopTokenDetector& stop_token_detector)
+                        MemoryReservation memory_reservation,
+                        SessionPool* absl_nullable session_pool)
       : executor_(*executor),
         tokenizer_(*tokenizer),
-        sampler_(std::move(sampler)),
+        sampler_(std::move(resources.sampler)),
         session_config_(session_config),
         benchmark_info_(benchmark_info),
         worker_thread_pool_(*worker_thread_pool),
-        stop_token_detector_(stop_token_detector) {}
+        stop_token_detector_(std::move(resources.stop_token_detector)),
+        user_turn_affixes_(std::move(resources.user_turn_affixes)),
+        memory_reservation_(std::move(memory_reservation)),
+        session_pool_(session_pool) {}
+
+  // Builds the resources of a session with `session_config`.
+  static absl::StatusOr<std::unique_ptr<SessionResources>> CreateResources(
+      Tokenizer& tokenizer, const SessionConfig& session_config);
 
   // The internal function to prefill the input prompt. It is for convenience to
   // wrap it with lambda function for scheduling.
@@ -100,9 +134,26 @@ class SessionBasic : public Engine::Session {
   absl::Status DecodeInternalStreaming(
       InferenceObservable* observer = nullptr);
 
+  // The internal function to score the continuations after the prefill of the
+  // prompt.
+  absl::StatusOr<std::vector<ContinuationScore>> ScoreInternal(
+      const std::vector<std::vector<int>>& continuation_ids);
+
+  // Returns the limits of the decodes from the cancel flag, the deadline and
+  // the session config.
+  DecodeLimits GetDecodeLimits() const;
+
+  // Selects the adapter and the sequence of the session on the executor,
+  // which is shared by the sessions. It is called on the worker thread before
+  // each prefill/decode.
+  absl::Status ActivateOnExecutor();
+
   // The executor used for run the LLM for prefill/decode.
   LlmExecutor& executor_;
 
+  // The sequence of the session on the executor.
+  const int sequence_id_ = NewExecutorSequenceId();
+
   // The tokenizer used for converting between text to token ids.
   Tokenizer& tokenizer_;
 
@@ -122,8 +173,30 @@ class SessionBasic : public Engine::Session {
   // The thread pool used for the session.
   ThreadPool& worker_thread_pool_;
 
+  // The thread handling the tokens of the pipelined decodes, created by the
+  // first one and kept for the next ones.
+  std::unique_ptr<ThreadPool> decode_consumer_thread_pool_;
+
   // The stop token detector used for the session.
   StopTokenDetector stop_token_detector_;
+
+  // The pre-tokenized prompt template wrapped around each user input, i.e.
+  // the user prefix, and the user suffix followed by the model prefix. They
+  // are tokenized once when the session is created.
+  TokenizedPromptAffixes user_turn_affixes_;
+
+  // The memory accounted to the session, e.g. for its sampler.
+  MemoryReservation memory_reservation_;
+
+  // The pool the sampler, the stop token detector and the user turn affixes
+  // are given back to, if any.
+  SessionPool* absl_nullable session_pool_;
+
+  // The flag cancelling the prefills and decodes, if any.
+  const std::atomic_bool* cancel_ = nullptr;
+
+  // The deadline of the prefills and decodes.
+  absl::Time deadline_ = absl::InfiniteFuture();
 };
 
 }  // namespace litert::lm
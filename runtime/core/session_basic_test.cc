@@ -8,20 +8,26 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
 #include "absl/time/time.h"  // from @com_google_absl
 #include "runtime/components/sentencepiece_tokenizer.h"
+#include "runtime/components/token_id_util.h"
 #include "runtime/components/tokenizer.h"
+#include "runtime/core/session_pool.h"
 #include "runtime/engine/engine_settings.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/fake_llm_executor.h"
 #include "runtime/executor/llm_executor.h"
 #include "runtime/framework/thread_options.h"
 #include "runtime/framework/threadpool.h"
+#include "runtime/util/memory_tracker.h"
 #include "runtime/util/test_utils.h"  // NOLINT
 
 namespace litert::lm {
 namespace {
 
+using ::testing::status::StatusIs;
+
 constexpr char kTestdataDir[] =
     "litert_lm/runtime/components/testdata/";
 
@@ -88,6 +94,73 @@ TEST_F(SessionBasicTest, RunDecode) {
   EXPECT_EQ(*(responses->GetResponseTextAt(0)), " How's it going?!");
 }
 
+TEST_F(SessionBasicTest, RejectsDroppingOldestTurns) {
+  SessionConfig session_config = SessionConfig::CreateDefault();
+  session_config.GetMutableSamplerParams() = sampler_params_;
+  session_config.GetMutableContextOverflowOptions().policy =
+      ContextOverflowPolicy::kDropOldestTurns;
+  EXPECT_THAT(SessionBasic::Create(executor_.get(), tokenizer_.get(),
+                                   session_config, std::nullopt,
+                                   worker_thread_pool_.get()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(SessionBasicTest, ReleasesMemoryReservationOnDestruction) {
+  SessionConfig session_config = SessionConfig::CreateDefault();
+  session_config.GetMutableSamplerParams() = sampler_params_;
+  session_config.GetMutableStopTokenIds() = {{2294}};
+  session_config.SetStartTokenId(2);
+  MemoryTracker memory_tracker;
+  {
+    auto session = SessionBasic::Create(
+        executor_.get(), tokenizer_.get(), session_config,
+        /*benchmark_info=*/std::nullopt, worker_thread_pool_.get(),
+        memory_tracker.Track("session_0", MemoryComponent::kSampler, 1024));
+    ASSERT_OK(session);
+    EXPECT_EQ(memory_tracker.GetUsage().GetOwnerBytes("session_0"), 1024);
+  }
+  EXPECT_EQ(memory_tracker.GetUsage().total_bytes, 0);
+}
+
+TEST_F(SessionBasicTest, ReusesResourcesFromSessionPool) {
+  SessionConfig session_config = SessionConfig::CreateDefault();
+  session_config.GetMutableSamplerParams() = sampler_params_;
+  session_config.GetMutableStopTokenIds() = {{2294}};
+  session_config.SetStartTokenId(2);
+  SessionPool session_pool(/*max_num_idle=*/1);
+  for (int i = 0; i < 2; ++i) {
+    auto session = SessionBasic::Create(
+        executor_.get(), tokenizer_.get(), session_config,
+        /*benchmark_info=*/std::nullopt, worker_thread_pool_.get(),
+        MemoryReservation(), &session_pool);
+    ASSERT_OK(session);
+  }
+  const SessionPoolStats stats = session_pool.GetStats();
+  EXPECT_EQ(stats.num_misses, 1);
+  EXPECT_EQ(stats.num_hits, 1);
+  EXPECT_EQ(stats.num_idle, 1);
+}
+
+TEST_F(SessionBasicTest, Score) {
+  SessionConfig session_config = SessionConfig::CreateDefault();
+  session_config.GetMutableSamplerParams() = sampler_params_;
+  session_config.SetStartTokenId(2);
+  auto session =
+      SessionBasic::Create(executor_.get(), tokenizer_.get(), session_config,
+                           std::nullopt, worker_thread_pool_.get());
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<ContinuationScore> scores,
+      (*session)->Score({InputText("Hello World!")}, {InputText("How's")}));
+  ASSERT_EQ(scores.size(), 1);
+  EXPECT_EQ(scores[0].token_log_probs.size(), 3);
+  EXPECT_FLOAT_EQ(scores[0].total_log_prob, 0.0f);
+  // The session is left after the prompt.
+  EXPECT_EQ(executor_->GetCurrentStep().value(), 8);
+
+  EXPECT_THAT((*session)->Score({InputText("Hello World!")}, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 class TestObserver : public InferenceObservable {
  public:
   void OnDone() override { done_ = true; }
@@ -2,17 +2,20 @@
 
 #include <memory>
 #include <optional>
+#include <utility>
 
 #include "absl/base/nullability.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "runtime/components/tokenizer.h"
 #include "runtime/core/session_basic.h"
+#include "runtime/core/session_pool.h"
 #include "runtime/engine/engine.h"
 #include "runtime/engine/engine_settings.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/llm_executor.h"
 #include "runtime/framework/threadpool.h"
 #include "runtime/proto/sampler_params.pb.h"
+#include "runtime/util/memory_tracker.h"
 #include "runtime/util/status_macros.h"  // NOLINT
 
 namespace litert::lm {
@@ -21,9 +24,11 @@ absl::StatusOr<std::unique_ptr<Engine::Session>> InitializeSession(
     LlmExecutor* executor, Tokenizer* tokenizer,
     const SessionConfig& session_config,
     std::optional<BenchmarkInfo> benchmark_info,
-    ThreadPool* absl_nonnull worker_thread_pool) {
-  auto session = SessionBasic::Create(executor, tokenizer, session_config,
-                                      benchmark_info, worker_thread_pool);
+    ThreadPool* absl_nonnull worker_thread_pool,
+    MemoryReservation memory_reservation, SessionPool* session_pool) {
+  auto session = SessionBasic::Create(
+      executor, tokenizer, session_config, benchmark_info, worker_thread_pool,
+      std::move(memory_reservation), session_pool);
   return session;
 }
 
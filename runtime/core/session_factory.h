@@ -21,11 +21,13 @@
 #include "absl/base/nullability.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "runtime/components/tokenizer.h"
+#include "runtime/core/session_pool.h"
 #include "runtime/engine/engine.h"
 #include "runtime/engine/engine_settings.h"
 #include "runtime/engine/io_types.h"
 #include "runtime/executor/llm_executor.h"
 #include "runtime/framework/threadpool.h"
+#include "runtime/util/memory_tracker.h"
 
 namespace litert::lm {
 
@@ -36,7 +38,9 @@ absl::StatusOr<std::unique_ptr<Engine::Session>> InitializeSession(
     LlmExecutor* absl_nonnull executor, Tokenizer* absl_nonnull tokenizer,
     const SessionConfig& session_config,
     std::optional<BenchmarkInfo> benchmark_info,
-    ThreadPool* absl_nonnull worker_thread_pool);
+    ThreadPool* absl_nonnull worker_thread_pool,
+    MemoryReservation memory_reservation = MemoryReservation(),
+    SessionPool* absl_nullable session_pool = nullptr);
 
 }  // namespace litert::lm
 
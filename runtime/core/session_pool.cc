@@ -0,0 +1,107 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/core/session_pool.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_log.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/str_join.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/proto/llm_metadata.pb.h"
+#include "runtime/proto/sampler_params.pb.h"
+
+namespace litert::lm {
+
+std::unique_ptr<SessionResources> SessionPool::Acquire(
+    const SessionConfig& session_config) {
+  const std::string key = GetKey(session_config);
+  absl::MutexLock lock(&mutex_);
+  auto it = idle_resources_.find(key);
+  if (it == idle_resources_.end() || it->second.empty()) {
+    ++num_misses_;
+    return nullptr;
+  }
+  std::unique_ptr<SessionResources> resources = std::move(it->second.back());
+  it->second.pop_back();
+  --num_idle_;
+  ++num_hits_;
+  return resources;
+}
+
+void SessionPool::Release(const SessionConfig& session_config,
+                          std::unique_ptr<SessionResources> resources) {
+  if (resources == nullptr) {
+    return;
+  }
+  // A reused sampler must sample like a new one, e.g. from the same seed.
+  if (resources->sampler != nullptr) {
+    absl::Status status = resources->sampler->Reset();
+    if (!status.ok()) {
+      ABSL_LOG(INFO) << "The sampler is not pooled: " << status;
+      return;
+    }
+  }
+  resources->stop_token_detector.ResetBatch();
+  const std::string key = GetKey(session_config);
+  absl::MutexLock lock(&mutex_);
+  if (num_idle_ >= max_num_idle_) {
+    return;
+  }
+  idle_resources_[key].push_back(std::move(resources));
+  ++num_idle_;
+}
+
+SessionPoolStats SessionPool::GetStats() const {
+  absl::MutexLock lock(&mutex_);
+  return SessionPoolStats{.num_hits = num_hits_,
+                          .num_misses = num_misses_,
+                          .num_idle = num_idle_,
+                          .max_num_idle = max_num_idle_};
+}
+
+// static
+std::string SessionPool::GetKey(const SessionConfig& session_config) {
+  const proto::PromptTemplates& prompt_templates =
+      session_config.GetPromptTemplates();
+  std::string key = absl::StrCat(
+      static_cast<int>(session_config.GetSamplerBackend()), "|",
+      session_config.GetNumOutputCandidates(), "|");
+  const std::string sampler_params =
+      session_config.GetSamplerParams().SerializeAsString();
+  // The strings may contain any character, so each of them is prefixed by its
+  // length to keep the keys of different configs apart.
+  for (absl::string_view field :
+       {absl::string_view(sampler_params),
+        absl::string_view(prompt_templates.user().prefix()),
+        absl::string_view(prompt_templates.user().suffix()),
+        absl::string_view(prompt_templates.model().prefix())}) {
+    absl::StrAppend(&key, field.size(), ":", field, "|");
+  }
+  for (const std::vector<int>& stop_token_ids :
+       session_config.GetStopTokenIds()) {
+    absl::StrAppend(&key, absl::StrJoin(stop_token_ids, ","), ";");
+  }
+  return key;
+}
+
+}  // namespace litert::lm
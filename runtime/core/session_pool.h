@@ -0,0 +1,94 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_SESSION_POOL_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_SESSION_POOL_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"  // from @com_google_absl
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "runtime/components/sampler.h"
+#include "runtime/components/stop_token_detector.h"
+#include "runtime/components/tokenized_prompt_affixes.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+
+namespace litert::lm {
+
+// The objects of a session which only depend on its config. They are built
+// once and handed from a destroyed session to the next one with the same
+// config by a SessionPool.
+struct SessionResources {
+  // The sampler, or null when the sampling is done by the executor.
+  std::unique_ptr<Sampler> sampler;
+  StopTokenDetector stop_token_detector;
+  // The pre-tokenized prompt template wrapped around each user input.
+  TokenizedPromptAffixes user_turn_affixes;
+};
+
+// Keeps the resources of the destroyed sessions warm, so that creating a
+// session with the same config as an earlier one neither creates a sampler
+// nor tokenizes the prompt templates. It is thread-safe.
+//
+// Sample usage:
+//
+// std::unique_ptr<SessionResources> resources = pool.Acquire(config);
+// if (resources == nullptr) {
+//   // Build the resources of the config.
+// }
+// ...
+// pool.Release(config, std::move(resources));
+//
+class SessionPool {
+ public:
+  // Creates a pool keeping at most `max_num_idle` resources, of any configs.
+  explicit SessionPool(int max_num_idle) : max_num_idle_(max_num_idle) {}
+
+  SessionPool(const SessionPool&) = delete;
+  SessionPool& operator=(const SessionPool&) = delete;
+
+  // Takes idle resources built for `session_config` out of the pool, or
+  // returns null if there are none.
+  std::unique_ptr<SessionResources> Acquire(
+      const SessionConfig& session_config);
+
+  // Puts the resources of a destroyed session back into the pool, unless it
+  // is full or the sampler cannot be reset, in which case they are dropped.
+  void Release(const SessionConfig& session_config,
+               std::unique_ptr<SessionResources> resources);
+
+  SessionPoolStats GetStats() const;
+
+ private:
+  // Returns the key of the resources of `session_config`, made of the fields
+  // they are built from.
+  static std::string GetKey(const SessionConfig& session_config);
+
+  const int max_num_idle_;
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string,
+                      std::vector<std::unique_ptr<SessionResources>>>
+      idle_resources_ ABSL_GUARDED_BY(mutex_);
+  int num_idle_ ABSL_GUARDED_BY(mutex_) = 0;
+  int num_hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int num_misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_CORE_SESSION_POOL_H_
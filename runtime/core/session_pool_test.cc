@@ -0,0 +1,117 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/core/session_pool.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/components/stop_token_detector.h"
+#include "runtime/components/tokenized_prompt_affixes.h"
+#include "runtime/components/tokenizer.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+// The prompt templates of the tests are empty, so they are never tokenized.
+class UnusedTokenizer : public Tokenizer {
+ public:
+  absl::StatusOr<std::vector<int>> TextToTokenIds(
+      absl::string_view text) override {
+    return absl::UnimplementedError("Not used.");
+  }
+  absl::StatusOr<std::string> TokenIdsToText(
+      const std::vector<int>& token_ids) override {
+    return absl::UnimplementedError("Not used.");
+  }
+};
+
+std::unique_ptr<SessionResources> CreateResources() {
+  UnusedTokenizer tokenizer;
+  auto affixes = TokenizedPromptAffixes::Create(tokenizer, "", "");
+  EXPECT_OK(affixes);
+  return std::make_unique<SessionResources>(SessionResources{
+      .sampler = nullptr,
+      .stop_token_detector = StopTokenDetector(/*batch_size=*/1),
+      .user_turn_affixes = std::move(*affixes)});
+}
+
+TEST(SessionPoolTest, ReusesTheResourcesOfTheSameConfig) {
+  SessionPool pool(/*max_num_idle=*/2);
+  SessionConfig config = SessionConfig::CreateDefault();
+  config.GetMutableStopTokenIds() = {{1}};
+
+  EXPECT_EQ(pool.Acquire(config), nullptr);
+  std::unique_ptr<SessionResources> resources = CreateResources();
+  const SessionResources* resources_ptr = resources.get();
+  pool.Release(config, std::move(resources));
+  EXPECT_EQ(pool.GetStats().num_idle, 1);
+
+  // A session with other stop tokens does not get the resources.
+  SessionConfig other_config = config;
+  other_config.GetMutableStopTokenIds() = {{2}};
+  EXPECT_EQ(pool.Acquire(other_config), nullptr);
+
+  EXPECT_EQ(pool.Acquire(config).get(), resources_ptr);
+  const SessionPoolStats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_hits, 1);
+  EXPECT_EQ(stats.num_misses, 2);
+  EXPECT_EQ(stats.num_idle, 0);
+  EXPECT_EQ(stats.max_num_idle, 2);
+}
+
+TEST(SessionPoolTest, KeepsTheAffixesOfTheConfigsApart) {
+  SessionPool pool(/*max_num_idle=*/2);
+  SessionConfig config = SessionConfig::CreateDefault();
+  config.GetMutablePromptTemplates().mutable_user()->set_prefix("a|b");
+  config.GetMutablePromptTemplates().mutable_user()->set_suffix("c");
+  pool.Release(config, CreateResources());
+
+  // The same characters split differently make another config.
+  SessionConfig other_config = config;
+  other_config.GetMutablePromptTemplates().mutable_user()->set_prefix("a");
+  other_config.GetMutablePromptTemplates().mutable_user()->set_suffix("b|c");
+  EXPECT_EQ(pool.Acquire(other_config), nullptr);
+  EXPECT_NE(pool.Acquire(config), nullptr);
+}
+
+TEST(SessionPoolTest, DropsTheResourcesBeyondItsSize) {
+  SessionPool pool(/*max_num_idle=*/1);
+  SessionConfig config = SessionConfig::CreateDefault();
+  pool.Release(config, CreateResources());
+  pool.Release(config, CreateResources());
+  EXPECT_EQ(pool.GetStats().num_idle, 1);
+
+  EXPECT_NE(pool.Acquire(config), nullptr);
+  EXPECT_EQ(pool.Acquire(config), nullptr);
+}
+
+TEST(SessionPoolTest, DisabledPoolKeepsNothing) {
+  SessionPool pool(/*max_num_idle=*/0);
+  SessionConfig config = SessionConfig::CreateDefault();
+  pool.Release(config, CreateResources());
+  EXPECT_EQ(pool.GetStats().num_idle, 0);
+  EXPECT_EQ(pool.Acquire(config), nullptr);
+}
+
+}  // namespace
+}  // namespace litert::lm
@@ -0,0 +1,140 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This tool measures the throughput of Engine::Embed in texts per second, on
+// synthetic short texts, with the texts packed into shared prefill calls
+// versus embedded one at a time.
+//
+// Example usage:
+// bazel run -c opt :embed_benchmark -- --model_path=<model_path> \
+//   --backend=cpu --num_texts=256 --max_words=24
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"  // from @com_google_absl
+#include "absl/flags/parse.h"  // from @com_google_absl
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/random/random.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/components/embedding_pooling.h"
+#include "runtime/engine/engine.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/executor/executor_settings_base.h"
+
+ABSL_FLAG(std::string, model_path, "",
+          "Model path of an LLM with a hidden_states prefill output.");
+ABSL_FLAG(std::string, backend, "cpu", "Executor backend (cpu, gpu).");
+ABSL_FLAG(int, num_texts, 256, "The number of texts to embed per run.");
+ABSL_FLAG(int, min_words, 4, "The minimum number of words of a text.");
+ABSL_FLAG(int, max_words, 24, "The maximum number of words of a text.");
+ABSL_FLAG(int, iterations, 3, "The number of runs to average.");
+
+namespace {
+
+using ::litert::lm::EmbeddingOptions;
+using ::litert::lm::EmbeddingPooling;
+using ::litert::lm::Engine;
+using ::litert::lm::InputData;
+using ::litert::lm::InputText;
+
+constexpr const char* kWords[] = {
+    "the",    "model",  "runs",   "on",      "device", "with",   "a",
+    "small",  "memory", "budget", "and",     "fast",   "search", "over",
+    "notes",  "photos", "mail",   "meeting", "travel", "recipe", "music"};
+
+// Returns the texts of random lengths made of common words.
+std::vector<InputData> MakeSyntheticTexts(int num_texts, int min_words,
+                                          int max_words) {
+  absl::BitGen rng;
+  std::vector<InputData> texts;
+  texts.reserve(num_texts);
+  for (int i = 0; i < num_texts; ++i) {
+    std::string text;
+    const int num_words = absl::Uniform<int>(absl::IntervalClosed, rng,
+                                             min_words, max_words);
+    for (int j = 0; j < num_words; ++j) {
+      if (j > 0) text += " ";
+      text += kWords[absl::Uniform<int>(rng, 0, std::size(kWords))];
+    }
+    texts.push_back(InputText(text));
+  }
+  return texts;
+}
+
+// Returns the texts per second of embedding the texts in calls of
+// `texts_per_call` texts.
+double TimeEmbed(Engine& engine, const std::vector<InputData>& texts,
+                 int texts_per_call, const EmbeddingOptions& options,
+                 int iterations) {
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    for (int first = 0; first < texts.size(); first += texts_per_call) {
+      const int last = std::min<int>(first + texts_per_call, texts.size());
+      std::vector<InputData> call_texts(texts.begin() + first,
+                                        texts.begin() + last);
+      ABSL_CHECK_OK(engine.Embed(call_texts, options).status());
+    }
+  }
+  return texts.size() * iterations / absl::ToDoubleSeconds(absl::Now() - start);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  auto model_assets =
+      litert::lm::ModelAssets::Create(absl::GetFlag(FLAGS_model_path));
+  ABSL_CHECK_OK(model_assets);
+  auto backend = litert::lm::GetBackendFromString(absl::GetFlag(FLAGS_backend));
+  ABSL_CHECK_OK(backend);
+  auto engine_settings = litert::lm::EngineSettings::CreateDefault(
+      std::move(*model_assets), *backend);
+  ABSL_CHECK_OK(engine_settings);
+  auto engine = Engine::CreateEngine(std::move(*engine_settings));
+  ABSL_CHECK_OK(engine);
+
+  const std::vector<InputData> texts = MakeSyntheticTexts(
+      absl::GetFlag(FLAGS_num_texts), absl::GetFlag(FLAGS_min_words),
+      absl::GetFlag(FLAGS_max_words));
+  const int iterations = absl::GetFlag(FLAGS_iterations);
+  // Warms up the prefill signatures.
+  ABSL_CHECK_OK((*engine)->Embed(texts).status());
+
+  std::cout << absl::StrFormat("%10s %8s %12s\n", "pooling", "packed",
+                               "texts/sec");
+  const std::pair<const char*, EmbeddingPooling> poolings[] = {
+      {"mean", EmbeddingPooling::kMean},
+      {"last", EmbeddingPooling::kLastToken},
+      {"first", EmbeddingPooling::kFirstToken}};
+  for (const auto& [name, pooling] : poolings) {
+    const EmbeddingOptions options{.pooling = pooling};
+    for (bool packed : {false, true}) {
+      const double texts_per_sec = TimeEmbed(
+          **engine, texts, /*texts_per_call=*/packed ? texts.size() : 1,
+          options, iterations);
+      std::cout << absl::StrFormat("%10s %8s %12.1f\n", name,
+                                   packed ? "yes" : "no", texts_per_sec);
+    }
+  }
+  return 0;
+}
@@ -15,6 +15,7 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_ENGINE_ENGINE_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_ENGINE_ENGINE_H_
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -24,6 +25,7 @@
 #include "absl/time/time.h"  // from @com_google_absl
 #include "runtime/engine/engine_settings.h"
 #include "runtime/engine/io_types.h"
+#include "runtime/util/memory_tracker.h"
 
 namespace litert::lm {
 
@@ -108,11 +110,71 @@ class Engine {
       return absl::UnimplementedError("Not implemented.");
     }
 
+    // Scores each of the continuations of the prompt, i.e. returns the log
+    // probabilities of their tokens as the model's reply to the prompt. The
+    // prompt is prefilled once like with RunPrefill and its KV cache is shared
+    // by the continuations, each scored in one pass over its tokens. The
+    // session is left as after RunPrefill(prompt).
+    // This is a blocking call.
+    virtual absl::StatusOr<std::vector<ContinuationScore>> Score(
+        const std::vector<InputData>& prompt,
+        const std::vector<InputData>& continuations) {
+      return absl::UnimplementedError("Not implemented.");
+    }
+
+    // Sets a flag which cancels the following prefills and decodes once it is
+    // true, e.g. when the client of a server disconnects. The cancelled calls
+    // fail with a CancelledError, also sent to the observer of the streaming
+    // calls. The decode stops between two steps and keeps the tokens decoded
+    // so far in the session. The flag must outlive the calls, or be reset to
+    // nullptr.
+    virtual void SetCancelFlag(const std::atomic_bool* cancel) {}
+
+    // Sets a wall-clock deadline of the following calls, which fail with a
+    // DeadlineExceededError once it is passed, like the cancelled calls.
+    // absl::InfiniteFuture() (the default) removes the deadline.
+    virtual void SetDeadline(absl::Time deadline) {}
+
     // Returns the benchmark info for the session. Returns error if the
     // benchmark is not enabled.
     virtual absl::StatusOr<BenchmarkInfo> GetBenchmarkInfo() = 0;
   };
 
+  // Conversation hosts a chat with the LLM where the client sends the full
+  // message history on every turn, e.g. a stateless OpenAI-style client. It
+  // keeps track of the tokens already resident in the KV cache, so that only
+  // the part of the history which differs from what was processed before is
+  // prefilled.
+  class Conversation {
+   public:
+    virtual ~Conversation() = default;
+
+    // Generates the next assistant message for the given message history.
+    // The history must contain all the messages of the conversation so far
+    // (including the replies returned by earlier calls) and must not end with
+    // an assistant message. This is a blocking call.
+    virtual absl::StatusOr<Responses> GenerateReply(
+        const std::vector<Message>& messages) = 0;
+
+    // Same as GenerateReply, but the reply is streamed through the observer.
+    // This is a blocking call.
+    virtual absl::Status GenerateReplyStream(
+        const std::vector<Message>& messages, InferenceObservable* observer) {
+      return absl::UnimplementedError("Not implemented.");
+    }
+
+    // Same as Session::SetCancelFlag. A cancelled reply is not part of the
+    // conversation: the next call must not include it in the history.
+    virtual void SetCancelFlag(const std::atomic_bool* cancel) {}
+
+    // Same as Session::SetDeadline.
+    virtual void SetDeadline(absl::Time deadline) {}
+
+    // Returns the benchmark info for the conversation. Returns error if the
+    // benchmark is not enabled.
+    virtual absl::StatusOr<BenchmarkInfo> GetBenchmarkInfo() = 0;
+  };
+
   // Method to create Engine.
   static absl::StatusOr<std::unique_ptr<Engine>> CreateEngine(
       EngineSettings settings);
@@ -121,6 +183,49 @@ class Engine {
   virtual absl::StatusOr<std::unique_ptr<Session>> CreateSession(
       const SessionConfig& session_config) const = 0;
 
+  // Method to create the Conversation. Like the Session, it shares the
+  // underlying executor with the other sessions of the engine.
+  virtual absl::StatusOr<std::unique_ptr<Conversation>> CreateConversation(
+      const SessionConfig& session_config) const {
+    return absl::UnimplementedError("Not implemented.");
+  }
+
+  // Embeds each of the texts, e.g. for retrieval, by pooling the hidden states
+  // of its tokens as set by `options`. The texts are prefilled together, many
+  // short texts sharing one prefill call with an attention mask keeping them
+  // apart, and are not added to any session. The model must output its
+  // hidden states. This is a blocking call.
+  virtual absl::StatusOr<std::vector<std::vector<float>>> Embed(
+      const std::vector<InputData>& texts,
+      const EmbeddingOptions& options = EmbeddingOptions()) {
+    return absl::UnimplementedError("Not implemented.");
+  }
+
+  // Returns the `num_top` most likely next tokens of each of the prompts, in
+  // decreasing order of probability, e.g. to classify a batch of short
+  // messages by the likelihood of label tokens. Like with Embed, the prompts
+  // are prefilled packed together and are not added to any session. The
+  // model must output the logits of all the positions of its prefill. This
+  // is a blocking call.
+  virtual absl::StatusOr<std::vector<std::vector<TokenLogProb>>>
+  PredictNextTokens(const std::vector<InputData>& prompts, int num_top) {
+    return absl::UnimplementedError("Not implemented.");
+  }
+
+  // Returns the memory accounted to the engine, e.g. its KV cache, to each of
+  // its live sessions, and to the KV caches saved for them, against the budget set by
+  // EngineSettings::SetMemoryBudgetBytes(). The model weights are not
+  // accounted as they are memory mapped from the model file.
+  virtual absl::StatusOr<MemoryUsage> GetMemoryUsage() const {
+    return absl::UnimplementedError("Not implemented.");
+  }
+
+  // Returns the statistics of the pool keeping the resources of the destroyed
+  // sessions warm for the next ones, see EngineSettings::SetSessionPoolSize.
+  virtual absl::StatusOr<SessionPoolStats> GetSessionPoolStats() const {
+    return absl::UnimplementedError("Not implemented.");
+  }
+
   // Waits until the engine is done with all the tasks. The function will
   // return error if the timeout is reached.
   virtual absl::Status WaitUntilDone(absl::Duration timeout) {
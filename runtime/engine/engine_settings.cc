@@ -1,7 +1,10 @@
 #include "runtime/engine/engine_settings.h"
 
+#include <cstddef>
+#include <map>
 #include <optional>
 #include <ostream>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -10,6 +13,7 @@
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/components/token_id_util.h"
 #include "runtime/components/tokenizer.h"
 #include "runtime/executor/executor_settings_base.h"
 #include "runtime/executor/llm_executor_settings.h"
@@ -161,6 +165,14 @@ std::ostream& operator<<(std::ostream& os, const EngineSettings& settings) {
   } else {
     os << "  BenchmarkParams: Not set" << std::endl;
   }
+  for (const auto& [name, model_assets] : settings.GetLoRAAdapters()) {
+    os << "  LoRAAdapter " << name << ": " << model_assets;
+  }
+  os << "  SessionPoolSize: " << settings.GetSessionPoolSize() << std::endl;
+  if (settings.GetMemoryBudgetBytes() > 0) {
+    os << "  MemoryBudgetBytes: " << settings.GetMemoryBudgetBytes()
+       << std::endl;
+  }
   return os;
 }
 
@@ -171,6 +183,30 @@ proto::LlmMetadata& EngineSettings::GetMutableLlmMetadata() {
   return metadata_.value();
 }
 
+const std::map<std::string, ModelAssets>& EngineSettings::GetLoRAAdapters()
+    const {
+  return lora_adapters_;
+}
+
+void EngineSettings::AddLoRAAdapter(std::string name,
+                                    ModelAssets model_assets) {
+  lora_adapters_.insert_or_assign(std::move(name), std::move(model_assets));
+}
+
+size_t EngineSettings::GetMemoryBudgetBytes() const {
+  return memory_budget_bytes_;
+}
+
+void EngineSettings::SetMemoryBudgetBytes(size_t memory_budget_bytes) {
+  memory_budget_bytes_ = memory_budget_bytes;
+}
+
+int EngineSettings::GetSessionPoolSize() const { return session_pool_size_; }
+
+void EngineSettings::SetSessionPoolSize(int session_pool_size) {
+  session_pool_size_ = session_pool_size;
+}
+
 SessionConfig SessionConfig::CreateDefault() {
   proto::SamplerParameters sampler_params;
   sampler_params.set_type(proto::SamplerParameters::TYPE_UNSPECIFIED);
@@ -257,7 +293,46 @@ absl::Status SessionConfig::MaybeUpdateAndValidate(
         num_output_candidates_));
   }
 
-  if (engine_settings.GetMainExecutorSettings().GetBackend() == Backend::GPU) {
+  if (beam_search_params_.beam_width() > 1 &&
+      num_output_candidates_ > beam_search_params_.beam_width()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Number of output candidates cannot exceed the beam width, but got: ",
+        num_output_candidates_, " > ", beam_search_params_.beam_width()));
+  }
+
+  if (lora_name_.has_value() &&
+      !engine_settings.GetLoRAAdapters().contains(*lora_name_)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown LoRA adapter: ", *lora_name_));
+  }
+
+  if (max_output_tokens_ < 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Max output tokens cannot be negative, but got: ", max_output_tokens_));
+  }
+
+  if (pipelined_decode_depth_ < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Pipelined decode depth cannot be negative, but got: ",
+                     pipelined_decode_depth_));
+  }
+
+  if (num_top_log_probs_.has_value()) {
+    if (*num_top_log_probs_ < 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Number of top log probabilities cannot be negative, "
+                       "but got: ",
+                       *num_top_log_probs_));
+    }
+    if (beam_search_params_.beam_width() > 1) {
+      return absl::InvalidArgumentError(
+          "Log probabilities are not supported with beam search.");
+    }
+  }
+
+  // The log probabilities are computed by the CPU sampler.
+  if (engine_settings.GetMainExecutorSettings().GetBackend() == Backend::GPU &&
+      !num_top_log_probs_.has_value()) {
     sampler_backend_ = Backend::GPU;
   }
   ABSL_LOG(INFO) << "The validated session config: " << *this;
@@ -275,6 +350,14 @@ proto::SamplerParameters& SessionConfig::GetMutableSamplerParams() {
   return sampler_params_;
 }
 
+const proto::BeamSearchParameters& SessionConfig::GetBeamSearchParams() const {
+  return beam_search_params_;
+}
+
+proto::BeamSearchParameters& SessionConfig::GetMutableBeamSearchParams() {
+  return beam_search_params_;
+}
+
 const std::vector<std::vector<int>>& SessionConfig::GetStopTokenIds() const {
   return stop_token_ids_;
 }
@@ -303,10 +386,52 @@ proto::PromptTemplates& SessionConfig::GetMutablePromptTemplates() {
   return prompt_templates_;
 }
 
+const ContextOverflowOptions& SessionConfig::GetContextOverflowOptions() const {
+  return context_overflow_options_;
+}
+
+ContextOverflowOptions& SessionConfig::GetMutableContextOverflowOptions() {
+  return context_overflow_options_;
+}
+
+const std::optional<std::string>& SessionConfig::GetLoRAName() const {
+  return lora_name_;
+}
+
+void SessionConfig::SetLoRAName(std::optional<std::string> lora_name) {
+  lora_name_ = std::move(lora_name);
+}
+
+int SessionConfig::GetMaxOutputTokens() const { return max_output_tokens_; }
+
+void SessionConfig::SetMaxOutputTokens(int max_output_tokens) {
+  max_output_tokens_ = max_output_tokens;
+}
+
+const std::optional<int>& SessionConfig::GetNumTopLogProbs() const {
+  return num_top_log_probs_;
+}
+
+void SessionConfig::SetNumTopLogProbs(std::optional<int> num_top_log_probs) {
+  num_top_log_probs_ = num_top_log_probs;
+}
+
+int SessionConfig::GetPipelinedDecodeDepth() const {
+  return pipelined_decode_depth_;
+}
+
+void SessionConfig::SetPipelinedDecodeDepth(int pipelined_decode_depth) {
+  pipelined_decode_depth_ = pipelined_decode_depth;
+}
+
 std::ostream& operator<<(std::ostream& os, const SessionConfig& config) {
   os << "SessionConfig: " << std::endl;
   os << "  SamplerParams: " << config.GetSamplerParams().DebugString()
      << std::endl;
+  if (config.GetBeamSearchParams().beam_width() > 1) {
+    os << "  BeamSearchParams: " << config.GetBeamSearchParams().DebugString()
+       << std::endl;
+  }
   os << "  StartTokenId: " << config.GetStartTokenId() << std::endl;
   os << "  StopTokenIds: " << std::endl;
   for (const auto& stop_token_ids : config.GetStopTokenIds()) {
@@ -316,6 +441,22 @@ std::ostream& operator<<(std::ostream& os, const SessionConfig& config) {
      << std::endl;
   os << "  PromptTemplates: " << config.GetPromptTemplates().DebugString()
      << std::endl;
+  os << "  ContextOverflowPolicy: "
+     << static_cast<int>(config.GetContextOverflowOptions().policy)
+     << std::endl;
+  if (config.GetLoRAName().has_value()) {
+    os << "  LoRAName: " << *config.GetLoRAName() << std::endl;
+  }
+  if (config.GetMaxOutputTokens() > 0) {
+    os << "  MaxOutputTokens: " << config.GetMaxOutputTokens() << std::endl;
+  }
+  if (config.GetNumTopLogProbs().has_value()) {
+    os << "  NumTopLogProbs: " << *config.GetNumTopLogProbs() << std::endl;
+  }
+  if (config.GetPipelinedDecodeDepth() > 0) {
+    os << "  PipelinedDecodeDepth: " << config.GetPipelinedDecodeDepth()
+       << std::endl;
+  }
   return os;
 }
 
@@ -1,13 +1,17 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_ENGINE_ENGINE_SETTINGS_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_ENGINE_ENGINE_SETTINGS_H_
 
+#include <cstddef>
+#include <map>
 #include <optional>
 #include <ostream>
+#include <string>
 #include <vector>
 
 #include "absl/base/nullability.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
+#include "runtime/components/token_id_util.h"
 #include "runtime/components/tokenizer.h"
 #include "runtime/executor/executor_settings_base.h"
 #include "runtime/executor/llm_executor_settings.h"
@@ -83,6 +87,30 @@ class EngineSettings {
   // created and returned.
   proto::LlmMetadata& GetMutableLlmMetadata();
 
+  // LoRA adapters:
+  // The LoRA adapters loaded by the engine on top of the main model, by name.
+  // Each session selects one of them with SessionConfig::SetLoRAName().
+  const std::map<std::string, ModelAssets>& GetLoRAAdapters() const;
+  // Adds the LoRA adapter in `model_assets` as `name`.
+  void AddLoRAAdapter(std::string name, ModelAssets model_assets);
+
+  // Memory budget:
+  // The memory the engine and its sessions may use on top of the model
+  // weights, in bytes, or 0 for no budget. Creating a session fails with a
+  // ResourceExhausted error when its memory does not fit in the budget, and so
+  // does switching between the sessions when the KV cache saved for the
+  // previous one does not.
+  size_t GetMemoryBudgetBytes() const;
+  void SetMemoryBudgetBytes(size_t memory_budget_bytes);
+
+  // Session pool:
+  // The most sessions' worth of resources (sampler, stop token detector,
+  // tokenized prompt templates) the engine keeps warm after the sessions are
+  // destroyed, to hand them to the next sessions with the same config. 0
+  // disables the pool.
+  int GetSessionPoolSize() const;
+  void SetSessionPoolSize(int session_pool_size);
+
  private:
   explicit EngineSettings(
       LlmExecutorSettings executor_settings,
@@ -97,6 +125,15 @@ class EngineSettings {
   // Default metadata for the model. This is loaded from the model assets (if
   // present).
   std::optional<proto::LlmMetadata> metadata_;
+
+  // The LoRA adapters of the main model, by name.
+  std::map<std::string, ModelAssets> lora_adapters_;
+
+  // The memory budget of the engine and its sessions, 0 for no budget.
+  size_t memory_budget_bytes_ = 0;
+
+  // The number of idle session resources kept by the engine.
+  int session_pool_size_ = 4;
 };
 std::ostream& operator<<(std::ostream& os, const EngineSettings& settings);
 
@@ -118,6 +155,12 @@ class SessionConfig {
   const proto::SamplerParameters& GetSamplerParams() const;
   proto::SamplerParameters& GetMutableSamplerParams();
 
+  // Beam search parameters:
+  // Getters for the beam search parameters. Beam search is used instead of
+  // the sampler when the beam width is greater than 1.
+  const proto::BeamSearchParameters& GetBeamSearchParams() const;
+  proto::BeamSearchParameters& GetMutableBeamSearchParams();
+
   // Stop token ids:
   // Getters for the stop token ids.
   const std::vector<std::vector<int>>& GetStopTokenIds() const;
@@ -142,6 +185,41 @@ class SessionConfig {
   const proto::PromptTemplates& GetPromptTemplates() const;
   proto::PromptTemplates& GetMutablePromptTemplates();
 
+  // Context overflow options:
+  // Getters for how to trim the input that does not fit in the context
+  // (i.e. the KV cache). By default, an error is returned.
+  const ContextOverflowOptions& GetContextOverflowOptions() const;
+  ContextOverflowOptions& GetMutableContextOverflowOptions();
+
+  // LoRA adapter:
+  // Getters for the name of the LoRA adapter applied to the session, one of
+  // EngineSettings::GetLoRAAdapters(). By default, the base model is used.
+  const std::optional<std::string>& GetLoRAName() const;
+  void SetLoRAName(std::optional<std::string> lora_name);
+
+  // Output length:
+  // Getters for the maximum number of tokens decoded per call. The decoding
+  // stops there as if it hit a stop token. 0 (the default) means no limit
+  // other than the KV cache size.
+  int GetMaxOutputTokens() const;
+  void SetMaxOutputTokens(int max_output_tokens);
+
+  // Log probabilities:
+  // Getters for the number of most likely tokens returned with the log
+  // probability of each decoded token (see Responses::GetTokenLogProbsAt).
+  // If set, even to 0, the sampling runs on CPU. By default, no log
+  // probabilities are returned.
+  const std::optional<int>& GetNumTopLogProbs() const;
+  void SetNumTopLogProbs(std::optional<int> num_top_log_probs);
+
+  // Getters for the depth of the pipelined streaming decode, i.e. the maximum
+  // number of decoded tokens waiting to be detokenized and sent to the
+  // observer on a second thread while the next steps are decoded. 0 (the
+  // default) decodes and handles the tokens in turn. It only applies to the
+  // streaming decode with the sampling done by the executor.
+  int GetPipelinedDecodeDepth() const;
+  void SetPipelinedDecodeDepth(int pipelined_decode_depth);
+
  private:
   // Private constructor for the SessionConfig. The user should use the
   // CreateDefault() method to create a SessionConfig.
@@ -150,6 +228,9 @@ class SessionConfig {
   // Parameters used to configure the sampling process.
   proto::SamplerParameters sampler_params_;
 
+  // Parameters used to configure the beam search.
+  proto::BeamSearchParameters beam_search_params_;
+
   // Stop token ids for the session. Note that the stop token could be a
   // sequence of token ids (as opposed to a single token id). The first
   // dimension is the index of the stop token in the session, and the second
@@ -169,6 +250,22 @@ class SessionConfig {
 
   // Backend to use for sampling.
   Backend sampler_backend_;
+
+  // How to trim the input that does not fit in the context.
+  ContextOverflowOptions context_overflow_options_;
+
+  // The LoRA adapter applied to the session, or nullopt for the base model.
+  std::optional<std::string> lora_name_;
+
+  // The maximum number of tokens decoded per call, or 0 for no limit.
+  int max_output_tokens_ = 0;
+
+  // The number of most likely tokens returned per decoded token, or nullopt
+  // for no log probabilities.
+  std::optional<int> num_top_log_probs_;
+
+  // The depth of the pipelined streaming decode, or 0 for no pipelining.
+  int pipelined_decode_depth_ = 0;
 };
 std::ostream& operator<<(std::ostream& os, const SessionConfig& config);
 
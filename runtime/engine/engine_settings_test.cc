@@ -1,5 +1,6 @@
 #include "runtime/engine/engine_settings.h"
 
+#include <optional>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -70,6 +71,28 @@ TEST(EngineSettingsTest, SetAndGetMaxNumTokens) {
   EXPECT_EQ(settings->GetMainExecutorSettings().GetMaxNumTokens(), 128);
 }
 
+TEST(EngineSettingsTest, SetAndGetMemoryBudgetBytes) {
+  auto model_assets = ModelAssets::Create("test_model_path_1");
+  ASSERT_OK(model_assets);
+
+  auto settings = EngineSettings::CreateDefault(*model_assets, Backend::CPU);
+  EXPECT_OK(settings);
+  EXPECT_EQ(settings->GetMemoryBudgetBytes(), 0);
+  settings->SetMemoryBudgetBytes(1 << 20);
+  EXPECT_EQ(settings->GetMemoryBudgetBytes(), 1 << 20);
+}
+
+TEST(EngineSettingsTest, SetAndGetSessionPoolSize) {
+  auto model_assets = ModelAssets::Create("test_model_path_1");
+  ASSERT_OK(model_assets);
+
+  auto settings = EngineSettings::CreateDefault(*model_assets, Backend::CPU);
+  EXPECT_OK(settings);
+  EXPECT_EQ(settings->GetSessionPoolSize(), 4);
+  settings->SetSessionPoolSize(0);
+  EXPECT_EQ(settings->GetSessionPoolSize(), 0);
+}
+
 TEST(EngineSettingsTest, SetAndGetExecutorBackend) {
   auto model_assets = ModelAssets::Create("test_model_path_1");
   ASSERT_OK(model_assets);
@@ -236,6 +259,17 @@ TEST(SessionConfigTest, SetAndGetSamplerParams) {
             proto::SamplerParameters::TYPE_UNSPECIFIED);
 }
 
+TEST(SessionConfigTest, SetAndGetBeamSearchParams) {
+  SessionConfig session_config = SessionConfig::CreateDefault();
+  EXPECT_EQ(session_config.GetBeamSearchParams().beam_width(), 0);
+  proto::BeamSearchParameters& beam_search_params =
+      session_config.GetMutableBeamSearchParams();
+  beam_search_params.set_beam_width(4);
+  beam_search_params.set_length_penalty(0.6f);
+  EXPECT_EQ(session_config.GetBeamSearchParams().beam_width(), 4);
+  EXPECT_FLOAT_EQ(session_config.GetBeamSearchParams().length_penalty(), 0.6f);
+}
+
 TEST(SessionConfigTest, SetAndGetStopTokenIds) {
   SessionConfig session_config = SessionConfig::CreateDefault();
   session_config.GetMutableStopTokenIds() = {{0}, {1, 2}};
@@ -297,6 +331,25 @@ TEST(SessionConfigTest, MaybeUpdateAndValidateMaxNumTokens) {
   EXPECT_EQ(settings->GetMainExecutorSettings().GetMaxNumTokens(), 1280);
 }
 
+TEST(SessionConfigTest, MaybeUpdateAndValidateBeamWidth) {
+  auto model_assets = ModelAssets::Create("test_model_path_1");
+  ASSERT_OK(model_assets);
+  auto settings = EngineSettings::CreateDefault(*model_assets);
+  EXPECT_OK(settings);
+  FakeTokenizer tokenizer;
+  proto::LlmMetadata llm_metadata = CreateLlmMetadata();
+  EXPECT_OK(settings->MaybeUpdateAndValidate(tokenizer, &llm_metadata));
+
+  auto session_config = SessionConfig::CreateDefault();
+  session_config.GetMutableBeamSearchParams().set_beam_width(2);
+  session_config.SetNumOutputCandidates(3);
+  EXPECT_THAT(session_config.MaybeUpdateAndValidate(*settings),
+              testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+
+  session_config.SetNumOutputCandidates(2);
+  EXPECT_OK(session_config.MaybeUpdateAndValidate(*settings));
+}
+
 TEST(SessionConfigTest, PrintOperator) {
   SessionConfig session_config = SessionConfig::CreateDefault();
   session_config.GetMutableSamplerParams().set_type(
@@ -316,5 +369,86 @@ TEST(SessionConfigTest, SetAndGetSamplerBackend) {
   EXPECT_EQ(session_config.GetSamplerBackend(), Backend::GPU);
 }
 
+TEST(SessionConfigTest, MaybeUpdateAndValidateLoRAName) {
+  auto model_assets = ModelAssets::Create("test_model_path_1");
+  ASSERT_OK(model_assets);
+  auto settings = EngineSettings::CreateDefault(*model_assets);
+  ASSERT_OK(settings);
+  FakeTokenizer tokenizer;
+  proto::LlmMetadata llm_metadata = CreateLlmMetadata();
+  EXPECT_OK(settings->MaybeUpdateAndValidate(tokenizer, &llm_metadata));
+  auto lora_assets = ModelAssets::Create("test_lora_path");
+  ASSERT_OK(lora_assets);
+  settings->AddLoRAAdapter("adapter", *lora_assets);
+  EXPECT_EQ(settings->GetLoRAAdapters().size(), 1);
+
+  auto session_config = SessionConfig::CreateDefault();
+  EXPECT_EQ(session_config.GetLoRAName(), std::nullopt);
+  session_config.SetLoRAName("unknown");
+  EXPECT_THAT(session_config.MaybeUpdateAndValidate(*settings),
+              testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+  session_config.SetLoRAName("adapter");
+  EXPECT_OK(session_config.MaybeUpdateAndValidate(*settings));
+  EXPECT_EQ(session_config.GetLoRAName(), "adapter");
+}
+
+TEST(SessionConfigTest, MaybeUpdateAndValidateMaxOutputTokens) {
+  auto model_assets = ModelAssets::Create("test_model_path_1");
+  ASSERT_OK(model_assets);
+  auto settings = EngineSettings::CreateDefault(*model_assets);
+  ASSERT_OK(settings);
+  FakeTokenizer tokenizer;
+  proto::LlmMetadata llm_metadata = CreateLlmMetadata();
+  EXPECT_OK(settings->MaybeUpdateAndValidate(tokenizer, &llm_metadata));
+
+  auto session_config = SessionConfig::CreateDefault();
+  EXPECT_EQ(session_config.GetMaxOutputTokens(), 0);
+  session_config.SetMaxOutputTokens(-1);
+  EXPECT_THAT(session_config.MaybeUpdateAndValidate(*settings),
+              testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+  session_config.SetMaxOutputTokens(16);
+  EXPECT_OK(session_config.MaybeUpdateAndValidate(*settings));
+  EXPECT_EQ(session_config.GetMaxOutputTokens(), 16);
+}
+
+TEST(SessionConfigTest, MaybeUpdateAndValidatePipelinedDecodeDepth) {
+  auto model_assets = ModelAssets::Create("test_model_path_1");
+  ASSERT_OK(model_assets);
+  auto settings = EngineSettings::CreateDefault(*model_assets);
+  ASSERT_OK(settings);
+  FakeTokenizer tokenizer;
+  proto::LlmMetadata llm_metadata = CreateLlmMetadata();
+  EXPECT_OK(settings->MaybeUpdateAndValidate(tokenizer, &llm_metadata));
+
+  auto session_config = SessionConfig::CreateDefault();
+  EXPECT_EQ(session_config.GetPipelinedDecodeDepth(), 0);
+  session_config.SetPipelinedDecodeDepth(-1);
+  EXPECT_THAT(session_config.MaybeUpdateAndValidate(*settings),
+              testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+  session_config.SetPipelinedDecodeDepth(2);
+  EXPECT_OK(session_config.MaybeUpdateAndValidate(*settings));
+  EXPECT_EQ(session_config.GetPipelinedDecodeDepth(), 2);
+}
+
+TEST(SessionConfigTest, MaybeUpdateAndValidateNumTopLogProbs) {
+  auto model_assets = ModelAssets::Create("test_model_path_1");
+  ASSERT_OK(model_assets);
+  auto settings = EngineSettings::CreateDefault(*model_assets, Backend::GPU);
+  ASSERT_OK(settings);
+  FakeTokenizer tokenizer;
+  proto::LlmMetadata llm_metadata = CreateLlmMetadata();
+  EXPECT_OK(settings->MaybeUpdateAndValidate(tokenizer, &llm_metadata));
+
+  auto session_config = SessionConfig::CreateDefault();
+  EXPECT_FALSE(session_config.GetNumTopLogProbs().has_value());
+  session_config.SetNumTopLogProbs(-1);
+  EXPECT_THAT(session_config.MaybeUpdateAndValidate(*settings),
+              testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+  session_config.SetNumTopLogProbs(5);
+  EXPECT_OK(session_config.MaybeUpdateAndValidate(*settings));
+  // The log probabilities are computed by the CPU sampler.
+  EXPECT_EQ(session_config.GetSamplerBackend(), Backend::CPU);
+}
+
 }  // namespace
 }  // namespace litert::lm
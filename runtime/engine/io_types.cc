@@ -1,5 +1,6 @@
 #include "runtime/engine/io_types.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
@@ -69,6 +70,28 @@ std::vector<float>& Responses::GetMutableScores() {
   return scores_;
 }
 
+absl::StatusOr<const std::vector<DecodedTokenLogProbs>*>
+Responses::GetTokenLogProbsAt(int index) const {
+  if (token_log_probs_.empty()) {
+    return absl::InvalidArgumentError("Token log probabilities are not set.");
+  }
+  if (index < 0 || index >= token_log_probs_.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Index ", index, " is out of range [0, ",
+                     token_log_probs_.size(), ")."));
+  }
+  return &token_log_probs_[index];
+}
+
+std::vector<std::vector<DecodedTokenLogProbs>>&
+Responses::GetMutableTokenLogProbs() {
+  if (token_log_probs_.empty()) {
+    token_log_probs_ =
+        std::vector<std::vector<DecodedTokenLogProbs>>(num_output_candidates_);
+  }
+  return token_log_probs_;
+}
+
 std::ostream& operator<<(std::ostream& os, const Responses& responses) {
   if (responses.GetNumOutputCandidates() == 0) {
     os << " No reponses." << std::endl;
@@ -126,6 +149,16 @@ absl::Status BenchmarkInfo::TimeInitPhaseEnd(const std::string& phase_name) {
   return absl::OkStatus();
 }
 
+absl::Status BenchmarkInfo::AddInitPhase(const std::string& phase_name,
+                                         absl::Duration duration) {
+  if (init_phases_.contains(phase_name)) {
+    return absl::InternalError(
+        absl::StrCat("Phase ", phase_name, " already recorded."));
+  }
+  init_phases_[phase_name] = duration;
+  return absl::OkStatus();
+}
+
 absl::Status BenchmarkInfo::TimeMarkDelta(const std::string& mark_name) {
   if (mark_time_map_.contains(mark_name)) {
     mark_durations_[mark_name] = absl::Now() - mark_time_map_[mark_name];
@@ -244,6 +277,13 @@ double BenchmarkInfo::GetDecodeTokensPerSec(int turn_index) const {
   return static_cast<double>(turn.num_tokens) / turn_seconds;
 }
 
+std::ostream& operator<<(std::ostream& os, const SessionPoolStats& stats) {
+  os << "SessionPoolStats: " << stats.num_hits << " hits, "
+     << stats.num_misses << " misses, " << stats.num_idle << " of "
+     << stats.max_num_idle << " idle." << std::endl;
+  return os;
+}
+
 std::ostream& operator<<(std::ostream& os, const BenchmarkTurnData& data) {
   os << "Processed " << data.num_tokens << " tokens in " << data.duration
      << " duration." << std::endl;
@@ -322,4 +362,14 @@ void InferenceObservable::OnError(const absl::Status& status) {
   LOG(ERROR) << "Inference Error: " << status.message() << std::endl;
 }
 
+absl::Status DecodeLimits::Check() const {
+  if (cancel != nullptr && cancel->load()) {
+    return absl::CancelledError("The decode is cancelled.");
+  }
+  if (absl::Now() >= deadline) {
+    return absl::DeadlineExceededError("The decode deadline is exceeded.");
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace litert::lm
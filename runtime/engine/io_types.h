@@ -15,6 +15,7 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_ENGINE_IO_TYPES_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_ENGINE_IO_TYPES_H_
 
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <optional>
@@ -27,6 +28,7 @@
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/components/embedding_pooling.h"
 #include "runtime/proto/engine.pb.h"
 
 namespace litert::lm {
@@ -50,6 +52,63 @@ using InputData = std::variant<InputText>;
 // is not an InputText.
 std::optional<std::string> ToString(const InputData& input_data);
 
+// A message of a multi-turn conversation, following the OpenAI chat
+// completions convention.
+struct Message {
+  // The author of the message: "system", "user" or "assistant".
+  std::string role;
+  // The text content of the message.
+  std::string content;
+};
+
+// A token and its log probability under the softmax of the whole vocabulary.
+struct TokenLogProb {
+  int token_id = 0;
+  // The text of the token.
+  std::string token;
+  float log_prob = 0.0f;
+};
+
+// The log probability of a decoded token, and the most likely tokens of its
+// decode step in decreasing order of probability.
+struct DecodedTokenLogProbs {
+  TokenLogProb token;
+  std::vector<TokenLogProb> top_tokens;
+};
+
+// The log-likelihood of a continuation of a prompt, e.g. to rank or classify
+// the continuations. The perplexity of the continuation is
+// exp(-total_log_prob / token_log_probs.size()).
+struct ContinuationScore {
+  // The log probability of each token of the continuation given the prompt
+  // and the tokens before it.
+  std::vector<TokenLogProb> token_log_probs;
+  // The sum of the token log probabilities.
+  float total_log_prob = 0.0f;
+};
+
+// The options of the text embeddings, see Engine::Embed.
+struct EmbeddingOptions {
+  // How the hidden states of the tokens of a text are reduced to its
+  // embedding, e.g. kLastToken for the decoder-only embedding models.
+  EmbeddingPooling pooling = EmbeddingPooling::kMean;
+  // Whether the embeddings are scaled to a unit L2 norm.
+  bool normalize = true;
+};
+
+// The statistics of the pool of warm session resources of an engine, see
+// EngineSettings::SetSessionPoolSize.
+struct SessionPoolStats {
+  // The number of sessions created with resources taken from the pool.
+  int num_hits = 0;
+  // The number of sessions created with new resources.
+  int num_misses = 0;
+  // The number of resources waiting in the pool, and the most it keeps.
+  int num_idle = 0;
+  int max_num_idle = 0;
+};
+std::ostream& operator<<(std::ostream& os, const SessionPoolStats& stats);
+
 // A container to host the model responses.
 class Responses {
  public:
@@ -77,6 +136,28 @@ class Responses {
   // (= log(0.0f)).
   std::vector<float>& GetMutableScores();
 
+  // Returns the log probabilities of the decoded tokens of the response at the
+  // given index. Returns error if the index is out of range or if the log
+  // probabilities are not included (see SessionConfig::SetNumTopLogProbs).
+  // When streaming, each Responses holds the tokens decoded since the last
+  // one.
+  absl::StatusOr<const std::vector<DecodedTokenLogProbs>*> GetTokenLogProbsAt(
+      int index) const;
+
+  // Returns the mutable log probabilities vector. If it is the first time
+  // calling this function, the vector will be allocated to the size of
+  // num_output_candidates_, with no tokens.
+  std::vector<std::vector<DecodedTokenLogProbs>>& GetMutableTokenLogProbs();
+
+  // Returns true if the decoding stopped because it reached the max number of
+  // output tokens (see SessionConfig::SetMaxOutputTokens) rather than on the
+  // stop tokens, i.e. the response texts are truncated. When streaming, only
+  // the last Responses is marked.
+  bool IsTruncated() const { return truncated_; }
+
+  // Sets whether the response texts are truncated.
+  void SetTruncated(bool truncated) { truncated_ = truncated; }
+
  private:
   // The number of output candidates.
   int num_output_candidates_;
@@ -87,6 +168,13 @@ class Responses {
   // The output vector of scores for each response text. The "score" is pulled
   // from the probability of the last token in the response text.
   std::vector<float> scores_;
+
+  // The log probabilities of the decoded tokens of each response text, if
+  // requested.
+  std::vector<std::vector<DecodedTokenLogProbs>> token_log_probs_;
+
+  // Whether the decoding stopped on the max number of output tokens.
+  bool truncated_ = false;
 };
 std::ostream& operator<<(std::ostream& os, const Responses& responses);
 
@@ -112,6 +200,11 @@ class BenchmarkInfo {
   // methods will return an error.
   absl::Status TimeInitPhaseStart(const std::string& phase_name);
   absl::Status TimeInitPhaseEnd(const std::string& phase_name);
+  // Records a phase of the initialization whose duration is measured or
+  // derived by the caller, e.g. the time saved by a cache. The method will
+  // return an error if the phase has already been recorded.
+  absl::Status AddInitPhase(const std::string& phase_name,
+                            absl::Duration duration);
   // Time the start and end of a prefill/decode turn. The num_prefill_tokens
   // should be the number of tokens processed in this turn. The method will
   // return an error if the methods are called out of order (i.e. one end after
@@ -179,6 +272,22 @@ class InferenceObservable {
   virtual void OnError(const absl::Status& status);
 };
 
+// The limits of a decode, checked before each decode step. A decode stopped by
+// `cancel` or `deadline` fails, while a decode stopped by `max_num_steps`
+// succeeds with what was decoded so far. Either way the KV cache keeps the
+// decoded tokens, so that the session can go on.
+struct DecodeLimits {
+  // Fails the decode with a CancelledError once true.
+  const std::atomic_bool* cancel = nullptr;
+  // Fails the decode with a DeadlineExceededError once passed.
+  absl::Time deadline = absl::InfiniteFuture();
+  // The maximum number of decode steps, or 0 for no limit.
+  int max_num_steps = 0;
+
+  // Returns the error the decode should fail with, if any.
+  absl::Status Check() const;
+};
+
 }  // namespace litert::lm
 
 #endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_ENGINE_IO_TYPES_H_
@@ -69,6 +69,24 @@ TEST(ResponsesTest, HasScores) {
   responses.GetMutableScores()[1] = 0.2;
 }
 
+TEST(ResponsesTest, GetTokenLogProbsAt) {
+  Responses responses(/*num_output_candidates=*/2);
+  EXPECT_THAT(responses.GetTokenLogProbsAt(0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  responses.GetMutableTokenLogProbs()[1].push_back(
+      {.token = {.token_id = 3, .token = "Hi", .log_prob = -0.5f},
+       .top_tokens = {{.token_id = 3, .token = "Hi", .log_prob = -0.5f}}});
+  ASSERT_OK_AND_ASSIGN(const std::vector<DecodedTokenLogProbs>* log_probs,
+                       responses.GetTokenLogProbsAt(1));
+  ASSERT_EQ(log_probs->size(), 1);
+  EXPECT_EQ((*log_probs)[0].token.token, "Hi");
+  EXPECT_EQ((*log_probs)[0].top_tokens.size(), 1);
+  ASSERT_OK_AND_ASSIGN(log_probs, responses.GetTokenLogProbsAt(0));
+  EXPECT_TRUE(log_probs->empty());
+  EXPECT_THAT(responses.GetTokenLogProbsAt(2),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(ResponsesTest, GetMutableResponseTexts) {
   Responses responses(/*num_output_candidates=*/2);
   responses.GetMutableResponseTexts()[0] = "Hello World!";
@@ -154,6 +172,16 @@ TEST(BenchmarkInfoTests, AddInitPhaseTwice) {
               StatusIs(absl::StatusCode::kInternal));
 }
 
+TEST(BenchmarkInfoTests, AddInitPhaseWithDuration) {
+  BenchmarkInfo benchmark_info(GetBenchmarkParams());
+  EXPECT_OK(benchmark_info.AddInitPhase("Cache hit", absl::Milliseconds(20)));
+  EXPECT_EQ(benchmark_info.GetInitPhases().at("Cache hit"),
+            absl::Milliseconds(20));
+  // Recording the same phase twice should fail.
+  EXPECT_THAT(benchmark_info.AddInitPhase("Cache hit", absl::Milliseconds(5)),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
 TEST(BenchmarkInfoTests, AddPrefillTurn) {
   BenchmarkInfo benchmark_info(GetBenchmarkParams());
   EXPECT_OK(benchmark_info.TimePrefillTurnStart());
@@ -21,6 +21,7 @@
 //
 // Consider run_llm_inference_engine.sh as an example to run on android device.
 
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <string>
@@ -65,6 +66,13 @@ ABSL_FLAG(int, benchmark_decode_tokens, 0,
 ABSL_FLAG(bool, async, true, "Run the LLM execution asynchronously.");
 ABSL_FLAG(bool, report_peak_memory_footprint, false,
           "Report peak memory footprint.");
+ABSL_FLAG(int, memory_budget_mb, 0,
+          "The memory the engine and its sessions may use on top of the model "
+          "weights, in MB, or 0 for no budget.");
+ABSL_FLAG(std::string, verify_sections, "none",
+          "How to verify the sections of a .litertlm model against their "
+          "checksums: none, eager (all of them at load time) or lazy (each of "
+          "them on first access).");
 
 namespace {
 
@@ -115,7 +123,9 @@ absl::Status MainHelper(int argc, char** argv) {
            "[--benchmark] [--benchmark_prefill_tokens=<num_prefill_tokens>] "
            "[--benchmark_decode_tokens=<num_decode_tokens>] "
            "[--async=<true|false>] "
-           "[--report_peak_memory_footprint]";
+           "[--report_peak_memory_footprint] "
+           "[--memory_budget_mb=<memory_budget_mb>] "
+           "[--verify_sections=<none|eager|lazy>]";
     return absl::InvalidArgumentError("No arguments provided.");
   }
 
@@ -133,6 +143,10 @@ absl::Status MainHelper(int argc, char** argv) {
   ABSL_LOG(INFO) << "Model path: " << model_path;
   ASSIGN_OR_RETURN(ModelAssets model_assets,  // NOLINT
                    ModelAssets::Create(model_path));
+  ASSIGN_OR_RETURN(auto verification_mode,
+                   litert::lm::GetSectionVerificationModeFromString(
+                       absl::GetFlag(FLAGS_verify_sections)));
+  model_assets.SetSectionVerificationMode(verification_mode);
   std::string backend_str = absl::GetFlag(FLAGS_backend).value();
   ABSL_LOG(INFO) << "Choose backend: " << backend_str;
   ASSIGN_OR_RETURN(Backend backend,
@@ -152,6 +166,8 @@ absl::Status MainHelper(int argc, char** argv) {
         absl::GetFlag(FLAGS_benchmark_decode_tokens));
     engine_settings.GetMutableBenchmarkParams() = benchmark_params;
   }
+  engine_settings.SetMemoryBudgetBytes(
+      static_cast<size_t>(absl::GetFlag(FLAGS_memory_budget_mb)) << 20);
   ABSL_LOG(INFO) << "Creating engine";
   absl::StatusOr<std::unique_ptr<litert::lm::Engine>> llm =
       litert::lm::Engine::CreateEngine(std::move(engine_settings));
@@ -191,6 +207,10 @@ absl::Status MainHelper(int argc, char** argv) {
   if (absl::GetFlag(FLAGS_benchmark)) {
     auto benchmark_info = (*session)->GetBenchmarkInfo();
     ABSL_LOG(INFO) << *benchmark_info;
+    auto session_pool_stats = (*llm)->GetSessionPoolStats();
+    if (session_pool_stats.ok()) {
+      ABSL_LOG(INFO) << *session_pool_stats;
+    }
   }
 
   if (absl::GetFlag(FLAGS_report_peak_memory_footprint)) {
@@ -200,6 +220,10 @@ absl::Status MainHelper(int argc, char** argv) {
       peak_mem_mb = mem_monitor->GetPeakMemUsageInMB();
     }
     ABSL_LOG(INFO) << "Peak system ram usage: " << peak_mem_mb << "MB.";
+    auto memory_usage = (*llm)->GetMemoryUsage();
+    if (memory_usage.ok()) {
+      ABSL_LOG(INFO) << *memory_usage;
+    }
   }
   return absl::OkStatus();
 }
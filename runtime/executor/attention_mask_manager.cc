@@ -0,0 +1,162 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/executor/attention_mask_manager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "absl/functional/function_ref.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+namespace {
+
+// Default value reference:
+// third_party/odml/infra/genai/inference/ml_drift/llm/tasks/apply_attention_mask_test_util.cc
+float GetMaskedValue(bool is_f16) {
+  return is_f16 ? -45824 : -0.7f * std::numeric_limits<float>::max();
+}
+
+}  // namespace
+
+AttentionMaskManager::AttentionMaskManager(AttentionMaskDataType mask_data_type,
+                                           bool is_f16, int num_rows,
+                                           int num_columns)
+    : mask_data_type_(mask_data_type),
+      masked_value_(GetMaskedValue(is_f16)),
+      num_rows_(num_rows),
+      num_columns_(num_columns),
+      row_ranges_(num_rows) {}
+
+absl::Status AttentionMaskManager::UpdateCausal(void* mask, int start_timestep,
+                                                int steps, int window_size) {
+  if (start_timestep < 0 || steps < 0 || steps > num_rows_ ||
+      start_timestep + steps > num_columns_) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Cannot mask ", steps, " steps from timestep ", start_timestep,
+        " with a mask of ", num_rows_, " rows and ", num_columns_,
+        " columns."));
+  }
+  if (window_size < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid sliding window size: ", window_size));
+  }
+  return Update(mask, [&](int row) {
+    if (row >= steps) {
+      return ColumnRange();
+    }
+    // For current step = n, the mask sequence attends to (n+1) positions.
+    const int end = start_timestep + row + 1;
+    return ColumnRange{window_size > 0 ? std::max(0, end - window_size) : 0,
+                       end};
+  });
+}
+
+absl::Status AttentionMaskManager::UpdatePacked(
+    void* mask, int start_timestep,
+    absl::Span<const int> sequence_start_timesteps) {
+  const int steps = sequence_start_timesteps.size();
+  if (start_timestep < 0 || steps > num_rows_ ||
+      start_timestep + steps > num_columns_) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Cannot mask ", steps, " steps from timestep ", start_timestep,
+        " with a mask of ", num_rows_, " rows and ", num_columns_,
+        " columns."));
+  }
+  for (int i = 0; i < steps; ++i) {
+    if (sequence_start_timesteps[i] < 0 ||
+        sequence_start_timesteps[i] > start_timestep + i) {
+      return absl::InvalidArgumentError(
+          "The sequence of a timestep must start at or before it.");
+    }
+  }
+  return Update(mask, [&](int row) {
+    if (row >= steps) {
+      return ColumnRange();
+    }
+    return ColumnRange{sequence_start_timesteps[row],
+                       start_timestep + row + 1};
+  });
+}
+
+absl::Status AttentionMaskManager::Update(
+    void* mask, absl::FunctionRef<ColumnRange(int row)> row_range) {
+  if (mask == nullptr) {
+    return absl::InvalidArgumentError("The attention mask buffer is null.");
+  }
+  if (!initialized_) {
+    // Nothing is known about the buffer: mask everything, then attend to the
+    // full range of each row below.
+    for (int row = 0; row < num_rows_; ++row) {
+      Fill(mask, row, 0, num_columns_, /*attended=*/false);
+      row_ranges_[row] = ColumnRange();
+    }
+    initialized_ = true;
+  }
+  for (int row = 0; row < num_rows_; ++row) {
+    const ColumnRange old_range = row_ranges_[row];
+    const ColumnRange new_range = row_range(row);
+    const bool old_empty = old_range.begin >= old_range.end;
+    const bool new_empty = new_range.begin >= new_range.end;
+    if (old_empty || new_empty || old_range.end <= new_range.begin ||
+        new_range.end <= old_range.begin) {
+      // Disjoint ranges: nothing is shared.
+      Fill(mask, row, old_range.begin, old_range.end, /*attended=*/false);
+      Fill(mask, row, new_range.begin, new_range.end, /*attended=*/true);
+    } else {
+      // Overlapping ranges: only the ends move.
+      if (old_range.begin < new_range.begin) {
+        Fill(mask, row, old_range.begin, new_range.begin, /*attended=*/false);
+      } else {
+        Fill(mask, row, new_range.begin, old_range.begin, /*attended=*/true);
+      }
+      if (new_range.end < old_range.end) {
+        Fill(mask, row, new_range.end, old_range.end, /*attended=*/false);
+      } else {
+        Fill(mask, row, old_range.end, new_range.end, /*attended=*/true);
+      }
+    }
+    row_ranges_[row] = new_empty ? ColumnRange() : new_range;
+  }
+  return absl::OkStatus();
+}
+
+void AttentionMaskManager::Fill(void* mask, int row, int begin, int end,
+                                bool attended) const {
+  if (begin >= end) {
+    return;
+  }
+  const int offset = row * num_columns_ + begin;
+  const int size = end - begin;
+  // The fills of contiguous ranges are vectorized by memset/std::fill_n.
+  switch (mask_data_type_) {
+    case AttentionMaskDataType::BOOLEAN:
+      memset(static_cast<bool*>(mask) + offset, attended ? 1 : 0, size);
+      break;
+    case AttentionMaskDataType::FLOAT:
+      if (attended) {
+        // 0.0f is all zero bits.
+        memset(static_cast<float*>(mask) + offset, 0, size * sizeof(float));
+      } else {
+        std::fill_n(static_cast<float*>(mask) + offset, size, masked_value_);
+      }
+      break;
+  }
+}
+
+}  // namespace litert::lm
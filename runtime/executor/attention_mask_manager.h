@@ -0,0 +1,99 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_ATTENTION_MASK_MANAGER_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_ATTENTION_MASK_MANAGER_H_
+
+#include <vector>
+
+#include "absl/functional/function_ref.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// The data type of the attention mask.
+// BOOLEAN: The attention mask is a boolean tensor.
+// FLOAT: The attention mask is a float tensor.
+enum class AttentionMaskDataType { BOOLEAN, FLOAT };
+
+// Keeps an attention mask buffer up to date across the prefill/decode calls
+// by only writing the entries whose value changes, instead of rewriting the
+// whole [seq_len, max_kv_len] buffer on every call. E.g. a decode step only
+// unmasks the KV cache entry of its own timestep, so it costs O(1) rather than
+// O(max_kv_len).
+//
+// The mask is a tensor with shape [batch=1, seq_len, 1, max_kv_len], seen as
+// `num_rows` rows of `num_columns` entries. Each row attends to a contiguous
+// range of columns (the timesteps in the KV cache), the other columns are
+// masked. The manager remembers the range of each row, so the buffer must
+// only be written through it, and must keep its content between two updates
+// (see Invalidate otherwise).
+class AttentionMaskManager {
+ public:
+  // `is_f16` selects the masked value of the float masks which is safe for
+  // the f16 calculation precision.
+  AttentionMaskManager(AttentionMaskDataType mask_data_type, bool is_f16,
+                       int num_rows, int num_columns);
+
+  // Updates `mask` to the causal mask of `steps` timesteps from
+  // `start_timestep`, i.e. row i attends to the timesteps up to
+  // start_timestep + i, or only to the last `window_size` of them if
+  // `window_size` is positive (sliding window attention). The rows from
+  // `steps` on are fully masked.
+  absl::Status UpdateCausal(void* mask, int start_timestep, int steps,
+                            int window_size = 0);
+
+  // Updates `mask` to the causal mask of timesteps from `start_timestep` of
+  // independent sequences packed together, i.e. row i attends to the
+  // timesteps from sequence_start_timesteps[i] (the first timestep of its
+  // sequence) up to start_timestep + i. The rows from
+  // sequence_start_timesteps.size() on are fully masked.
+  absl::Status UpdatePacked(void* mask, int start_timestep,
+                            absl::Span<const int> sequence_start_timesteps);
+
+  // Forgets the content of the mask buffer, so that the next update rewrites
+  // it in full, e.g. when the buffer is not kept between two updates.
+  void Invalidate() { initialized_ = false; }
+
+  int num_rows() const { return num_rows_; }
+  int num_columns() const { return num_columns_; }
+
+ private:
+  // The range [begin, end) of columns a row attends to.
+  struct ColumnRange {
+    int begin = 0;
+    int end = 0;
+  };
+
+  // Updates the rows of `mask` to the ranges returned by `row_range`, by
+  // writing only the columns entering or leaving the range of each row.
+  absl::Status Update(void* mask,
+                      absl::FunctionRef<ColumnRange(int row)> row_range);
+
+  // Sets the columns [begin, end) of `row` to the masked or attended value.
+  void Fill(void* mask, int row, int begin, int end, bool attended) const;
+
+  const AttentionMaskDataType mask_data_type_;
+  const float masked_value_;
+  const int num_rows_;
+  const int num_columns_;
+  // Whether `row_ranges_` is the content of the mask buffer.
+  bool initialized_ = false;
+  std::vector<ColumnRange> row_ranges_;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_ATTENTION_MASK_MANAGER_H_
@@ -0,0 +1,99 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This tool measures the cost of the attention mask updates of the prefill
+// and decode calls filling a context, when the whole mask is rewritten on
+// every call versus when only the changed entries are written.
+//
+// Example usage:
+// bazel run -c opt :attention_mask_manager_benchmark -- --context_size=4096
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "absl/flags/flag.h"  // from @com_google_absl
+#include "absl/flags/parse.h"  // from @com_google_absl
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/executor/attention_mask_manager.h"
+
+ABSL_FLAG(int, context_size, 4096,
+          "The maximum KV cache length, i.e. the columns of the mask.");
+
+ABSL_FLAG(int, prefill_length, 128,
+          "The length of the prefill signature, i.e. the rows of its mask.");
+
+ABSL_FLAG(int, iterations, 5, "The number of context fills to average.");
+
+namespace {
+
+using ::litert::lm::AttentionMaskDataType;
+using ::litert::lm::AttentionMaskManager;
+
+// Returns the average time of a mask update of the calls filling the
+// context with `num_rows` timesteps per call. If `rewrite` is true, the whole
+// mask is rewritten on every call, like without the manager.
+absl::Duration TimeContextFill(AttentionMaskDataType mask_data_type,
+                               int num_rows, int context_size, bool rewrite,
+                               int iterations) {
+  const int element_size =
+      mask_data_type == AttentionMaskDataType::BOOLEAN ? 1 : sizeof(float);
+  std::vector<uint8_t> mask(num_rows * context_size * element_size);
+  AttentionMaskManager manager(mask_data_type, /*is_f16=*/true, num_rows,
+                               context_size);
+  int num_calls = 0;
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    for (int step = 0; step + num_rows <= context_size; step += num_rows) {
+      if (rewrite) {
+        manager.Invalidate();
+      }
+      ABSL_CHECK_OK(manager.UpdateCausal(mask.data(), step, num_rows));
+      ++num_calls;
+    }
+  }
+  return (absl::Now() - start) / num_calls;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const int context_size = absl::GetFlag(FLAGS_context_size);
+  const int prefill_length = absl::GetFlag(FLAGS_prefill_length);
+  const int iterations = absl::GetFlag(FLAGS_iterations);
+
+  std::cout << absl::StrFormat("%8s %8s %14s %14s %8s\n", "type", "rows",
+                               "rewrite us", "delta us", "speedup");
+  for (AttentionMaskDataType mask_data_type :
+       {AttentionMaskDataType::BOOLEAN, AttentionMaskDataType::FLOAT}) {
+    // One row for the decode, `prefill_length` rows for the prefill.
+    for (int num_rows : {1, prefill_length}) {
+      const absl::Duration rewrite = TimeContextFill(
+          mask_data_type, num_rows, context_size, /*rewrite=*/true, iterations);
+      const absl::Duration delta =
+          TimeContextFill(mask_data_type, num_rows, context_size,
+                          /*rewrite=*/false, iterations);
+      std::cout << absl::StrFormat(
+          "%8s %8d %14.3f %14.3f %7.1fx\n",
+          mask_data_type == AttentionMaskDataType::BOOLEAN ? "bool" : "float",
+          num_rows, absl::ToDoubleMicroseconds(rewrite),
+          absl::ToDoubleMicroseconds(delta), rewrite / delta);
+    }
+  }
+  return 0;
+}
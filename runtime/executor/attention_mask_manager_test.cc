@@ -0,0 +1,157 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/executor/attention_mask_manager.h"
+
+#include <limits>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr float kMaskedF16 = -45824;
+
+TEST(AttentionMaskManagerTest, UpdateCausalBoolean) {
+  AttentionMaskManager manager(AttentionMaskDataType::BOOLEAN,
+                               /*is_f16=*/true, /*num_rows=*/2,
+                               /*num_columns=*/4);
+  // Garbage which the first update must overwrite.
+  std::vector<char> mask(8, 1);
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/1,
+                                 /*steps=*/1));
+  EXPECT_THAT(mask, ElementsAre(1, 1, 0, 0, 0, 0, 0, 0));
+
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/1,
+                                 /*steps=*/2));
+  EXPECT_THAT(mask, ElementsAre(1, 1, 0, 0, 1, 1, 1, 0));
+}
+
+TEST(AttentionMaskManagerTest, UpdateCausalFloat) {
+  AttentionMaskManager manager(AttentionMaskDataType::FLOAT, /*is_f16=*/true,
+                               /*num_rows=*/1, /*num_columns=*/4);
+  std::vector<float> mask(4, 1.0f);
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/0,
+                                 /*steps=*/1));
+  EXPECT_THAT(mask, ElementsAre(0.0f, kMaskedF16, kMaskedF16, kMaskedF16));
+
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/2,
+                                 /*steps=*/1));
+  EXPECT_THAT(mask, ElementsAre(0.0f, 0.0f, 0.0f, kMaskedF16));
+}
+
+TEST(AttentionMaskManagerTest, UpdateCausalFloatF32MaskedValue) {
+  AttentionMaskManager manager(AttentionMaskDataType::FLOAT, /*is_f16=*/false,
+                               /*num_rows=*/1, /*num_columns=*/2);
+  std::vector<float> mask(2);
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/0,
+                                 /*steps=*/1));
+  EXPECT_THAT(mask,
+              ElementsAre(0.0f, -0.7f * std::numeric_limits<float>::max()));
+}
+
+TEST(AttentionMaskManagerTest, UpdateCausalRewindMasksDroppedTimesteps) {
+  AttentionMaskManager manager(AttentionMaskDataType::BOOLEAN,
+                               /*is_f16=*/true, /*num_rows=*/1,
+                               /*num_columns=*/6);
+  std::vector<char> mask(6);
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/4,
+                                 /*steps=*/1));
+  EXPECT_THAT(mask, ElementsAre(1, 1, 1, 1, 1, 0));
+
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/1,
+                                 /*steps=*/1));
+  EXPECT_THAT(mask, ElementsAre(1, 1, 0, 0, 0, 0));
+}
+
+TEST(AttentionMaskManagerTest, UpdateCausalSlidingWindow) {
+  AttentionMaskManager manager(AttentionMaskDataType::BOOLEAN,
+                               /*is_f16=*/true, /*num_rows=*/2,
+                               /*num_columns=*/6);
+  std::vector<char> mask(12);
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/2,
+                                 /*steps=*/2, /*window_size=*/2));
+  EXPECT_THAT(mask, ElementsAre(0, 1, 1, 0, 0, 0,  //
+                                0, 0, 1, 1, 0, 0));
+
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/4,
+                                 /*steps=*/1, /*window_size=*/2));
+  EXPECT_THAT(mask, ElementsAre(0, 0, 0, 1, 1, 0,  //
+                                0, 0, 0, 0, 0, 0));
+}
+
+TEST(AttentionMaskManagerTest, UpdatePacked) {
+  AttentionMaskManager manager(AttentionMaskDataType::BOOLEAN,
+                               /*is_f16=*/true, /*num_rows=*/4,
+                               /*num_columns=*/6);
+  std::vector<char> mask(24);
+  // Two sequences of 2 tokens from timestep 1, then the causal mask again.
+  ASSERT_OK(manager.UpdatePacked(mask.data(), /*start_timestep=*/1,
+                                 /*sequence_start_timesteps=*/{1, 1, 3}));
+  EXPECT_THAT(mask, ElementsAre(0, 1, 0, 0, 0, 0,  //
+                                0, 1, 1, 0, 0, 0,  //
+                                0, 0, 0, 1, 0, 0,  //
+                                0, 0, 0, 0, 0, 0));
+
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/1,
+                                 /*steps=*/4));
+  EXPECT_THAT(mask, ElementsAre(1, 1, 0, 0, 0, 0,  //
+                                1, 1, 1, 0, 0, 0,  //
+                                1, 1, 1, 1, 0, 0,  //
+                                1, 1, 1, 1, 1, 0));
+}
+
+TEST(AttentionMaskManagerTest, InvalidateRewritesTheWholeMask) {
+  AttentionMaskManager manager(AttentionMaskDataType::BOOLEAN,
+                               /*is_f16=*/true, /*num_rows=*/1,
+                               /*num_columns=*/4);
+  std::vector<char> mask(4);
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/0,
+                                 /*steps=*/1));
+  // The buffer content is lost, e.g. reallocated.
+  mask.assign(4, 1);
+  manager.Invalidate();
+  ASSERT_OK(manager.UpdateCausal(mask.data(), /*start_timestep=*/1,
+                                 /*steps=*/1));
+  EXPECT_THAT(mask, ElementsAre(1, 1, 0, 0));
+}
+
+TEST(AttentionMaskManagerTest, InvalidArguments) {
+  AttentionMaskManager manager(AttentionMaskDataType::BOOLEAN,
+                               /*is_f16=*/true, /*num_rows=*/2,
+                               /*num_columns=*/4);
+  std::vector<char> mask(8);
+  EXPECT_EQ(manager
+                .UpdateCausal(mask.data(), /*start_timestep=*/0, /*steps=*/3)
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(manager
+                .UpdateCausal(mask.data(), /*start_timestep=*/3, /*steps=*/2)
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(manager
+                .UpdatePacked(mask.data(), /*start_timestep=*/1,
+                              /*sequence_start_timesteps=*/{2})
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace litert::lm
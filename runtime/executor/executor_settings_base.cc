@@ -101,6 +101,33 @@ std::ostream& operator<<(std::ostream& os,
   }
 }
 
+std::ostream& operator<<(std::ostream& os,
+                         const SectionVerificationMode& verification_mode) {
+  switch (verification_mode) {
+    case SectionVerificationMode::SECTION_VERIFICATION_NONE:
+      return os << "SECTION_VERIFICATION_NONE";
+    case SectionVerificationMode::SECTION_VERIFICATION_EAGER:
+      return os << "SECTION_VERIFICATION_EAGER";
+    case SectionVerificationMode::SECTION_VERIFICATION_LAZY:
+      return os << "SECTION_VERIFICATION_LAZY";
+    default:
+      return os << "SECTION_VERIFICATION_NONE";
+  }
+}
+
+absl::StatusOr<SectionVerificationMode> GetSectionVerificationModeFromString(
+    absl::string_view verification_mode_str) {
+  if (absl::EqualsIgnoreCase(verification_mode_str, "none")) {
+    return SectionVerificationMode::SECTION_VERIFICATION_NONE;
+  } else if (absl::EqualsIgnoreCase(verification_mode_str, "eager")) {
+    return SectionVerificationMode::SECTION_VERIFICATION_EAGER;
+  } else if (absl::EqualsIgnoreCase(verification_mode_str, "lazy")) {
+    return SectionVerificationMode::SECTION_VERIFICATION_LAZY;
+  }
+  return absl::InvalidArgumentError(absl::StrCat(
+      "Unsupported section verification mode: ", verification_mode_str));
+}
+
 std::ostream& operator<<(std::ostream& os, const FileFormat& file_format) {
   switch (file_format) {
     case FileFormat::TFLITE:
@@ -174,6 +201,8 @@ std::ostream& operator<<(std::ostream& os, const ModelAssets& model_assets) {
     os << "model_path: " << model_assets.GetPath().value() << "\n";
   }
   os << "fake_weights_mode: " << model_assets.fake_weights_mode() << "\n";
+  os << "section_verification_mode: "
+     << model_assets.section_verification_mode() << "\n";
   return os;
 }
 
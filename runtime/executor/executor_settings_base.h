@@ -82,6 +82,26 @@ enum class FakeWeightsMode {
 std::ostream& operator<<(std::ostream& os,
                          const FakeWeightsMode& fake_weights_mode);
 
+// How the sections of a .litertlm model are verified against the checksums
+// recorded in its header. The sections without checksum are never verified.
+enum class SectionVerificationMode {
+  // Don't verify the sections.
+  SECTION_VERIFICATION_NONE,
+
+  // Verify all the sections when the model is loaded, in parallel.
+  SECTION_VERIFICATION_EAGER,
+
+  // Verify each section the first time it is accessed, so that the unused
+  // sections are never read. The compressed sections are verified when they
+  // are decompressed, at load time.
+  SECTION_VERIFICATION_LAZY,
+};
+std::ostream& operator<<(std::ostream& os,
+                         const SectionVerificationMode& verification_mode);
+// Returns the section verification mode from the string: none, eager or lazy.
+absl::StatusOr<SectionVerificationMode> GetSectionVerificationModeFromString(
+    absl::string_view verification_mode_str);
+
 enum class FileFormat {
   // .tflite file format.
   TFLITE,
@@ -126,6 +146,15 @@ class ModelAssets {
     fake_weights_mode_ = fake_weights_mode;
   }
 
+  SectionVerificationMode section_verification_mode() const {
+    return section_verification_mode_;
+  }
+
+  void SetSectionVerificationMode(
+      SectionVerificationMode section_verification_mode) {
+    section_verification_mode_ = section_verification_mode;
+  }
+
  private:
   explicit ModelAssets(std::shared_ptr<ScopedFile> model_file);
   explicit ModelAssets(absl::string_view model_path);
@@ -136,6 +165,9 @@ class ModelAssets {
       path_or_scoped_file_;
 
   FakeWeightsMode fake_weights_mode_ = FakeWeightsMode::FAKE_WEIGHTS_NONE;
+
+  SectionVerificationMode section_verification_mode_ =
+      SectionVerificationMode::SECTION_VERIFICATION_NONE;
 };
 std::ostream& operator<<(std::ostream& os, const ModelAssets& model_assets);
 
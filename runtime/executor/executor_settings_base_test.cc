@@ -19,11 +19,15 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
 #include "runtime/util/test_utils.h"  // NOLINT
 
 namespace litert::lm {
 namespace {
 
+using ::testing::status::IsOkAndHolds;
+using ::testing::status::StatusIs;
+
 TEST(LlmExecutorConfigTest, Backend) {
   Backend backend;
   std::stringstream oss;
@@ -103,6 +107,32 @@ TEST(LlmExecutorConfigTest, FakeWeightsMode) {
   EXPECT_EQ(oss.str(), "FAKE_WEIGHTS_ATTN_8_FFN_4_EMB_4");
 }
 
+TEST(LlmExecutorConfigTest, SectionVerificationMode) {
+  std::stringstream oss;
+  oss << SectionVerificationMode::SECTION_VERIFICATION_NONE;
+  EXPECT_EQ(oss.str(), "SECTION_VERIFICATION_NONE");
+
+  oss.str("");
+  oss << SectionVerificationMode::SECTION_VERIFICATION_EAGER;
+  EXPECT_EQ(oss.str(), "SECTION_VERIFICATION_EAGER");
+
+  oss.str("");
+  oss << SectionVerificationMode::SECTION_VERIFICATION_LAZY;
+  EXPECT_EQ(oss.str(), "SECTION_VERIFICATION_LAZY");
+}
+
+TEST(LlmExecutorConfigTest, StringToSectionVerificationMode) {
+  EXPECT_THAT(GetSectionVerificationModeFromString("none"),
+              IsOkAndHolds(SectionVerificationMode::SECTION_VERIFICATION_NONE));
+  EXPECT_THAT(
+      GetSectionVerificationModeFromString("eager"),
+      IsOkAndHolds(SectionVerificationMode::SECTION_VERIFICATION_EAGER));
+  EXPECT_THAT(GetSectionVerificationModeFromString("lazy"),
+              IsOkAndHolds(SectionVerificationMode::SECTION_VERIFICATION_LAZY));
+  EXPECT_THAT(GetSectionVerificationModeFromString("sometimes"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(LlmExecutorConfigTest, FileFormat) {
   std::stringstream oss;
 
@@ -126,6 +156,7 @@ TEST(LlmExecutorConfigTest, ModelAssets) {
   oss << *model_assets;
   const std::string expected_output = R"(model_path: /path/to/model1
 fake_weights_mode: FAKE_WEIGHTS_NONE
+section_verification_mode: SECTION_VERIFICATION_NONE
 )";
   EXPECT_EQ(oss.str(), expected_output);
 }
@@ -1,9 +1,11 @@
 #include "runtime/executor/fake_llm_executor.h"
 
+#include <atomic>
 #include <limits>
 #include <utility>
 #include <vector>
 
+#include "absl/functional/function_ref.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
@@ -94,6 +96,10 @@ absl::Status FakeLlmExecutor::Prefill(const ExecutorInputs& inputs) {
 
 absl::Status FakeLlmExecutor::Prefill(
     const ExecutorInputs& inputs, const ExecutorPrefillParams& prefill_params) {
+  if (prefill_params.GetCancelFlag() != nullptr &&
+      prefill_params.GetCancelFlag()->load(std::memory_order_relaxed)) {
+    return absl::CancelledError("The prefill is cancelled.");
+  }
   if (prefill_params.GetWaitForCompletion()) {
     // Sleep some time here to simulate a synchronous prefill.
     // We can time the function time in test to make sure the code calls prefill
@@ -166,4 +172,87 @@ absl::StatusOr<::litert::TensorBuffer> FakeLlmExecutor::DecodeLogits(
   return std::move(output_logits);
 }
 
+absl::StatusOr<::litert::TensorBuffer> FakeLlmExecutor::PrefillLogits(
+    const ExecutorInputs& inputs) {
+  if (!prefill_logits_enabled_) {
+    return absl::UnimplementedError(
+        "Prefill for logits output is disabled in the fake executor.");
+  }
+  if (batch_size_ != 1) {
+    return absl::InvalidArgumentError(
+        "Prefill for logits output only supports batch size 1.");
+  }
+  auto input_span =
+      ReferTensorBufferAsSpan<int>(*(*inputs.GetTextTokenIdsPtr()));
+  const int num_tokens = input_span->size();
+  if (decode_times_ + num_tokens > decode_tokens_set_.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Prefill for logits output needs more decode tokens than expected: ",
+        decode_times_ + num_tokens));
+  }
+  std::vector<int> ids;
+  for (int i = 0; i < num_tokens; ++i) {
+    ids.push_back(decode_tokens_set_[decode_times_ + i][0]);
+  }
+  LITERT_ASSIGN_OR_RETURN(
+      auto output_logits,
+      CreateTensorBuffer<float>({1, num_tokens, vocab_size_}));
+  DecodeIdsToLogits(ids, vocab_size_, output_logits);
+  decode_times_ += num_tokens;
+  current_step_ += num_tokens;
+  return std::move(output_logits);
+}
+
+absl::Status FakeLlmExecutor::PrefillHiddenStates(
+    const std::vector<std::vector<int>>& sequences,
+    absl::FunctionRef<absl::Status(int, absl::Span<const float>)> consumer) {
+  std::vector<float> hidden_states;
+  for (int i = 0; i < sequences.size(); ++i) {
+    if (sequences[i].empty()) {
+      return absl::InvalidArgumentError("The sequences must not be empty.");
+    }
+    hidden_states.clear();
+    for (int j = 0; j < sequences[i].size(); ++j) {
+      hidden_states.push_back(static_cast<float>(sequences[i][j]));
+      hidden_states.push_back(static_cast<float>(j));
+    }
+    RETURN_IF_ERROR(consumer(i, hidden_states));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<::litert::TensorBuffer> FakeLlmExecutor::PrefillLastLogits(
+    const std::vector<std::vector<int>>& sequences) {
+  const int num_sequences = sequences.size();
+  if (decode_times_ + num_sequences > decode_tokens_set_.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Prefill for last logits output needs more decode tokens than "
+        "expected: ",
+        decode_times_ + num_sequences));
+  }
+  std::vector<int> ids;
+  for (int i = 0; i < num_sequences; ++i) {
+    if (sequences[i].empty()) {
+      return absl::InvalidArgumentError("The sequences must not be empty.");
+    }
+    ids.push_back(decode_tokens_set_[decode_times_ + i][0]);
+  }
+  LITERT_ASSIGN_OR_RETURN(
+      auto output_logits,
+      CreateTensorBuffer<float>({num_sequences, 1, vocab_size_}));
+  DecodeIdsToLogits(ids, vocab_size_, output_logits);
+  decode_times_ += num_sequences;
+  return std::move(output_logits);
+}
+
+absl::Status FakeLlmExecutor::RewindTo(int step) {
+  if (step < 0 || step > current_step_) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Cannot rewind to step ", step, ", the current step is ",
+        current_step_, "."));
+  }
+  current_step_ = step;
+  return absl::OkStatus();
+}
+
 }  // namespace litert::lm
@@ -17,9 +17,11 @@
 
 #include <vector>
 
+#include "absl/functional/function_ref.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
 #include "runtime/executor/llm_executor.h"
 #include "runtime/executor/llm_executor_settings.h"
@@ -56,6 +58,31 @@ class FakeLlmExecutor : public LlmExecutor {
   absl::StatusOr<::litert::TensorBuffer> DecodeLogits(
       const ExecutorInputs& inputs) override;
 
+  // Returns the logits of the next expected decode tokens, one call per input
+  // token, without checking the input tokens. Only batch size 1 is supported.
+  absl::StatusOr<::litert::TensorBuffer> PrefillLogits(
+      const ExecutorInputs& inputs) override;
+
+  // Makes PrefillLogits fail with Unimplemented, like for the models without
+  // the logits output in their prefill.
+  void DisablePrefillLogits() { prefill_logits_enabled_ = false; }
+
+  // Returns the hidden states of size kHiddenSize of each sequence, whose row
+  // of each token is {token id, position in the sequence}.
+  absl::Status PrefillHiddenStates(
+      const std::vector<std::vector<int>>& sequences,
+      absl::FunctionRef<absl::Status(int index,
+                                     absl::Span<const float> hidden_states)>
+          consumer) override;
+
+  // Returns the logits of the next expected decode tokens, one per sequence,
+  // without checking the sequences. The current step is unchanged.
+  absl::StatusOr<::litert::TensorBuffer> PrefillLastLogits(
+      const std::vector<std::vector<int>>& sequences) override;
+
+  // The hidden size of the fake hidden states.
+  static constexpr int kHiddenSize = 2;
+
   absl::string_view ExecutorBackendName() const override {
     return "FakeLlmExecutorBackend";
   };
@@ -72,6 +99,17 @@ class FakeLlmExecutor : public LlmExecutor {
     return current_step_;
   }
 
+  // Resets the current step. The expected prefill and decode tokens are not
+  // rewound, i.e. the following calls keep consuming them in order.
+  absl::Status Reset() override {
+    current_step_ = 0;
+    return absl::OkStatus();
+  }
+
+  // Moves the current step back. Like Reset(), the expected prefill and decode
+  // tokens are not rewound.
+  absl::Status RewindTo(int step) override;
+
  private:
   int vocab_size_;
   std::vector<std::vector<int>> prefill_tokens_set_;
@@ -88,6 +126,9 @@ class FakeLlmExecutor : public LlmExecutor {
 
   // The current step of the executor.
   int current_step_;
+
+  // Whether PrefillLogits is supported.
+  bool prefill_logits_enabled_ = true;
 };
 
 }  // namespace litert::lm
@@ -29,6 +29,7 @@
 namespace litert::lm {
 namespace {
 
+using ::testing::ElementsAre;
 using ::testing::status::StatusIs;
 
 TEST(FakeLlmExecutorTest, ExecutorSettings) {
@@ -177,5 +178,116 @@ TEST(FakeLlmExecutorTest, DecodeLogits) {
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST(FakeLlmExecutorTest, PrefillLogits) {
+  const std::vector<std::vector<int>> prefill_tokens_set = {{1, 2, 3}};
+  const std::vector<std::vector<int>> decode_tokens_set = {{3}, {0}};
+  FakeLlmExecutor fake_llm_executor(/*vocab_size=*/4, prefill_tokens_set,
+                                    decode_tokens_set);
+
+  ExecutorInputs inputs;
+  const std::vector<int> input_tokens = {3, 1};
+  LITERT_ASSERT_OK_AND_ASSIGN(
+      auto input_tokens_buffer,
+      CopyToTensorBuffer<int>(absl::MakeSpan(input_tokens), {1, 2}));
+  inputs.SetTextData(ExecutorTextData(std::move(input_tokens_buffer)));
+
+  // One position per input token, with the logits of the decode tokens:
+  // [[-inf, -inf, -inf, inf], [inf, -inf, -inf, -inf]].
+  auto output_logits = fake_llm_executor.PrefillLogits(inputs);
+  ASSERT_OK(output_logits);
+  EXPECT_EQ(fake_llm_executor.GetCurrentStep().value(), 2);
+  auto output_logits_span = ReferTensorBufferAsSpan<float>(*output_logits);
+  ASSERT_EQ(output_logits_span->size(), 8);
+  EXPECT_GE((*output_logits_span)[3], 0.0f);
+  EXPECT_LE((*output_logits_span)[0], 0.0f);
+  EXPECT_GE((*output_logits_span)[4], 0.0f);
+  EXPECT_LE((*output_logits_span)[7], 0.0f);
+
+  // No decode tokens are left.
+  EXPECT_THAT(fake_llm_executor.PrefillLogits(inputs),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  fake_llm_executor.DisablePrefillLogits();
+  EXPECT_THAT(fake_llm_executor.PrefillLogits(inputs),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+TEST(FakeLlmExecutorTest, PrefillHiddenStates) {
+  FakeLlmExecutor fake_llm_executor(/*vocab_size=*/4, /*prefill_tokens_set=*/{},
+                                    /*decode_tokens_set=*/{});
+
+  std::vector<std::vector<float>> hidden_states(2);
+  EXPECT_OK(fake_llm_executor.PrefillHiddenStates(
+      {{3, 1}, {2}},
+      [&](int index, absl::Span<const float> sequence_hidden_states) {
+        hidden_states[index].assign(sequence_hidden_states.begin(),
+                                    sequence_hidden_states.end());
+        return absl::OkStatus();
+      }));
+  EXPECT_THAT(hidden_states, ElementsAre(ElementsAre(3.0f, 0.0f, 1.0f, 1.0f),
+                                         ElementsAre(2.0f, 0.0f)));
+  // The sequences are not added to the executor.
+  EXPECT_EQ(fake_llm_executor.GetCurrentStep().value(), 0);
+
+  EXPECT_THAT(fake_llm_executor.PrefillHiddenStates(
+                  {{}}, [](int, absl::Span<const float>) {
+                    return absl::OkStatus();
+                  }),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(FakeLlmExecutorTest, PrefillLastLogits) {
+  FakeLlmExecutor fake_llm_executor(/*vocab_size=*/4, /*prefill_tokens_set=*/{},
+                                    /*decode_tokens_set=*/{{3}, {0}});
+
+  // One row per sequence, with the logits of the decode tokens.
+  auto output_logits = fake_llm_executor.PrefillLastLogits({{1, 2}, {2}});
+  ASSERT_OK(output_logits);
+  EXPECT_EQ(fake_llm_executor.GetCurrentStep().value(), 0);
+  auto output_logits_span = ReferTensorBufferAsSpan<float>(*output_logits);
+  ASSERT_EQ(output_logits_span->size(), 8);
+  EXPECT_GE((*output_logits_span)[3], 0.0f);
+  EXPECT_LE((*output_logits_span)[0], 0.0f);
+  EXPECT_GE((*output_logits_span)[4], 0.0f);
+  EXPECT_LE((*output_logits_span)[7], 0.0f);
+
+  // No decode tokens are left.
+  EXPECT_THAT(fake_llm_executor.PrefillLastLogits({{1}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(FakeLlmExecutorTest, RewindTo) {
+  const std::vector<std::vector<int>> prefill_tokens_set = {{1, 2, 3}, {4}};
+  const std::vector<std::vector<int>> decode_tokens_set = {{3}};
+  FakeLlmExecutor fake_llm_executor(4, prefill_tokens_set, decode_tokens_set);
+
+  ExecutorInputs inputs;
+  const std::vector<int> input_tokens = {1, 2, 3};
+  LITERT_ASSERT_OK_AND_ASSIGN(
+      auto input_tokens_buffer,
+      CopyToTensorBuffer<int>(absl::MakeSpan(input_tokens), {1, 3}));
+  inputs.SetTextData(ExecutorTextData(std::move(input_tokens_buffer)));
+  EXPECT_OK(fake_llm_executor.Prefill(inputs));
+  EXPECT_EQ(fake_llm_executor.GetCurrentStep().value(), 3);
+
+  // Rewinding past the current step or to a negative step fails.
+  EXPECT_THAT(fake_llm_executor.RewindTo(4),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(fake_llm_executor.RewindTo(-1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  EXPECT_OK(fake_llm_executor.RewindTo(1));
+  EXPECT_EQ(fake_llm_executor.GetCurrentStep().value(), 1);
+
+  // The following prefill continues from the rewound step.
+  const std::vector<int> next_input_tokens = {4};
+  LITERT_ASSERT_OK_AND_ASSIGN(
+      auto next_input_tokens_buffer,
+      CopyToTensorBuffer<int>(absl::MakeSpan(next_input_tokens), {1, 1}));
+  inputs.SetTextData(ExecutorTextData(std::move(next_input_tokens_buffer)));
+  EXPECT_OK(fake_llm_executor.Prefill(inputs));
+  EXPECT_EQ(fake_llm_executor.GetCurrentStep().value(), 2);
+}
+
 }  // namespace
 }  // namespace litert::lm
@@ -29,6 +29,7 @@
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/match.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_buffer_ref.h"  // from @litert
 #include "litert/cc/litert_expected.h"  // from @litert
 #include "litert/cc/litert_model.h"  // from @litert
@@ -190,8 +191,11 @@ BuildModelResourcesFromTaskFormat(std::shared_ptr<ScopedFile> model_file) {
 }
 
 absl::StatusOr<std::unique_ptr<ModelResources>>
-BuildModelResourcesFromLitertLmFormat(ScopedFile model_file) {
-  auto loader = std::make_unique<LitertLmLoader>(std::move(model_file));
+BuildModelResourcesFromLitertLmFormat(
+    ScopedFile model_file, SectionVerificationMode verification_mode) {
+  ASSIGN_OR_RETURN(auto loader,  // NOLINT
+                   LitertLmLoader::Create(std::move(model_file),
+                                          verification_mode));
 
   ABSL_LOG(INFO) << "Read litert model from section.";
 
@@ -329,71 +333,19 @@ GetOptimizedPrefillWorkGroups(
   return work_groups;
 }
 
-absl::Status InitializeAttentionMask(litert::TensorBuffer& mask,
-                                     AttentionMaskDataType mask_data_type,
-                                     bool is_f16) {
-  auto mask_size = mask.PackedSize();
-  RET_CHECK(mask_size) << "Failed to get attention mask buffer size.";
-  auto mask_lock_and_addr = litert::TensorBufferScopedLock::Create(
-      mask, litert::TensorBuffer::LockMode::kWrite);
-  RET_CHECK(mask_lock_and_addr) << "Failed to lock attention mask buffer.";
-
-  switch (mask_data_type) {
-    case AttentionMaskDataType::BOOLEAN: {
-      // Boolean mask: Default value = false.
-      memset(mask_lock_and_addr->second, 0, *mask_size);
-    } break;
-    case AttentionMaskDataType::FLOAT: {
-      // Float mask: Default value is based on precision.
-      // Default value reference:
-      // third_party/odml/infra/genai/inference/ml_drift/llm/tasks/apply_attention_mask_test_util.cc
-      float* mask_ptr = static_cast<float*>(mask_lock_and_addr->second);
-      std::fill(mask_ptr, mask_ptr + *mask_size / sizeof(float),
-                is_f16 ? -45824 : -0.7f * std::numeric_limits<float>::max());
-    } break;
-    default:
-      return absl::InvalidArgumentError(
-          "Unsupported attention mask data type.");
-  }
-  return absl::OkStatus();
-}
-
-absl::Status FillAttentionMask(litert::TensorBuffer& mask, int start_timestep,
-                               int steps,
-                               AttentionMaskDataType mask_data_type) {
-  auto mask_tensor_type = mask.TensorType();
-  RET_CHECK(mask_tensor_type) << "Failed to get attention mask tensor type.";
-  RET_CHECK_EQ(mask_tensor_type->Layout().Rank(), 4)
-          .SetCode(absl::StatusCode::kInvalidArgument)
-      << "Attention mask must be 4D.";
-  int channel_size = mask_tensor_type->Layout().Dimensions()[3];
-  auto mask_lock_and_addr = litert::TensorBufferScopedLock::Create(
-      mask, litert::TensorBuffer::LockMode::kWrite);
-  RET_CHECK(mask_lock_and_addr) << "Failed to lock attention mask buffer.";
-
-  for (int i = 0; i < steps; ++i) {
-    int current_step = start_timestep + i;
-    int offset = i * channel_size;
-    // For current step = n, we fill (n+1) positions for the mask sequence.
-    switch (mask_data_type) {
-      case AttentionMaskDataType::BOOLEAN: {
-        // Boolean mask: Fill value = true.
-        bool* mask_bool_ptr = static_cast<bool*>(mask_lock_and_addr->second);
-        std::fill(mask_bool_ptr + offset,
-                  mask_bool_ptr + offset + current_step + 1, true);
-      } break;
-      case AttentionMaskDataType::FLOAT: {
-        // Float mask: Fill value = 0.0f.
-        float* mask_float_ptr = static_cast<float*>(mask_lock_and_addr->second);
-        std::fill(mask_float_ptr + offset,
-                  mask_float_ptr + offset + current_step + 1, 0.0f);
-      } break;
-      default:
-        return absl::InvalidArgumentError(
-            "Unsupported attention mask data type.");
+std::vector<int> GetPackedPrefillGroups(absl::Span<const int> sequence_lengths,
+                                        int max_packed_length) {
+  std::vector<int> group_sizes;
+  int group_length = 0;
+  for (int length : sequence_lengths) {
+    if (group_sizes.empty() || group_length + length > max_packed_length) {
+      group_sizes.push_back(0);
+      group_length = 0;
     }
+    ++group_sizes.back();
+    group_length += length;
   }
-  return absl::OkStatus();
+  return group_sizes;
 }
 
 absl::StatusOr<std::unique_ptr<ModelResources>>
@@ -412,7 +364,8 @@ BuildLiteRtCompiledModelResources(const ModelAssets& model_assets) {
     case FileFormat::TASK:
       return BuildModelResourcesFromTaskFormat(std::move(scoped_file));
     case FileFormat::LITERT_LM:
-      return BuildModelResourcesFromLitertLmFormat(std::move(*scoped_file));
+      return BuildModelResourcesFromLitertLmFormat(
+          std::move(*scoped_file), model_assets.section_verification_mode());
   }
 }
 
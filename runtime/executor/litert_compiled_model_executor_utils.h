@@ -26,9 +26,11 @@
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_model.h"  // from @litert
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
 #include "runtime/components/model_resources.h"
+#include "runtime/executor/attention_mask_manager.h"
 #include "runtime/executor/executor_settings_base.h"
 
 namespace litert::lm {
@@ -37,11 +39,6 @@ namespace litert::lm {
 using SortedPrefillSignatureMap =
     absl::btree_map<int, std::string, std::greater<int>>;
 
-// The data type of the attention mask.
-// BOOLEAN: The attention mask is a boolean tensor.
-// FLOAT: The attention mask is a float tensor.
-enum class AttentionMaskDataType { BOOLEAN, FLOAT };
-
 // A struct holding a set of model signatures used for doing inference on a
 // conversion path Gemini/Gemma model.
 // For now, this struct supports Gemini V1.5 and Gemma2 only.
@@ -66,8 +63,16 @@ struct ModelSignatures {
   std::optional<std::string> input_per_layer_embeddings;
   // Output logits signature name. Necessary for decode.
   std::string output_logits;
+  // Output hidden states signature name of the prefill, i.e. the final hidden
+  // state of each position before the logits projection. Only needed for the
+  // embeddings, see kOutputHiddenStates.
+  std::optional<std::string> output_hidden_states;
 };
 
+// The name of the optional prefill output of the hidden states, with shape
+// [batch_size, max_seq_len, hidden_size].
+inline constexpr char kOutputHiddenStates[] = "hidden_states";
+
 // Get the corresponding ModelSignatures struct for the given model using
 // the signature runner. Returns an error if the the runner's signature does not
 // match any of the predefined signature set.
@@ -97,22 +102,14 @@ absl::StatusOr<std::vector<std::pair<std::string, int>>>
 GetOptimizedPrefillWorkGroups(
     const SortedPrefillSignatureMap& prefill_runner_set, int input_length);
 
-// Initializes the attention mask tensor for prefill/decode.
-// The mask is a 4D tensor with shape [batch=1, seq_len, 1, max_kv_len].
-// The default value for mask is different for different mask data types, and
-// different calculation precisions.
-absl::Status InitializeAttentionMask(::litert::TensorBuffer& mask,
-                                     AttentionMaskDataType mask_data_type,
-                                     bool is_f16);
-
-// Fill attention mask for a given range of timesteps.
-// The mask is a 4D tensor with shape [batch=1, seq_len, 1, max_kv_len].
-// mask - The attention mask tensor to be filled.
-// start_timestep - The starting timestep to be filled at seq = 1.
-// steps - The number of steps to fill (the number of sequences to be filled).
-// mask_data_type - The data type of the attention mask (e.g. boolean, float).
-absl::Status FillAttentionMask(::litert::TensorBuffer& mask, int start_timestep,
-                               int steps, AttentionMaskDataType mask_data_type);
+// Packs independent sequences, in order, into groups prefilled together with
+// the attention mask of AttentionMaskManager::UpdatePacked, each of at most
+// `max_packed_length` tokens. The tokens of a group are then split into
+// prefill calls with GetOptimizedPrefillWorkGroups. A sequence longer than
+// `max_packed_length` is alone in its group.
+// Output: The number of sequences of each group.
+std::vector<int> GetPackedPrefillGroups(absl::Span<const int> sequence_lengths,
+                                        int max_packed_length);
 
 // Builds the model resources from the model_path for compiled model only.
 // Supports .task and .litertlm formats.
@@ -29,6 +29,8 @@ namespace litert::lm {
 namespace {
 
 using ::testing::_;  // NOLINT: Required by ASSERT_OK_AND_ASSIGN().
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 
 TEST(LlmLiteRTCompiledModelExecutorUtilsTest,
      BuildModelResourcesTaskBundleFromPath) {
@@ -62,5 +64,17 @@ TEST(LlmLiteRTCompiledModelExecutorUtilsTest,
   ASSERT_OK(model_resources->GetTFLiteModel(ModelType::kTfLitePrefillDecode));
 }
 
+TEST(LlmLiteRTCompiledModelExecutorUtilsTest, GetPackedPrefillGroups) {
+  EXPECT_THAT(GetPackedPrefillGroups({3, 4, 1, 5, 8}, /*max_packed_length=*/8),
+              ElementsAre(3, 1, 1));
+}
+
+TEST(LlmLiteRTCompiledModelExecutorUtilsTest,
+     GetPackedPrefillGroupsLongSequenceIsAlone) {
+  EXPECT_THAT(GetPackedPrefillGroups({2, 10, 2}, /*max_packed_length=*/8),
+              ElementsAre(1, 1, 1));
+  EXPECT_THAT(GetPackedPrefillGroups({}, /*max_packed_length=*/8), IsEmpty());
+}
+
 }  // namespace
 }  // namespace litert::lm
@@ -15,16 +15,32 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_LLM_EXECUTOR_BASE_H_
 #define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_LLM_EXECUTOR_BASE_H_
 
+#include <atomic>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/functional/function_ref.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_tensor_buffer.h"  // from @litert
+#include "runtime/executor/executor_settings_base.h"
 #include "runtime/executor/llm_executor_io_types.h"
 #include "runtime/executor/llm_executor_settings.h"
+#include "runtime/util/memory_tracker.h"
 
 namespace litert::lm {
 
+// Returns a new sequence id for LlmExecutorBase::SetActiveSequence, unique in
+// the process, e.g. for each of the sessions sharing an executor.
+inline int NewExecutorSequenceId() {
+  static std::atomic<int> next_sequence_id = 0;
+  return next_sequence_id++;
+}
+
 // The LLM Executor serves as a lightweight and portable wrapper around various
 // converted LLM model formats, i.e. LiteRT. It aims to provide a general,
 // minimal-dependency interface for the users, abstracting the complexities of
@@ -76,6 +92,55 @@ class LlmExecutorBase {
                      ExecutorBackendName()));
   };
 
+  // API to score the input tokens, i.e. get the logits predicting each of them
+  // from the tokens before it, in one pass over the tokens. The tokens are
+  // added to the sequence like with Prefill, so the sequence must not be empty
+  // and the last input token is kept for the next step.
+  // Input is token ids with shape `[batch, sequence_length]`
+  // Output is logits with shape `[batch, sequence_length, vocab_size]` of
+  // float32_t on the host memory.
+  // It is only implemented for the models outputting the logits at all the
+  // positions of the prefill.
+  virtual absl::StatusOr<::litert::TensorBuffer> PrefillLogits(
+      const ExecutorInputs& inputs) {
+    return absl::UnimplementedError(
+        absl::StrCat("Prefill for logits output not implemented for backend: ",
+                     ExecutorBackendName()));
+  };
+
+  // API to get the hidden states of independent token sequences, e.g. to pool
+  // them into text embeddings. The sequences are prefilled packed together,
+  // each attending only to its own tokens, and are not added to the sequence
+  // of the executor, i.e. the current step is unchanged.
+  // `consumer` is called with the index of each sequence and its hidden
+  // states with shape `[sequence_length, hidden_size]` of float32_t on the
+  // host memory, only valid during the call.
+  // It is only implemented for the models outputting the hidden states of
+  // their prefill.
+  virtual absl::Status PrefillHiddenStates(
+      const std::vector<std::vector<int>>& sequences,
+      absl::FunctionRef<absl::Status(int index,
+                                     absl::Span<const float> hidden_states)>
+          consumer) {
+    return absl::UnimplementedError(absl::StrCat(
+        "Prefill for hidden states output not implemented for backend: ",
+        ExecutorBackendName()));
+  };
+
+  // API to get the logits predicting the token after each of independent
+  // token sequences, e.g. to classify a batch of short prompts. The sequences
+  // are prefilled packed together like with PrefillHiddenStates, and are not
+  // added to the sequence of the executor.
+  // Output is logits with shape `[num_sequences, 1, vocab_size]` of float32_t
+  // on the host memory.
+  virtual absl::StatusOr<::litert::TensorBuffer> PrefillLastLogits(
+      const std::vector<std::vector<int>>& sequences) {
+    return absl::UnimplementedError(
+        absl::StrCat("Packed prefill for logits output not implemented for "
+                     "backend: ",
+                     ExecutorBackendName()));
+  };
+
   virtual absl::string_view ExecutorBackendName() const = 0;
 
   // Get vocabulary size used to build tensor buffers for decode functions.
@@ -84,6 +149,23 @@ class LlmExecutorBase {
         "GetVocabSize not implemented for backend: ", ExecutorBackendName()));
   };
 
+  // Gets the memory allocated by the executor for the inputs and outputs of
+  // the model, e.g. the KV cache, per component. The model weights are not
+  // included, nor the memory allocated as the sequences grow, which is
+  // accounted to the tracker set by SetMemoryTracker().
+  virtual absl::StatusOr<absl::flat_hash_map<MemoryComponent, size_t>>
+  GetMemoryUsage() const {
+    return absl::UnimplementedError(absl::StrCat(
+        "GetMemoryUsage not implemented for backend: ", ExecutorBackendName()));
+  };
+
+  // Accounts the memory allocated for each sequence as it grows, e.g. its
+  // saved KV cache, to `tracker`, which must outlive the executor. Once the
+  // budget of the tracker is exceeded, the calls allocating more memory fail
+  // with a ResourceExhausted error. The executors not allocating such memory
+  // ignore the tracker.
+  virtual void SetMemoryTracker(MemoryTracker* tracker) {}
+
   // Gets the current step of the executor.
   virtual absl::StatusOr<int> GetCurrentStep() const {
     return absl::UnimplementedError(absl::StrCat(
@@ -112,12 +194,65 @@ class LlmExecutorBase {
                      ExecutorBackendName()));
   };
 
+  // ------------LoRA APIs------------:
+  // Loads the LoRA adapter in `model_assets`, a .litertlm file with a TF Lite
+  // section of model type tf_lite_lora, as `name`. The base weights are shared
+  // by all the adapters, so only the adapter weights are loaded.
+  virtual absl::Status LoadLoRA(absl::string_view name,
+                                const ModelAssets& model_assets) {
+    return absl::UnimplementedError(absl::StrCat(
+        "LoadLoRA not implemented for backend: ", ExecutorBackendName()));
+  };
+
+  // Selects the LoRA adapter applied by the following Prefill/Decode calls, or
+  // the base model if `name` is nullopt. It is cheap enough to be called
+  // between any two steps, e.g. by each of the sessions sharing the executor.
+  virtual absl::Status SetActiveLoRA(std::optional<absl::string_view> name) {
+    if (!name.has_value()) {
+      // Without LoRA support, the base model is always active.
+      return absl::OkStatus();
+    }
+    return absl::UnimplementedError(absl::StrCat(
+        "SetActiveLoRA not implemented for backend: ", ExecutorBackendName()));
+  };
+
+  // ------------Sequence APIs------------:
+  // Makes `sequence_id` the sequence continued by the following Prefill/Decode
+  // calls, e.g. the one of each of the sessions sharing the executor. The
+  // tokens and KV cache of the previously active sequence are saved, and the
+  // ones of `sequence_id` restored, or emptied for a new id. The state of the
+  // executor before the first call, not bound to any id, is dropped.
+  virtual absl::Status SetActiveSequence(int sequence_id) {
+    return absl::UnimplementedError(
+        absl::StrCat("SetActiveSequence not implemented for backend: ",
+                     ExecutorBackendName()));
+  };
+
+  // Drops the saved tokens and KV cache of `sequence_id`, and empties the
+  // executor if it is the active sequence. Releasing a sequence which was
+  // never active is a no-op.
+  virtual absl::Status ReleaseSequence(int sequence_id) {
+    return absl::UnimplementedError(
+        absl::StrCat("ReleaseSequence not implemented for backend: ",
+                     ExecutorBackendName()));
+  };
+
   // Resets all of the internal states (e.g. KVCache). Loaded and used LoRA
   // models are not affected (remain loaded and in use).
   virtual absl::Status Reset() {
     return absl::UnimplementedError(absl::StrCat(
         "Reset not implemented for backend: ", ExecutorBackendName()));
   };
+
+  // Rewinds the executor to the given step, i.e. drops the tokens at and after
+  // `step` as if they were never processed, so that the next Prefill/Decode
+  // continues from `step`. It is meant to be cheap: the KV cache entries past
+  // the new step are invalidated lazily (masked out and later overwritten)
+  // rather than cleared. `step` must be in [0, GetCurrentStep()].
+  virtual absl::Status RewindTo(int step) {
+    return absl::UnimplementedError(absl::StrCat(
+        "RewindTo not implemented for backend: ", ExecutorBackendName()));
+  };
 };
 
 }  // namespace litert::lm
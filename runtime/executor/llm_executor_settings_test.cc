@@ -136,6 +136,7 @@ TEST(LlmExecutorConfigTest, ModelAssets) {
   oss << *model_assets;
   const std::string expected_output = R"(model_path: /path/to/model1
 fake_weights_mode: FAKE_WEIGHTS_NONE
+section_verification_mode: SECTION_VERIFICATION_NONE
 )";
   EXPECT_EQ(oss.str(), expected_output);
 }
@@ -196,6 +197,7 @@ cache_dir: /path/to/cache
 cache_file: Not set.
 model_assets: model_path: /path/to/model1
 fake_weights_mode: FAKE_WEIGHTS_NONE
+section_verification_mode: SECTION_VERIFICATION_NONE
 
 )";
   EXPECT_EQ(oss.str(), expected_output);
@@ -14,14 +14,19 @@
 
 #include "runtime/executor/llm_litert_compiled_model_executor.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/container/flat_hash_set.h"  // from @com_google_absl
+#include "absl/functional/function_ref.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/memory/memory.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
@@ -29,6 +34,8 @@
 #include "absl/strings/match.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
 #include "absl/types/span.h"  // from @com_google_absl
 #include "litert/c/litert_common.h"  // from @litert
 #include "litert/c/litert_environment_options.h"  // from @litert
@@ -42,12 +49,14 @@
 #include "litert/cc/options/litert_gpu_options.h"  // from @litert
 #include "litert/cc/options/litert_runtime_options.h"  // from @litert
 #include "runtime/components/embedding_lookup_text.h"
+#include "runtime/components/lora_adapter.h"
 #include "runtime/components/model_resources.h"
 #include "runtime/components/sampler_factory.h"
 #include "runtime/executor/executor_settings_base.h"
 #include "runtime/executor/litert_compiled_model_executor_utils.h"
 #include "runtime/executor/llm_executor_io_types.h"
 #include "runtime/executor/llm_executor_settings.h"
+#include "runtime/executor/weight_cache_manager.h"
 #include "runtime/util/convert_tensor_buffer.h"
 #include "runtime/util/file_util.h"
 #include "runtime/util/litert_status_util.h"
@@ -66,6 +75,11 @@ using ::litert::TensorBuffer;
 constexpr char kPrefillSignatureRunner[] = "prefill";
 constexpr char kDecodeSignatureRunner[] = "decode";
 
+// The number of tokens per block of the paged KV cache holding the inactive
+// sequences on CPU, and the maximum number of tokens of all of them.
+constexpr int kKvCacheBlockSize = 64;
+constexpr int kMaxNumPagedKvCacheTokens = 1 << 20;
+
 absl::Status GetCacheRootNames(std::vector<absl::string_view> input_names,
                                std::string& k_root_name,
                                std::string& v_root_name) {
@@ -85,6 +99,115 @@ absl::Status GetCacheRootNames(std::vector<absl::string_view> input_names,
 
 bool IsCalculationPrecisionF16() { return true; }
 
+// Fills the LoRA input buffer with `weights`, or with zeros if `weights` is
+// empty, which disables the low-rank update of the base model.
+absl::Status FillLoRABuffer(absl::string_view input_name,
+                            absl::Span<const uint8_t> weights,
+                            TensorBuffer& buffer) {
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto size, buffer.PackedSize());
+  if (!weights.empty() && weights.size() != size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The LoRA weights of ", input_name, " have ",
+                     weights.size(), " bytes, the model expects ", size, "."));
+  }
+  LITERT_ASSIGN_OR_RETURN_ABSL(
+      auto lock_and_addr, ::litert::TensorBufferScopedLock::Create(
+                              buffer, TensorBuffer::LockMode::kWrite));
+  if (weights.empty()) {
+    memset(lock_and_addr.second, 0, size);
+  } else {
+    memcpy(lock_and_addr.second, weights.data(), size);
+  }
+  return absl::OkStatus();
+}
+
+// Returns the layout of a KV cache buffer whose only dimension of size
+// `kv_cache_length` is the token dimension, e.g. [1, kv_cache_length,
+// num_heads, head_dim], or [1, num_heads, head_dim, kv_cache_length] for a
+// transposed cache.
+absl::StatusOr<KvCacheTensorLayout> GetKvCacheTensorLayout(
+    absl::string_view name, const TensorBuffer& buffer, int kv_cache_length) {
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto buffer_type, buffer.BufferType());
+  if (buffer_type != kLiteRtTensorBufferTypeHostMemory) {
+    return absl::UnimplementedError(absl::StrCat(
+        "The KV cache buffer ", name, " is not in the host memory."));
+  }
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto tensor_type, buffer.TensorType());
+  LITERT_ASSIGN_OR_RETURN_ABSL(size_t packed_size, buffer.PackedSize());
+  const auto& dimensions = tensor_type.Layout().Dimensions();
+  const int num_dimensions = dimensions.size();
+  int token_dimension = -1;
+  size_t num_elements = 1;
+  for (int i = 0; i < num_dimensions; ++i) {
+    num_elements *= dimensions[i];
+    if (dimensions[i] != kv_cache_length) {
+      continue;
+    }
+    if (token_dimension != -1) {
+      return absl::UnimplementedError(
+          absl::StrCat("The token dimension of the KV cache buffer ", name,
+                       " is ambiguous."));
+    }
+    token_dimension = i;
+  }
+  if (token_dimension == -1) {
+    return absl::UnimplementedError(
+        absl::StrCat("The KV cache buffer ", name, " has no dimension of ",
+                     kv_cache_length, " tokens."));
+  }
+  RET_CHECK_EQ(packed_size % num_elements, 0);
+  KvCacheTensorLayout layout = {.outer_size = 1,
+                                .max_num_tokens = kv_cache_length,
+                                .token_size_in_bytes =
+                                    packed_size / num_elements};
+  for (int i = 0; i < num_dimensions; ++i) {
+    if (i < token_dimension) {
+      layout.outer_size *= dimensions[i];
+    } else if (i > token_dimension) {
+      layout.token_size_in_bytes *= dimensions[i];
+    }
+  }
+  return layout;
+}
+
+// Creates the paged KV cache of the sequences saved from the KV cache
+// `buffers`, and fills `names` with the names of the buffers in the order of
+// its tensor layouts.
+absl::StatusOr<std::unique_ptr<PagedKvCache>> CreatePagedKvCache(
+    const absl::flat_hash_map<absl::string_view, TensorBuffer>& buffers,
+    int kv_cache_length, std::vector<absl::string_view>& names) {
+  names.clear();
+  for (const auto& [name, buffer] : buffers) {
+    names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+  std::vector<KvCacheTensorLayout> layouts;
+  layouts.reserve(names.size());
+  for (absl::string_view name : names) {
+    ASSIGN_OR_RETURN(
+        KvCacheTensorLayout layout,
+        GetKvCacheTensorLayout(name, buffers.at(name), kv_cache_length));
+    layouts.push_back(layout);
+  }
+  return PagedKvCache::Create(std::move(layouts), kKvCacheBlockSize,
+                              /*max_num_blocks=*/
+                              (kMaxNumPagedKvCacheTokens + kKvCacheBlockSize -
+                               1) / kKvCacheBlockSize);
+}
+
+// Replaces the buffers of `input_buffers` with the ones of `lora_buffers`.
+// The buffers are duplicated, i.e. only their references are copied.
+absl::Status SwapInLoRABuffers(
+    const absl::flat_hash_map<absl::string_view, TensorBuffer>& lora_buffers,
+    absl::flat_hash_map<absl::string_view, TensorBuffer>& input_buffers) {
+  for (const auto& [input_name, lora_buffer] : lora_buffers) {
+    auto duplicated_buffer = lora_buffer.Duplicate();
+    RET_CHECK(duplicated_buffer) << "Failed to duplicate LoRA buffer.";
+    input_buffers[input_name] = std::move(*duplicated_buffer);
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::Status LlmLiteRtCompiledModelExecutor::Prefill(
@@ -97,65 +220,356 @@ absl::Status LlmLiteRtCompiledModelExecutor::Prefill(
       << "Prefill token ids must be non-empty.";
   LITERT_ASSIGN_OR_RETURN_ABSL(auto ids, ReferTensorBufferAsSpan<int32_t>(
                                              *(*inputs.GetTextTokenIdsPtr())));
+  return PrefillTokens(ids, params, /*logits=*/nullptr);
+}
 
+absl::StatusOr<::litert::TensorBuffer>
+LlmLiteRtCompiledModelExecutor::PrefillLogits(const ExecutorInputs& inputs) {
+  if (!prefill_output_buffers_.contains(signatures_.output_logits)) {
+    return absl::UnimplementedError(
+        "The prefill signatures of the model do not output the logits.");
+  }
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto tensor_type,
+                               (*inputs.GetTextTokenIdsPtr())->TensorType());
+  // Only accept batch size 1 for now.
+  RET_CHECK_EQ(tensor_type.Layout().Dimensions()[0], 1);
+  RET_CHECK_GT(tensor_type.Layout().Dimensions()[1], 0)
+      << "Prefill token ids must be non-empty.";
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto ids, ReferTensorBufferAsSpan<int32_t>(
+                                             *(*inputs.GetTextTokenIdsPtr())));
+  // The first input token is predicted from the pending token, which is fed
+  // to the model along with all the input tokens but the last one.
+  if (next_input_token_id_ == -1) {
+    return absl::FailedPreconditionError(
+        "No token is pending to predict the first input token from.");
+  }
+  ASSIGN_OR_RETURN(const int vocab_size, GetVocabSize());
+  std::vector<float> logits;
+  logits.reserve(ids.size() * vocab_size);
+  RETURN_IF_ERROR(PrefillTokens(ids, ExecutorPrefillParams(), &logits));
+  RET_CHECK_EQ(logits.size(), ids.size() * vocab_size);
+  LITERT_ASSIGN_OR_RETURN_ABSL(
+      auto logits_buffer,
+      CopyToTensorBuffer<float>(
+          logits, {1, static_cast<int>(ids.size()), vocab_size}));
+  return std::move(logits_buffer);
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::PrefillHiddenStates(
+    const std::vector<std::vector<int>>& sequences,
+    absl::FunctionRef<absl::Status(int, absl::Span<const float>)> consumer) {
+  if (!signatures_.output_hidden_states.has_value()) {
+    return absl::UnimplementedError(
+        "The prefill signatures of the model do not output the hidden "
+        "states.");
+  }
+  return PrefillPacked(sequences, signatures_.output_hidden_states.value(),
+                       /*last_position_only=*/false, consumer);
+}
+
+absl::StatusOr<::litert::TensorBuffer>
+LlmLiteRtCompiledModelExecutor::PrefillLastLogits(
+    const std::vector<std::vector<int>>& sequences) {
+  ASSIGN_OR_RETURN(const int vocab_size, GetVocabSize());
+  std::vector<float> logits(sequences.size() * vocab_size);
+  RETURN_IF_ERROR(PrefillPacked(
+      sequences, signatures_.output_logits, /*last_position_only=*/true,
+      [&](int index, absl::Span<const float> last_logits) -> absl::Status {
+        RET_CHECK_EQ(last_logits.size(), vocab_size);
+        std::copy(last_logits.begin(), last_logits.end(),
+                  logits.begin() + index * vocab_size);
+        return absl::OkStatus();
+      }));
+  LITERT_ASSIGN_OR_RETURN_ABSL(
+      auto logits_buffer,
+      CopyToTensorBuffer<float>(
+          logits, {static_cast<int>(sequences.size()), 1, vocab_size}));
+  return std::move(logits_buffer);
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::PrefillPacked(
+    const std::vector<std::vector<int>>& sequences,
+    absl::string_view output_name, bool last_position_only,
+    absl::FunctionRef<absl::Status(int, absl::Span<const float>)> consumer) {
+  if (!signatures_.input_attn_mask.has_value()) {
+    return absl::UnimplementedError(
+        "The sequences cannot be kept apart without an attention mask input.");
+  }
+  // The sequences are written to the KV cache from the current step on, where
+  // they are masked out and overwritten by the following prefill/decode, like
+  // the entries dropped by RewindTo.
+  const int start_step = current_step_;
+  const int max_length =
+      static_cast<int>(executor_settings_.GetMaxNumTokens()) - start_step;
+  std::vector<int> lengths;
+  lengths.reserve(sequences.size());
+  for (const auto& sequence : sequences) {
+    if (sequence.empty() || static_cast<int>(sequence.size()) > max_length) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The sequence length ", sequence.size(), " is not in [1, ",
+          max_length, "], the space left in the KV cache."));
+    }
+    lengths.push_back(sequence.size());
+  }
+  // The groups fill the largest prefill signature, so that the sequences
+  // shorter than it share its calls.
+  const std::vector<int> group_sizes = GetPackedPrefillGroups(
+      lengths, std::min(prefill_signature_map_.begin()->first, max_length));
+  int first_sequence = 0;
+  std::vector<int> tokens;
+  std::vector<int> sequence_starts;
+  std::vector<bool> is_kept;
+  std::vector<float> rows;
+  for (int group_size : group_sizes) {
+    tokens.clear();
+    sequence_starts.clear();
+    is_kept.clear();
+    for (int i = first_sequence; i < first_sequence + group_size; ++i) {
+      sequence_starts.insert(sequence_starts.end(), sequences[i].size(),
+                             start_step + tokens.size());
+      tokens.insert(tokens.end(), sequences[i].begin(), sequences[i].end());
+      is_kept.insert(is_kept.end(), sequences[i].size(), !last_position_only);
+      is_kept.back() = true;
+    }
+    ASSIGN_OR_RETURN(auto work_groups, GetOptimizedPrefillWorkGroups(
+                                           prefill_signature_map_,
+                                           tokens.size()));
+    rows.clear();
+    int row_size = 0;
+    int offset = 0;
+    for (const auto& [prefill_signature, prefill_length] : work_groups) {
+      RETURN_IF_ERROR(CreatePrefillInputBuffers(prefill_signature));
+      LITERT_ASSIGN_OR_RETURN_ABSL(
+          auto output_buffer,
+          compiled_model_.CreateOutputBuffer(prefill_signature, output_name));
+      LITERT_ASSIGN_OR_RETURN_ABSL(auto output_type,
+                                   output_buffer.TensorType());
+      const auto& dimensions = output_type.Layout().Dimensions();
+      RET_CHECK_EQ(dimensions.size(), 3)
+          << "Output " << output_name << " must be (batch, seq, size).";
+      if (dimensions[1] < prefill_length) {
+        return absl::UnimplementedError(absl::StrCat(
+            "The prefill signatures of the model do not output the ",
+            output_name, " of all the positions."));
+      }
+      row_size = dimensions[2];
+      RETURN_IF_ERROR(PrefillPackedInternal(
+          prefill_signature,
+          absl::MakeConstSpan(tokens).subspan(offset, prefill_length),
+          start_step + offset,
+          absl::MakeConstSpan(sequence_starts).subspan(offset, prefill_length),
+          output_name, output_buffer));
+      // Only the kept rows are read from the output, e.g. one row of logits
+      // per sequence instead of one per position.
+      LITERT_ASSIGN_OR_RETURN_ABSL(
+          auto output_lock_and_addr,
+          ::litert::TensorBufferScopedLock::Create(
+              output_buffer, TensorBuffer::LockMode::kRead));
+      const float* output_ptr =
+          static_cast<const float*>(output_lock_and_addr.second);
+      for (int i = 0; i < prefill_length; ++i) {
+        if (is_kept[offset + i]) {
+          rows.insert(rows.end(), output_ptr + i * row_size,
+                      output_ptr + (i + 1) * row_size);
+        }
+      }
+      offset += prefill_length;
+    }
+    offset = 0;
+    for (int i = first_sequence; i < first_sequence + group_size; ++i) {
+      const int num_rows = last_position_only ? 1 : sequences[i].size();
+      RETURN_IF_ERROR(consumer(
+          i, absl::MakeConstSpan(rows).subspan(offset * row_size,
+                                               num_rows * row_size)));
+      offset += num_rows;
+    }
+    first_sequence += group_size;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::PrefillTokens(
+    absl::Span<const int> ids, const ExecutorPrefillParams& params,
+    std::vector<float>* logits) {
   ASSIGN_OR_RETURN(auto work_groups, GetOptimizedPrefillWorkGroups(
                                          prefill_signature_map_, ids.size()));
   for (const auto& [prefill_signature, prefill_length] : work_groups) {
-    // Create input_token, positions and attn_mask buffers after determining
-    // the prefill length.
-    if (!signatures_.input_tokens.empty()) {
-      auto tokens_buffer = compiled_model_.CreateInputBuffer(
-          prefill_signature, signatures_.input_tokens);
-      prefill_input_buffers_[signatures_.input_tokens] =
-          std::move(*tokens_buffer);
+    // The prefill is cancelled between the signature calls, which leaves the
+    // KV cache consistent with the current step.
+    if (params.GetCancelFlag() != nullptr &&
+        params.GetCancelFlag()->load(std::memory_order_relaxed)) {
+      return absl::CancelledError("The prefill is cancelled.");
+    }
+    RETURN_IF_ERROR(CreatePrefillInputBuffers(prefill_signature));
+    if (logits == nullptr) {
+      RETURN_IF_ERROR(PrefillInternal(prefill_signature,
+                                      ids.subspan(/*pos=*/0, prefill_length)));
     } else {
-      // If input_tokens is empty, we must have input_embeddings.
-      if (!signatures_.input_embeddings.has_value()) {
-        return absl::FailedPreconditionError(
-            "Input tokens or embeddings must be provided.");
+      // The logits buffer is sized for the signature, and only the positions
+      // filled with tokens are kept.
+      LITERT_ASSIGN_OR_RETURN_ABSL(
+          auto logits_buffer,
+          compiled_model_.CreateOutputBuffer(prefill_signature,
+                                             signatures_.output_logits));
+      LITERT_ASSIGN_OR_RETURN_ABSL(auto logits_type,
+                                   logits_buffer.TensorType());
+      if (logits_type.Layout().Dimensions()[1] < prefill_length) {
+        return absl::UnimplementedError(
+            "The prefill signatures of the model do not output the logits of "
+            "all the positions.");
       }
+      const int start_step = current_step_;
+      RETURN_IF_ERROR(PrefillInternal(prefill_signature,
+                                      ids.subspan(/*pos=*/0, prefill_length),
+                                      &logits_buffer));
+      LITERT_ASSIGN_OR_RETURN_ABSL(auto signature_logits,
+                                   CopyFromTensorBuffer<float>(logits_buffer));
+      ASSIGN_OR_RETURN(const int vocab_size, GetVocabSize());
+      logits->insert(logits->end(), signature_logits.begin(),
+                     signature_logits.begin() +
+                         (current_step_ - start_step) * vocab_size);
+    }
+    ids = ids.subspan(/*pos=*/prefill_length);
+  }
+  RET_CHECK_EQ(ids.size(), 0).SetCode(absl::StatusCode::kInternal)
+      << "Work groups not covering the entire prefill input.";
+  return absl::OkStatus();
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::CreatePrefillInputBuffers(
+    absl::string_view prefill_signature) {
+  // Create input_token, positions and attn_mask buffers after determining
+  // the prefill length.
+  if (!signatures_.input_tokens.empty()) {
+    auto tokens_buffer = compiled_model_.CreateInputBuffer(
+        prefill_signature, signatures_.input_tokens);
+    prefill_input_buffers_[signatures_.input_tokens] =
+        std::move(*tokens_buffer);
+  } else {
+    // If input_tokens is empty, we must have input_embeddings.
+    if (!signatures_.input_embeddings.has_value()) {
+      return absl::FailedPreconditionError(
+          "Input tokens or embeddings must be provided.");
+    }
+    if (embedding_lookup_ == nullptr) {
+      return absl::FailedPreconditionError(
+          "Input embeddings required by signature but embedding lookup "
+          "model is not initialized.");
+    }
+    auto embeddings_buffer = compiled_model_.CreateInputBuffer(
+        prefill_signature, signatures_.input_embeddings.value());
+    prefill_input_buffers_[signatures_.input_embeddings.value()] =
+        std::move(*embeddings_buffer);
+
+    // We may have per layer embedding as well.
+    if (signatures_.input_per_layer_embeddings.has_value()) {
       if (embedding_lookup_ == nullptr) {
         return absl::FailedPreconditionError(
-            "Input embeddings required by signature but embedding lookup "
-            "model is not initialized.");
+            "Input per layer embeddings required by signature but embedding "
+            "lookup model is not initialized.");
       }
-      auto embeddings_buffer = compiled_model_.CreateInputBuffer(
-          prefill_signature, signatures_.input_embeddings.value());
-      prefill_input_buffers_[signatures_.input_embeddings.value()] =
-          std::move(*embeddings_buffer);
+      auto per_layer_embeddings_buffer = compiled_model_.CreateInputBuffer(
+          prefill_signature, signatures_.input_per_layer_embeddings.value());
+      prefill_input_buffers_[signatures_.input_per_layer_embeddings.value()] =
+          std::move(*per_layer_embeddings_buffer);
+    }
+  }
+  auto positions_buffer = compiled_model_.CreateInputBuffer(
+      prefill_signature, signatures_.input_positions);
+  prefill_input_buffers_[signatures_.input_positions] =
+      std::move(*positions_buffer);
+  // The attention mask buffer is kept across the calls, see
+  // PrefillAttentionMask.
+  auto attn_mask = prefill_attn_masks_.find(prefill_signature);
+  if (attn_mask == prefill_attn_masks_.end()) {
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto attn_mask_buffer,
+        compiled_model_.CreateInputBuffer(
+            prefill_signature, signatures_.input_attn_mask.value()));
+    attn_mask = prefill_attn_masks_
+                    .emplace(std::string(prefill_signature),
+                             PrefillAttentionMask{std::move(attn_mask_buffer),
+                                                  std::nullopt})
+                    .first;
+  }
+  LITERT_ASSIGN_OR_RETURN_ABSL(auto attn_mask_buffer,
+                               attn_mask->second.buffer.Duplicate());
+  prefill_input_buffers_[signatures_.input_attn_mask.value()] =
+      std::move(attn_mask_buffer);
+  return absl::OkStatus();
+}
 
-      // We may have per layer embedding as well.
-      if (signatures_.input_per_layer_embeddings.has_value()) {
-        if (embedding_lookup_ == nullptr) {
-          return absl::FailedPreconditionError(
-              "Input per layer embeddings required by signature but embedding "
-              "lookup model is not initialized.");
-        }
-        auto per_layer_embeddings_buffer = compiled_model_.CreateInputBuffer(
-            prefill_signature, signatures_.input_per_layer_embeddings.value());
-        prefill_input_buffers_[signatures_.input_per_layer_embeddings.value()] =
-            std::move(*per_layer_embeddings_buffer);
-      }
+absl::Status LlmLiteRtCompiledModelExecutor::UpdateAttentionMask(
+    ::litert::TensorBuffer& mask, std::optional<AttentionMaskManager>& manager,
+    absl::FunctionRef<absl::Status(AttentionMaskManager& manager,
+                                   void* mask_data)>
+        update) {
+  RET_CHECK(signatures_.input_attn_mask_data_type.has_value())
+      << "Attention mask data type is not provided.";
+  if (!manager.has_value()) {
+    LITERT_ASSIGN_OR_RETURN_ABSL(auto mask_tensor_type, mask.TensorType());
+    const auto dimensions = mask_tensor_type.Layout().Dimensions();
+    RET_CHECK_EQ(dimensions.size(), 4)
+            .SetCode(absl::StatusCode::kInvalidArgument)
+        << "Attention mask must be 4D.";
+    manager.emplace(signatures_.input_attn_mask_data_type.value(),
+                    IsCalculationPrecisionF16(),
+                    /*num_rows=*/dimensions[0] * dimensions[1] * dimensions[2],
+                    /*num_columns=*/dimensions[3]);
+  }
+  // On the CPU, the mask buffer is host memory keeping its content between
+  // the calls. Otherwise, locking it for writing may not download its content
+  // first, so it is rewritten in full.
+  if (executor_settings_.GetBackend() != Backend::CPU) {
+    manager->Invalidate();
+  }
+  LITERT_ASSIGN_OR_RETURN_ABSL(
+      auto mask_lock_and_addr,
+      ::litert::TensorBufferScopedLock::Create(mask,
+                                               TensorBuffer::LockMode::kWrite));
+  return update(*manager, mask_lock_and_addr.second);
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::FillPrefillInputTokens(
+    absl::Span<const int> tokens_to_lookup) {
+  if (!signatures_.input_tokens.empty()) {
+    auto& prefill_input_buffer =
+        prefill_input_buffers_[signatures_.input_tokens];
+    LITERT_ASSIGN_OR_RETURN_ABSL(auto prefill_input_size,
+                                 prefill_input_buffer.PackedSize());
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto prefill_input_lock_and_addr,
+        ::litert::TensorBufferScopedLock::Create(
+            prefill_input_buffer, TensorBuffer::LockMode::kWrite));
+    int32_t* prefill_input_ptr =
+        static_cast<int32_t*>(prefill_input_lock_and_addr.second);
+    memset(prefill_input_ptr, 0, prefill_input_size);
+    memcpy(prefill_input_ptr, tokens_to_lookup.data(),
+           tokens_to_lookup.size() * sizeof(int32_t));
+  } else {
+    // If input_tokens is empty, we must have input_embeddings. There is no
+    // need to create input_embeddings_ptr because TensorBuffer locking and
+    // filling is handled by the embedding lookup.
+    TensorBuffer* prefill_input_embeddings_buffer =
+        &(prefill_input_buffers_[signatures_.input_embeddings.value()]);
+    RETURN_IF_ERROR(embedding_lookup_->LookupPrefill(
+        tokens_to_lookup, prefill_input_embeddings_buffer, 0));
+
+    // We may have per layer embedding as well.
+    if (signatures_.input_per_layer_embeddings.has_value()) {
+      TensorBuffer* prefill_input_per_layer_embeddings_buffer =
+          &(prefill_input_buffers_[signatures_.input_per_layer_embeddings
+                                       .value()]);
+      RETURN_IF_ERROR(per_layer_embedding_lookup_->LookupPrefill(
+          tokens_to_lookup, prefill_input_per_layer_embeddings_buffer, 0));
     }
-    auto positions_buffer = compiled_model_.CreateInputBuffer(
-        prefill_signature, signatures_.input_positions);
-    auto attn_mask_buffer = compiled_model_.CreateInputBuffer(
-        prefill_signature, signatures_.input_attn_mask.value());
-    prefill_input_buffers_[signatures_.input_positions] =
-        std::move(*positions_buffer);
-    prefill_input_buffers_[signatures_.input_attn_mask.value()] =
-        std::move(*attn_mask_buffer);
-    RETURN_IF_ERROR(PrefillInternal(prefill_signature,
-                                    ids.subspan(/*pos=*/0, prefill_length)));
-    ids = ids.subspan(/*pos=*/prefill_length);
   }
-  RET_CHECK_EQ(ids.size(), 0).SetCode(absl::StatusCode::kInternal)
-      << "Work groups not covering the entire prefill input.";
   return absl::OkStatus();
 }
 
 absl::Status LlmLiteRtCompiledModelExecutor::PrefillInternal(
-    absl::string_view prefill_signature, Span<const int> ids) {
+    absl::string_view prefill_signature, Span<const int> ids,
+    ::litert::TensorBuffer* output_logits) {
   {
     // Fill the input buffers with scoped locks.
     auto& prefill_input_pos =
@@ -171,14 +585,6 @@ absl::Status LlmLiteRtCompiledModelExecutor::PrefillInternal(
     bool has_input_attn_mask = signatures_.input_attn_mask.has_value();
 
     memset(prefill_input_pos_ptr, 0, prefill_input_pos_size);
-    if (has_input_attn_mask) {
-      RET_CHECK(signatures_.input_attn_mask_data_type.has_value())
-          << "Attention mask data type is not provided.";
-      RETURN_IF_ERROR(InitializeAttentionMask(
-          prefill_input_buffers_[signatures_.input_attn_mask.value()],
-          signatures_.input_attn_mask_data_type.value(),
-          IsCalculationPrecisionF16()));
-    }
     // We will not fill the last token of the current input into the
     // interpreter now. It will be stored in next_input_token_id_ and used in
     // the next prefill or decode.
@@ -201,48 +607,59 @@ absl::Status LlmLiteRtCompiledModelExecutor::PrefillInternal(
       }
       prefill_input_pos_ptr[input_idx] = current_step_;
     }
-    if (!signatures_.input_tokens.empty()) {
-      auto& prefill_input_buffer =
-          prefill_input_buffers_[signatures_.input_tokens];
-      LITERT_ASSIGN_OR_RETURN_ABSL(auto prefill_input_size,
-                                   prefill_input_buffer.PackedSize());
-      LITERT_ASSIGN_OR_RETURN_ABSL(
-          auto prefill_input_lock_and_addr,
-          ::litert::TensorBufferScopedLock::Create(
-              prefill_input_buffer, TensorBuffer::LockMode::kWrite));
-      int32_t* prefill_input_ptr =
-          static_cast<int32_t*>(prefill_input_lock_and_addr.second);
-      memset(prefill_input_ptr, 0, prefill_input_size);
-      memcpy(prefill_input_ptr, tokens_to_lookup.data(),
-             tokens_to_lookup.size() * sizeof(int32_t));
-    } else {
-      // If input_tokens is empty, we must have input_embeddings. There is no
-      // need to create input_embeddings_ptr because TensorBuffer locking and
-      // filling is handled by the embedding lookup.
-      TensorBuffer* prefill_input_embeddings_buffer =
-          &(prefill_input_buffers_[signatures_.input_embeddings.value()]);
-      RETURN_IF_ERROR(embedding_lookup_->LookupPrefill(
-          tokens_to_lookup, prefill_input_embeddings_buffer, 0));
-
-      // We may have per layer embedding as well.
-      if (signatures_.input_per_layer_embeddings.has_value()) {
-        TensorBuffer* prefill_input_per_layer_embeddings_buffer =
-            &(prefill_input_buffers_[signatures_.input_per_layer_embeddings
-                                         .value()]);
-        RETURN_IF_ERROR(per_layer_embedding_lookup_->LookupPrefill(
-            tokens_to_lookup, prefill_input_per_layer_embeddings_buffer, 0));
-      }
-    }
+    processed_tokens_.insert(processed_tokens_.end(), tokens_to_lookup.begin(),
+                             tokens_to_lookup.end());
+    RETURN_IF_ERROR(FillPrefillInputTokens(tokens_to_lookup));
     if (has_input_attn_mask) {
-      RETURN_IF_ERROR(FillAttentionMask(
+      RETURN_IF_ERROR(UpdateAttentionMask(
           prefill_input_buffers_[signatures_.input_attn_mask.value()],
-          start_step,
-          /*steps=*/current_step_ - start_step,
-          signatures_.input_attn_mask_data_type.value()));
+          prefill_attn_masks_[prefill_signature].manager,
+          [&](AttentionMaskManager& manager, void* mask_data) {
+            return manager.UpdateCausal(mask_data, start_step,
+                                        /*steps=*/current_step_ - start_step);
+          }));
     }
   }
   next_input_token_id_ = ids[ids.size() - 1];
 
+  return RunPrefillSignature(prefill_signature, signatures_.output_logits,
+                             output_logits);
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::PrefillPackedInternal(
+    absl::string_view prefill_signature, absl::Span<const int> tokens,
+    int start_step, absl::Span<const int> sequence_starts,
+    absl::string_view output_name, ::litert::TensorBuffer& output_buffer) {
+  {
+    auto& prefill_input_pos =
+        prefill_input_buffers_[signatures_.input_positions];
+    LITERT_ASSIGN_OR_RETURN_ABSL(auto prefill_input_pos_size,
+                                 prefill_input_pos.PackedSize());
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto prefill_input_pos_lock_and_addr,
+        ::litert::TensorBufferScopedLock::Create(
+            prefill_input_pos, TensorBuffer::LockMode::kWrite));
+    auto* prefill_input_pos_ptr =
+        static_cast<int32_t*>(prefill_input_pos_lock_and_addr.second);
+    memset(prefill_input_pos_ptr, 0, prefill_input_pos_size);
+    // The positions go on across the sequences, see PrefillPacked.
+    for (int i = 0; i < tokens.size(); ++i) {
+      prefill_input_pos_ptr[i] = start_step + i;
+    }
+  }
+  RETURN_IF_ERROR(UpdateAttentionMask(
+      prefill_input_buffers_[signatures_.input_attn_mask.value()],
+      prefill_attn_masks_[prefill_signature].manager,
+      [&](AttentionMaskManager& manager, void* mask_data) {
+        return manager.UpdatePacked(mask_data, start_step, sequence_starts);
+      }));
+  RETURN_IF_ERROR(FillPrefillInputTokens(tokens));
+  return RunPrefillSignature(prefill_signature, output_name, &output_buffer);
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::RunPrefillSignature(
+    absl::string_view prefill_signature, absl::string_view output_name,
+    ::litert::TensorBuffer* output_buffer) {
   absl::flat_hash_map<absl::string_view, ::litert::TensorBuffer>
       prefill_input_buffers;
   for (const auto& [input_name, input_buffer] : prefill_input_buffers_) {
@@ -257,16 +674,22 @@ absl::Status LlmLiteRtCompiledModelExecutor::PrefillInternal(
   }
   absl::flat_hash_map<absl::string_view, ::litert::TensorBuffer>
       prefill_output_buffers;
-  for (const auto& [output_name, output_buffer] : prefill_output_buffers_) {
-    auto duplicated_output_buffer = output_buffer.Duplicate();
+  for (const auto& [name, buffer] : prefill_output_buffers_) {
+    auto duplicated_output_buffer = buffer.Duplicate();
     RET_CHECK(duplicated_output_buffer) << "Failed to duplicate output buffer.";
-    prefill_output_buffers[output_name] = std::move(*duplicated_output_buffer);
+    prefill_output_buffers[name] = std::move(*duplicated_output_buffer);
   }
-  for (const auto& [output_name, output_buffer] : *output_kv_cache_buffers_) {
-    auto duplicated_output_buffer = output_buffer.Duplicate();
+  if (output_buffer != nullptr) {
+    // Overrides or adds the output, which may not be in the default outputs.
+    auto duplicated_output_buffer = output_buffer->Duplicate();
     RET_CHECK(duplicated_output_buffer) << "Failed to duplicate output buffer.";
     prefill_output_buffers[output_name] = std::move(*duplicated_output_buffer);
   }
+  for (const auto& [name, buffer] : *output_kv_cache_buffers_) {
+    auto duplicated_output_buffer = buffer.Duplicate();
+    RET_CHECK(duplicated_output_buffer) << "Failed to duplicate output buffer.";
+    prefill_output_buffers[name] = std::move(*duplicated_output_buffer);
+  }
 
   auto res = compiled_model_.Run(prefill_signature, prefill_input_buffers,
                                  prefill_output_buffers);
@@ -363,16 +786,13 @@ absl::Status LlmLiteRtCompiledModelExecutor::Decode(
         static_cast<int32_t*>(decode_input_pos_lock_and_addr->second);
     bool has_input_attn_mask = signatures_.input_attn_mask.has_value();
     if (has_input_attn_mask) {
-      RET_CHECK(signatures_.input_attn_mask_data_type.has_value())
-          << "Attention mask data type is not provided.";
-      RETURN_IF_ERROR(InitializeAttentionMask(
-          decode_input_buffers_[signatures_.input_attn_mask.value()],
-          signatures_.input_attn_mask_data_type.value(),
-          IsCalculationPrecisionF16()));
-      RETURN_IF_ERROR(FillAttentionMask(
+      RETURN_IF_ERROR(UpdateAttentionMask(
           decode_input_buffers_[signatures_.input_attn_mask.value()],
-          current_step_, /*steps=*/1,
-          signatures_.input_attn_mask_data_type.value()));
+          decode_attn_mask_manager_,
+          [&](AttentionMaskManager& manager, void* mask_data) {
+            return manager.UpdateCausal(mask_data, current_step_,
+                                        /*steps=*/1);
+          }));
     }
     decode_input_pos_ptr[0] = current_step_;
   }
@@ -409,6 +829,7 @@ absl::Status LlmLiteRtCompiledModelExecutor::Decode(
   RET_CHECK(res) << "Failed to run compiled model: " << res.Error().Message();
   std::swap(input_kv_cache_buffers_, output_kv_cache_buffers_);
 
+  processed_tokens_.push_back(id);
   ++current_step_;
   return absl::OkStatus();
 }
@@ -480,16 +901,13 @@ LlmLiteRtCompiledModelExecutor::DecodeLogits(const ExecutorInputs& inputs) {
         static_cast<int32_t*>(decode_input_pos_lock_and_addr->second);
     bool has_input_attn_mask = signatures_.input_attn_mask.has_value();
     if (has_input_attn_mask) {
-      RET_CHECK(signatures_.input_attn_mask_data_type.has_value())
-          << "Attention mask data type is not provided.";
-      RETURN_IF_ERROR(InitializeAttentionMask(
-          decode_input_buffers_[signatures_.input_attn_mask.value()],
-          signatures_.input_attn_mask_data_type.value(),
-          IsCalculationPrecisionF16()));
-      RETURN_IF_ERROR(FillAttentionMask(
+      RETURN_IF_ERROR(UpdateAttentionMask(
           decode_input_buffers_[signatures_.input_attn_mask.value()],
-          current_step_, /*steps=*/1,
-          signatures_.input_attn_mask_data_type.value()));
+          decode_attn_mask_manager_,
+          [&](AttentionMaskManager& manager, void* mask_data) {
+            return manager.UpdateCausal(mask_data, current_step_,
+                                        /*steps=*/1);
+          }));
     }
     decode_input_pos_ptr[0] = current_step_;
   }
@@ -524,6 +942,7 @@ LlmLiteRtCompiledModelExecutor::DecodeLogits(const ExecutorInputs& inputs) {
   RET_CHECK(res) << "Failed to run compiled model: " << res.Error().Message();
   std::swap(input_kv_cache_buffers_, output_kv_cache_buffers_);
 
+  processed_tokens_.push_back(id);
   ++current_step_;
   auto output_logits =
       decode_output_buffers[signatures_.output_logits].Duplicate();
@@ -569,10 +988,300 @@ absl::Status LlmLiteRtCompiledModelExecutor::Reset() {
   current_step_ = 0;
   next_input_token_id_ = -1;
   processed_tokens_.clear();
-  sampler_.reset();
+  // The sampler is kept: its parameters are the same for all the sessions,
+  // and creating it again, e.g. loading the GPU sampler library, would be
+  // paid by every new session.
+  return absl::OkStatus();
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::RewindTo(int step) {
+  ASSIGN_OR_RETURN(const int current_step, GetCurrentStep());
+  if (step < 0 || step > current_step) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot rewind to step ", step,
+                     ", the current step is ", current_step, "."));
+  }
+  if (step == current_step &&
+      (step == 0 || next_input_token_id_ != -1)) {
+    return absl::OkStatus();
+  }
+  RET_CHECK_EQ(processed_tokens_.size(), current_step_);
+  if (step == 0) {
+    current_step_ = 0;
+    next_input_token_id_ = -1;
+    processed_tokens_.clear();
+    return absl::OkStatus();
+  }
+  // Keep the last remaining token pending, the same state as right after a
+  // prefill ending with it. Its KV cache entry is recomputed by the next
+  // prefill/decode.
+  current_step_ = step - 1;
+  next_input_token_id_ = processed_tokens_[current_step_];
+  processed_tokens_.resize(current_step_);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<absl::Span<uint8_t>>>
+LlmLiteRtCompiledModelExecutor::GetKvCacheBytes() {
+  std::vector<absl::Span<uint8_t>> kv_cache_bytes;
+  kv_cache_bytes.reserve(kv_cache_names_.size());
+  for (absl::string_view name : kv_cache_names_) {
+    auto it = input_kv_cache_buffers_->find(name);
+    RET_CHECK(it != input_kv_cache_buffers_->end())
+        << "KV cache buffer " << name << " not found.";
+    TensorBuffer& buffer = it->second;
+    LITERT_ASSIGN_OR_RETURN_ABSL(auto size, buffer.PackedSize());
+    LITERT_ASSIGN_OR_RETURN_ABSL(
+        auto lock_and_addr, ::litert::TensorBufferScopedLock::Create(
+                                buffer, TensorBuffer::LockMode::kReadWrite));
+    kv_cache_bytes.push_back(
+        absl::MakeSpan(static_cast<uint8_t*>(lock_and_addr.second), size));
+  }
+  return kv_cache_bytes;
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::SaveActiveSequence() {
+  SequenceState& state = sequences_.at(*active_sequence_id_);
+  ASSIGN_OR_RETURN(absl::Span<const int> saved_token_ids,
+                   paged_kv_cache_->GetTokenIds(state.paged_sequence_id));
+  // The KV cache entry of a token only depends on the tokens up to it, so the
+  // saved entries of the common prefix are still valid, e.g. after a rewind.
+  RET_CHECK_EQ(processed_tokens_.size(), current_step_);
+  const int max_common_length =
+      std::min(saved_token_ids.size(), processed_tokens_.size());
+  const int common_length =
+      std::mismatch(saved_token_ids.begin(),
+                    saved_token_ids.begin() + max_common_length,
+                    processed_tokens_.begin())
+          .first -
+      saved_token_ids.begin();
+  RETURN_IF_ERROR(
+      paged_kv_cache_->Truncate(state.paged_sequence_id, common_length));
+  // The blocks are accounted before they are allocated, so that saving a
+  // sequence past the memory budget fails instead of allocating them.
+  const size_t num_blocks =
+      (processed_tokens_.size() + paged_kv_cache_->GetBlockSize() - 1) /
+      paged_kv_cache_->GetBlockSize();
+  RETURN_IF_ERROR(state.memory_reservation.Resize(
+      num_blocks * paged_kv_cache_->GetBlockSizeInBytes()));
+  ASSIGN_OR_RETURN(std::vector<absl::Span<uint8_t>> kv_cache_bytes,
+                   GetKvCacheBytes());
+  const std::vector<absl::Span<const uint8_t>> const_kv_cache_bytes(
+      kv_cache_bytes.begin(), kv_cache_bytes.end());
+  RETURN_IF_ERROR(paged_kv_cache_->Scatter(
+      state.paged_sequence_id, common_length,
+      absl::MakeConstSpan(processed_tokens_).subspan(common_length),
+      const_kv_cache_bytes));
+  state.next_input_token_id = next_input_token_id_;
+  return absl::OkStatus();
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::LoadSequence(int sequence_id) {
+  auto it = sequences_.find(sequence_id);
+  if (it == sequences_.end()) {
+    SequenceState& state = sequences_[sequence_id];
+    state.paged_sequence_id = paged_kv_cache_->CreateSequence();
+    if (memory_tracker_ != nullptr) {
+      state.memory_reservation =
+          memory_tracker_->Track(absl::StrCat("sequence_", sequence_id),
+                                 MemoryComponent::kKvCache, /*bytes=*/0);
+    }
+    active_sequence_id_ = sequence_id;
+    return Reset();
+  }
+  ASSIGN_OR_RETURN(std::vector<absl::Span<uint8_t>> kv_cache_bytes,
+                   GetKvCacheBytes());
+  RETURN_IF_ERROR(
+      paged_kv_cache_->Gather(it->second.paged_sequence_id, kv_cache_bytes));
+  ASSIGN_OR_RETURN(absl::Span<const int> token_ids,
+                   paged_kv_cache_->GetTokenIds(it->second.paged_sequence_id));
+  processed_tokens_.assign(token_ids.begin(), token_ids.end());
+  current_step_ = processed_tokens_.size();
+  next_input_token_id_ = it->second.next_input_token_id;
+  active_sequence_id_ = sequence_id;
+  return absl::OkStatus();
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::SetActiveSequence(
+    int sequence_id) {
+  if (paged_kv_cache_ == nullptr) {
+    return absl::UnimplementedError(
+        "SetActiveSequence is only implemented on CPU, for the KV cache "
+        "layouts with a single token dimension.");
+  }
+  if (active_sequence_id_ == sequence_id) {
+    return absl::OkStatus();
+  }
+  if (active_sequence_id_.has_value()) {
+    RETURN_IF_ERROR(SaveActiveSequence());
+  }
+  return LoadSequence(sequence_id);
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::ReleaseSequence(
+    int sequence_id) {
+  if (paged_kv_cache_ == nullptr) {
+    return absl::UnimplementedError(
+        "ReleaseSequence is only implemented on CPU, for the KV cache "
+        "layouts with a single token dimension.");
+  }
+  auto it = sequences_.find(sequence_id);
+  if (it == sequences_.end()) {
+    return absl::OkStatus();
+  }
+  if (active_sequence_id_ == sequence_id) {
+    active_sequence_id_ = std::nullopt;
+    RETURN_IF_ERROR(Reset());
+  }
+  RETURN_IF_ERROR(
+      paged_kv_cache_->ReleaseSequence(it->second.paged_sequence_id));
+  sequences_.erase(it);
+  paged_kv_cache_->ReleaseFreeBlocks();
+  return absl::OkStatus();
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::InitializeBaseLoRA() {
+  auto zero_lora_inputs =
+      [](absl::flat_hash_map<absl::string_view, TensorBuffer>& input_buffers,
+         absl::flat_hash_map<absl::string_view, TensorBuffer>& base_buffers)
+      -> absl::Status {
+    for (auto& [input_name, input_buffer] : input_buffers) {
+      if (!absl::StartsWith(input_name, kLoRAInputPrefix)) {
+        continue;
+      }
+      RETURN_IF_ERROR(FillLoRABuffer(input_name, /*weights=*/{}, input_buffer));
+      auto duplicated_buffer = input_buffer.Duplicate();
+      RET_CHECK(duplicated_buffer) << "Failed to duplicate LoRA buffer.";
+      base_buffers[input_name] = std::move(*duplicated_buffer);
+    }
+    return absl::OkStatus();
+  };
+  RETURN_IF_ERROR(
+      zero_lora_inputs(prefill_input_buffers_, base_lora_buffers_.prefill));
+  return zero_lora_inputs(decode_input_buffers_, base_lora_buffers_.decode);
+}
+
+absl::Status LlmLiteRtCompiledModelExecutor::LoadLoRA(
+    absl::string_view name, const ModelAssets& model_assets) {
+  if (name.empty()) {
+    return absl::InvalidArgumentError("The LoRA name must not be empty.");
+  }
+  if (lora_buffers_.contains(name)) {
+    return absl::AlreadyExistsError(
+        absl::StrCat("LoRA ", name, " is already loaded."));
+  }
+  if (base_lora_buffers_.prefill.empty() && base_lora_buffers_.decode.empty()) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "The model has no LoRA inputs (", kLoRAInputPrefix, "*)."));
+  }
+  ASSIGN_OR_RETURN(auto resources,
+                   BuildLiteRtCompiledModelResources(model_assets));
+  ASSIGN_OR_RETURN(const ::litert::Model* lora_model,
+                   resources->GetTFLiteModel(ModelType::kTfLiteLoRA));
+  ASSIGN_OR_RETURN(auto adapter, LoRAAdapter::CreateFromModel(*lora_model));
+
+  // Each adapter gets its own buffers, so that switching adapters does not
+  // copy the weights.
+  auto create_lora_buffers =
+      [&](absl::string_view signature,
+          const absl::flat_hash_map<absl::string_view, TensorBuffer>&
+              base_buffers,
+          absl::flat_hash_map<absl::string_view, TensorBuffer>& lora_buffers)
+      -> absl::Status {
+    for (const auto& [input_name, base_buffer] : base_buffers) {
+      ASSIGN_OR_RETURN(auto weights, adapter->GetWeights(input_name));
+      auto lora_buffer =
+          compiled_model_.CreateInputBuffer(signature, input_name);
+      RET_CHECK(lora_buffer) << "Failed to create LoRA buffer for "
+                             << input_name << ": "
+                             << lora_buffer.Error().Message();
+      RETURN_IF_ERROR(FillLoRABuffer(input_name, weights, *lora_buffer));
+      lora_buffers[input_name] = std::move(*lora_buffer);
+    }
+    return absl::OkStatus();
+  };
+  LoRABuffers buffers;
+  // The prefill signatures share the buffers of their common inputs.
+  RETURN_IF_ERROR(create_lora_buffers(prefill_signature_map_.begin()->second,
+                                      base_lora_buffers_.prefill,
+                                      buffers.prefill));
+  RETURN_IF_ERROR(create_lora_buffers(kDecodeSignatureRunner,
+                                      base_lora_buffers_.decode,
+                                      buffers.decode));
+
+  absl::flat_hash_set<absl::string_view> lora_inputs;
+  for (const auto& [input_name, buffer] : buffers.prefill) {
+    lora_inputs.insert(input_name);
+  }
+  for (const auto& [input_name, buffer] : buffers.decode) {
+    lora_inputs.insert(input_name);
+  }
+  if (adapter->NumInputs() != lora_inputs.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "LoRA ", name, " has weights for ", adapter->NumInputs(),
+        " inputs, but the model has ", lora_inputs.size(), " LoRA inputs."));
+  }
+  lora_buffers_.emplace(name, std::move(buffers));
+  ABSL_LOG(INFO) << "Loaded LoRA " << name << " for " << lora_inputs.size()
+                 << " inputs.";
   return absl::OkStatus();
 }
 
+absl::Status LlmLiteRtCompiledModelExecutor::SetActiveLoRA(
+    std::optional<absl::string_view> name) {
+  if (name == active_lora_) {
+    return absl::OkStatus();
+  }
+  const LoRABuffers* buffers = &base_lora_buffers_;
+  if (name.has_value()) {
+    auto it = lora_buffers_.find(*name);
+    if (it == lora_buffers_.end()) {
+      return absl::NotFoundError(
+          absl::StrCat("LoRA ", *name, " is not loaded."));
+    }
+    buffers = &it->second;
+  }
+  RETURN_IF_ERROR(SwapInLoRABuffers(buffers->prefill, prefill_input_buffers_));
+  RETURN_IF_ERROR(SwapInLoRABuffers(buffers->decode, decode_input_buffers_));
+  active_lora_ = name.has_value() ? std::make_optional(std::string(*name))
+                                  : std::nullopt;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<absl::flat_hash_map<MemoryComponent, size_t>>
+LlmLiteRtCompiledModelExecutor::GetMemoryUsage() const {
+  auto get_bytes =
+      [](const absl::flat_hash_map<absl::string_view, TensorBuffer>& buffers)
+      -> absl::StatusOr<size_t> {
+    size_t bytes = 0;
+    for (const auto& [name, buffer] : buffers) {
+      LITERT_ASSIGN_OR_RETURN_ABSL(auto size, buffer.PackedSize());
+      bytes += size;
+    }
+    return bytes;
+  };
+
+  absl::flat_hash_map<MemoryComponent, size_t> usage;
+  ASSIGN_OR_RETURN(usage[MemoryComponent::kKvCache],
+                   get_bytes(kv_cache_buffers_1_));
+  // On CPU, the output KV cache buffers are duplicates of the input ones,
+  // i.e. they share their memory.
+  if (executor_settings_.GetBackend() != Backend::CPU) {
+    ASSIGN_OR_RETURN(size_t output_kv_cache_bytes,
+                     get_bytes(kv_cache_buffers_2_));
+    usage[MemoryComponent::kKvCache] += output_kv_cache_bytes;
+  }
+  size_t activation_bytes = 0;
+  for (const auto* buffers :
+       {&prefill_input_buffers_, &prefill_output_buffers_,
+        &decode_input_buffers_, &decode_output_buffers_}) {
+    ASSIGN_OR_RETURN(size_t bytes, get_bytes(*buffers));
+    activation_bytes += bytes;
+  }
+  usage[MemoryComponent::kActivations] = activation_bytes;
+  return usage;
+}
+
 absl::StatusOr<int> LlmLiteRtCompiledModelExecutor::GetVocabSize() {
   if (!decode_output_buffers_.contains(signatures_.output_logits)) {
     return absl::NotFoundError("Output logits info not found.");
@@ -597,6 +1306,7 @@ LlmLiteRtCompiledModelExecutor::Create(LlmExecutorSettings executor_settings,
   // TODO(b/405424188): - Add support for NPU backends.
   auto compilation_options = ::litert::Options::Create();
   std::string weight_cache_path = executor_settings.GetCacheDir();
+  std::unique_ptr<WeightCacheManager> weight_cache;
   const Backend backend = executor_settings.GetBackend();
   switch (backend) {
     case Backend::GPU: {
@@ -632,6 +1342,10 @@ LlmLiteRtCompiledModelExecutor::Create(LlmExecutorSettings executor_settings,
       // This option prevents KVCache handling from being affected by
       // NoExternalTensorsMode.
       gpu_compilation_options.AddExternalTensorPattern("kv_cache_");
+      // The same for the LoRA inputs, whose buffers are swapped when the
+      // active adapter changes.
+      gpu_compilation_options.AddExternalTensorPattern(
+          kLoRAInputPrefix.data());
       compilation_options->AddOpaqueOptions(std::move(gpu_compilation_options));
       compilation_options->SetHardwareAccelerators(kLiteRtHwAcceleratorGpu);
       break;
@@ -645,12 +1359,12 @@ LlmLiteRtCompiledModelExecutor::Create(LlmExecutorSettings executor_settings,
       if (weight_cache_path != ":nocache") {
         ASSIGN_OR_RETURN(auto model_path,
                          executor_settings.GetModelAssets().GetPath());
-        if (weight_cache_path.empty()) {
-          weight_cache_path = absl::StrCat(model_path, ".xnnpack_cache");
-        } else {
-          ASSIGN_OR_RETURN(weight_cache_path,
-                           JoinPath(weight_cache_path, Basename(model_path)));
-        }
+        ASSIGN_OR_RETURN(weight_cache,
+                         WeightCacheManager::Open(weight_cache_path,
+                                                  model_path, num_threads));
+        // On a hit, XNNPack maps the packed weights from the published cache
+        // instead of packing them again.
+        weight_cache_path = weight_cache->GetBackendCachePath();
         cpu_compilation_options->SetXNNPackWeightCachePath(
             weight_cache_path.c_str());
       }
@@ -677,12 +1391,25 @@ LlmLiteRtCompiledModelExecutor::Create(LlmExecutorSettings executor_settings,
   if (!litert_model || !*litert_model) {
     return absl::InternalError("Failed to build LiteRt model");
   }
+  const absl::Time compilation_start = absl::Now();
   auto compiled_model = ::litert::CompiledModel::Create(
       *lrt_env, *litert_model, std::move(*compilation_options));
   if (!compiled_model) {
     return absl::InternalError(absl::StrCat("Failed to create compiled model: ",
                                             compiled_model.Error().Message()));
   }
+  std::optional<WeightCacheStats> weight_cache_stats;
+  if (weight_cache != nullptr) {
+    // The model is compiled at this point, so failing to publish the cache
+    // only costs the next start its warm start.
+    auto stats = weight_cache->Commit(absl::Now() - compilation_start);
+    if (stats.ok()) {
+      weight_cache_stats = *stats;
+    } else {
+      ABSL_LOG(WARNING) << "Failed to publish the weight cache: "
+                        << stats.status();
+    }
+  }
 
   absl::flat_hash_map<absl::string_view, TensorBuffer> prefill_input_buffers;
   absl::flat_hash_map<absl::string_view, TensorBuffer> prefill_output_buffers;
@@ -713,6 +1440,12 @@ LlmLiteRtCompiledModelExecutor::Create(LlmExecutorSettings executor_settings,
       GetModelSignaturesFromInputOutputNames(decode_signature->InputNames(),
                                              decode_signature->OutputNames()));
 
+  for (auto output_name : prefill_signature->OutputNames()) {
+    if (output_name == kOutputHiddenStates) {
+      signatures.output_hidden_states = std::string(output_name);
+    }
+  }
+
   for (auto input_name : prefill_signature->InputNames()) {
     // Skip creating buffers for the input tokens, positions and attn mask. Move
     // into prefill function to create them based on the ids size.
@@ -822,7 +1555,7 @@ LlmLiteRtCompiledModelExecutor::Create(LlmExecutorSettings executor_settings,
                      EmbeddingLookupText::Create(*per_layer_embedder_model));
   }
 
-  return absl::WrapUnique(new LlmLiteRtCompiledModelExecutor(
+  auto executor = absl::WrapUnique(new LlmLiteRtCompiledModelExecutor(
       std::move(executor_settings), std::move(*lrt_env), litert_model,
       std::move(*compiled_model), std::move(prefill_input_buffers),
       std::move(prefill_output_buffers), std::move(decode_input_buffers),
@@ -830,6 +1563,30 @@ LlmLiteRtCompiledModelExecutor::Create(LlmExecutorSettings executor_settings,
       std::move(output_kv_cache_buffers), std::move(prefill_runner_set),
       signatures, batch_size, weight_cache_path, std::move(embedding_lookup),
       std::move(per_layer_embedding_lookup)));
+  executor->weight_cache_stats_ = weight_cache_stats;
+  if (backend == Backend::CPU) {
+    // The KV cache length is the number of columns of the attention mask, or
+    // max_num_tokens for the models without one.
+    int kv_cache_length = executor->executor_settings_.GetMaxNumTokens();
+    if (signatures.input_attn_mask.has_value()) {
+      LITERT_ASSIGN_OR_RETURN_ABSL(
+          auto mask_type,
+          executor->decode_input_buffers_[*signatures.input_attn_mask]
+              .TensorType());
+      kv_cache_length = mask_type.Layout().Dimensions().back();
+    }
+    auto paged_kv_cache = CreatePagedKvCache(
+        executor->kv_cache_buffers_1_, kv_cache_length,
+        executor->kv_cache_names_);
+    if (paged_kv_cache.ok()) {
+      executor->paged_kv_cache_ = std::move(*paged_kv_cache);
+    } else {
+      ABSL_LOG(INFO) << "The sequences of the executor are not paged: "
+                     << paged_kv_cache.status();
+    }
+  }
+  RETURN_IF_ERROR(executor->InitializeBaseLoRA());
+  return executor;
 }
 
 }  // namespace litert::lm
@@ -15,13 +15,16 @@
 #ifndef THIRD_PARTY_ODML_INFRA_GENAI_INFERENCE_EXECUTOR_LLM_TFLITE_GPU_EXECUTOR_H_
 #define THIRD_PARTY_ODML_INFRA_GENAI_INFERENCE_EXECUTOR_LLM_TFLITE_GPU_EXECUTOR_H_
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/nullability.h"  // from @com_google_absl
 #include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/functional/function_ref.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
@@ -34,10 +37,15 @@
 #include "runtime/components/embedding_lookup_text.h"
 #include "runtime/components/model_resources.h"
 #include "runtime/components/sampler.h"
+#include "runtime/executor/attention_mask_manager.h"
+#include "runtime/executor/executor_settings_base.h"
 #include "runtime/executor/litert_compiled_model_executor_utils.h"
 #include "runtime/executor/llm_executor.h"
 #include "runtime/executor/llm_executor_io_types.h"
 #include "runtime/executor/llm_executor_settings.h"
+#include "runtime/executor/paged_kv_cache.h"
+#include "runtime/executor/weight_cache_manager.h"
+#include "runtime/util/memory_tracker.h"
 
 namespace litert::lm {
 
@@ -79,6 +87,29 @@ class LlmLiteRtCompiledModelExecutor : public LlmExecutor {
   absl::StatusOr<::litert::TensorBuffer> DecodeLogits(
       const ExecutorInputs& inputs) override;
 
+  // Runs the prefill like Prefill, with the logits output of the prefill
+  // signatures kept for the positions filled with tokens. It fails with
+  // Unimplemented if the prefill signatures have no logits output.
+  absl::StatusOr<::litert::TensorBuffer> PrefillLogits(
+      const ExecutorInputs& inputs) override;
+
+  // Packs the sequences into the largest prefill signature, each attending
+  // only to its own tokens through the attention mask, and keeps the hidden
+  // states output of the prefill signatures. It fails with Unimplemented if
+  // the model has no "hidden_states" prefill output or no attention mask
+  // input. See PrefillPacked.
+  absl::Status PrefillHiddenStates(
+      const std::vector<std::vector<int>>& sequences,
+      absl::FunctionRef<absl::Status(int index,
+                                     absl::Span<const float> hidden_states)>
+          consumer) override;
+
+  // Packs the sequences like PrefillHiddenStates, and keeps the logits output
+  // of the last position of each sequence. It fails with Unimplemented if the
+  // prefill signatures do not output the logits of all the positions.
+  absl::StatusOr<::litert::TensorBuffer> PrefillLastLogits(
+      const std::vector<std::vector<int>>& sequences) override;
+
   absl::string_view ExecutorBackendName() const override {
     return "LiteRT Compiled Model";
   }
@@ -88,6 +119,17 @@ class LlmLiteRtCompiledModelExecutor : public LlmExecutor {
     return executor_settings_;
   }
 
+  // Gets the memory of the KV cache and of the other input and output buffers
+  // of the prefill and decode signatures.
+  absl::StatusOr<absl::flat_hash_map<MemoryComponent, size_t>> GetMemoryUsage()
+      const override;
+
+  // Accounts the blocks of the paged KV cache holding each saved sequence to
+  // `tracker`, as the KV cache of "sequence_<id>".
+  void SetMemoryTracker(MemoryTracker* tracker) override {
+    memory_tracker_ = tracker;
+  }
+
   // Gets the current step of the executor.
   // Public API, the return value is the current step that user expects (e.g.
   // users prefill 100 tokens, then they expect the current step to be 100). It
@@ -99,8 +141,44 @@ class LlmLiteRtCompiledModelExecutor : public LlmExecutor {
   // Resets all of the internal states.
   absl::Status Reset() override;
 
+  // Rewinds the executor to the given public step. The KV cache buffers are
+  // left untouched: the entries past the new step are masked out by the
+  // attention mask, which is rebuilt from the current step on every call, and
+  // overwritten by the following prefill/decode.
+  // The last remaining token is left pending, like right after a prefill
+  // ending with it, even if no token is dropped.
+  absl::Status RewindTo(int step) override;
+
   absl::StatusOr<int> GetVocabSize() override;
 
+  // Loads the LoRA adapter as `name`. Its weights are copied once into
+  // buffers fed to the LoRA inputs (named kLoRAInputPrefix*) of the model.
+  absl::Status LoadLoRA(absl::string_view name,
+                        const ModelAssets& model_assets) override;
+
+  // Swaps the buffers fed to the LoRA inputs for the ones of the adapter
+  // `name`, or for the zero buffers of the base model. Neither the model is
+  // recompiled nor the weights are copied.
+  absl::Status SetActiveLoRA(std::optional<absl::string_view> name) override;
+
+  // Saves the active sequence into the blocks of the paged KV cache, only
+  // copying its tokens added since it was last saved, and gathers the blocks
+  // of `sequence_id` back into the KV cache buffers. This way, the KV cache of
+  // each sequence only holds the memory of its tokens, while a single set of
+  // KV cache buffers of max_num_tokens is fed to the model. It is only
+  // implemented on CPU.
+  absl::Status SetActiveSequence(int sequence_id) override;
+
+  // Releases the blocks of the sequence in the paged KV cache, and their
+  // memory in the tracker.
+  absl::Status ReleaseSequence(int sequence_id) override;
+
+  // Returns whether the XNNPack weight cache was hit and the time it saved,
+  // or nullopt if the weight cache is not used (e.g. on GPU or when disabled).
+  const std::optional<WeightCacheStats>& GetWeightCacheStats() const {
+    return weight_cache_stats_;
+  }
+
  protected:
   LlmLiteRtCompiledModelExecutor(
       LlmExecutorSettings executor_settings, ::litert::Environment env,
@@ -146,15 +224,94 @@ class LlmLiteRtCompiledModelExecutor : public LlmExecutor {
   absl::Status SampleLogits(const TensorBuffer& logits,
                             TensorBuffer& ids_tensor);
 
+  // Prefills the ids with the prefill signatures covering them. If `logits`
+  // is set, the logits of the positions filled with tokens are appended to
+  // it.
+  absl::Status PrefillTokens(absl::Span<const int> ids,
+                             const ExecutorPrefillParams& params,
+                             std::vector<float>* absl_nullable logits);
+
+  // Creates the prefill input buffers whose shape depends on the prefill
+  // signature, i.e. the tokens (or embeddings), positions and attention mask.
+  absl::Status CreatePrefillInputBuffers(absl::string_view prefill_signature);
+
+  // Locks the attention mask buffer `mask` for writing and calls `update`
+  // with its content and `manager`, which is created on the first call.
+  absl::Status UpdateAttentionMask(
+      ::litert::TensorBuffer& mask,
+      std::optional<AttentionMaskManager>& manager,
+      absl::FunctionRef<absl::Status(AttentionMaskManager& manager,
+                                     void* mask_data)>
+          update);
+
+  // Fills the tokens input of the prefill, or looks up their embeddings.
+  absl::Status FillPrefillInputTokens(absl::Span<const int> tokens_to_lookup);
+
   // Prefill internal implementation, for one prefill call to the Interpreter
-  // with a certain length.
-  absl::Status PrefillInternal(absl::string_view prefill_signature,
-                               absl::Span<const int> ids);
+  // with a certain length. If `output_logits` is set, it receives the logits
+  // output of the signature.
+  absl::Status PrefillInternal(
+      absl::string_view prefill_signature, absl::Span<const int> ids,
+      ::litert::TensorBuffer* absl_nullable output_logits = nullptr);
+
+  // Prefills independent sequences packed together from the current step,
+  // without adding them to the sequence of the executor. The sequences are
+  // grouped to fill the largest prefill signature, and each group is split
+  // into prefill calls with GetOptimizedPrefillWorkGroups. Their positions go
+  // on across the sequences rather than restarting, since a position is also
+  // the KV cache entry written; this is harmless with the relative position
+  // embeddings (RoPE) of the supported models.
+  // `consumer` is called with the index of each sequence and the rows of the
+  // output `output_name` of its positions, or only of its last position if
+  // `last_position_only`.
+  absl::Status PrefillPacked(
+      const std::vector<std::vector<int>>& sequences,
+      absl::string_view output_name, bool last_position_only,
+      absl::FunctionRef<absl::Status(int index, absl::Span<const float> rows)>
+          consumer);
+
+  // Runs one prefill call of PrefillPacked from `start_step`, where
+  // `sequence_starts` holds the first step of the sequence of each token.
+  // `output_buffer` receives the output `output_name` of the signature.
+  absl::Status PrefillPackedInternal(
+      absl::string_view prefill_signature, absl::Span<const int> tokens,
+      int start_step, absl::Span<const int> sequence_starts,
+      absl::string_view output_name, ::litert::TensorBuffer& output_buffer);
+
+  // Runs the prefill signature on the prefill input buffers and the KV cache,
+  // then swaps the KV cache buffers. If `output_buffer` is set, it receives
+  // the output `output_name` of the signature.
+  absl::Status RunPrefillSignature(
+      absl::string_view prefill_signature, absl::string_view output_name,
+      ::litert::TensorBuffer* absl_nullable output_buffer);
 
   // Decode internal implementation, without result downloading.
   // Caller of this function is responsible for capturing the output.
   absl::Status DecodeInternal(ExecutorInputs inputs);
 
+  // The buffers fed to the LoRA inputs of the prefill and decode signatures.
+  struct LoRABuffers {
+    absl::flat_hash_map<absl::string_view, ::litert::TensorBuffer> prefill;
+    absl::flat_hash_map<absl::string_view, ::litert::TensorBuffer> decode;
+  };
+
+  // Zeroes the LoRA input buffers, so that the base model runs until an
+  // adapter is selected, and keeps them as base_lora_buffers_.
+  absl::Status InitializeBaseLoRA();
+
+  // Returns the bytes of the KV cache buffers, in the order of
+  // kv_cache_names_. The buffers are in the host memory on CPU, so their
+  // addresses stay valid once unlocked.
+  absl::StatusOr<std::vector<absl::Span<uint8_t>>> GetKvCacheBytes();
+
+  // Copies the tokens of the active sequence added since it was last saved
+  // from the KV cache buffers into its blocks.
+  absl::Status SaveActiveSequence();
+
+  // Restores the tokens and KV cache of `sequence_id` from its blocks, or
+  // empties the executor for a new sequence, and makes it active.
+  absl::Status LoadSequence(int sequence_id);
+
   LlmExecutorSettings executor_settings_;
   ::litert::Environment env_;
   const ::litert::Model& model_;
@@ -178,6 +335,16 @@ class LlmLiteRtCompiledModelExecutor : public LlmExecutor {
 
   SortedPrefillSignatureMap prefill_signature_map_;
 
+  // The attention mask of a prefill signature, kept across the prefill calls
+  // so that only the entries changed since the last call are written.
+  struct PrefillAttentionMask {
+    ::litert::TensorBuffer buffer;
+    std::optional<AttentionMaskManager> manager;
+  };
+  absl::flat_hash_map<std::string, PrefillAttentionMask> prefill_attn_masks_;
+  // The manager of the attention mask buffer of the decode signature.
+  std::optional<AttentionMaskManager> decode_attn_mask_manager_;
+
   // The signatures of the model.
   ModelSignatures signatures_;
 
@@ -196,8 +363,9 @@ class LlmLiteRtCompiledModelExecutor : public LlmExecutor {
   // Internal timestep.
   int current_step_ = 0;
 
-  // TODO: b/404625243 - To be implemented.
-  // The processed tokens.
+  // The token ids whose KV cache entries have been computed, i.e. the token id
+  // at each step before current_step_. It is used to restore
+  // next_input_token_id_ when rewinding.
   std::vector<int> processed_tokens_;
 
   // The token served as the first input token to the model for next Prefill or
@@ -216,6 +384,37 @@ class LlmLiteRtCompiledModelExecutor : public LlmExecutor {
   // this path to maintain the path lifecycle.
   std::string weight_cache_path_;
 
+  // The outcome of the XNNPack weight cache, if used.
+  std::optional<WeightCacheStats> weight_cache_stats_;
+
+  // The LoRA input buffers of the base model (zeros) and of the loaded
+  // adapters, by name. Empty if the model has no LoRA inputs.
+  LoRABuffers base_lora_buffers_;
+  absl::flat_hash_map<std::string, LoRABuffers> lora_buffers_;
+  // The selected adapter, or nullopt for the base model.
+  std::optional<std::string> active_lora_;
+
+  // The KV caches of the sequences, e.g. of the sessions sharing the
+  // executor, in blocks allocated as they grow. Null if unsupported, e.g. on
+  // GPU. The active sequence is computed in the KV cache buffers, and only
+  // copied into its blocks when another sequence is activated.
+  std::unique_ptr<PagedKvCache> paged_kv_cache_;
+  // The names of the KV cache buffers, in the order of the tensor layouts of
+  // paged_kv_cache_.
+  std::vector<absl::string_view> kv_cache_names_;
+  // The saved state of a sequence.
+  struct SequenceState {
+    PagedKvCache::SequenceId paged_sequence_id;
+    int next_input_token_id = -1;
+    // The memory of the blocks of the sequence, if there is a tracker.
+    MemoryReservation memory_reservation;
+  };
+  absl::flat_hash_map<int, SequenceState> sequences_;
+  // The sequence whose tokens are in the KV cache buffers, if any.
+  std::optional<int> active_sequence_id_;
+  // The tracker the blocks of the sequences are accounted to, if any.
+  MemoryTracker* memory_tracker_ = nullptr;
+
   // The embedding lookup for the optional embedder model.
   std::unique_ptr<EmbeddingLookupText> embedding_lookup_;
   // The embedding lookup for the optional per layer embedder model.
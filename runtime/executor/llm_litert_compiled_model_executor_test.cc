@@ -17,21 +17,28 @@
 #include <cstdlib>
 #include <filesystem>  // NOLINT: Required for path manipulation.
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/cleanup/cleanup.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "runtime/components/model_resources.h"
 #include "runtime/components/model_resources_task.h"
 #include "runtime/executor/executor_settings_base.h"
+#include "runtime/executor/llm_executor_io_types.h"
 #include "runtime/executor/llm_executor_settings.h"
+#include "runtime/util/convert_tensor_buffer.h"
+#include "runtime/util/memory_tracker.h"
 #include "runtime/util/model_asset_bundle_resources.h"
 #include "runtime/util/scoped_file.h"
+#include "runtime/util/status_macros.h"  // IWYU pragma: keep
 #include "runtime/util/test_utils.h"  // IWYU pragma: keep
 
 namespace litert::lm {
@@ -43,8 +50,10 @@ using ::litert::lm::Backend;
 using ::litert::lm::LlmExecutorSettings;
 using ::litert::lm::ModelAssets;
 using ::litert::lm::LlmLiteRtCompiledModelExecutor;
+using ::litert::lm::MemoryTracker;
 using ::litert::lm::ModelAssetBundleResources;
 using ::litert::lm::ModelResourcesTask;
+using ::testing::status::StatusIs;
 
 absl::StatusOr<std::unique_ptr<ModelResources>> CreateExecutorModelResources(
     absl::string_view model_path) {
@@ -104,5 +113,196 @@ TEST(LlmLiteRTCompiledModelExecutorTest, CreateExecutorTest_WithCache) {
   ASSERT_NE(*executor, nullptr);
 }
 
+absl::Status PrefillTokens(LlmLiteRtCompiledModelExecutor& executor,
+                           const std::vector<int>& token_ids) {
+  auto ids_buffer = CopyToTensorBuffer<int>(
+      token_ids, {1, static_cast<int>(token_ids.size())});
+  if (!ids_buffer) {
+    return absl::InternalError(ids_buffer.Error().Message());
+  }
+  return executor.Prefill(ExecutorInputs(
+      ExecutorTextData(std::move(*ids_buffer)), std::nullopt, std::nullopt));
+}
+
+absl::StatusOr<int> DecodeToken(LlmLiteRtCompiledModelExecutor& executor) {
+  auto output_tokens = CreateTensorBuffer<int>({1, 1});
+  if (!output_tokens) {
+    return absl::InternalError(output_tokens.Error().Message());
+  }
+  RETURN_IF_ERROR(executor.Decode(*output_tokens));
+  auto tokens = CopyFromTensorBuffer<int>(*output_tokens);
+  if (!tokens) {
+    return absl::InternalError(tokens.Error().Message());
+  }
+  return (*tokens)[0];
+}
+
+TEST(LlmLiteRTCompiledModelExecutorTest, RewindTo) {
+  auto model_path =
+      std::filesystem::path(::testing::SrcDir()) /
+      "litert_lm/runtime/testdata/test_lm.task";
+  ASSERT_OK_AND_ASSIGN(auto model_resources,
+                       CreateExecutorModelResources(model_path.string()));
+  auto model_assets = ModelAssets::Create(model_path.string());
+  ASSERT_OK(model_assets);
+  auto executor_settings =
+      LlmExecutorSettings::CreateDefault(*model_assets, Backend::CPU);
+  executor_settings->SetCacheDir(":nocache");
+  executor_settings->SetMaxNumTokens(kMaxNumTokens);
+  ::litert::lm::CpuConfig config;
+  config.number_of_threads = kNumThreads;
+  executor_settings->SetBackendConfig(config);
+  ASSERT_OK_AND_ASSIGN(auto executor, LlmLiteRtCompiledModelExecutor::Create(
+                                          *executor_settings,
+                                          *model_resources));
+
+  // Decoding after rewinding must match decoding after prefilling only the
+  // remaining tokens, i.e. the stale KV cache entries must be ignored.
+  ASSERT_OK(PrefillTokens(*executor, {1, 2}));
+  ASSERT_OK_AND_ASSIGN(int expected_token, DecodeToken(*executor));
+
+  ASSERT_OK(executor->Reset());
+  ASSERT_OK(PrefillTokens(*executor, {1, 2, 3, 4}));
+  ASSERT_OK(DecodeToken(*executor));
+  EXPECT_EQ(*executor->GetCurrentStep(), 5);
+
+  EXPECT_FALSE(executor->RewindTo(6).ok());
+  ASSERT_OK(executor->RewindTo(2));
+  EXPECT_EQ(*executor->GetCurrentStep(), 2);
+  ASSERT_OK_AND_ASSIGN(int token, DecodeToken(*executor));
+  EXPECT_EQ(token, expected_token);
+  EXPECT_EQ(*executor->GetCurrentStep(), 3);
+
+  // Rewinding to the beginning is equivalent to a reset.
+  ASSERT_OK(executor->RewindTo(0));
+  EXPECT_EQ(*executor->GetCurrentStep(), 0);
+  ASSERT_OK(PrefillTokens(*executor, {1, 2}));
+  ASSERT_OK_AND_ASSIGN(token, DecodeToken(*executor));
+  EXPECT_EQ(token, expected_token);
+}
+
+TEST(LlmLiteRTCompiledModelExecutorTest, InterleavedSequences) {
+  auto model_path =
+      std::filesystem::path(::testing::SrcDir()) /
+      "litert_lm/runtime/testdata/test_lm.task";
+  ASSERT_OK_AND_ASSIGN(auto model_resources,
+                       CreateExecutorModelResources(model_path.string()));
+  auto model_assets = ModelAssets::Create(model_path.string());
+  ASSERT_OK(model_assets);
+  auto executor_settings =
+      LlmExecutorSettings::CreateDefault(*model_assets, Backend::CPU);
+  executor_settings->SetCacheDir(":nocache");
+  executor_settings->SetMaxNumTokens(kMaxNumTokens);
+  ::litert::lm::CpuConfig config;
+  config.number_of_threads = kNumThreads;
+  executor_settings->SetBackendConfig(config);
+  ASSERT_OK_AND_ASSIGN(auto executor, LlmLiteRtCompiledModelExecutor::Create(
+                                          *executor_settings,
+                                          *model_resources));
+
+  // The tokens decoded by each sequence alone.
+  ASSERT_OK(PrefillTokens(*executor, {1, 2}));
+  ASSERT_OK_AND_ASSIGN(int expected_token_1, DecodeToken(*executor));
+  ASSERT_OK(executor->Reset());
+  ASSERT_OK(PrefillTokens(*executor, {3, 4, 5}));
+  ASSERT_OK_AND_ASSIGN(int expected_token_2, DecodeToken(*executor));
+
+  // Interleaving the sequences must not change their tokens, i.e. the KV cache
+  // of each one is restored when it is activated again.
+  ASSERT_OK(executor->SetActiveSequence(1));
+  EXPECT_EQ(*executor->GetCurrentStep(), 0);
+  ASSERT_OK(PrefillTokens(*executor, {1, 2}));
+  ASSERT_OK(executor->SetActiveSequence(2));
+  EXPECT_EQ(*executor->GetCurrentStep(), 0);
+  ASSERT_OK(PrefillTokens(*executor, {3, 4, 5}));
+  ASSERT_OK(executor->SetActiveSequence(1));
+  EXPECT_EQ(*executor->GetCurrentStep(), 2);
+  ASSERT_OK_AND_ASSIGN(int token, DecodeToken(*executor));
+  EXPECT_EQ(token, expected_token_1);
+  ASSERT_OK(executor->SetActiveSequence(2));
+  EXPECT_EQ(*executor->GetCurrentStep(), 3);
+  ASSERT_OK_AND_ASSIGN(token, DecodeToken(*executor));
+  EXPECT_EQ(token, expected_token_2);
+
+  // A released sequence starts over when activated again.
+  ASSERT_OK(executor->ReleaseSequence(1));
+  ASSERT_OK(executor->SetActiveSequence(1));
+  EXPECT_EQ(*executor->GetCurrentStep(), 0);
+  ASSERT_OK(executor->ReleaseSequence(1));
+  ASSERT_OK(executor->ReleaseSequence(2));
+  EXPECT_EQ(*executor->GetCurrentStep(), 0);
+}
+
+TEST(LlmLiteRTCompiledModelExecutorTest, AccountsTheSavedSequences) {
+  auto model_path =
+      std::filesystem::path(::testing::SrcDir()) /
+      "litert_lm/runtime/testdata/test_lm.task";
+  ASSERT_OK_AND_ASSIGN(auto model_resources,
+                       CreateExecutorModelResources(model_path.string()));
+  auto model_assets = ModelAssets::Create(model_path.string());
+  ASSERT_OK(model_assets);
+  auto executor_settings =
+      LlmExecutorSettings::CreateDefault(*model_assets, Backend::CPU);
+  executor_settings->SetCacheDir(":nocache");
+  executor_settings->SetMaxNumTokens(kMaxNumTokens);
+  ::litert::lm::CpuConfig config;
+  config.number_of_threads = kNumThreads;
+  executor_settings->SetBackendConfig(config);
+  ASSERT_OK_AND_ASSIGN(auto executor, LlmLiteRtCompiledModelExecutor::Create(
+                                          *executor_settings,
+                                          *model_resources));
+  MemoryTracker tracker;
+  executor->SetMemoryTracker(&tracker);
+
+  // The active sequence is in the KV cache buffers, accounted by
+  // GetMemoryUsage(), and only takes blocks once it is saved.
+  ASSERT_OK(executor->SetActiveSequence(1));
+  ASSERT_OK(PrefillTokens(*executor, {1, 2}));
+  EXPECT_EQ(tracker.GetUsage().GetOwnerBytes("sequence_1"), 0);
+  ASSERT_OK(executor->SetActiveSequence(2));
+  EXPECT_GT(tracker.GetUsage().GetOwnerBytes("sequence_1"), 0);
+  ASSERT_OK(executor->ReleaseSequence(1));
+  ASSERT_OK(executor->ReleaseSequence(2));
+  EXPECT_EQ(tracker.GetUsage().total_bytes, 0);
+
+  // Saving a sequence past the budget fails rather than allocating blocks.
+  MemoryTracker small_tracker(/*budget_bytes=*/1);
+  executor->SetMemoryTracker(&small_tracker);
+  ASSERT_OK(executor->SetActiveSequence(3));
+  ASSERT_OK(PrefillTokens(*executor, {1, 2}));
+  EXPECT_THAT(executor->SetActiveSequence(4),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+  ASSERT_OK(executor->ReleaseSequence(3));
+}
+
+TEST(LlmLiteRTCompiledModelExecutorTest, LoRAWithoutLoRAInputs) {
+  auto model_path =
+      std::filesystem::path(::testing::SrcDir()) /
+      "litert_lm/runtime/testdata/test_lm.task";
+  ASSERT_OK_AND_ASSIGN(auto model_resources,
+                       CreateExecutorModelResources(model_path.string()));
+  auto model_assets = ModelAssets::Create(model_path.string());
+  ASSERT_OK(model_assets);
+  auto executor_settings =
+      LlmExecutorSettings::CreateDefault(*model_assets, Backend::CPU);
+  executor_settings->SetCacheDir(":nocache");
+  executor_settings->SetMaxNumTokens(kMaxNumTokens);
+  ::litert::lm::CpuConfig config;
+  config.number_of_threads = kNumThreads;
+  executor_settings->SetBackendConfig(config);
+  ASSERT_OK_AND_ASSIGN(auto executor, LlmLiteRtCompiledModelExecutor::Create(
+                                          *executor_settings,
+                                          *model_resources));
+
+  // The test model has no LoRA inputs: only the base model can be selected.
+  EXPECT_THAT(executor->LoadLoRA("adapter", *model_assets),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(executor->SetActiveLoRA("adapter"),
+              StatusIs(absl::StatusCode::kNotFound));
+  ASSERT_OK(executor->SetActiveLoRA(std::nullopt));
+  ASSERT_OK(PrefillTokens(*executor, {1, 2}));
+  ASSERT_OK(DecodeToken(*executor));
+}
+
 }  // namespace
 }  // namespace litert::lm
@@ -17,6 +17,7 @@
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/match.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "absl/time/clock.h"  // from @com_google_absl
 #include "absl/time/time.h"  // from @com_google_absl
@@ -1186,6 +1187,7 @@ absl::Status LlmLiteRtNpuCompiledModelExecutor::PrefillInternal(
         i++;
       }
       prefill_input_pos_ptr[input_idx] = current_step_;
+      processed_tokens_.push_back(prefill_input_ptr[input_idx]);
     }
   }
   next_input_token_id_ = ids[ids.size() - 1];
@@ -1525,10 +1527,36 @@ absl::Status LlmLiteRtNpuCompiledModelExecutor::Decode(
     latency_stats_.decode_cache_update_inference_latency_us +=
         absl::ToInt64Microseconds(end - start);
   }
+  processed_tokens_.push_back(id);
   ++current_step_;
   return absl::OkStatus();
 }
 
+absl::Status LlmLiteRtNpuCompiledModelExecutor::RewindTo(int step) {
+  const int num_tokens = GetNumTokens();
+  if (step < 0 || step > num_tokens) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot rewind to step ", step, ", the sequence has ",
+                     num_tokens, " tokens."));
+  }
+  if (step == num_tokens) {
+    return absl::OkStatus();
+  }
+  RET_CHECK_EQ(processed_tokens_.size(), current_step_);
+  if (step == 0) {
+    current_step_ = 0;
+    next_input_token_id_ = -1;
+    processed_tokens_.clear();
+    return absl::OkStatus();
+  }
+  // Keep the last remaining token pending, as if the last prefill ended with
+  // it.
+  current_step_ = step - 1;
+  next_input_token_id_ = processed_tokens_[current_step_];
+  processed_tokens_.resize(current_step_);
+  return absl::OkStatus();
+}
+
 absl::StatusOr<int> LlmLiteRtNpuCompiledModelExecutor::GetVocabSize() {
   LITERT_ASSIGN_OR_RETURN(
       auto logits_tensor_type,
@@ -109,6 +109,12 @@ class LlmLiteRtNpuCompiledModelExecutor : public ::litert::lm::LlmExecutor {
 
   absl::StatusOr<int> GetVocabSize() override;
 
+  // Rewinds the executor to the given step, at most the number of processed
+  // and pending tokens. The KV cache entries past the new step are not
+  // cleared: the mask model only attends up to the current time step, and the
+  // cache update model overwrites them later.
+  absl::Status RewindTo(int step) override;
+
   absl::StatusOr<litert::lm::LlmExecutorSettings> GetExecutorSettings()
       const override {
     return executor_settings_;
@@ -201,6 +207,14 @@ class LlmLiteRtNpuCompiledModelExecutor : public ::litert::lm::LlmExecutor {
   // Caller of this function is responsible for capturing the output.
   absl::Status DecodeInternal(::litert::lm::ExecutorInputs inputs);
 
+  // Returns the number of tokens of the sequence, i.e. the processed tokens
+  // and the pending input token. Unlike the LlmExecutor::GetCurrentStep() of
+  // the other executors, it is not exposed, so that the decoding loop keeps
+  // reading the step of this executor as before.
+  int GetNumTokens() const {
+    return current_step_ + (next_input_token_id_ == -1 ? 0 : 1);
+  }
+
   // Creates the context for the embedder model.
   static absl::StatusOr<EmbedderContext>
   CreateEmbedderContextWithoutBufferSharing(::litert::Environment& env,
@@ -359,8 +373,9 @@ class LlmLiteRtNpuCompiledModelExecutor : public ::litert::lm::LlmExecutor {
   // Internal timestep.
   int current_step_ = 0;
 
-  // TODO: b/404625243 - To be implemented.
-  // The processed tokens.
+  // The token ids whose KV cache entries have been computed, i.e. the token id
+  // at each step before current_step_. It is used to restore
+  // next_input_token_id_ when rewinding.
   std::vector<int> processed_tokens_;
 
   // The token served as the first input token to the model for next Prefill or
@@ -0,0 +1,342 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/executor/paged_kv_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/util/status_macros.h"  // NOLINT
+
+namespace litert::lm {
+
+absl::StatusOr<std::unique_ptr<PagedKvCache>> PagedKvCache::Create(
+    std::vector<KvCacheTensorLayout> tensor_layouts, int block_size,
+    int max_num_blocks) {
+  if (tensor_layouts.empty()) {
+    return absl::InvalidArgumentError("No KV cache tensor layout is given.");
+  }
+  if (block_size <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Block size must be positive, got ", block_size, "."));
+  }
+  if (max_num_blocks <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Max number of blocks must be positive, got ", max_num_blocks, "."));
+  }
+  for (const auto& layout : tensor_layouts) {
+    if (layout.outer_size <= 0 || layout.max_num_tokens <= 0 ||
+        layout.token_size_in_bytes == 0) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Invalid KV cache tensor layout: outer_size=", layout.outer_size,
+          ", max_num_tokens=", layout.max_num_tokens,
+          ", token_size_in_bytes=", layout.token_size_in_bytes, "."));
+    }
+  }
+  return absl::WrapUnique(
+      new PagedKvCache(std::move(tensor_layouts), block_size, max_num_blocks));
+}
+
+PagedKvCache::PagedKvCache(std::vector<KvCacheTensorLayout> tensor_layouts,
+                           int block_size, int max_num_blocks)
+    : tensor_layouts_(std::move(tensor_layouts)),
+      block_size_(block_size),
+      max_num_blocks_(max_num_blocks) {
+  tensor_offsets_in_block_.reserve(tensor_layouts_.size());
+  for (const auto& layout : tensor_layouts_) {
+    tensor_offsets_in_block_.push_back(block_size_in_bytes_);
+    block_size_in_bytes_ +=
+        layout.outer_size * block_size_ * layout.token_size_in_bytes;
+  }
+}
+
+PagedKvCache::SequenceId PagedKvCache::CreateSequence() {
+  const SequenceId id = next_sequence_id_++;
+  sequences_[id] = Sequence();
+  return id;
+}
+
+absl::StatusOr<PagedKvCache::SequenceId> PagedKvCache::ForkSequence(
+    SequenceId source_id) {
+  ASSIGN_OR_RETURN(const Sequence* source, GetSequence(source_id));
+  Sequence sequence = *source;
+  for (int block_index : sequence.block_table) {
+    ++ref_counts_[block_index];
+  }
+  const SequenceId id = next_sequence_id_++;
+  sequences_[id] = std::move(sequence);
+  return id;
+}
+
+absl::Status PagedKvCache::ReleaseSequence(SequenceId id) {
+  RETURN_IF_ERROR(Truncate(id, 0));
+  sequences_.erase(id);
+  return absl::OkStatus();
+}
+
+absl::Status PagedKvCache::Truncate(SequenceId id, int num_tokens) {
+  ASSIGN_OR_RETURN(Sequence * sequence, GetSequence(id));
+  if (num_tokens < 0 || num_tokens > sequence->token_ids.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot truncate sequence ", id, " of ",
+                     sequence->token_ids.size(), " tokens to ", num_tokens,
+                     " tokens."));
+  }
+  sequence->token_ids.resize(num_tokens);
+  const int num_blocks = (num_tokens + block_size_ - 1) / block_size_;
+  for (int i = num_blocks; i < sequence->block_table.size(); ++i) {
+    UnrefBlock(sequence->block_table[i]);
+  }
+  sequence->block_table.resize(num_blocks);
+  return absl::OkStatus();
+}
+
+absl::Status PagedKvCache::Scatter(
+    SequenceId id, int begin, absl::Span<const int> token_ids,
+    absl::Span<const absl::Span<const uint8_t>> tensors) {
+  RETURN_IF_ERROR(CheckTensors(tensors));
+  ASSIGN_OR_RETURN(Sequence * sequence, GetSequence(id));
+  const int end = begin + token_ids.size();
+  if (begin < 0 || begin > sequence->token_ids.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot write at token ", begin, " of sequence ", id,
+                     " of ", sequence->token_ids.size(), " tokens."));
+  }
+  if (end > tensor_layouts_[0].max_num_tokens) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot write ", end, " tokens in tensors of ",
+                     tensor_layouts_[0].max_num_tokens, " tokens."));
+  }
+
+  // Fails before writing anything if the pool cannot provide the new and
+  // copied blocks.
+  int num_needed_blocks = 0;
+  for (int i = begin / block_size_; i * block_size_ < end; ++i) {
+    if (i >= sequence->block_table.size() ||
+        ref_counts_[sequence->block_table[i]] > 1) {
+      ++num_needed_blocks;
+    }
+  }
+  const int num_available_blocks =
+      free_blocks_.size() + max_num_blocks_ - blocks_.size();
+  if (num_needed_blocks > num_available_blocks) {
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "Need ", num_needed_blocks, " blocks, but only ", num_available_blocks,
+        " of the ", max_num_blocks_, " blocks of the KV cache are available."));
+  }
+
+  for (int position = begin; position < end;) {
+    const int table_index = position / block_size_;
+    if (table_index == sequence->block_table.size()) {
+      ASSIGN_OR_RETURN(int block_index, AllocateBlock());
+      sequence->block_table.push_back(block_index);
+    } else {
+      RETURN_IF_ERROR(MakeBlockWritable(*sequence, table_index));
+    }
+    const int block_end = std::min(end, (table_index + 1) * block_size_);
+    CopyFromTensors(sequence->block_table[table_index], table_index, position,
+                    block_end, tensors);
+    position = block_end;
+  }
+
+  sequence->token_ids.resize(std::max<int>(end, sequence->token_ids.size()));
+  std::copy(token_ids.begin(), token_ids.end(),
+            sequence->token_ids.begin() + begin);
+  return absl::OkStatus();
+}
+
+absl::Status PagedKvCache::Gather(
+    SequenceId id, absl::Span<const absl::Span<uint8_t>> tensors) const {
+  RETURN_IF_ERROR(CheckTensors(tensors));
+  ASSIGN_OR_RETURN(const Sequence* sequence, GetSequence(id));
+  const int num_tokens = sequence->token_ids.size();
+  for (int i = 0; i < sequence->block_table.size(); ++i) {
+    CopyToTensors(sequence->block_table[i], i, i * block_size_,
+                  std::min(num_tokens, (i + 1) * block_size_), tensors);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<absl::Span<const int>> PagedKvCache::GetTokenIds(
+    SequenceId id) const {
+  ASSIGN_OR_RETURN(const Sequence* sequence, GetSequence(id));
+  return absl::MakeConstSpan(sequence->token_ids);
+}
+
+absl::StatusOr<absl::Span<const int>> PagedKvCache::GetBlockTable(
+    SequenceId id) const {
+  ASSIGN_OR_RETURN(const Sequence* sequence, GetSequence(id));
+  return absl::MakeConstSpan(sequence->block_table);
+}
+
+absl::Span<const uint8_t> PagedKvCache::GetBlockData(int block_index) const {
+  if (block_index < 0 || block_index >= blocks_.size() ||
+      blocks_[block_index] == nullptr) {
+    return {};
+  }
+  return absl::MakeConstSpan(blocks_[block_index].get(), block_size_in_bytes_);
+}
+
+int PagedKvCache::GetBlockRefCount(int block_index) const {
+  if (block_index < 0 || block_index >= ref_counts_.size()) {
+    return 0;
+  }
+  return ref_counts_[block_index];
+}
+
+int PagedKvCache::GetNumUsedBlocks() const {
+  return blocks_.size() - free_blocks_.size();
+}
+
+void PagedKvCache::ReleaseFreeBlocks() {
+  for (int block_index : free_blocks_) {
+    if (blocks_[block_index] != nullptr) {
+      blocks_[block_index].reset();
+      --num_allocated_blocks_;
+    }
+  }
+}
+
+absl::StatusOr<PagedKvCache::Sequence*> PagedKvCache::GetSequence(
+    SequenceId id) {
+  auto it = sequences_.find(id);
+  if (it == sequences_.end()) {
+    return absl::NotFoundError(absl::StrCat("Sequence ", id, " not found."));
+  }
+  return &it->second;
+}
+
+absl::StatusOr<const PagedKvCache::Sequence*> PagedKvCache::GetSequence(
+    SequenceId id) const {
+  auto it = sequences_.find(id);
+  if (it == sequences_.end()) {
+    return absl::NotFoundError(absl::StrCat("Sequence ", id, " not found."));
+  }
+  return &it->second;
+}
+
+absl::StatusOr<int> PagedKvCache::AllocateBlock() {
+  int block_index;
+  if (!free_blocks_.empty()) {
+    block_index = free_blocks_.back();
+    free_blocks_.pop_back();
+  } else if (blocks_.size() < max_num_blocks_) {
+    block_index = blocks_.size();
+    blocks_.emplace_back();
+    ref_counts_.push_back(0);
+  } else {
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "All the ", max_num_blocks_, " blocks of the KV cache are used."));
+  }
+  if (blocks_[block_index] == nullptr) {
+    blocks_[block_index] = std::make_unique<uint8_t[]>(block_size_in_bytes_);
+    ++num_allocated_blocks_;
+  }
+  ref_counts_[block_index] = 1;
+  return block_index;
+}
+
+void PagedKvCache::UnrefBlock(int block_index) {
+  if (--ref_counts_[block_index] == 0) {
+    free_blocks_.push_back(block_index);
+  }
+}
+
+absl::Status PagedKvCache::MakeBlockWritable(Sequence& sequence,
+                                             int table_index) {
+  const int block_index = sequence.block_table[table_index];
+  if (ref_counts_[block_index] == 1) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(int new_block_index, AllocateBlock());
+  std::memcpy(blocks_[new_block_index].get(), blocks_[block_index].get(),
+              block_size_in_bytes_);
+  UnrefBlock(block_index);
+  sequence.block_table[table_index] = new_block_index;
+  return absl::OkStatus();
+}
+
+void PagedKvCache::CopyFromTensors(
+    int block_index, int block_position, int begin, int end,
+    absl::Span<const absl::Span<const uint8_t>> tensors) {
+  uint8_t* block = blocks_[block_index].get();
+  const int offset_in_block = begin - block_position * block_size_;
+  for (int t = 0; t < tensor_layouts_.size(); ++t) {
+    const auto& layout = tensor_layouts_[t];
+    const size_t num_bytes = (end - begin) * layout.token_size_in_bytes;
+    for (int o = 0; o < layout.outer_size; ++o) {
+      const uint8_t* src =
+          tensors[t].data() +
+          (o * layout.max_num_tokens + begin) * layout.token_size_in_bytes;
+      uint8_t* dst = block + tensor_offsets_in_block_[t] +
+                     (o * block_size_ + offset_in_block) *
+                         layout.token_size_in_bytes;
+      std::memcpy(dst, src, num_bytes);
+    }
+  }
+}
+
+void PagedKvCache::CopyToTensors(
+    int block_index, int block_position, int begin, int end,
+    absl::Span<const absl::Span<uint8_t>> tensors) const {
+  const uint8_t* block = blocks_[block_index].get();
+  const int offset_in_block = begin - block_position * block_size_;
+  for (int t = 0; t < tensor_layouts_.size(); ++t) {
+    const auto& layout = tensor_layouts_[t];
+    const size_t num_bytes = (end - begin) * layout.token_size_in_bytes;
+    for (int o = 0; o < layout.outer_size; ++o) {
+      const uint8_t* src = block + tensor_offsets_in_block_[t] +
+                           (o * block_size_ + offset_in_block) *
+                               layout.token_size_in_bytes;
+      uint8_t* dst =
+          tensors[t].data() +
+          (o * layout.max_num_tokens + begin) * layout.token_size_in_bytes;
+      std::memcpy(dst, src, num_bytes);
+    }
+  }
+}
+
+template <typename T>
+absl::Status PagedKvCache::CheckTensors(
+    absl::Span<const absl::Span<T>> tensors) const {
+  if (tensors.size() != tensor_layouts_.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected ", tensor_layouts_.size(), " tensors, got ",
+                     tensors.size(), "."));
+  }
+  for (int t = 0; t < tensors.size(); ++t) {
+    const auto& layout = tensor_layouts_[t];
+    const size_t expected_size = static_cast<size_t>(layout.outer_size) *
+                                 layout.max_num_tokens *
+                                 layout.token_size_in_bytes;
+    if (tensors[t].size() != expected_size) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Tensor ", t, " has ", tensors[t].size(),
+                       " bytes, expected ", expected_size, "."));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace litert::lm
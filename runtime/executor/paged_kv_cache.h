@@ -0,0 +1,184 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_PAGED_KV_CACHE_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_PAGED_KV_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// The layout of a contiguous KV cache tensor, viewed as a
+// [outer_size, max_num_tokens, token_size_in_bytes] byte array. E.g. a
+// [1, max_num_tokens, num_heads, head_dim] float tensor has an outer size of 1
+// and num_heads * head_dim * 4 bytes per token, while a transposed
+// [1, num_heads, max_num_tokens, head_dim] tensor has an outer size of
+// num_heads and head_dim * 4 bytes per token.
+struct KvCacheTensorLayout {
+  int outer_size = 1;
+  int max_num_tokens = 0;
+  size_t token_size_in_bytes = 0;
+};
+
+// A paged KV cache: the KV cache entries of each sequence are stored in
+// fixed-size blocks of `block_size` tokens, which are allocated on demand from
+// a pool shared by all the sequences. A sequence therefore only holds the
+// memory of the tokens it actually has, instead of a buffer sized for the
+// maximum number of tokens.
+//
+// Each sequence has a block table mapping its token positions to blocks.
+// Blocks are reference counted: ForkSequence() shares all the blocks of a
+// sequence (e.g. a common prompt prefix), and a shared block is copied on the
+// first write to it (copy-on-write).
+//
+// The exported models take contiguous KV cache tensors, so the blocks are
+// gathered into/scattered from the contiguous layout (see
+// KvCacheTensorLayout) when a sequence is loaded into/saved from the executor.
+// Models with paged-attention signatures may read the blocks directly, using
+// GetBlockTable() and GetBlockData().
+//
+// The class is not thread-safe.
+class PagedKvCache {
+ public:
+  using SequenceId = int;
+
+  // Creates a PagedKvCache.
+  // - tensor_layouts: The layouts of the KV cache tensors of the model, e.g.
+  //   the k and v caches of each layer. Each block holds `block_size` tokens
+  //   of all of them.
+  // - block_size: The number of tokens per block.
+  // - max_num_blocks: The maximum number of blocks of the pool.
+  static absl::StatusOr<std::unique_ptr<PagedKvCache>> Create(
+      std::vector<KvCacheTensorLayout> tensor_layouts, int block_size,
+      int max_num_blocks);
+
+  // Creates a new empty sequence.
+  SequenceId CreateSequence();
+
+  // Creates a new sequence sharing all the blocks (and token ids) of
+  // `source_id`.
+  absl::StatusOr<SequenceId> ForkSequence(SequenceId source_id);
+
+  // Releases the sequence and its references to its blocks.
+  absl::Status ReleaseSequence(SequenceId id);
+
+  // Drops the tokens at and after `num_tokens`, releasing the blocks that are
+  // no longer used by the sequence.
+  absl::Status Truncate(SequenceId id, int num_tokens);
+
+  // Writes the KV cache entries of the tokens [begin, begin +
+  // token_ids.size()) of the sequence, read from the same token positions of
+  // the contiguous `tensors` (in the order of the tensor layouts). `begin`
+  // must not exceed the number of tokens of the sequence, which grows to
+  // cover the written tokens. Blocks are allocated as needed, and the shared
+  // blocks written to are copied first.
+  absl::Status Scatter(SequenceId id, int begin,
+                       absl::Span<const int> token_ids,
+                       absl::Span<const absl::Span<const uint8_t>> tensors);
+
+  // Copies the KV cache entries of all the tokens of the sequence to the
+  // same token positions of the contiguous `tensors`.
+  absl::Status Gather(SequenceId id,
+                      absl::Span<const absl::Span<uint8_t>> tensors) const;
+
+  // Returns the token ids of the sequence.
+  absl::StatusOr<absl::Span<const int>> GetTokenIds(SequenceId id) const;
+
+  // Returns the block table of the sequence, i.e. the index of the block
+  // holding the tokens [i * block_size, (i + 1) * block_size) at index i.
+  absl::StatusOr<absl::Span<const int>> GetBlockTable(SequenceId id) const;
+
+  // Returns the data of a block: for each tensor, in the order of the tensor
+  // layouts, a [outer_size, block_size, token_size_in_bytes] byte array.
+  absl::Span<const uint8_t> GetBlockData(int block_index) const;
+
+  // Returns the number of references to a block.
+  int GetBlockRefCount(int block_index) const;
+
+  int GetBlockSize() const { return block_size_; }
+  size_t GetBlockSizeInBytes() const { return block_size_in_bytes_; }
+
+  // Returns the number of blocks referenced by at least one sequence.
+  int GetNumUsedBlocks() const;
+
+  // Returns the number of blocks holding memory, used or not.
+  int GetNumAllocatedBlocks() const { return num_allocated_blocks_; }
+
+  // Frees the memory of the allocated blocks which are not used anymore.
+  void ReleaseFreeBlocks();
+
+ private:
+  struct Sequence {
+    std::vector<int> token_ids;
+    std::vector<int> block_table;
+  };
+
+  PagedKvCache(std::vector<KvCacheTensorLayout> tensor_layouts, int block_size,
+               int max_num_blocks);
+
+  absl::StatusOr<Sequence*> GetSequence(SequenceId id);
+  absl::StatusOr<const Sequence*> GetSequence(SequenceId id) const;
+
+  // Returns a block with a reference count of 1, reusing a free block if any.
+  absl::StatusOr<int> AllocateBlock();
+
+  // Drops a reference to the block, and puts it back to the free list once
+  // unused.
+  void UnrefBlock(int block_index);
+
+  // Makes sure the block at `table_index` of the sequence is only referenced
+  // by it, copying it if shared.
+  absl::Status MakeBlockWritable(Sequence& sequence, int table_index);
+
+  // Copies the tokens [begin, end) of a block from/to the contiguous tensors.
+  // The tokens must all be in the block at `block_position` of the sequence.
+  void CopyFromTensors(int block_index, int block_position, int begin, int end,
+                       absl::Span<const absl::Span<const uint8_t>> tensors);
+  void CopyToTensors(int block_index, int block_position, int begin, int end,
+                     absl::Span<const absl::Span<uint8_t>> tensors) const;
+
+  // Checks that the tensors match the tensor layouts.
+  template <typename T>
+  absl::Status CheckTensors(absl::Span<const absl::Span<T>> tensors) const;
+
+  const std::vector<KvCacheTensorLayout> tensor_layouts_;
+  // The offset of the data of each tensor in a block.
+  std::vector<size_t> tensor_offsets_in_block_;
+  const int block_size_;
+  const int max_num_blocks_;
+  size_t block_size_in_bytes_ = 0;
+
+  // The blocks created so far. The memory of a free block may be released,
+  // leaving it null until it is reused.
+  std::vector<std::unique_ptr<uint8_t[]>> blocks_;
+  int num_allocated_blocks_ = 0;
+  std::vector<int> ref_counts_;
+  // The indices of the blocks that are not used.
+  std::vector<int> free_blocks_;
+
+  absl::flat_hash_map<SequenceId, Sequence> sequences_;
+  SequenceId next_sequence_id_ = 0;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_PAGED_KV_CACHE_H_
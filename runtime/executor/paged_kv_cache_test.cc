@@ -0,0 +1,182 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/executor/paged_kv_cache.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::status::StatusIs;
+
+constexpr int kMaxNumTokens = 8;
+
+// A [1, kMaxNumTokens, 2 bytes] tensor and a transposed
+// [3, kMaxNumTokens, 1 byte] tensor.
+std::vector<KvCacheTensorLayout> GetLayouts() {
+  return {{.outer_size = 1, .max_num_tokens = kMaxNumTokens,
+           .token_size_in_bytes = 2},
+          {.outer_size = 3, .max_num_tokens = kMaxNumTokens,
+           .token_size_in_bytes = 1}};
+}
+
+// Contiguous tensors filled with `value` + the index of each byte.
+struct Tensors {
+  explicit Tensors(uint8_t value) : k(2 * kMaxNumTokens), v(3 * kMaxNumTokens) {
+    for (int i = 0; i < k.size(); ++i) k[i] = value + i;
+    for (int i = 0; i < v.size(); ++i) v[i] = value + i;
+  }
+
+  std::vector<absl::Span<const uint8_t>> Const() const { return {k, v}; }
+  std::vector<absl::Span<uint8_t>> Mutable() {
+    return {absl::MakeSpan(k), absl::MakeSpan(v)};
+  }
+
+  std::vector<uint8_t> k;
+  std::vector<uint8_t> v;
+};
+
+TEST(PagedKvCacheTest, CreateFailsOnInvalidArguments) {
+  EXPECT_THAT(PagedKvCache::Create({}, /*block_size=*/4, /*max_num_blocks=*/4),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(PagedKvCache::Create(GetLayouts(), /*block_size=*/0,
+                                   /*max_num_blocks=*/4),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(PagedKvCache::Create(GetLayouts(), /*block_size=*/4,
+                                   /*max_num_blocks=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PagedKvCacheTest, AllocatesBlocksOnDemand) {
+  ASSERT_OK_AND_ASSIGN(auto cache,
+                       PagedKvCache::Create(GetLayouts(), /*block_size=*/3,
+                                            /*max_num_blocks=*/4));
+  // 3 tokens of 2 bytes + 3 x 3 tokens of 1 byte.
+  EXPECT_EQ(cache->GetBlockSizeInBytes(), 15);
+
+  const Tensors tensors(0);
+  const auto id = cache->CreateSequence();
+  ASSERT_OK(cache->Scatter(id, 0, {1, 2}, tensors.Const()));
+  EXPECT_EQ(cache->GetNumUsedBlocks(), 1);
+  ASSERT_OK(cache->Scatter(id, 2, {3, 4}, tensors.Const()));
+  EXPECT_EQ(cache->GetNumUsedBlocks(), 2);
+  EXPECT_THAT(*cache->GetTokenIds(id), ElementsAre(1, 2, 3, 4));
+  EXPECT_THAT(*cache->GetBlockTable(id), ElementsAre(0, 1));
+}
+
+TEST(PagedKvCacheTest, GatherRestoresScatteredTokens) {
+  ASSERT_OK_AND_ASSIGN(auto cache,
+                       PagedKvCache::Create(GetLayouts(), /*block_size=*/3,
+                                            /*max_num_blocks=*/4));
+  const Tensors source(10);
+  const auto id = cache->CreateSequence();
+  ASSERT_OK(cache->Scatter(id, 0, {1, 2, 3, 4, 5}, source.Const()));
+
+  Tensors destination(0);
+  ASSERT_OK(cache->Gather(id, destination.Mutable()));
+  // The first 5 tokens are restored, the others are left untouched.
+  for (int i = 0; i < 2 * kMaxNumTokens; ++i) {
+    EXPECT_EQ(destination.k[i], i < 2 * 5 ? 10 + i : i) << i;
+  }
+  for (int i = 0; i < 3 * kMaxNumTokens; ++i) {
+    EXPECT_EQ(destination.v[i], i % kMaxNumTokens < 5 ? 10 + i : i) << i;
+  }
+}
+
+TEST(PagedKvCacheTest, ForkSharesBlocksAndCopiesOnWrite) {
+  ASSERT_OK_AND_ASSIGN(auto cache,
+                       PagedKvCache::Create(GetLayouts(), /*block_size=*/2,
+                                            /*max_num_blocks=*/8));
+  const auto prompt = cache->CreateSequence();
+  ASSERT_OK(cache->Scatter(prompt, 0, {1, 2, 3}, Tensors(10).Const()));
+  ASSERT_OK_AND_ASSIGN(const auto fork, cache->ForkSequence(prompt));
+  EXPECT_EQ(cache->GetNumUsedBlocks(), 2);
+  EXPECT_EQ(cache->GetBlockRefCount(0), 2);
+  EXPECT_EQ(cache->GetBlockRefCount(1), 2);
+
+  // Appending to the fork copies the partially filled shared block only.
+  ASSERT_OK(cache->Scatter(fork, 3, {4}, Tensors(50).Const()));
+  EXPECT_THAT(*cache->GetBlockTable(prompt), ElementsAre(0, 1));
+  EXPECT_THAT(*cache->GetBlockTable(fork), ElementsAre(0, 2));
+  EXPECT_EQ(cache->GetBlockRefCount(0), 2);
+  EXPECT_EQ(cache->GetBlockRefCount(1), 1);
+  EXPECT_THAT(*cache->GetTokenIds(prompt), ElementsAre(1, 2, 3));
+  EXPECT_THAT(*cache->GetTokenIds(fork), ElementsAre(1, 2, 3, 4));
+
+  // The prompt is unchanged, and the fork has the prompt followed by its own
+  // token.
+  Tensors gathered(0);
+  ASSERT_OK(cache->Gather(prompt, gathered.Mutable()));
+  EXPECT_EQ(gathered.k[2 * 3], 0 + 2 * 3);
+  EXPECT_EQ(gathered.k[2 * 2], 10 + 2 * 2);
+  ASSERT_OK(cache->Gather(fork, gathered.Mutable()));
+  EXPECT_EQ(gathered.k[2 * 2], 10 + 2 * 2);
+  EXPECT_EQ(gathered.k[2 * 3], 50 + 2 * 3);
+  EXPECT_EQ(gathered.v[kMaxNumTokens + 3], 50 + kMaxNumTokens + 3);
+}
+
+TEST(PagedKvCacheTest, TruncateAndReleaseFreeBlocks) {
+  ASSERT_OK_AND_ASSIGN(auto cache,
+                       PagedKvCache::Create(GetLayouts(), /*block_size=*/2,
+                                            /*max_num_blocks=*/8));
+  const Tensors tensors(0);
+  const auto id = cache->CreateSequence();
+  ASSERT_OK(cache->Scatter(id, 0, {1, 2, 3, 4, 5}, tensors.Const()));
+  EXPECT_EQ(cache->GetNumUsedBlocks(), 3);
+
+  ASSERT_OK(cache->Truncate(id, 2));
+  EXPECT_THAT(*cache->GetTokenIds(id), ElementsAre(1, 2));
+  EXPECT_EQ(cache->GetNumUsedBlocks(), 1);
+  EXPECT_EQ(cache->GetNumAllocatedBlocks(), 3);
+  EXPECT_THAT(cache->Truncate(id, 3),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  // The free blocks are reused first.
+  ASSERT_OK(cache->Scatter(id, 2, {6, 7}, tensors.Const()));
+  EXPECT_EQ(cache->GetNumAllocatedBlocks(), 3);
+
+  ASSERT_OK(cache->ReleaseSequence(id));
+  EXPECT_EQ(cache->GetNumUsedBlocks(), 0);
+  cache->ReleaseFreeBlocks();
+  EXPECT_EQ(cache->GetNumAllocatedBlocks(), 0);
+  EXPECT_THAT(cache->GetTokenIds(id), StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(PagedKvCacheTest, ScatterFailsWhenPoolIsExhausted) {
+  ASSERT_OK_AND_ASSIGN(auto cache,
+                       PagedKvCache::Create(GetLayouts(), /*block_size=*/2,
+                                            /*max_num_blocks=*/2));
+  const Tensors tensors(0);
+  const auto id = cache->CreateSequence();
+  EXPECT_THAT(cache->Scatter(id, 0, {1, 2, 3, 4, 5}, tensors.Const()),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+  // Nothing is allocated on failure.
+  EXPECT_EQ(cache->GetNumUsedBlocks(), 0);
+  EXPECT_THAT(cache->Scatter(id, 1, {1}, tensors.Const()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(cache->Scatter(id, 0, {1}, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace litert::lm
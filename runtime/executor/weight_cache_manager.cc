@@ -0,0 +1,375 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/executor/weight_cache_manager.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT: Required for the age of the temporary files.
+#include <cstdint>
+#include <cstring>
+#include <filesystem>  // NOLINT: Required for the atomic rename.
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "absl/log/absl_log.h"  // from @com_google_absl
+#include "absl/memory/memory.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/match.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "litert/c/litert_common.h"  // from @litert
+#include "runtime/util/file_util.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_read.h"
+
+namespace litert::lm {
+namespace {
+
+// The size of the blocks sampled from the model and cache files.
+constexpr uint64_t kSampleBlockSize = 64 * 1024;
+// The number of evenly spaced blocks sampled from files without sections.
+constexpr int kNumSampledBlocks = 16;
+// The age past which the temporary files of a cache are left by builds which
+// did not complete, e.g. crashed processes, rather than by running ones.
+constexpr std::chrono::hours kStaleTempFileAge(24);
+
+constexpr char kManifestMagic[8] = {'L', 'R', 'T', 'L', 'M', 'W', 'C', '\0'};
+
+// The manifest published next to a cache. All fields are little endian.
+struct Manifest {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t key;
+  uint64_t cache_size;
+  uint64_t cache_checksum;
+  int64_t build_duration_us;
+};
+
+// A 64-bit FNV-1a hash. Unlike absl::Hash, it is stable across processes,
+// which is required for keys of persisted files.
+class Fnv1aHasher {
+ public:
+  void Update(absl::string_view data) {
+    for (unsigned char c : data) {
+      hash_ = (hash_ ^ c) * 0x100000001b3ULL;
+    }
+  }
+  void Update(uint64_t value) {
+    Update(absl::string_view(reinterpret_cast<const char*>(&value),
+                             sizeof(value)));
+  }
+  uint64_t hash() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 0xcbf29ce484222325ULL;
+};
+
+// Hashes the offset, the size and the content of [offset, offset + size).
+absl::Status HashRange(std::ifstream& file, uint64_t offset, uint64_t size,
+                       Fnv1aHasher& hasher) {
+  std::string block(size, '\0');
+  file.seekg(offset);
+  file.read(block.data(), size);
+  if (!file) {
+    return absl::DataLossError(
+        absl::StrCat("Failed to read ", size, " bytes at offset ", offset));
+  }
+  hasher.Update(offset);
+  hasher.Update(size);
+  hasher.Update(block);
+  return absl::OkStatus();
+}
+
+// Hashes the first and last kSampleBlockSize bytes of [begin, end).
+absl::Status HashRangeEnds(std::ifstream& file, uint64_t begin, uint64_t end,
+                           Fnv1aHasher& hasher) {
+  const uint64_t size = end - begin;
+  if (size <= 2 * kSampleBlockSize) {
+    return HashRange(file, begin, size, hasher);
+  }
+  RETURN_IF_ERROR(HashRange(file, begin, kSampleBlockSize, hasher));
+  return HashRange(file, end - kSampleBlockSize, kSampleBlockSize, hasher);
+}
+
+// Hashes the size and kNumSampledBlocks evenly spaced blocks of a file,
+// including its first and last blocks.
+absl::Status HashSampledBlocks(std::ifstream& file, uint64_t file_size,
+                               Fnv1aHasher& hasher) {
+  hasher.Update(file_size);
+  if (file_size <= kNumSampledBlocks * kSampleBlockSize) {
+    return HashRange(file, 0, file_size, hasher);
+  }
+  const uint64_t stride =
+      (file_size - kSampleBlockSize) / (kNumSampledBlocks - 1);
+  for (int i = 0; i < kNumSampledBlocks; ++i) {
+    RETURN_IF_ERROR(HashRange(file, i * stride, kSampleBlockSize, hasher));
+  }
+  return absl::OkStatus();
+}
+
+// Hashes the metadata of a file which changes when it is written or replaced:
+// its size, device, inode and modification time.
+absl::Status HashFileStat(const std::string& path, Fnv1aHasher& hasher) {
+  struct stat file_stat;
+  std::error_code error;
+  const std::filesystem::file_time_type mtime =
+      std::filesystem::last_write_time(path, error);
+  if (error || stat(path.c_str(), &file_stat) != 0) {
+    return absl::NotFoundError(absl::StrCat("Could not stat file: ", path));
+  }
+  hasher.Update(static_cast<uint64_t>(file_stat.st_size));
+  hasher.Update(static_cast<uint64_t>(file_stat.st_dev));
+  hasher.Update(static_cast<uint64_t>(file_stat.st_ino));
+  hasher.Update(static_cast<uint64_t>(mtime.time_since_epoch().count()));
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::ifstream> OpenWithSize(const std::string& path,
+                                           uint64_t& size) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return absl::NotFoundError(absl::StrCat("Could not open file: ", path));
+  }
+  size = file.tellg();
+  file.seekg(0);
+  return file;
+}
+
+absl::StatusOr<uint64_t> ComputeCacheChecksum(const std::string& cache_path,
+                                              uint64_t& cache_size) {
+  ASSIGN_OR_RETURN(std::ifstream cache, OpenWithSize(cache_path, cache_size));
+  Fnv1aHasher hasher;
+  RETURN_IF_ERROR(HashSampledBlocks(cache, cache_size, hasher));
+  return hasher.hash();
+}
+
+void RemoveIfExists(const std::string& path) {
+  std::error_code error;
+  std::filesystem::remove(path, error);
+}
+
+// Returns `path` with a random suffix, so that the temporary files of
+// processes building the same cache at the same time do not collide.
+std::string GetUniqueTempPath(absl::string_view path) {
+  std::random_device random;
+  const uint64_t id = (static_cast<uint64_t>(random()) << 32) | random();
+  return absl::StrFormat("%s.%016x.tmp", path, id);
+}
+
+// Removes the temporary files of `path` left by builds which did not
+// complete. The recent ones may belong to running builds, so they are kept.
+void RemoveStaleTempFiles(const std::string& path) {
+  const std::filesystem::path file_path(path);
+  const std::string prefix = absl::StrCat(file_path.filename().string(), ".");
+  std::error_code error;
+  std::filesystem::directory_iterator it(file_path.parent_path(), error);
+  const std::filesystem::directory_iterator end;
+  for (; !error && it != end; it.increment(error)) {
+    const std::string name = it->path().filename().string();
+    if (!absl::StartsWith(name, prefix) || !absl::EndsWith(name, ".tmp")) {
+      continue;
+    }
+    std::error_code time_error;
+    const std::filesystem::file_time_type mtime =
+        it->last_write_time(time_error);
+    if (!time_error && std::filesystem::file_time_type::clock::now() - mtime >
+                           kStaleTempFileAge) {
+      RemoveIfExists(it->path().string());
+    }
+  }
+}
+
+absl::Status Rename(const std::string& from, const std::string& to) {
+  std::error_code error;
+  std::filesystem::rename(from, to, error);
+  if (error) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to rename %s to %s: %s", from, to, error.message()));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<uint64_t> ComputeModelFingerprint(absl::string_view model_path) {
+  uint64_t file_size;
+  ASSIGN_OR_RETURN(std::ifstream file,
+                   OpenWithSize(std::string(model_path), file_size));
+  char magic[8] = {};
+  file.read(magic, sizeof(magic));
+  file.seekg(0);
+
+  Fnv1aHasher hasher;
+  // A model replaced by another one with the same layout, e.g. fine-tuned,
+  // may only differ outside of the sampled bytes, but not in its metadata.
+  RETURN_IF_ERROR(HashFileStat(std::string(model_path), hasher));
+  if (!file || absl::string_view(magic, sizeof(magic)) != "LITERTLM") {
+    file.clear();
+    RETURN_IF_ERROR(HashSampledBlocks(file, file_size, hasher));
+    return hasher.hash();
+  }
+
+  schema::LitertlmHeader header;
+  RETURN_IF_ERROR(schema::ReadHeaderFromLiteRTLM(file, &header));
+  const uint64_t header_end_offset = file.tellg();
+  RETURN_IF_ERROR(HashRange(file, 0, header_end_offset, hasher));
+  if (header.metadata == nullptr ||
+      header.metadata->section_metadata() == nullptr ||
+      header.metadata->section_metadata()->objects() == nullptr) {
+    return absl::InvalidArgumentError("The model has no section metadata.");
+  }
+  for (const auto* section : *header.metadata->section_metadata()->objects()) {
+    const uint64_t begin_offset = section->begin_offset();
+    const uint64_t end_offset = section->end_offset();
+    if (begin_offset > end_offset || end_offset > file_size) {
+      return absl::DataLossError(absl::StrFormat(
+          "Section [%d, %d) is out of the file of %d bytes.", begin_offset,
+          end_offset, file_size));
+    }
+    RETURN_IF_ERROR(HashRangeEnds(file, begin_offset, end_offset, hasher));
+  }
+  return hasher.hash();
+}
+
+// static
+absl::StatusOr<std::unique_ptr<WeightCacheManager>> WeightCacheManager::Open(
+    absl::string_view cache_dir, absl::string_view model_path,
+    uint32_t num_threads) {
+  ASSIGN_OR_RETURN(const uint64_t fingerprint,
+                   ComputeModelFingerprint(model_path));
+  Fnv1aHasher hasher;
+  hasher.Update(fingerprint);
+  hasher.Update(num_threads);
+  hasher.Update(kWeightCacheVersion);
+  // XNNPack is linked into LiteRT, so an upgrade of either changes the LiteRT
+  // version and may change the packing of the weights.
+  hasher.Update(LITERT_API_VERSION_MAJOR);
+  hasher.Update(LITERT_API_VERSION_MINOR);
+  hasher.Update(LITERT_API_VERSION_PATCH);
+  const uint64_t key = hasher.hash();
+
+  const std::string file_name = absl::StrFormat(
+      "%s.%016x.xnnpack_cache", Basename(model_path), key);
+  ASSIGN_OR_RETURN(
+      std::string cache_path,
+      JoinPath(cache_dir.empty() ? Dirname(model_path) : cache_dir, file_name));
+  auto manager =
+      absl::WrapUnique(new WeightCacheManager(std::move(cache_path), key));
+  manager->hit_ = manager->Validate();
+  if (!manager->hit_) {
+    RemoveStaleTempFiles(manager->cache_path_);
+  }
+  return manager;
+}
+
+WeightCacheManager::WeightCacheManager(std::string cache_path, uint64_t key)
+    : cache_path_(std::move(cache_path)),
+      manifest_path_(absl::StrCat(cache_path_, ".manifest")),
+      temp_path_(GetUniqueTempPath(cache_path_)),
+      key_(key) {}
+
+WeightCacheManager::~WeightCacheManager() {
+  if (!hit_ && !committed_) {
+    RemoveIfExists(temp_path_);
+  }
+}
+
+bool WeightCacheManager::Validate() {
+  std::ifstream manifest_file(manifest_path_, std::ios::binary);
+  Manifest manifest;
+  uint64_t cache_size = 0;
+  std::string error;
+  std::error_code exists_error;
+  if (!manifest_file.is_open() ||
+      !std::filesystem::exists(cache_path_, exists_error)) {
+    // Not built yet, or interrupted between publishing the cache and its
+    // manifest.
+  } else if (!manifest_file.read(reinterpret_cast<char*>(&manifest),
+                                 sizeof(manifest)) ||
+             std::memcmp(manifest.magic, kManifestMagic,
+                         sizeof(kManifestMagic)) != 0 ||
+             manifest.version != kWeightCacheVersion || manifest.key != key_) {
+    error = "invalid manifest";
+  } else if (auto checksum = ComputeCacheChecksum(cache_path_, cache_size);
+             !checksum.ok()) {
+    error = checksum.status().ToString();
+  } else if (cache_size != manifest.cache_size ||
+             *checksum != manifest.cache_checksum) {
+    error = "the cache does not match its manifest";
+  } else {
+    build_duration_ = absl::Microseconds(manifest.build_duration_us);
+    return true;
+  }
+  if (!error.empty()) {
+    ABSL_LOG(WARNING) << "Rebuilding the weight cache " << cache_path_ << ": "
+                      << error;
+  }
+  RemoveIfExists(cache_path_);
+  RemoveIfExists(manifest_path_);
+  return false;
+}
+
+absl::StatusOr<WeightCacheStats> WeightCacheManager::Commit(
+    absl::Duration init_duration) {
+  if (committed_) {
+    return absl::FailedPreconditionError("The weight cache is committed.");
+  }
+  committed_ = true;
+  WeightCacheStats stats;
+  stats.hit = hit_;
+  stats.init_duration = init_duration;
+  if (hit_) {
+    stats.time_saved =
+        std::max(build_duration_ - init_duration, absl::ZeroDuration());
+    return stats;
+  }
+
+  Manifest manifest = {};
+  std::memcpy(manifest.magic, kManifestMagic, sizeof(kManifestMagic));
+  manifest.version = kWeightCacheVersion;
+  manifest.key = key_;
+  manifest.build_duration_us = absl::ToInt64Microseconds(init_duration);
+  ASSIGN_OR_RETURN(manifest.cache_checksum,
+                   ComputeCacheChecksum(temp_path_, manifest.cache_size));
+
+  // Publish the cache before its manifest, so that an interruption leaves at
+  // worst a cache without manifest, which is rebuilt on the next start.
+  RETURN_IF_ERROR(Rename(temp_path_, cache_path_));
+  const std::string temp_manifest_path = GetUniqueTempPath(manifest_path_);
+  {
+    std::ofstream manifest_file(temp_manifest_path,
+                                std::ios::binary | std::ios::trunc);
+    manifest_file.write(reinterpret_cast<const char*>(&manifest),
+                        sizeof(manifest));
+    if (!manifest_file) {
+      RemoveIfExists(temp_manifest_path);
+      return absl::InternalError(
+          absl::StrCat("Failed to write ", temp_manifest_path));
+    }
+  }
+  RETURN_IF_ERROR(Rename(temp_manifest_path, manifest_path_));
+  return stats;
+}
+
+}  // namespace litert::lm
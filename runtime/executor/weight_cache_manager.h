@@ -0,0 +1,128 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_WEIGHT_CACHE_MANAGER_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_WEIGHT_CACHE_MANAGER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// The version of the weight cache files written by this runtime. It is part of
+// the cache key, together with the LiteRT version, so it must be bumped
+// whenever a change of this runtime changes the layout of the packed weights.
+constexpr uint32_t kWeightCacheVersion = 1;
+
+// The outcome of initializing a backend with a weight cache.
+struct WeightCacheStats {
+  // Whether a valid cache was found and used by the backend.
+  bool hit = false;
+  // The time the backend took to initialize.
+  absl::Duration init_duration;
+  // On a hit, the time saved compared to the initialization which built the
+  // cache. Zero on a miss.
+  absl::Duration time_saved;
+};
+
+// Computes a fingerprint of the model file which changes whenever its weights
+// change. Hashing whole models of several GBs would take longer than the
+// weight packing the cache saves, so only a sample is hashed, together with the
+// size, modification time and inode of the file, which change whenever the
+// file is rewritten or replaced even if the sampled bytes are the same:
+// - For .litertlm files, the header, which holds the type, offsets and sizes
+//   of every section, and the first and last 64KB of each section.
+// - For other files, the file size and 64KB blocks at 16 evenly spaced
+//   offsets.
+absl::StatusOr<uint64_t> ComputeModelFingerprint(absl::string_view model_path);
+
+// Manages the XNNPack weight cache of a model, which holds the weights packed
+// for the CPU kernels. The cache file is keyed by the model fingerprint, the
+// number of threads, the LiteRT version (which XNNPack is built with) and
+// kWeightCacheVersion, so a cache built for another model, configuration or
+// runtime is never used.
+//
+// On a miss, the backend builds the cache into a temporary file with a unique
+// name, so concurrent processes never write into the same file, which
+// Commit() publishes atomically by renaming it, followed by a manifest
+// recording the size and a checksum of the cache. On a hit, the backend maps
+// the published cache instead of packing the weights again. A cache that does
+// not match its manifest (e.g. a truncated or overwritten file) is deleted
+// and rebuilt as a miss. Temporary files left by a crashed process are
+// removed once they are a day old.
+//
+// Usage:
+//   ASSIGN_OR_RETURN(auto cache, WeightCacheManager::Open(
+//       cache_dir, model_path, num_threads));
+//   options.SetXNNPackWeightCachePath(cache->GetBackendCachePath().c_str());
+//   ... initialize the backend, which takes init_duration ...
+//   ASSIGN_OR_RETURN(WeightCacheStats stats, cache->Commit(init_duration));
+class WeightCacheManager {
+ public:
+  // Computes the cache key and validates the existing cache, if any.
+  // - cache_dir: The directory of the cache, or empty for the directory of
+  //   the model.
+  static absl::StatusOr<std::unique_ptr<WeightCacheManager>> Open(
+      absl::string_view cache_dir, absl::string_view model_path,
+      uint32_t num_threads);
+
+  // Removes the temporary cache file if it was not committed.
+  ~WeightCacheManager();
+
+  WeightCacheManager(const WeightCacheManager&) = delete;
+  WeightCacheManager& operator=(const WeightCacheManager&) = delete;
+
+  // Whether a valid cache was found.
+  bool IsHit() const { return hit_; }
+
+  // The path of the published cache.
+  const std::string& GetCachePath() const { return cache_path_; }
+
+  // The path the backend should use: the published cache on a hit, or the
+  // temporary file to build the cache into on a miss.
+  const std::string& GetBackendCachePath() const {
+    return hit_ ? cache_path_ : temp_path_;
+  }
+
+  // Completes the initialization of the backend, which took `init_duration`.
+  // On a miss, publishes the cache the backend built, recording
+  // `init_duration` as its build time. Must be called at most once.
+  absl::StatusOr<WeightCacheStats> Commit(absl::Duration init_duration);
+
+ private:
+  WeightCacheManager(std::string cache_path, uint64_t key);
+
+  // Checks the published cache against its manifest. Returns false, after
+  // deleting both, if they do not match.
+  bool Validate();
+
+  const std::string cache_path_;
+  const std::string manifest_path_;
+  const std::string temp_path_;
+  const uint64_t key_;
+  bool hit_ = false;
+  bool committed_ = false;
+  // The build time recorded in the manifest of a valid cache.
+  absl::Duration build_duration_;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_EXECUTOR_WEIGHT_CACHE_MANAGER_H_
@@ -0,0 +1,209 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/executor/weight_cache_manager.h"
+
+#include <chrono>  // NOLINT: Required for the age of the temporary files.
+#include <cstdint>
+#include <filesystem>  // NOLINT: Required for path manipulation.
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::status::IsOkAndHolds;
+using ::testing::status::StatusIs;
+
+void WriteFile(const std::string& path, absl::string_view content) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << content;
+}
+
+class WeightCacheManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::path(::testing::TempDir()) /
+           ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+    model_path_ = (dir_ / "model.tflite").string();
+    // Larger than the sampled blocks, so that the fingerprint is sampled.
+    WriteFile(model_path_, std::string(2 * 1024 * 1024, 'w'));
+  }
+
+  // Opens the cache and simulates the backend, which builds the cache into
+  // the backend path on a miss.
+  std::unique_ptr<WeightCacheManager> OpenAndBuild(uint32_t num_threads = 4) {
+    auto cache = WeightCacheManager::Open(/*cache_dir=*/"", model_path_,
+                                          num_threads);
+    EXPECT_OK(cache);
+    if (!(*cache)->IsHit()) {
+      WriteFile((*cache)->GetBackendCachePath(), "packed weights");
+    }
+    return std::move(*cache);
+  }
+
+  std::filesystem::path dir_;
+  std::string model_path_;
+};
+
+TEST_F(WeightCacheManagerTest, MissThenHit) {
+  auto cache = OpenAndBuild();
+  EXPECT_FALSE(cache->IsHit());
+  EXPECT_EQ(std::filesystem::path(cache->GetCachePath()).parent_path(), dir_);
+  EXPECT_NE(cache->GetBackendCachePath(), cache->GetCachePath());
+  ASSERT_OK_AND_ASSIGN(WeightCacheStats stats,
+                       cache->Commit(absl::Seconds(3)));
+  EXPECT_FALSE(stats.hit);
+  EXPECT_EQ(stats.time_saved, absl::ZeroDuration());
+  EXPECT_TRUE(std::filesystem::exists(cache->GetCachePath()));
+  EXPECT_FALSE(std::filesystem::exists(cache->GetBackendCachePath()));
+  EXPECT_THAT(cache->Commit(absl::Seconds(3)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+
+  cache = OpenAndBuild();
+  EXPECT_TRUE(cache->IsHit());
+  EXPECT_EQ(cache->GetBackendCachePath(), cache->GetCachePath());
+  ASSERT_OK_AND_ASSIGN(stats, cache->Commit(absl::Seconds(1)));
+  EXPECT_TRUE(stats.hit);
+  EXPECT_EQ(stats.init_duration, absl::Seconds(1));
+  EXPECT_EQ(stats.time_saved, absl::Seconds(2));
+}
+
+TEST_F(WeightCacheManagerTest, CacheDir) {
+  const std::filesystem::path cache_dir = dir_ / "cache";
+  std::filesystem::create_directories(cache_dir);
+  ASSERT_OK_AND_ASSIGN(auto cache, WeightCacheManager::Open(
+                                        cache_dir.string(), model_path_,
+                                        /*num_threads=*/4));
+  EXPECT_EQ(std::filesystem::path(cache->GetCachePath()).parent_path(),
+            cache_dir);
+}
+
+TEST_F(WeightCacheManagerTest, KeyDependsOnModelAndThreads) {
+  auto cache = OpenAndBuild(/*num_threads=*/4);
+  ASSERT_OK(cache->Commit(absl::Seconds(1)));
+  const std::string cache_path = cache->GetCachePath();
+
+  EXPECT_FALSE(OpenAndBuild(/*num_threads=*/2)->IsHit());
+
+  // Modifies the end of the model, which is covered by the last sampled
+  // block.
+  {
+    std::fstream model(model_path_,
+                       std::ios::binary | std::ios::in | std::ios::out);
+    model.seekp(-100, std::ios::end);
+    model << "new weights";
+  }
+  cache = OpenAndBuild(/*num_threads=*/4);
+  EXPECT_FALSE(cache->IsHit());
+  EXPECT_NE(cache->GetCachePath(), cache_path);
+}
+
+TEST_F(WeightCacheManagerTest, ReplacedModelIsAMiss) {
+  ASSERT_OK(OpenAndBuild()->Commit(absl::Seconds(1)));
+  // A model which only differs outside of the sampled bytes is not told apart
+  // by its content, but by its file metadata. Here, the content is the same.
+  const std::string new_model_path = model_path_ + ".new";
+  WriteFile(new_model_path, std::string(2 * 1024 * 1024, 'w'));
+  std::filesystem::rename(new_model_path, model_path_);
+
+  EXPECT_FALSE(OpenAndBuild()->IsHit());
+}
+
+TEST_F(WeightCacheManagerTest, ConcurrentBuildsUseTheirOwnTempFiles) {
+  auto first = OpenAndBuild();
+  auto second = OpenAndBuild();
+  EXPECT_NE(first->GetBackendCachePath(), second->GetBackendCachePath());
+  ASSERT_OK(first->Commit(absl::Seconds(1)));
+  ASSERT_OK(second->Commit(absl::Seconds(1)));
+  EXPECT_TRUE(OpenAndBuild()->IsHit());
+}
+
+TEST_F(WeightCacheManagerTest, StaleTempFilesAreRemoved) {
+  ASSERT_OK_AND_ASSIGN(auto cache, WeightCacheManager::Open(
+                                        /*cache_dir=*/"", model_path_,
+                                        /*num_threads=*/4));
+  const std::string stale_path = cache->GetCachePath() + ".0123.tmp";
+  const std::string recent_path = cache->GetCachePath() + ".4567.tmp";
+  WriteFile(stale_path, "crashed build");
+  WriteFile(recent_path, "running build");
+  std::filesystem::last_write_time(
+      stale_path,
+      std::filesystem::file_time_type::clock::now() - std::chrono::hours(48));
+
+  ASSERT_OK(WeightCacheManager::Open(/*cache_dir=*/"", model_path_,
+                                     /*num_threads=*/4));
+  EXPECT_FALSE(std::filesystem::exists(stale_path));
+  EXPECT_TRUE(std::filesystem::exists(recent_path));
+}
+
+TEST_F(WeightCacheManagerTest, CorruptCacheIsRebuilt) {
+  auto cache = OpenAndBuild();
+  ASSERT_OK(cache->Commit(absl::Seconds(1)));
+  WriteFile(cache->GetCachePath(), "truncated");
+
+  cache = OpenAndBuild();
+  EXPECT_FALSE(cache->IsHit());
+  EXPECT_FALSE(std::filesystem::exists(cache->GetCachePath()));
+  ASSERT_OK(cache->Commit(absl::Seconds(1)));
+  EXPECT_TRUE(OpenAndBuild()->IsHit());
+}
+
+TEST_F(WeightCacheManagerTest, CacheWithoutManifestIsRebuilt) {
+  auto cache = OpenAndBuild();
+  ASSERT_OK(cache->Commit(absl::Seconds(1)));
+  std::filesystem::remove(cache->GetCachePath() + ".manifest");
+
+  EXPECT_FALSE(OpenAndBuild()->IsHit());
+}
+
+TEST_F(WeightCacheManagerTest, UncommittedBuildIsDiscarded) {
+  std::string temp_path;
+  {
+    auto cache = OpenAndBuild();
+    temp_path = cache->GetBackendCachePath();
+    EXPECT_TRUE(std::filesystem::exists(temp_path));
+  }
+  EXPECT_FALSE(std::filesystem::exists(temp_path));
+  EXPECT_FALSE(OpenAndBuild()->IsHit());
+}
+
+TEST(ComputeModelFingerprintTest, LitertLmModel) {
+  const std::string model_path =
+      (std::filesystem::path(::testing::SrcDir()) /
+       "litert_lm/runtime/testdata/test_lm.litertlm")
+          .string();
+  ASSERT_OK_AND_ASSIGN(const uint64_t fingerprint,
+                       ComputeModelFingerprint(model_path));
+  EXPECT_THAT(ComputeModelFingerprint(model_path),
+              IsOkAndHolds(fingerprint));
+}
+
+TEST(ComputeModelFingerprintTest, MissingModel) {
+  EXPECT_THAT(ComputeModelFingerprint("/does/not/exist.litertlm"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace litert::lm
@@ -0,0 +1,92 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_LITERT_LM_RUNTIME_FRAMEWORK_SPSC_QUEUE_H_
+#define THIRD_PARTY_LITERT_LM_RUNTIME_FRAMEWORK_SPSC_QUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace litert::lm {
+
+// A bounded lock-free queue between one producer thread and one consumer
+// thread. Neither side ever blocks: TryPush() fails when the queue is full and
+// TryPop() fails when it is empty, and the caller decides how to wait.
+//
+// Sample usage:
+//
+// SpscQueue<int> queue(/*capacity=*/4);
+// // Producer thread.
+// while (!queue.TryPush(value)) std::this_thread::yield();
+// // Consumer thread.
+// int value;
+// while (!queue.TryPop(value)) std::this_thread::yield();
+//
+template <typename T>
+class SpscQueue {
+ public:
+  // Creates a queue holding up to `capacity` elements, at least 1.
+  explicit SpscQueue(size_t capacity)
+      : slots_(std::max<size_t>(capacity, 1) + 1) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  size_t capacity() const { return slots_.size() - 1; }
+
+  // Adds `value` to the back of the queue, unless it is full. Only called by
+  // the producer thread.
+  bool TryPush(T value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t next_tail = Next(tail);
+    if (next_tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots_[tail] = std::move(value);
+    tail_.store(next_tail, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the front of the queue to `value`, unless it is empty. Only called
+  // by the consumer thread.
+  bool TryPop(T& value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = std::move(slots_[head]);
+    head_.store(Next(head), std::memory_order_release);
+    return true;
+  }
+
+ private:
+  size_t Next(size_t index) const {
+    return index + 1 == slots_.size() ? 0 : index + 1;
+  }
+
+  // One slot is kept empty to tell a full queue from an empty one.
+  std::vector<T> slots_;
+  // The index of the front element, written by the consumer only. The indices
+  // are on separate cache lines so that the two threads do not contend.
+  alignas(64) std::atomic<size_t> head_ = 0;
+  // The index past the back element, written by the producer only.
+  alignas(64) std::atomic<size_t> tail_ = 0;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_LITERT_LM_RUNTIME_FRAMEWORK_SPSC_QUEUE_H_
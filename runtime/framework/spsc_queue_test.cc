@@ -0,0 +1,86 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/framework/spsc_queue.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pointee;
+
+TEST(SpscQueueTest, PushAndPopInOrder) {
+  SpscQueue<int> queue(/*capacity=*/2);
+  EXPECT_EQ(queue.capacity(), 2u);
+  int value = 0;
+  EXPECT_FALSE(queue.TryPop(value));
+  EXPECT_TRUE(queue.TryPush(1));
+  EXPECT_TRUE(queue.TryPush(2));
+  // The queue is full.
+  EXPECT_FALSE(queue.TryPush(3));
+  EXPECT_TRUE(queue.TryPop(value));
+  EXPECT_EQ(value, 1);
+  // The freed slot is reused across the end of the ring.
+  EXPECT_TRUE(queue.TryPush(3));
+  std::vector<int> values;
+  while (queue.TryPop(value)) {
+    values.push_back(value);
+  }
+  EXPECT_THAT(values, ElementsAre(2, 3));
+}
+
+TEST(SpscQueueTest, MovesElements) {
+  SpscQueue<std::unique_ptr<int>> queue(/*capacity=*/1);
+  EXPECT_TRUE(queue.TryPush(std::make_unique<int>(7)));
+  std::unique_ptr<int> value;
+  EXPECT_TRUE(queue.TryPop(value));
+  EXPECT_THAT(value, Pointee(7));
+}
+
+TEST(SpscQueueTest, TransfersBetweenThreads) {
+  constexpr int kNumValues = 100000;
+  SpscQueue<int> queue(/*capacity=*/4);
+  std::thread producer([&queue]() {
+    for (int i = 0; i < kNumValues; ++i) {
+      while (!queue.TryPush(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::vector<int> values;
+  values.reserve(kNumValues);
+  while (values.size() < kNumValues) {
+    int value;
+    if (queue.TryPop(value)) {
+      values.push_back(value);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  for (int i = 0; i < kNumValues; ++i) {
+    ASSERT_EQ(values[i], i);
+  }
+}
+
+}  // namespace
+}  // namespace litert::lm
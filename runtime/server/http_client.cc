@@ -0,0 +1,173 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/http_client.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/ascii.h"  // from @com_google_absl
+#include "absl/strings/match.h"  // from @com_google_absl
+#include "absl/strings/numbers.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/strings/strip.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+
+namespace litert::lm {
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+// Closes the socket when going out of scope.
+class ScopedSocket {
+ public:
+  explicit ScopedSocket(int fd) : fd_(fd) {}
+  ~ScopedSocket() {
+    if (fd_ >= 0) close(fd_);
+  }
+  int fd() const { return fd_; }
+
+ private:
+  const int fd_;
+};
+
+// Moves the complete events at the front of `stream` to `events`.
+void ExtractEvents(std::string& stream, std::vector<std::string>& events) {
+  size_t end;
+  while ((end = stream.find("\n\n")) != std::string::npos) {
+    absl::string_view event = absl::string_view(stream).substr(0, end);
+    if (absl::ConsumePrefix(&event, "data:")) {
+      events.push_back(std::string(absl::StripLeadingAsciiWhitespace(event)));
+    }
+    stream.erase(0, end + 2);
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<HttpClientResponse> SendHttpRequest(int port,
+                                                   absl::string_view method,
+                                                   absl::string_view path,
+                                                   absl::string_view body,
+                                                   absl::Duration timeout) {
+  ScopedSocket socket_fd(socket(AF_INET, SOCK_STREAM, 0));
+  if (socket_fd.fd() < 0) {
+    return absl::InternalError(
+        absl::StrCat("Failed to create a socket: ", std::strerror(errno)));
+  }
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const absl::Time start = absl::Now();
+  const absl::Time deadline = start + timeout;
+  if (connect(socket_fd.fd(), reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    return absl::UnavailableError(absl::StrCat(
+        "Failed to connect to port ", port, ": ", std::strerror(errno)));
+  }
+  const std::string request = absl::StrCat(
+      method, " ", path, " HTTP/1.1\r\nHost: localhost\r\n",
+      "Content-Type: application/json\r\nContent-Length: ", body.size(),
+      "\r\nConnection: close\r\n\r\n", body);
+  for (absl::string_view data = request; !data.empty();) {
+    const ssize_t sent = send(socket_fd.fd(), data.data(), data.size(),
+                              kSendFlags);
+    if (sent <= 0) {
+      return absl::UnavailableError("Failed to send the request.");
+    }
+    data.remove_prefix(sent);
+  }
+
+  HttpClientResponse response;
+  std::string received;
+  // The part of the event stream not split into events yet.
+  std::string stream;
+  size_t head_end = std::string::npos;
+  bool is_event_stream = false;
+  char chunk[16 * 1024];
+  while (true) {
+    const int timeout_ms =
+        absl::ToInt64Milliseconds(deadline - absl::Now()) + 1;
+    pollfd poll_fd{};
+    poll_fd.fd = socket_fd.fd();
+    poll_fd.events = POLLIN;
+    if (timeout_ms <= 0 || poll(&poll_fd, 1, timeout_ms) <= 0) {
+      return absl::DeadlineExceededError("Timed out reading the response.");
+    }
+    const ssize_t size = recv(socket_fd.fd(), chunk, sizeof(chunk), 0);
+    if (size < 0 && errno == EINTR) {
+      continue;
+    }
+    if (size < 0) {
+      return absl::UnavailableError("Failed to read the response.");
+    }
+    if (size == 0) {
+      break;
+    }
+    absl::string_view data(chunk, size);
+    if (head_end == std::string::npos) {
+      absl::StrAppend(&received, data);
+      head_end = received.find("\r\n\r\n");
+      if (head_end == std::string::npos) {
+        continue;
+      }
+      const absl::string_view head =
+          absl::string_view(received).substr(0, head_end);
+      if (!absl::StartsWith(head, "HTTP/1.1 ") ||
+          !absl::SimpleAtoi(head.substr(9, 3), &response.status_code)) {
+        return absl::DataLossError("Malformed response.");
+      }
+      is_event_stream = absl::StrContains(absl::AsciiStrToLower(head),
+                                          "content-type: text/event-stream");
+      data = absl::string_view(received).substr(head_end + 4);
+    }
+    absl::StrAppend(&response.body, data);
+    if (is_event_stream) {
+      absl::StrAppend(&stream, data);
+      ExtractEvents(stream, response.events);
+      if (!response.events.empty() &&
+          response.time_to_first_event == absl::ZeroDuration()) {
+        response.time_to_first_event = absl::Now() - start;
+      }
+    }
+  }
+  if (head_end == std::string::npos) {
+    return absl::DataLossError("The connection closed without a response.");
+  }
+  response.total_time = absl::Now() - start;
+  if (!is_event_stream) {
+    response.time_to_first_event = response.total_time;
+  }
+  return response;
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,50 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_HTTP_CLIENT_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_HTTP_CLIENT_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// The response to a request sent with SendHttpRequest().
+struct HttpClientResponse {
+  int status_code = 0;
+  // The body, or the raw event stream for "text/event-stream" responses.
+  std::string body;
+  // The data of the server-sent events, in order.
+  std::vector<std::string> events;
+  // The time from sending the request to receiving the first event, or the
+  // whole response if it is not an event stream.
+  absl::Duration time_to_first_event;
+  // The time from sending the request to the end of the response.
+  absl::Duration total_time;
+};
+
+// Sends an HTTP/1.1 request to a local HttpServer and reads the response
+// until the server closes the connection. The client of the tests and of the
+// load generator.
+absl::StatusOr<HttpClientResponse> SendHttpRequest(
+    int port, absl::string_view method, absl::string_view path,
+    absl::string_view body, absl::Duration timeout = absl::Minutes(10));
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_HTTP_CLIENT_H_
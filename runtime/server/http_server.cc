@@ -0,0 +1,393 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/log/absl_log.h"  // from @com_google_absl
+#include "absl/memory/memory.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/ascii.h"  // from @com_google_absl
+#include "absl/strings/match.h"  // from @com_google_absl
+#include "absl/strings/numbers.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/str_split.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+
+namespace litert::lm {
+namespace {
+
+// The interval of the accept and disconnection polls, which bounds the time
+// to stop the server and to detect a disconnection.
+constexpr int kPollIntervalMs = 50;
+// The maximum size of the request line and headers.
+constexpr size_t kMaxHeaderSize = 64 * 1024;
+// The time a client has to send its request.
+constexpr absl::Duration kReadTimeout = absl::Seconds(30);
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+absl::string_view ReasonPhrase(int status_code) {
+  switch (status_code) {
+    case 200:
+      return "OK";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    case 405:
+      return "Method Not Allowed";
+    case 408:
+      return "Request Timeout";
+    case 411:
+      return "Length Required";
+    case 413:
+      return "Payload Too Large";
+    case 429:
+      return "Too Many Requests";
+    case 499:
+      return "Client Closed Request";
+    case 500:
+      return "Internal Server Error";
+    case 503:
+      return "Service Unavailable";
+    default:
+      return "Unknown";
+  }
+}
+
+bool SendAll(int fd, absl::string_view data) {
+  while (!data.empty()) {
+    const ssize_t sent = send(fd, data.data(), data.size(), kSendFlags);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    data.remove_prefix(sent);
+  }
+  return true;
+}
+
+// Reads from `fd` into `buffer` until it holds at least `size` bytes, or
+// until the deadline. Returns false on timeout, error or end of stream.
+bool ReadAtLeast(int fd, size_t size, absl::Time deadline,
+                 std::string& buffer) {
+  char chunk[16 * 1024];
+  while (buffer.size() < size) {
+    const int timeout_ms =
+        absl::ToInt64Milliseconds(deadline - absl::Now()) + 1;
+    pollfd poll_fd{};
+    poll_fd.fd = fd;
+    poll_fd.events = POLLIN;
+    if (timeout_ms <= 0 || poll(&poll_fd, 1, timeout_ms) <= 0) {
+      return false;
+    }
+    const ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+    if (received < 0 && errno == EINTR) {
+      continue;
+    }
+    if (received <= 0) {
+      return false;
+    }
+    buffer.append(chunk, received);
+  }
+  return true;
+}
+
+class SocketResponseWriter : public HttpResponseWriter {
+ public:
+  explicit SocketResponseWriter(int fd) : fd_(fd) {}
+
+  bool Send(int status_code, absl::string_view content_type,
+            absl::string_view body) override {
+    if (responded_) {
+      return false;
+    }
+    responded_ = true;
+    return Write(absl::StrCat("HTTP/1.1 ", status_code, " ",
+                              ReasonPhrase(status_code),
+                              "\r\nContent-Type: ", content_type,
+                              "\r\nContent-Length: ", body.size(),
+                              "\r\nConnection: close\r\n\r\n", body));
+  }
+
+  bool StartEventStream() override {
+    if (responded_) {
+      return false;
+    }
+    responded_ = true;
+    return Write(
+        "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\nConnection: close\r\n\r\n");
+  }
+
+  bool SendEvent(absl::string_view data) override {
+    return Write(absl::StrCat("data: ", data, "\n\n"));
+  }
+
+  const std::atomic_bool& Disconnected() const override {
+    return disconnected_;
+  }
+
+  std::atomic_bool& MutableDisconnected() { return disconnected_; }
+
+  bool responded() const { return responded_; }
+
+ private:
+  bool Write(absl::string_view data) {
+    if (disconnected_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (!SendAll(fd_, data)) {
+      disconnected_.store(true, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  const int fd_;
+  bool responded_ = false;
+  std::atomic_bool disconnected_ = false;
+};
+
+// Parses the request line and the headers.
+absl::StatusOr<HttpRequest> ParseRequestHead(absl::string_view head) {
+  std::vector<absl::string_view> lines = absl::StrSplit(head, "\r\n");
+  std::vector<absl::string_view> request_line =
+      absl::StrSplit(lines[0], ' ', absl::SkipEmpty());
+  if (request_line.size() != 3 || !absl::StartsWith(request_line[2], "HTTP/")) {
+    return absl::InvalidArgumentError("Malformed request line.");
+  }
+  HttpRequest request;
+  request.method = std::string(request_line[0]);
+  // The query string is not used by the handlers.
+  request.path = std::string(
+      request_line[1].substr(0, request_line[1].find('?')));
+  for (size_t i = 1; i < lines.size(); ++i) {
+    const size_t colon = lines[i].find(':');
+    if (colon == absl::string_view::npos) {
+      return absl::InvalidArgumentError("Malformed header.");
+    }
+    request.headers[absl::AsciiStrToLower(lines[i].substr(0, colon))] =
+        std::string(absl::StripAsciiWhitespace(lines[i].substr(colon + 1)));
+  }
+  return request;
+}
+
+}  // namespace
+
+// static
+absl::StatusOr<std::unique_ptr<HttpServer>> HttpServer::Start(
+    const HttpServerOptions& options, Handler handler) {
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid IPv4 address: ", options.host));
+  }
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return absl::InternalError(
+        absl::StrCat("Failed to create a socket: ", std::strerror(errno)));
+  }
+  const int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(fd, options.max_pending_connections) != 0) {
+    const absl::Status status = absl::UnavailableError(
+        absl::StrCat("Failed to listen on ", options.host, ":", options.port,
+                     ": ", std::strerror(errno)));
+    close(fd);
+    return status;
+  }
+  socklen_t address_size = sizeof(address);
+  getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_size);
+
+  auto server = absl::WrapUnique(
+      new HttpServer(options, std::move(handler), fd, ntohs(address.sin_port)));
+  HttpServer* server_ptr = server.get();
+  ABSL_CHECK_OK(server->loop_pool_.Schedule(
+      [server_ptr]() { server_ptr->AcceptLoop(); }));
+  ABSL_CHECK_OK(server->loop_pool_.Schedule(
+      [server_ptr]() { server_ptr->MonitorLoop(); }));
+  ABSL_LOG(INFO) << "Listening on " << options.host << ":" << server->port();
+  return server;
+}
+
+HttpServer::HttpServer(const HttpServerOptions& options, Handler handler,
+                       int listen_fd, int port)
+    : options_(options),
+      handler_(std::move(handler)),
+      listen_fd_(listen_fd),
+      port_(port),
+      loop_pool_("http_server_loop", /*max_num_threads=*/2),
+      connection_pool_("http_server", options.num_threads) {}
+
+HttpServer::~HttpServer() {
+  stopped_ = true;
+  ABSL_CHECK_OK(loop_pool_.WaitUntilDone(absl::InfiniteDuration()));
+  ABSL_CHECK_OK(connection_pool_.WaitUntilDone(absl::InfiniteDuration()));
+  close(listen_fd_);
+}
+
+void HttpServer::AcceptLoop() {
+  while (!stopped_) {
+    pollfd poll_fd{};
+    poll_fd.fd = listen_fd_;
+    poll_fd.events = POLLIN;
+    if (poll(&poll_fd, 1, kPollIntervalMs) <= 0) {
+      continue;
+    }
+    const int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      if (num_pending_connections_ >= options_.max_pending_connections) {
+        SocketResponseWriter(fd).Send(
+            503, "application/json",
+            R"({"error":{"message":"The server is overloaded.",)"
+            R"("type":"server_overloaded"}})");
+        close(fd);
+        continue;
+      }
+      ++num_pending_connections_;
+    }
+    auto status = connection_pool_.Schedule([this, fd]() {
+      HandleConnection(fd);
+      absl::MutexLock lock(&mutex_);
+      --num_pending_connections_;
+    });
+    if (!status.ok()) {
+      ABSL_LOG(ERROR) << "Failed to schedule a connection: " << status;
+      close(fd);
+      absl::MutexLock lock(&mutex_);
+      --num_pending_connections_;
+    }
+  }
+}
+
+void HttpServer::MonitorLoop() {
+  std::vector<pollfd> poll_fds;
+  while (!stopped_) {
+    absl::SleepFor(absl::Milliseconds(kPollIntervalMs));
+    absl::MutexLock lock(&mutex_);
+    poll_fds.clear();
+    for (const auto& [fd, disconnected] : connections_) {
+      pollfd poll_fd{};
+      poll_fd.fd = fd;
+      poll_fd.events = POLLIN;
+      poll_fds.push_back(poll_fd);
+    }
+    if (poll(poll_fds.data(), poll_fds.size(), /*timeout=*/0) <= 0) {
+      continue;
+    }
+    for (const pollfd& poll_fd : poll_fds) {
+      if (poll_fd.revents == 0) {
+        continue;
+      }
+      // The request was read entirely, so a readable socket without data is
+      // a closed connection. Note that this includes clients which only shut
+      // down their side of the connection after sending the request.
+      char byte;
+      if ((poll_fd.revents & (POLLHUP | POLLERR)) != 0 ||
+          recv(poll_fd.fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+        connections_[poll_fd.fd]->store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+void HttpServer::HandleConnection(int fd) {
+  SocketResponseWriter writer(fd);
+  const absl::Time deadline = absl::Now() + kReadTimeout;
+  std::string buffer;
+  size_t head_end;
+  while ((head_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+    if (buffer.size() > kMaxHeaderSize ||
+        !ReadAtLeast(fd, buffer.size() + 1, deadline, buffer)) {
+      writer.Send(buffer.size() > kMaxHeaderSize ? 413 : 408, "text/plain",
+                  "Invalid request.");
+      close(fd);
+      return;
+    }
+  }
+  absl::StatusOr<HttpRequest> request =
+      ParseRequestHead(absl::string_view(buffer).substr(0, head_end));
+  size_t content_length = 0;
+  int error_code = 0;
+  if (!request.ok()) {
+    error_code = 400;
+  } else if (request->headers.contains("transfer-encoding")) {
+    error_code = 411;
+  } else if (auto it = request->headers.find("content-length");
+             it != request->headers.end() &&
+             !absl::SimpleAtoi(it->second, &content_length)) {
+    error_code = 400;
+  } else if (content_length > options_.max_body_size) {
+    error_code = 413;
+  } else if (!ReadAtLeast(fd, head_end + 4 + content_length, deadline,
+                          buffer)) {
+    error_code = 408;
+  }
+  if (error_code != 0) {
+    writer.Send(error_code, "text/plain", ReasonPhrase(error_code));
+    close(fd);
+    return;
+  }
+  request->body = buffer.substr(head_end + 4, content_length);
+
+  {
+    absl::MutexLock lock(&mutex_);
+    connections_[fd] = &writer.MutableDisconnected();
+  }
+  handler_(*request, writer);
+  {
+    absl::MutexLock lock(&mutex_);
+    connections_.erase(fd);
+  }
+  if (!writer.responded()) {
+    writer.Send(500, "text/plain", "The request was not handled.");
+  }
+  close(fd);
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,135 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_HTTP_SERVER_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_HTTP_SERVER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"  // from @com_google_absl
+#include "absl/container/flat_hash_map.h"  // from @com_google_absl
+#include "absl/functional/any_invocable.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+
+namespace litert::lm {
+
+// An HTTP request. The body is read entirely before the handler is called.
+struct HttpRequest {
+  std::string method;
+  std::string path;
+  // The header names are lower case.
+  absl::flat_hash_map<std::string, std::string> headers;
+  std::string body;
+};
+
+// Writes the response of a request: either a whole response, or a stream of
+// server-sent events. The methods return false once the client is gone.
+class HttpResponseWriter {
+ public:
+  virtual ~HttpResponseWriter() = default;
+
+  // Sends a whole response.
+  virtual bool Send(int status_code, absl::string_view content_type,
+                    absl::string_view body) = 0;
+
+  // Starts a "text/event-stream" response. Must be called once, before
+  // SendEvent().
+  virtual bool StartEventStream() = 0;
+
+  // Sends a server-sent event with the given data, which must not contain
+  // empty lines.
+  virtual bool SendEvent(absl::string_view data) = 0;
+
+  // Set to true when the client disconnects, e.g. to cancel the request.
+  virtual const std::atomic_bool& Disconnected() const = 0;
+};
+
+struct HttpServerOptions {
+  // The address to listen on. The server is meant for local clients only.
+  std::string host = "127.0.0.1";
+  // The port to listen on, or 0 to pick a free port.
+  int port = 8080;
+  // The maximum number of connections handled concurrently.
+  int num_threads = 16;
+  // The maximum number of connections handled or waiting for a thread. The
+  // next connections are rejected with 503 Service Unavailable, so that
+  // clients back off instead of piling up requests.
+  int max_pending_connections = 64;
+  // The maximum size of a request body.
+  size_t max_body_size = 16 * 1024 * 1024;
+};
+
+// A minimal HTTP/1.1 server on POSIX sockets, closing the connection after
+// each response. It has no dependency beyond the runtime, which is enough for
+// a local serving front end and its load tests, but it does not implement
+// TLS, keep-alive or chunked request bodies.
+class HttpServer {
+ public:
+  using Handler =
+      absl::AnyInvocable<void(const HttpRequest&, HttpResponseWriter&)>;
+
+  // Starts listening and serving on background threads. `handler` is called
+  // concurrently from several threads.
+  static absl::StatusOr<std::unique_ptr<HttpServer>> Start(
+      const HttpServerOptions& options, Handler handler);
+
+  // Stops accepting connections and waits for the ongoing ones.
+  ~HttpServer();
+
+  HttpServer(const HttpServer&) = delete;
+  HttpServer& operator=(const HttpServer&) = delete;
+
+  // The port the server listens on.
+  int port() const { return port_; }
+
+ private:
+  HttpServer(const HttpServerOptions& options, Handler handler, int listen_fd,
+             int port);
+
+  // Accepts the connections until the server stops.
+  void AcceptLoop();
+  // Detects the clients which disconnect while their request is handled.
+  void MonitorLoop();
+  // Reads the request of a connection, handles it and closes the connection.
+  void HandleConnection(int fd);
+
+  const HttpServerOptions options_;
+  Handler handler_;
+  const int listen_fd_;
+  const int port_;
+  std::atomic_bool stopped_ = false;
+
+  absl::Mutex mutex_;
+  // The number of connections handled or waiting for a thread.
+  int num_pending_connections_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The connections being handled, and their disconnection flags.
+  absl::flat_hash_map<int, std::atomic_bool*> connections_
+      ABSL_GUARDED_BY(mutex_);
+
+  // The accept and monitor loops.
+  ThreadPool loop_pool_;
+  // The connection handlers.
+  ThreadPool connection_pool_;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_HTTP_SERVER_H_
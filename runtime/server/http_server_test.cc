@@ -0,0 +1,141 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/http_server.h"
+
+#include <atomic>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/synchronization/notification.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "runtime/server/http_client.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::status::StatusIs;
+
+HttpServerOptions TestOptions() {
+  HttpServerOptions options;
+  options.port = 0;
+  return options;
+}
+
+TEST(HttpServerTest, SendsResponse) {
+  ASSERT_OK_AND_ASSIGN(
+      auto server,
+      HttpServer::Start(TestOptions(), [](const HttpRequest& request,
+                                         HttpResponseWriter& writer) {
+        writer.Send(200, "text/plain",
+                    absl::StrCat(request.method, " ", request.path, " ",
+                                 request.headers.at("content-type"), " ",
+                                 request.body));
+      }));
+  ASSERT_OK_AND_ASSIGN(
+      HttpClientResponse response,
+      SendHttpRequest(server->port(), "POST", "/echo?x=1", "hello"));
+  EXPECT_EQ(response.status_code, 200);
+  EXPECT_EQ(response.body, "POST /echo application/json hello");
+  EXPECT_TRUE(response.events.empty());
+}
+
+TEST(HttpServerTest, StreamsEvents) {
+  ASSERT_OK_AND_ASSIGN(
+      auto server,
+      HttpServer::Start(TestOptions(),
+                        [](const HttpRequest&, HttpResponseWriter& writer) {
+                          writer.StartEventStream();
+                          writer.SendEvent("1");
+                          writer.SendEvent("2");
+                          writer.SendEvent("[DONE]");
+                        }));
+  ASSERT_OK_AND_ASSIGN(HttpClientResponse response,
+                       SendHttpRequest(server->port(), "GET", "/", ""));
+  EXPECT_EQ(response.status_code, 200);
+  EXPECT_THAT(response.events, ElementsAre("1", "2", "[DONE]"));
+  EXPECT_GT(response.time_to_first_event, absl::ZeroDuration());
+}
+
+TEST(HttpServerTest, UnhandledRequestFails) {
+  ASSERT_OK_AND_ASSIGN(
+      auto server,
+      HttpServer::Start(TestOptions(),
+                        [](const HttpRequest&, HttpResponseWriter&) {}));
+  ASSERT_OK_AND_ASSIGN(HttpClientResponse response,
+                       SendHttpRequest(server->port(), "GET", "/", ""));
+  EXPECT_EQ(response.status_code, 500);
+}
+
+TEST(HttpServerTest, RejectsConnectionsBeyondTheLimit) {
+  HttpServerOptions options = TestOptions();
+  options.num_threads = 1;
+  options.max_pending_connections = 1;
+  absl::Notification started;
+  absl::Notification release;
+  ASSERT_OK_AND_ASSIGN(
+      auto server,
+      HttpServer::Start(options, [&](const HttpRequest&,
+                                     HttpResponseWriter& writer) {
+        started.Notify();
+        release.WaitForNotification();
+        writer.Send(200, "text/plain", "done");
+      }));
+
+  ThreadPool client_pool("client", /*max_num_threads=*/1);
+  absl::StatusOr<HttpClientResponse> first;
+  ASSERT_OK(client_pool.Schedule([&]() {
+    first = SendHttpRequest(server->port(), "GET", "/", "");
+  }));
+  started.WaitForNotification();
+  ASSERT_OK_AND_ASSIGN(HttpClientResponse second,
+                       SendHttpRequest(server->port(), "GET", "/", ""));
+  EXPECT_EQ(second.status_code, 503);
+
+  release.Notify();
+  ASSERT_OK(client_pool.WaitUntilDone(absl::Seconds(10)));
+  ASSERT_OK(first);
+  EXPECT_EQ(first->status_code, 200);
+}
+
+TEST(HttpServerTest, DetectsDisconnectedClients) {
+  std::atomic_bool disconnected = false;
+  ASSERT_OK_AND_ASSIGN(
+      auto server,
+      HttpServer::Start(TestOptions(), [&](const HttpRequest&,
+                                           HttpResponseWriter& writer) {
+        const absl::Time deadline = absl::Now() + absl::Seconds(10);
+        while (!writer.Disconnected() && absl::Now() < deadline) {
+          absl::SleepFor(absl::Milliseconds(10));
+        }
+        disconnected = writer.Disconnected().load();
+        EXPECT_FALSE(writer.Send(200, "text/plain", "too late"));
+      }));
+  // The client gives up before the response.
+  EXPECT_THAT(SendHttpRequest(server->port(), "GET", "/", "",
+                              /*timeout=*/absl::Milliseconds(100)),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+  server.reset();
+  EXPECT_TRUE(disconnected);
+}
+
+}  // namespace
+}  // namespace litert::lm
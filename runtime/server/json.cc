@@ -0,0 +1,373 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/json.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/ascii.h"  // from @com_google_absl
+#include "absl/strings/numbers.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/util/status_macros.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+// The maximum nesting of arrays and objects, which bounds the recursion.
+constexpr int kMaxDepth = 64;
+
+// Appends `code_point` encoded in UTF-8.
+void AppendUtf8(uint32_t code_point, std::string& out) {
+  if (code_point < 0x80) {
+    out.push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+void AppendQuoted(absl::string_view text, std::string& out) {
+  out.push_back('"');
+  for (const char c : text) {
+    switch (c) {
+      case '"':
+        out.append("\\\"");
+        break;
+      case '\\':
+        out.append("\\\\");
+        break;
+      case '\n':
+        out.append("\\n");
+        break;
+      case '\r':
+        out.append("\\r");
+        break;
+      case '\t':
+        out.append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&out, "\\u%04x", c);
+        } else {
+          out.push_back(c);
+        }
+    }
+  }
+  out.push_back('"');
+}
+
+class Parser {
+ public:
+  explicit Parser(absl::string_view text) : text_(text) {}
+
+  absl::StatusOr<Json> ParseDocument() {
+    ASSIGN_OR_RETURN(Json value, ParseValue(/*depth=*/0));
+    SkipWhitespace();
+    if (pos_ != text_.size()) {
+      return Error("Unexpected trailing characters");
+    }
+    return value;
+  }
+
+ private:
+  absl::Status Error(absl::string_view message) const {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid JSON at offset ", pos_, ": ", message));
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+                                   text_[pos_] == '\n' || text_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  // Consumes `c` after the whitespace, if it is next.
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeLiteral(absl::string_view literal) {
+    if (text_.substr(pos_, literal.size()) == literal) {
+      pos_ += literal.size();
+      return true;
+    }
+    return false;
+  }
+
+  absl::StatusOr<Json> ParseValue(int depth) {
+    if (depth > kMaxDepth) {
+      return Error("Too deeply nested");
+    }
+    SkipWhitespace();
+    if (pos_ == text_.size()) {
+      return Error("Unexpected end");
+    }
+    switch (text_[pos_]) {
+      case '{':
+        return ParseObject(depth);
+      case '[':
+        return ParseArray(depth);
+      case '"': {
+        ASSIGN_OR_RETURN(std::string value, ParseString());
+        return Json(std::move(value));
+      }
+      case 't':
+        if (ConsumeLiteral("true")) return Json(true);
+        break;
+      case 'f':
+        if (ConsumeLiteral("false")) return Json(false);
+        break;
+      case 'n':
+        if (ConsumeLiteral("null")) return Json(nullptr);
+        break;
+      default:
+        return ParseNumber();
+    }
+    return Error("Invalid literal");
+  }
+
+  absl::StatusOr<Json> ParseObject(int depth) {
+    ++pos_;  // '{'
+    Json::Object members;
+    if (Consume('}')) {
+      return Json(std::move(members));
+    }
+    do {
+      SkipWhitespace();
+      if (pos_ == text_.size() || text_[pos_] != '"') {
+        return Error("Expected a member name");
+      }
+      ASSIGN_OR_RETURN(std::string key, ParseString());
+      if (!Consume(':')) {
+        return Error("Expected ':'");
+      }
+      ASSIGN_OR_RETURN(Json value, ParseValue(depth + 1));
+      members.emplace_back(std::move(key), std::move(value));
+    } while (Consume(','));
+    if (!Consume('}')) {
+      return Error("Expected ',' or '}'");
+    }
+    return Json(std::move(members));
+  }
+
+  absl::StatusOr<Json> ParseArray(int depth) {
+    ++pos_;  // '['
+    Json::Array elements;
+    if (Consume(']')) {
+      return Json(std::move(elements));
+    }
+    do {
+      ASSIGN_OR_RETURN(Json value, ParseValue(depth + 1));
+      elements.push_back(std::move(value));
+    } while (Consume(','));
+    if (!Consume(']')) {
+      return Error("Expected ',' or ']'");
+    }
+    return Json(std::move(elements));
+  }
+
+  absl::StatusOr<uint32_t> ParseHex4() {
+    uint32_t value = 0;
+    if (pos_ + 4 > text_.size()) {
+      return Error("Truncated \\u escape");
+    }
+    for (int i = 0; i < 4; ++i) {
+      const char c = text_[pos_++];
+      if (!absl::ascii_isxdigit(c)) {
+        return Error("Invalid \\u escape");
+      }
+      value = value * 16 + (absl::ascii_isdigit(c)
+                                ? c - '0'
+                                : absl::ascii_tolower(c) - 'a' + 10);
+    }
+    return value;
+  }
+
+  absl::StatusOr<std::string> ParseString() {
+    ++pos_;  // '"'
+    std::string value;
+    while (pos_ < text_.size()) {
+      const char c = text_[pos_++];
+      if (c == '"') {
+        return value;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return Error("Control character in string");
+      }
+      if (c != '\\') {
+        value.push_back(c);
+        continue;
+      }
+      if (pos_ == text_.size()) {
+        break;
+      }
+      switch (text_[pos_++]) {
+        case '"':
+          value.push_back('"');
+          break;
+        case '\\':
+          value.push_back('\\');
+          break;
+        case '/':
+          value.push_back('/');
+          break;
+        case 'b':
+          value.push_back('\b');
+          break;
+        case 'f':
+          value.push_back('\f');
+          break;
+        case 'n':
+          value.push_back('\n');
+          break;
+        case 'r':
+          value.push_back('\r');
+          break;
+        case 't':
+          value.push_back('\t');
+          break;
+        case 'u': {
+          ASSIGN_OR_RETURN(uint32_t code_point, ParseHex4());
+          // A surrogate pair encodes a code point beyond the BMP.
+          if (code_point >= 0xD800 && code_point < 0xDC00 &&
+              ConsumeLiteral("\\u")) {
+            ASSIGN_OR_RETURN(uint32_t low, ParseHex4());
+            if (low < 0xDC00 || low >= 0xE000) {
+              return Error("Invalid surrogate pair");
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          }
+          AppendUtf8(code_point, value);
+          break;
+        }
+        default:
+          return Error("Invalid escape");
+      }
+    }
+    return Error("Unterminated string");
+  }
+
+  absl::StatusOr<Json> ParseNumber() {
+    const size_t begin = pos_;
+    while (pos_ < text_.size() &&
+           (absl::ascii_isdigit(text_[pos_]) || text_[pos_] == '-' ||
+            text_[pos_] == '+' || text_[pos_] == '.' || text_[pos_] == 'e' ||
+            text_[pos_] == 'E')) {
+      ++pos_;
+    }
+    double value;
+    if (begin == pos_ ||
+        !absl::SimpleAtod(text_.substr(begin, pos_ - begin), &value) ||
+        !std::isfinite(value)) {
+      pos_ = begin;
+      return Error("Invalid number");
+    }
+    return Json(value);
+  }
+
+  absl::string_view text_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+absl::StatusOr<Json> Json::Parse(absl::string_view text) {
+  return Parser(text).ParseDocument();
+}
+
+std::string Json::Serialize() const {
+  std::string out;
+  SerializeTo(out);
+  return out;
+}
+
+const Json* Json::Find(absl::string_view key) const {
+  if (!is_object()) {
+    return nullptr;
+  }
+  for (const auto& [name, value] : object_value()) {
+    if (name == key) {
+      return &value;
+    }
+  }
+  return nullptr;
+}
+
+void Json::SerializeTo(std::string& out) const {
+  if (is_null()) {
+    out.append("null");
+  } else if (is_bool()) {
+    out.append(bool_value() ? "true" : "false");
+  } else if (is_number()) {
+    const double value = number_value();
+    // Integers, e.g. timestamps and counts, are printed exactly.
+    if (std::trunc(value) == value && std::abs(value) < 9007199254740992.0) {
+      absl::StrAppend(&out, static_cast<int64_t>(value));
+    } else if (std::isfinite(value)) {
+      // The shortest of the usual precisions which round-trips.
+      std::string text = absl::StrFormat("%.15g", value);
+      double parsed;
+      if (!absl::SimpleAtod(text, &parsed) || parsed != value) {
+        text = absl::StrFormat("%.17g", value);
+      }
+      out.append(text);
+    } else {
+      out.append("null");
+    }
+  } else if (is_string()) {
+    AppendQuoted(string_value(), out);
+  } else if (is_array()) {
+    out.push_back('[');
+    for (size_t i = 0; i < array_value().size(); ++i) {
+      if (i > 0) out.push_back(',');
+      array_value()[i].SerializeTo(out);
+    }
+    out.push_back(']');
+  } else {
+    out.push_back('{');
+    for (size_t i = 0; i < object_value().size(); ++i) {
+      if (i > 0) out.push_back(',');
+      AppendQuoted(object_value()[i].first, out);
+      out.push_back(':');
+      object_value()[i].second.SerializeTo(out);
+    }
+    out.push_back('}');
+  }
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,84 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_JSON_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_JSON_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// A JSON value, with just enough functionality for the request and response
+// bodies of the server. The members of an object keep their order, so that
+// the serialized responses are stable.
+class Json {
+ public:
+  using Array = std::vector<Json>;
+  using Object = std::vector<std::pair<std::string, Json>>;
+
+  Json() : value_(nullptr) {}
+  Json(std::nullptr_t) : value_(nullptr) {}  // NOLINT
+  Json(bool value) : value_(value) {}  // NOLINT
+  Json(int value) : value_(static_cast<double>(value)) {}  // NOLINT
+  Json(int64_t value) : value_(static_cast<double>(value)) {}  // NOLINT
+  Json(double value) : value_(value) {}  // NOLINT
+  Json(const char* value) : value_(std::string(value)) {}  // NOLINT
+  Json(absl::string_view value) : value_(std::string(value)) {}  // NOLINT
+  Json(std::string value) : value_(std::move(value)) {}  // NOLINT
+  Json(Array value) : value_(std::move(value)) {}  // NOLINT
+  Json(Object value) : value_(std::move(value)) {}  // NOLINT
+
+  // Parses a JSON text. Returns an InvalidArgumentError if it is malformed.
+  static absl::StatusOr<Json> Parse(absl::string_view text);
+
+  // Serializes the value without whitespace.
+  std::string Serialize() const;
+
+  bool is_null() const { return std::holds_alternative<std::nullptr_t>(value_); }
+  bool is_bool() const { return std::holds_alternative<bool>(value_); }
+  bool is_number() const { return std::holds_alternative<double>(value_); }
+  bool is_string() const { return std::holds_alternative<std::string>(value_); }
+  bool is_array() const { return std::holds_alternative<Array>(value_); }
+  bool is_object() const { return std::holds_alternative<Object>(value_); }
+
+  // The accessors must only be called for the matching type.
+  bool bool_value() const { return std::get<bool>(value_); }
+  double number_value() const { return std::get<double>(value_); }
+  const std::string& string_value() const {
+    return std::get<std::string>(value_);
+  }
+  const Array& array_value() const { return std::get<Array>(value_); }
+  const Object& object_value() const { return std::get<Object>(value_); }
+
+  // Returns the member `key` of an object, or nullptr if the value is not an
+  // object or has no such member.
+  const Json* Find(absl::string_view key) const;
+
+ private:
+  void SerializeTo(std::string& out) const;
+
+  std::variant<std::nullptr_t, bool, double, std::string, Array, Object> value_;
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_JSON_H_
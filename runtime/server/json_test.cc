@@ -0,0 +1,86 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/json.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::status::StatusIs;
+
+TEST(JsonTest, ParseObject) {
+  ASSERT_OK_AND_ASSIGN(
+      Json json,
+      Json::Parse(R"( {"model": "gemma", "stream": true, "max_tokens": 16,
+                       "temperature": 0.5, "stop": null,
+                       "messages": [{"role": "user", "content": "hi"}]} )"));
+  ASSERT_TRUE(json.is_object());
+  EXPECT_EQ(json.Find("model")->string_value(), "gemma");
+  EXPECT_TRUE(json.Find("stream")->bool_value());
+  EXPECT_EQ(json.Find("max_tokens")->number_value(), 16);
+  EXPECT_EQ(json.Find("temperature")->number_value(), 0.5);
+  EXPECT_TRUE(json.Find("stop")->is_null());
+  EXPECT_EQ(json.Find("missing"), nullptr);
+  const Json::Array& messages = json.Find("messages")->array_value();
+  ASSERT_EQ(messages.size(), 1);
+  EXPECT_EQ(messages[0].Find("content")->string_value(), "hi");
+}
+
+TEST(JsonTest, ParseStringEscapes) {
+  ASSERT_OK_AND_ASSIGN(
+      Json json, Json::Parse(R"("a\"b\\c\/\n\t\u00e9\ud83d\ude00")"));
+  EXPECT_EQ(json.string_value(), "a\"b\\c/\n\t\xC3\xA9\xF0\x9F\x98\x80");
+}
+
+TEST(JsonTest, ParseErrors) {
+  for (const char* text :
+       {"", "{", "[1,]", "{\"a\" 1}", "\"unterminated", "tru", "1 2",
+        "\"\\x\"", "-", "{1: 2}"}) {
+    EXPECT_THAT(Json::Parse(text), StatusIs(absl::StatusCode::kInvalidArgument))
+        << text;
+  }
+  std::string nested(100, '[');
+  EXPECT_THAT(Json::Parse(nested),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(JsonTest, Serialize) {
+  Json json(Json::Object{
+      {"id", "cmpl-1"},
+      {"created", int64_t{1760000000}},
+      {"logprob", -0.25},
+      {"text", "say \"hi\"\n\x01"},
+      {"choices", Json::Array{true, nullptr, 3}},
+  });
+  EXPECT_EQ(json.Serialize(),
+            R"({"id":"cmpl-1","created":1760000000,"logprob":-0.25,)"
+            R"("text":"say \"hi\"\n\u0001","choices":[true,null,3]})");
+}
+
+TEST(JsonTest, RoundTrip) {
+  const std::string text =
+      R"({"a":[1,2.5,"x",{"b":false}],"c":{},"d":[],"e":0.1})";
+  ASSERT_OK_AND_ASSIGN(Json json, Json::Parse(text));
+  EXPECT_EQ(json.Serialize(), text);
+}
+
+}  // namespace
+}  // namespace litert::lm
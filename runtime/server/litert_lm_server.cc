@@ -0,0 +1,198 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Serves a model with an OpenAI-compatible HTTP API on localhost, e.g.
+//
+//   ./litert_lm_server --model_path=<model_path> --port=8080
+//   curl localhost:8080/v1/chat/completions -d '{"messages": [{"role":
+//       "user", "content": "Hello"}], "stream": true}'
+//
+// With --load_test_concurrency, the server instead runs the built-in load
+// generator against itself for each concurrency level, prints a
+// throughput/latency table and exits.
+
+#include <signal.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"  // from @com_google_absl
+#include "absl/flags/parse.h"  // from @com_google_absl
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/log/absl_log.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/numbers.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/str_split.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/engine/engine.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/executor/executor_settings_base.h"
+#include "runtime/server/http_server.h"
+#include "runtime/server/json.h"
+#include "runtime/server/load_generator.h"
+#include "runtime/server/openai_handler.h"
+#include "runtime/util/status_macros.h"  // IWYU pragma: keep
+
+ABSL_FLAG(std::string, model_path, "", "Model path to use for LLM execution.");
+ABSL_FLAG(std::string, backend, "gpu",
+          "Executor backend to use for LLM execution (cpu, gpu, etc.)");
+ABSL_FLAG(std::string, model_name, "litert-lm",
+          "The model name reported by the API.");
+ABSL_FLAG(int, port, 8080, "The port to listen on, on localhost.");
+ABSL_FLAG(int, num_threads, 16,
+          "The number of connections handled at the same time.");
+ABSL_FLAG(int, max_pending_requests, 8,
+          "The number of requests running or waiting for the engine, beyond "
+          "which the requests are rejected with 429.");
+ABSL_FLAG(absl::Duration, request_timeout, absl::InfiniteDuration(),
+          "The time a request may take once it has the engine, beyond which "
+          "it fails with 504.");
+ABSL_FLAG(std::string, load_test_concurrency, "",
+          "If set, a comma-separated list of concurrency levels to run the "
+          "load generator with, e.g. 1,2,4,8. The server exits after the "
+          "load tests.");
+ABSL_FLAG(int, load_test_requests, 16,
+          "The number of requests per concurrency level of the load test.");
+ABSL_FLAG(std::string, load_test_prompt,
+          "What is the tallest building in the world?",
+          "The prompt of the chat requests of the load test.");
+ABSL_FLAG(bool, load_test_stream, true,
+          "Whether the requests of the load test stream the reply.");
+
+namespace {
+
+using ::litert::lm::Backend;
+using ::litert::lm::EngineSettings;
+using ::litert::lm::HttpServer;
+using ::litert::lm::HttpServerOptions;
+using ::litert::lm::Json;
+using ::litert::lm::LoadTestOptions;
+using ::litert::lm::LoadTestResult;
+using ::litert::lm::ModelAssets;
+using ::litert::lm::OpenAiHandler;
+using ::litert::lm::OpenAiHandlerOptions;
+
+absl::StatusOr<std::vector<int>> ParseConcurrencies(absl::string_view flag) {
+  std::vector<int> concurrencies;
+  for (absl::string_view level : absl::StrSplit(flag, ',')) {
+    int concurrency;
+    if (!absl::SimpleAtoi(level, &concurrency) || concurrency <= 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid concurrency: ", level));
+    }
+    concurrencies.push_back(concurrency);
+  }
+  return concurrencies;
+}
+
+absl::Status RunLoadTests(int port, const std::vector<int>& concurrencies) {
+  LoadTestOptions options;
+  options.port = port;
+  options.path = "/v1/chat/completions";
+  options.body =
+      Json(Json::Object{
+               {"messages",
+                Json::Array{Json::Object{
+                    {"role", "user"},
+                    {"content", absl::GetFlag(FLAGS_load_test_prompt)},
+                }}},
+               {"stream", absl::GetFlag(FLAGS_load_test_stream)},
+           })
+          .Serialize();
+  options.num_requests = absl::GetFlag(FLAGS_load_test_requests);
+  std::vector<LoadTestResult> results;
+  for (int concurrency : concurrencies) {
+    options.concurrency = concurrency;
+    ABSL_LOG(INFO) << "Running the load test with concurrency "
+                   << concurrency;
+    ASSIGN_OR_RETURN(LoadTestResult result,
+                     litert::lm::RunLoadTest(options));
+    results.push_back(result);
+  }
+  ABSL_LOG(INFO) << "Load test results:\n"
+                 << litert::lm::FormatLoadTestResults(results);
+  return absl::OkStatus();
+}
+
+absl::Status MainHelper(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  const std::string model_path = absl::GetFlag(FLAGS_model_path);
+  if (model_path.empty()) {
+    ABSL_LOG(INFO) << "Example usage: ./litert_lm_server "
+                      "--model_path=<model_path> [--backend=<cpu|gpu>] "
+                      "[--port=<port>] [--max_pending_requests=<n>] "
+                      "[--load_test_concurrency=1,2,4,8]";
+    return absl::InvalidArgumentError("Model path is empty.");
+  }
+  std::vector<int> concurrencies;
+  if (!absl::GetFlag(FLAGS_load_test_concurrency).empty()) {
+    ASSIGN_OR_RETURN(concurrencies,
+                     ParseConcurrencies(
+                         absl::GetFlag(FLAGS_load_test_concurrency)));
+  }
+
+  ASSIGN_OR_RETURN(ModelAssets model_assets,  // NOLINT
+                   ModelAssets::Create(model_path));
+  ASSIGN_OR_RETURN(Backend backend, litert::lm::GetBackendFromString(
+                                        absl::GetFlag(FLAGS_backend)));
+  ASSIGN_OR_RETURN(
+      EngineSettings engine_settings,
+      EngineSettings::CreateDefault(std::move(model_assets), backend));
+  ABSL_LOG(INFO) << "Creating engine";
+  ASSIGN_OR_RETURN(std::unique_ptr<litert::lm::Engine> engine,
+                   litert::lm::Engine::CreateEngine(std::move(engine_settings)));
+
+  OpenAiHandlerOptions handler_options;
+  handler_options.model_name = absl::GetFlag(FLAGS_model_name);
+  handler_options.max_pending_requests =
+      absl::GetFlag(FLAGS_max_pending_requests);
+  handler_options.request_timeout = absl::GetFlag(FLAGS_request_timeout);
+  OpenAiHandler handler(engine.get(), handler_options);
+
+  // SIGINT and SIGTERM are blocked in all the threads, and waited for below.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  HttpServerOptions server_options;
+  server_options.port = absl::GetFlag(FLAGS_port);
+  server_options.num_threads = absl::GetFlag(FLAGS_num_threads);
+  ASSIGN_OR_RETURN(std::unique_ptr<HttpServer> server,
+                   HttpServer::Start(server_options, handler.AsHttpHandler()));
+
+  if (!concurrencies.empty()) {
+    return RunLoadTests(server->port(), concurrencies);
+  }
+  ABSL_LOG(INFO) << "Serving " << handler_options.model_name
+                 << " on http://127.0.0.1:" << server->port();
+  int signal_number;
+  sigwait(&signals, &signal_number);
+  ABSL_LOG(INFO) << "Shutting down";
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ABSL_CHECK_OK(MainHelper(argc, argv));
+  return 0;
+}
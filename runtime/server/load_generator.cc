@@ -0,0 +1,118 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/load_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "runtime/server/http_client.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+// Returns the percentiles of `durations`, which is sorted in place.
+LatencyPercentiles GetPercentiles(std::vector<absl::Duration>& durations) {
+  if (durations.empty()) {
+    return {};
+  }
+  std::sort(durations.begin(), durations.end());
+  auto percentile = [&](int p) {
+    // The nearest-rank percentile.
+    const size_t rank = (p * durations.size() + 99) / 100;
+    return durations[std::max<size_t>(rank, 1) - 1];
+  };
+  return {.p50 = percentile(50), .p90 = percentile(90), .p99 = percentile(99)};
+}
+
+std::string FormatMs(absl::Duration duration) {
+  return absl::StrFormat("%.1f", absl::ToDoubleMilliseconds(duration));
+}
+
+}  // namespace
+
+absl::StatusOr<LoadTestResult> RunLoadTest(const LoadTestOptions& options) {
+  if (options.concurrency <= 0 || options.num_requests <= 0) {
+    return absl::InvalidArgumentError(
+        "The concurrency and the number of requests must be positive.");
+  }
+  absl::Mutex mutex;
+  std::vector<absl::Duration> latencies;
+  std::vector<absl::Duration> times_to_first_event;
+  int num_errors = 0;
+  std::atomic<int> next_request = 0;
+
+  const absl::Time start = absl::Now();
+  {
+    ThreadPool clients("load_generator", options.concurrency);
+    for (int i = 0; i < options.concurrency; ++i) {
+      RETURN_IF_ERROR(clients.Schedule([&]() {
+        while (next_request.fetch_add(1) < options.num_requests) {
+          absl::StatusOr<HttpClientResponse> response = SendHttpRequest(
+              options.port, options.method, options.path, options.body);
+          absl::MutexLock lock(&mutex);
+          if (!response.ok() || response->status_code != 200) {
+            ++num_errors;
+            continue;
+          }
+          latencies.push_back(response->total_time);
+          times_to_first_event.push_back(response->time_to_first_event);
+        }
+      }));
+    }
+    RETURN_IF_ERROR(clients.WaitUntilDone(absl::InfiniteDuration()));
+  }
+
+  LoadTestResult result;
+  result.concurrency = options.concurrency;
+  result.num_requests = options.num_requests;
+  result.num_errors = num_errors;
+  result.duration = absl::Now() - start;
+  result.requests_per_second =
+      latencies.size() / absl::ToDoubleSeconds(result.duration);
+  result.latency = GetPercentiles(latencies);
+  result.time_to_first_event = GetPercentiles(times_to_first_event);
+  return result;
+}
+
+std::string FormatLoadTestResults(const std::vector<LoadTestResult>& results) {
+  std::string table = absl::StrFormat(
+      "%11s %8s %6s %8s %9s %9s %9s %9s %9s %9s\n", "concurrency", "requests",
+      "errors", "req/s", "p50 ms", "p90 ms", "p99 ms", "ttft p50", "ttft p90",
+      "ttft p99");
+  for (const LoadTestResult& result : results) {
+    absl::StrAppendFormat(
+        &table, "%11d %8d %6d %8.2f %9s %9s %9s %9s %9s %9s\n",
+        result.concurrency, result.num_requests, result.num_errors,
+        result.requests_per_second, FormatMs(result.latency.p50),
+        FormatMs(result.latency.p90), FormatMs(result.latency.p99),
+        FormatMs(result.time_to_first_event.p50),
+        FormatMs(result.time_to_first_event.p90),
+        FormatMs(result.time_to_first_event.p99));
+  }
+  return table;
+}
+
+}  // namespace litert::lm
@@ -0,0 +1,71 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_LOAD_GENERATOR_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_LOAD_GENERATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+struct LoadTestOptions {
+  // The port of the local server.
+  int port = 8080;
+  // The request sent repeatedly.
+  std::string method = "POST";
+  std::string path = "/v1/chat/completions";
+  std::string body;
+  // The number of clients sending requests at the same time.
+  int concurrency = 1;
+  // The total number of requests, split across the clients.
+  int num_requests = 16;
+};
+
+// The latency percentiles of the successful requests.
+struct LatencyPercentiles {
+  absl::Duration p50;
+  absl::Duration p90;
+  absl::Duration p99;
+};
+
+struct LoadTestResult {
+  int concurrency = 0;
+  int num_requests = 0;
+  // The requests which failed or got a status other than 200, e.g. the ones
+  // rejected with 429 or 503 by the backpressure of the server.
+  int num_errors = 0;
+  absl::Duration duration;
+  // The successful requests per second.
+  double requests_per_second = 0;
+  // The time to the end of the response.
+  LatencyPercentiles latency;
+  // The time to the first event, or the whole response when not streaming.
+  LatencyPercentiles time_to_first_event;
+};
+
+// Sends `options.num_requests` requests to a local server with
+// `options.concurrency` clients, and measures the throughput and latencies.
+absl::StatusOr<LoadTestResult> RunLoadTest(const LoadTestOptions& options);
+
+// Formats the results of load tests as a table, one row per test, e.g. for a
+// throughput/latency curve over the concurrency.
+std::string FormatLoadTestResults(const std::vector<LoadTestResult>& results);
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_LOAD_GENERATOR_H_
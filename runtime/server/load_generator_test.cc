@@ -0,0 +1,86 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/load_generator.h"
+
+#include <atomic>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/server/http_server.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::status::StatusIs;
+
+TEST(LoadGeneratorTest, MeasuresRequests) {
+  std::atomic<int> num_requests = 0;
+  HttpServerOptions server_options;
+  server_options.port = 0;
+  ASSERT_OK_AND_ASSIGN(
+      auto server,
+      HttpServer::Start(server_options, [&](const HttpRequest& request,
+                                            HttpResponseWriter& writer) {
+        ++num_requests;
+        // Every other request fails.
+        if (request.body == "fail" && num_requests % 2 == 0) {
+          writer.Send(429, "text/plain", "busy");
+          return;
+        }
+        writer.StartEventStream();
+        writer.SendEvent("first");
+        absl::SleepFor(absl::Milliseconds(5));
+        writer.SendEvent("[DONE]");
+      }));
+
+  LoadTestOptions options;
+  options.port = server->port();
+  options.body = "ok";
+  options.concurrency = 4;
+  options.num_requests = 10;
+  ASSERT_OK_AND_ASSIGN(LoadTestResult result, RunLoadTest(options));
+  EXPECT_EQ(num_requests, 10);
+  EXPECT_EQ(result.concurrency, 4);
+  EXPECT_EQ(result.num_errors, 0);
+  EXPECT_GT(result.requests_per_second, 0);
+  EXPECT_GE(result.latency.p50, absl::Milliseconds(5));
+  EXPECT_LE(result.latency.p50, result.latency.p99);
+  EXPECT_LT(result.time_to_first_event.p50, result.latency.p50);
+
+  options.body = "fail";
+  options.concurrency = 1;
+  ASSERT_OK_AND_ASSIGN(LoadTestResult failing, RunLoadTest(options));
+  EXPECT_EQ(failing.num_errors, 5);
+
+  const std::string table = FormatLoadTestResults({result, failing});
+  EXPECT_THAT(table, HasSubstr("concurrency"));
+  EXPECT_THAT(table, HasSubstr("ttft p99"));
+}
+
+TEST(LoadGeneratorTest, RejectsInvalidOptions) {
+  LoadTestOptions options;
+  options.concurrency = 0;
+  EXPECT_THAT(RunLoadTest(options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace litert::lm
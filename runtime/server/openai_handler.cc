@@ -0,0 +1,517 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/openai_handler.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"  // from @com_google_absl
+#include "absl/log/absl_log.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "absl/synchronization/notification.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/engine/engine.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/proto/sampler_params.pb.h"
+#include "runtime/server/http_server.h"
+#include "runtime/server/json.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+constexpr absl::string_view kJsonContentType = "application/json";
+
+int HttpStatusCode(const absl::Status& status) {
+  switch (status.code()) {
+    case absl::StatusCode::kInvalidArgument:
+    case absl::StatusCode::kFailedPrecondition:
+    case absl::StatusCode::kOutOfRange:
+      return 400;
+    case absl::StatusCode::kNotFound:
+      return 404;
+    case absl::StatusCode::kResourceExhausted:
+      return 429;
+    case absl::StatusCode::kCancelled:
+      return 499;
+    case absl::StatusCode::kDeadlineExceeded:
+      return 504;
+    case absl::StatusCode::kUnavailable:
+      return 503;
+    default:
+      return 500;
+  }
+}
+
+std::string ErrorBody(const absl::Status& status) {
+  return Json(Json::Object{
+                  {"error", Json::Object{
+                                {"message", std::string(status.message())},
+                                {"type", absl::StatusCodeToString(
+                                             status.code())},
+                            }}})
+      .Serialize();
+}
+
+void SendError(HttpResponseWriter& writer, const absl::Status& status) {
+  writer.Send(HttpStatusCode(status), kJsonContentType, ErrorBody(status));
+}
+
+// Returns the optional number `name` of the request.
+absl::StatusOr<const Json*> GetNumber(const Json& request,
+                                      absl::string_view name) {
+  const Json* value = request.Find(name);
+  if (value == nullptr || value->is_null()) {
+    return nullptr;
+  }
+  if (!value->is_number()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("\"", name, "\" must be a number."));
+  }
+  return value;
+}
+
+bool IsStreaming(const Json& request) {
+  const Json* stream = request.Find("stream");
+  return stream != nullptr && stream->is_bool() && stream->bool_value();
+}
+
+// Returns the text of a prompt, which is a string or an array of one string.
+absl::StatusOr<std::string> GetPrompt(const Json& request) {
+  const Json* prompt = request.Find("prompt");
+  if (prompt != nullptr && prompt->is_array() &&
+      prompt->array_value().size() == 1) {
+    prompt = &prompt->array_value()[0];
+  }
+  if (prompt == nullptr || !prompt->is_string()) {
+    return absl::InvalidArgumentError("\"prompt\" must be a string.");
+  }
+  return prompt->string_value();
+}
+
+// Returns the messages of a chat request. The content of a message is a
+// string or an array of text parts.
+absl::StatusOr<std::vector<Message>> GetMessages(const Json& request) {
+  const Json* messages = request.Find("messages");
+  if (messages == nullptr || !messages->is_array()) {
+    return absl::InvalidArgumentError("\"messages\" must be an array.");
+  }
+  std::vector<Message> result;
+  for (const Json& message : messages->array_value()) {
+    const Json* role = message.Find("role");
+    const Json* content = message.Find("content");
+    if (role == nullptr || !role->is_string() || content == nullptr) {
+      return absl::InvalidArgumentError(
+          "Each message must have a \"role\" and a \"content\".");
+    }
+    std::string text;
+    if (content->is_string()) {
+      text = content->string_value();
+    } else if (content->is_array()) {
+      for (const Json& part : content->array_value()) {
+        const Json* part_text = part.Find("text");
+        if (part_text == nullptr || !part_text->is_string()) {
+          return absl::InvalidArgumentError(
+              "Only text content parts are supported.");
+        }
+        absl::StrAppend(&text, part_text->string_value());
+      }
+    } else {
+      return absl::InvalidArgumentError(
+          "\"content\" must be a string or an array of text parts.");
+    }
+    // The system prompt is folded in the first user turn by the conversation,
+    // and "developer" is the newer name of "system".
+    const std::string& role_name = role->string_value();
+    result.push_back(
+        {.role = role_name == "developer" ? "system" : role_name,
+         .content = std::move(text)});
+  }
+  return result;
+}
+
+// Returns the OpenAI finish reason of a response: "length" if the max number
+// of output tokens cut it short, "stop" otherwise.
+absl::string_view FinishReason(bool truncated) {
+  return truncated ? "length" : "stop";
+}
+
+// Streams the responses of a session or a conversation as server-sent events,
+// built by `make_chunk` from the text of each response.
+class EventStreamObserver : public InferenceObservable {
+ public:
+  // Makes the chunk of `text`, or the last chunk if `finish_reason` is set.
+  using ChunkFactory = absl::AnyInvocable<Json(
+      absl::string_view text, std::optional<absl::string_view> finish_reason)>;
+
+  EventStreamObserver(HttpResponseWriter& writer, ChunkFactory make_chunk)
+      : writer_(writer), make_chunk_(std::move(make_chunk)) {}
+
+  void OnNext(const Responses& responses) override {
+    truncated_ = responses.IsTruncated();
+    auto text = responses.GetResponseTextAt(0);
+    if (text.ok() && !text->empty()) {
+      writer_.SendEvent(make_chunk_(*text, std::nullopt).Serialize());
+    }
+  }
+
+  void OnDone() override {
+    writer_.SendEvent(make_chunk_("", FinishReason(truncated_)).Serialize());
+    writer_.SendEvent("[DONE]");
+    status_ = absl::OkStatus();
+    done_.Notify();
+  }
+
+  void OnError(const absl::Status& status) override {
+    // The error is sent as an event, since the response has started.
+    writer_.SendEvent(ErrorBody(status));
+    status_ = status;
+    done_.Notify();
+  }
+
+  // Returns true after OnDone() or OnError().
+  bool done() const { return done_.HasBeenNotified(); }
+
+  // Waits for OnDone() or OnError() and returns the status.
+  absl::Status Wait() {
+    done_.WaitForNotification();
+    return status_;
+  }
+
+ private:
+  HttpResponseWriter& writer_;
+  ChunkFactory make_chunk_;
+  // Whether the last responses were truncated.
+  bool truncated_ = false;
+  absl::Notification done_;
+  absl::Status status_;
+};
+
+}  // namespace
+
+OpenAiHandler::OpenAiHandler(Engine* engine, OpenAiHandlerOptions options)
+    : engine_(*engine), options_(std::move(options)) {}
+
+std::string OpenAiHandler::NewId(absl::string_view prefix) {
+  return absl::StrCat(prefix, "-", next_id_.fetch_add(1));
+}
+
+// static
+absl::StatusOr<SessionConfig> OpenAiHandler::GetSessionConfig(
+    const Json& request) {
+  SessionConfig session_config = SessionConfig::CreateDefault();
+  ASSIGN_OR_RETURN(const Json* temperature, GetNumber(request, "temperature"));
+  ASSIGN_OR_RETURN(const Json* top_p, GetNumber(request, "top_p"));
+  ASSIGN_OR_RETURN(const Json* top_k, GetNumber(request, "top_k"));
+  ASSIGN_OR_RETURN(const Json* seed, GetNumber(request, "seed"));
+  ASSIGN_OR_RETURN(const Json* max_tokens,
+                   GetNumber(request, "max_completion_tokens"));
+  if (max_tokens == nullptr) {
+    ASSIGN_OR_RETURN(max_tokens, GetNumber(request, "max_tokens"));
+  }
+  // The decoding only stops on the stop tokens of the model, so it would
+  // generate past the stop sequences of the request.
+  const Json* stop = request.Find("stop");
+  if (stop != nullptr && !stop->is_null() &&
+      !(stop->is_array() && stop->array_value().empty())) {
+    return absl::InvalidArgumentError("Unsupported parameter: \"stop\".");
+  }
+  const Json* n = request.Find("n");
+  if (n != nullptr && !(n->is_number() && n->number_value() == 1)) {
+    return absl::InvalidArgumentError("Only \"n\": 1 is supported.");
+  }
+  if (max_tokens != nullptr) {
+    if (max_tokens->number_value() < 1) {
+      return absl::InvalidArgumentError(
+          "The maximum number of tokens must be positive.");
+    }
+    session_config.SetMaxOutputTokens(max_tokens->number_value());
+  }
+  // Without sampling parameters, the defaults of the model are used.
+  if (temperature == nullptr && top_p == nullptr && top_k == nullptr) {
+    return session_config;
+  }
+  proto::SamplerParameters& sampler_params =
+      session_config.GetMutableSamplerParams();
+  if (temperature != nullptr && temperature->number_value() == 0) {
+    sampler_params.set_type(proto::SamplerParameters::GREEDY);
+    sampler_params.set_k(1);
+  } else {
+    sampler_params.set_type(proto::SamplerParameters::TOP_P);
+    sampler_params.set_k(top_k != nullptr ? top_k->number_value() : 40);
+    sampler_params.set_p(top_p != nullptr ? top_p->number_value() : 1.0f);
+    sampler_params.set_temperature(
+        temperature != nullptr ? temperature->number_value() : 1.0f);
+  }
+  if (seed != nullptr) {
+    sampler_params.set_seed(seed->number_value());
+  }
+  return session_config;
+}
+
+void OpenAiHandler::Handle(const HttpRequest& request,
+                           HttpResponseWriter& writer) {
+  if (request.path == "/health") {
+    writer.Send(200, kJsonContentType, R"({"status":"ok"})");
+    return;
+  }
+  if (request.path == "/v1/models") {
+    writer.Send(200, kJsonContentType,
+                Json(Json::Object{
+                         {"object", "list"},
+                         {"data", Json::Array{Json::Object{
+                                      {"id", options_.model_name},
+                                      {"object", "model"},
+                                      {"owned_by", "litert-lm"},
+                                  }}},
+                     })
+                    .Serialize());
+    return;
+  }
+  const bool is_chat = request.path == "/v1/chat/completions";
+  if (!is_chat && request.path != "/v1/completions") {
+    SendError(writer, absl::NotFoundError(
+                          absl::StrCat("Unknown path: ", request.path)));
+    return;
+  }
+  if (request.method != "POST") {
+    writer.Send(405, kJsonContentType,
+                ErrorBody(absl::InvalidArgumentError("Use POST.")));
+    return;
+  }
+  absl::StatusOr<Json> json = Json::Parse(request.body);
+  if (!json.ok()) {
+    SendError(writer, json.status());
+    return;
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    if (num_pending_requests_ >= options_.max_pending_requests) {
+      SendError(writer, absl::ResourceExhaustedError(
+                            "Too many pending requests, retry later."));
+      return;
+    }
+    ++num_pending_requests_;
+  }
+  {
+    absl::MutexLock lock(&engine_mutex_);
+    // The client may have given up while waiting for the engine.
+    if (!writer.Disconnected()) {
+      if (is_chat) {
+        HandleChatCompletions(*json, writer);
+      } else {
+        HandleCompletions(*json, writer);
+      }
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  --num_pending_requests_;
+}
+
+void OpenAiHandler::HandleCompletions(const Json& request,
+                                      HttpResponseWriter& writer) {
+  absl::StatusOr<std::string> prompt = GetPrompt(request);
+  absl::StatusOr<SessionConfig> session_config = GetSessionConfig(request);
+  if (!prompt.ok() || !session_config.ok()) {
+    SendError(writer, !prompt.ok() ? prompt.status() : session_config.status());
+    return;
+  }
+  // The session has its own sequence on the executor, so the conversation of
+  // the chat requests is kept.
+  absl::StatusOr<std::unique_ptr<Engine::Session>> session =
+      engine_.CreateSession(*session_config);
+  if (!session.ok()) {
+    SendError(writer, session.status());
+    return;
+  }
+  (*session)->SetCancelFlag(&writer.Disconnected());
+  (*session)->SetDeadline(absl::Now() + options_.request_timeout);
+
+  const std::string id = NewId("cmpl");
+  const int64_t created = absl::ToUnixSeconds(absl::Now());
+  auto make_response = [&](absl::string_view text,
+                           std::optional<absl::string_view> finish_reason) {
+    return Json(Json::Object{
+        {"id", id},
+        {"object", "text_completion"},
+        {"created", created},
+        {"model", options_.model_name},
+        {"choices",
+         Json::Array{Json::Object{
+             {"index", 0},
+             {"text", text},
+             {"finish_reason", finish_reason.has_value()
+                                   ? Json(*finish_reason)
+                                   : Json(nullptr)},
+         }}},
+    });
+  };
+
+  const std::vector<InputData> contents = {InputText(*prompt)};
+  if (!IsStreaming(request)) {
+    absl::StatusOr<Responses> responses = (*session)->GenerateContent(contents);
+    absl::StatusOr<absl::string_view> text =
+        responses.ok() ? responses->GetResponseTextAt(0)
+                       : absl::StatusOr<absl::string_view>(responses.status());
+    if (!text.ok()) {
+      SendError(writer, text.status());
+      return;
+    }
+    writer.Send(
+        200, kJsonContentType,
+        make_response(*text, FinishReason(responses->IsTruncated()))
+            .Serialize());
+    return;
+  }
+
+  if (absl::Status status = (*session)->RunPrefill(contents); !status.ok()) {
+    SendError(writer, status);
+    return;
+  }
+  writer.StartEventStream();
+  EventStreamObserver observer(writer, make_response);
+  if (absl::Status status = (*session)->RunDecodeAsync(&observer);
+      !status.ok() && !observer.done()) {
+    observer.OnError(status);
+  }
+  if (absl::Status status = observer.Wait(); !status.ok()) {
+    ABSL_LOG(WARNING) << "Completion " << id << " failed: " << status;
+  }
+}
+
+absl::StatusOr<Engine::Conversation*> OpenAiHandler::GetConversation(
+    const SessionConfig& session_config) {
+  std::string key =
+      absl::StrCat(session_config.GetSamplerParams().SerializeAsString(), "/",
+                   session_config.GetMaxOutputTokens());
+  if (conversation_ != nullptr && key == conversation_key_) {
+    return conversation_.get();
+  }
+  // Only the conversation of the last config is kept, the KV cache of the
+  // others would take the memory of the engine.
+  conversation_.reset();
+  ASSIGN_OR_RETURN(conversation_, engine_.CreateConversation(session_config));
+  conversation_key_ = std::move(key);
+  return conversation_.get();
+}
+
+void OpenAiHandler::HandleChatCompletions(const Json& request,
+                                          HttpResponseWriter& writer) {
+  absl::StatusOr<std::vector<Message>> messages = GetMessages(request);
+  absl::StatusOr<SessionConfig> session_config = GetSessionConfig(request);
+  if (!messages.ok() || !session_config.ok()) {
+    SendError(writer,
+              !messages.ok() ? messages.status() : session_config.status());
+    return;
+  }
+  absl::StatusOr<Engine::Conversation*> conversation =
+      GetConversation(*session_config);
+  if (!conversation.ok()) {
+    SendError(writer, conversation.status());
+    return;
+  }
+  (*conversation)->SetCancelFlag(&writer.Disconnected());
+  (*conversation)->SetDeadline(absl::Now() + options_.request_timeout);
+
+  const std::string id = NewId("chatcmpl");
+  const int64_t created = absl::ToUnixSeconds(absl::Now());
+  absl::Status status;
+  if (!IsStreaming(request)) {
+    absl::StatusOr<Responses> responses =
+        (*conversation)->GenerateReply(*messages);
+    absl::StatusOr<absl::string_view> text =
+        responses.ok() ? responses->GetResponseTextAt(0)
+                       : absl::StatusOr<absl::string_view>(responses.status());
+    if (!text.ok()) {
+      status = text.status();
+      SendError(writer, status);
+    } else {
+      writer.Send(
+          200, kJsonContentType,
+          Json(Json::Object{
+                   {"id", id},
+                   {"object", "chat.completion"},
+                   {"created", created},
+                   {"model", options_.model_name},
+                   {"choices", Json::Array{Json::Object{
+                                   {"index", 0},
+                                   {"message", Json::Object{
+                                                   {"role", "assistant"},
+                                                   {"content", *text},
+                                               }},
+                                   {"finish_reason",
+                                    FinishReason(responses->IsTruncated())},
+                               }}},
+               })
+              .Serialize());
+    }
+  } else {
+    writer.StartEventStream();
+    bool first = true;
+    EventStreamObserver observer(
+        writer, [&](absl::string_view text,
+                    std::optional<absl::string_view> finish_reason) {
+          Json::Object delta;
+          if (first) {
+            delta.emplace_back("role", "assistant");
+            first = false;
+          }
+          if (!finish_reason.has_value()) {
+            delta.emplace_back("content", text);
+          }
+          return Json(Json::Object{
+              {"id", id},
+              {"object", "chat.completion.chunk"},
+              {"created", created},
+              {"model", options_.model_name},
+              {"choices", Json::Array{Json::Object{
+                              {"index", 0},
+                              {"delta", std::move(delta)},
+                              {"finish_reason", finish_reason.has_value()
+                                                    ? Json(*finish_reason)
+                                                    : Json(nullptr)},
+                          }}},
+          });
+        });
+    // The errors of the turn are sent to the observer, except the ones
+    // preventing it from running.
+    if (absl::Status stream_status =
+            (*conversation)->GenerateReplyStream(*messages, &observer);
+        !stream_status.ok() && !observer.done()) {
+      observer.OnError(stream_status);
+    }
+    status = observer.Wait();
+  }
+  (*conversation)->SetCancelFlag(nullptr);
+  (*conversation)->SetDeadline(absl::InfiniteFuture());
+  if (!status.ok()) {
+    ABSL_LOG(WARNING) << "Chat completion " << id << " failed: " << status;
+    // The history of a failed turn is unknown, start over on the next one.
+    conversation_.reset();
+  }
+}
+
+}  // namespace litert::lm
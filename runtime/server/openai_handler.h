@@ -0,0 +1,117 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_OPENAI_HANDLER_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_OPENAI_HANDLER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/engine/engine.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/server/http_server.h"
+#include "runtime/server/json.h"
+
+namespace litert::lm {
+
+struct OpenAiHandlerOptions {
+  // The model name reported by /v1/models and in the responses.
+  std::string model_name = "litert-lm";
+  // The maximum number of requests running or waiting for the engine. The
+  // next requests are rejected with 429 Too Many Requests.
+  int max_pending_requests = 8;
+  // The time a request may take once it has the engine. Past it, the request
+  // fails with 504 Gateway Timeout.
+  absl::Duration request_timeout = absl::InfiniteDuration();
+};
+
+// Serves a subset of the OpenAI API on top of an Engine:
+// - GET /v1/models
+// - POST /v1/completions, with a Session per request.
+// - POST /v1/chat/completions, with a Conversation reused across requests, so
+//   that a client resending the growing history of a chat only prefills the
+//   new messages.
+// Both POST endpoints stream server-sent events when "stream" is true.
+//
+// The sessions of an engine share its executor, so the requests run one at a
+// time. The conversation is kept between chat requests with the same sampling
+// parameters, including across completion requests, whose sessions use their
+// own sequences of the executor. The prefill and decode of a request are
+// cancelled when its client disconnects or its timeout expires.
+//
+// Supported request fields: "prompt" (completions), "messages" (chat),
+// "stream", "temperature", "top_p", "top_k", "seed" and "max_tokens" (or
+// "max_completion_tokens"). Requests with stop sequences ("stop") are
+// rejected, the decoding only stopping on the stop tokens of the model. The
+// other fields are ignored.
+class OpenAiHandler {
+ public:
+  // `engine` must outlive the handler.
+  OpenAiHandler(Engine* engine, OpenAiHandlerOptions options);
+
+  // Handles a request, possibly concurrently with other requests.
+  void Handle(const HttpRequest& request, HttpResponseWriter& writer);
+
+  // Returns a handler for HttpServer.
+  HttpServer::Handler AsHttpHandler() {
+    return [this](const HttpRequest& request, HttpResponseWriter& writer) {
+      Handle(request, writer);
+    };
+  }
+
+ private:
+  // Builds the session config of a request from its sampling parameters.
+  static absl::StatusOr<SessionConfig> GetSessionConfig(const Json& request);
+
+  void HandleCompletions(const Json& request, HttpResponseWriter& writer)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(engine_mutex_);
+  void HandleChatCompletions(const Json& request, HttpResponseWriter& writer)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(engine_mutex_);
+
+  // Returns the conversation for `session_config`, reusing the current one if
+  // it has the same config.
+  absl::StatusOr<Engine::Conversation*> GetConversation(
+      const SessionConfig& session_config)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(engine_mutex_);
+
+  // Returns a new response id with the given prefix.
+  std::string NewId(absl::string_view prefix);
+
+  Engine& engine_;
+  const OpenAiHandlerOptions options_;
+  std::atomic<int64_t> next_id_ = 0;
+
+  absl::Mutex mutex_;
+  // The number of requests running or waiting for the engine.
+  int num_pending_requests_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // Serializes the use of the engine.
+  absl::Mutex engine_mutex_;
+  // The conversation kept between chat requests, and the key of its config.
+  std::unique_ptr<Engine::Conversation> conversation_
+      ABSL_GUARDED_BY(engine_mutex_);
+  std::string conversation_key_ ABSL_GUARDED_BY(engine_mutex_);
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_SERVER_OPENAI_HANDLER_H_
@@ -0,0 +1,486 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/server/openai_handler.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/notification.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/engine/engine.h"
+#include "runtime/engine/engine_settings.h"
+#include "runtime/engine/io_types.h"
+#include "runtime/framework/threadpool.h"
+#include "runtime/proto/sampler_params.pb.h"
+#include "runtime/server/http_server.h"
+#include "runtime/server/json.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::SizeIs;
+
+Responses TextResponses(absl::string_view text, bool truncated = false) {
+  Responses responses(/*num_output_candidates=*/1);
+  responses.GetMutableResponseTexts()[0] = std::string(text);
+  responses.SetTruncated(truncated);
+  return responses;
+}
+
+// The characters of the fake replies stand for the tokens, so a reply longer
+// than the max number of output tokens of `session_config` is cut to it.
+Responses Reply(absl::string_view text, const SessionConfig& session_config) {
+  const int max_output_tokens = session_config.GetMaxOutputTokens();
+  if (max_output_tokens > 0 &&
+      text.size() > static_cast<size_t>(max_output_tokens)) {
+    return TextResponses(text.substr(0, max_output_tokens),
+                         /*truncated=*/true);
+  }
+  return TextResponses(text);
+}
+
+// Streams `reply` in two chunks, the last one marked as truncated like the
+// reply.
+void StreamReply(const Responses& reply, InferenceObservable& observer) {
+  const absl::string_view text = reply.GetResponseTextAt(0).value();
+  observer.OnNext(TextResponses(text.substr(0, 1)));
+  observer.OnNext(TextResponses(text.substr(1), reply.IsTruncated()));
+  observer.OnDone();
+}
+
+// Records what the handler writes.
+class FakeWriter : public HttpResponseWriter {
+ public:
+  bool Send(int status_code, absl::string_view content_type,
+            absl::string_view body) override {
+    this->status_code = status_code;
+    this->body = std::string(body);
+    return true;
+  }
+  bool StartEventStream() override {
+    status_code = 200;
+    return true;
+  }
+  bool SendEvent(absl::string_view data) override {
+    events.push_back(std::string(data));
+    return true;
+  }
+  const std::atomic_bool& Disconnected() const override {
+    return disconnected;
+  }
+
+  // Returns the parsed body.
+  Json BodyJson() const { return Json::Parse(body).value(); }
+
+  int status_code = 0;
+  std::string body;
+  std::vector<std::string> events;
+  std::atomic_bool disconnected = false;
+};
+
+// Replies with the given responses, streamed in two chunks.
+class FakeSession : public Engine::Session {
+ public:
+  explicit FakeSession(Responses reply) : reply_(std::move(reply)) {}
+
+  absl::StatusOr<Responses> GenerateContent(
+      const std::vector<InputData>& contents) override {
+    return reply_;
+  }
+  absl::Status GenerateContentStream(const std::vector<InputData>& contents,
+                                     InferenceObservable* observer) override {
+    return absl::UnimplementedError("Not used.");
+  }
+  absl::Status RunPrefill(const std::vector<InputData>& contents) override {
+    return absl::OkStatus();
+  }
+  absl::StatusOr<Responses> RunDecode() override { return reply_; }
+  absl::Status RunDecodeAsync(InferenceObservable* observer) override {
+    StreamReply(reply_, *observer);
+    return absl::OkStatus();
+  }
+  absl::StatusOr<BenchmarkInfo> GetBenchmarkInfo() override {
+    return absl::UnimplementedError("Not used.");
+  }
+
+ private:
+  const Responses reply_;
+};
+
+class FakeConversation : public Engine::Conversation {
+ public:
+  FakeConversation(Responses reply, absl::Notification* started,
+                   absl::Notification* release)
+      : reply_(std::move(reply)), started_(started), release_(release) {}
+
+  absl::StatusOr<Responses> GenerateReply(
+      const std::vector<Message>& messages) override {
+    if (release_ != nullptr) {
+      started_->Notify();
+      release_->WaitForNotification();
+    }
+    last_messages_ = messages;
+    return reply_;
+  }
+  absl::Status GenerateReplyStream(const std::vector<Message>& messages,
+                                   InferenceObservable* observer) override {
+    last_messages_ = messages;
+    StreamReply(reply_, *observer);
+    return absl::OkStatus();
+  }
+  absl::StatusOr<BenchmarkInfo> GetBenchmarkInfo() override {
+    return absl::UnimplementedError("Not used.");
+  }
+  void SetDeadline(absl::Time deadline) override {
+    deadlines_.push_back(deadline);
+  }
+
+  const std::vector<Message>& last_messages() const { return last_messages_; }
+  const std::vector<absl::Time>& deadlines() const { return deadlines_; }
+
+ private:
+  const Responses reply_;
+  absl::Notification* const started_;
+  absl::Notification* const release_;
+  std::vector<Message> last_messages_;
+  std::vector<absl::Time> deadlines_;
+};
+
+class FakeEngine : public Engine {
+ public:
+  absl::StatusOr<std::unique_ptr<Session>> CreateSession(
+      const SessionConfig& session_config) const override {
+    session_configs_.push_back(session_config);
+    return std::make_unique<FakeSession>(Reply("Hello", session_config));
+  }
+  absl::StatusOr<std::unique_ptr<Conversation>> CreateConversation(
+      const SessionConfig& session_config) const override {
+    session_configs_.push_back(session_config);
+    auto conversation = std::make_unique<FakeConversation>(
+        Reply("Hi!", session_config), started_, release_);
+    last_conversation_ = conversation.get();
+    return conversation;
+  }
+
+  // Makes the next conversation notify `started` and wait for `release`
+  // before replying.
+  void set_blocking(absl::Notification* started,
+                    absl::Notification* release) {
+    started_ = started;
+    release_ = release;
+  }
+
+  const std::vector<SessionConfig>& session_configs() const {
+    return session_configs_;
+  }
+  FakeConversation* last_conversation() const { return last_conversation_; }
+
+ private:
+  absl::Notification* started_ = nullptr;
+  absl::Notification* release_ = nullptr;
+  mutable std::vector<SessionConfig> session_configs_;
+  mutable FakeConversation* last_conversation_ = nullptr;
+};
+
+HttpRequest Post(absl::string_view path, absl::string_view body) {
+  return {.method = "POST", .path = std::string(path),
+          .body = std::string(body)};
+}
+
+TEST(OpenAiHandlerTest, Completions) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  FakeWriter writer;
+  handler.Handle(Post("/v1/completions", R"({"prompt": "Say hello"})"),
+                 writer);
+  ASSERT_EQ(writer.status_code, 200);
+  const Json response = writer.BodyJson();
+  EXPECT_EQ(response.Find("object")->string_value(), "text_completion");
+  const Json& choice = response.Find("choices")->array_value()[0];
+  EXPECT_EQ(choice.Find("text")->string_value(), "Hello");
+  EXPECT_EQ(choice.Find("finish_reason")->string_value(), "stop");
+  // Without sampling parameters, the defaults of the model are used.
+  ASSERT_THAT(engine.session_configs(), SizeIs(1));
+  EXPECT_EQ(engine.session_configs()[0].GetSamplerParams().type(),
+            proto::SamplerParameters::TYPE_UNSPECIFIED);
+}
+
+TEST(OpenAiHandlerTest, StreamsCompletions) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  FakeWriter writer;
+  handler.Handle(Post("/v1/completions",
+                      R"({"prompt": "Say hello", "stream": true})"),
+                 writer);
+  ASSERT_THAT(writer.events, SizeIs(4));
+  std::string text;
+  for (int i = 0; i < 2; ++i) {
+    const Json chunk = Json::Parse(writer.events[i]).value();
+    absl::StrAppend(
+        &text,
+        chunk.Find("choices")->array_value()[0].Find("text")->string_value());
+  }
+  EXPECT_EQ(text, "Hello");
+  EXPECT_EQ(writer.events[3], "[DONE]");
+}
+
+TEST(OpenAiHandlerTest, ChatCompletions) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  FakeWriter writer;
+  handler.Handle(Post("/v1/chat/completions", R"({
+      "messages": [
+        {"role": "developer", "content": "Be brief."},
+        {"role": "user", "content": [{"type": "text", "text": "Hi"}]}
+      ],
+      "temperature": 0.5, "top_k": 8, "seed": 3})"),
+                 writer);
+  ASSERT_EQ(writer.status_code, 200);
+  const Json response = writer.BodyJson();
+  const Json& choice = response.Find("choices")->array_value()[0];
+  EXPECT_EQ(choice.Find("message")->Find("content")->string_value(), "Hi!");
+
+  const std::vector<Message>& messages =
+      engine.last_conversation()->last_messages();
+  ASSERT_THAT(messages, SizeIs(2));
+  EXPECT_EQ(messages[0].role, "system");
+  EXPECT_EQ(messages[1].content, "Hi");
+  const proto::SamplerParameters& sampler_params =
+      engine.session_configs()[0].GetSamplerParams();
+  EXPECT_EQ(sampler_params.type(), proto::SamplerParameters::TOP_P);
+  EXPECT_EQ(sampler_params.k(), 8);
+  EXPECT_FLOAT_EQ(sampler_params.p(), 1.0f);
+  EXPECT_FLOAT_EQ(sampler_params.temperature(), 0.5f);
+  EXPECT_EQ(sampler_params.seed(), 3);
+}
+
+TEST(OpenAiHandlerTest, StreamsChatCompletions) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  FakeWriter writer;
+  handler.Handle(Post("/v1/chat/completions", R"({
+      "messages": [{"role": "user", "content": "Hi"}], "stream": true})"),
+                 writer);
+  ASSERT_THAT(writer.events, SizeIs(4));
+  const Json first = Json::Parse(writer.events[0]).value();
+  const Json& delta = *first.Find("choices")->array_value()[0].Find("delta");
+  EXPECT_EQ(delta.Find("role")->string_value(), "assistant");
+  EXPECT_EQ(delta.Find("content")->string_value(), "H");
+  const Json last = Json::Parse(writer.events[2]).value();
+  EXPECT_EQ(last.Find("choices")
+                ->array_value()[0]
+                .Find("finish_reason")
+                ->string_value(),
+            "stop");
+  EXPECT_EQ(writer.events[3], "[DONE]");
+}
+
+TEST(OpenAiHandlerTest, ReusesTheConversationWithTheSameParameters) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  const std::vector<std::string> bodies = {
+      R"({"messages": [{"role": "user", "content": "Hi"}],
+          "temperature": 0})",
+      R"({"messages": [{"role": "user", "content": "Hi"},
+                       {"role": "assistant", "content": "Hi!"},
+                       {"role": "user", "content": "Bye"}],
+          "temperature": 0})",
+      R"({"messages": [{"role": "user", "content": "Hi"}],
+          "temperature": 1})",
+  };
+  for (const std::string& body : bodies) {
+    FakeWriter writer;
+    handler.Handle(Post("/v1/chat/completions", body), writer);
+    EXPECT_EQ(writer.status_code, 200);
+  }
+  // The first two requests share a conversation.
+  ASSERT_THAT(engine.session_configs(), SizeIs(2));
+  EXPECT_EQ(engine.session_configs()[0].GetSamplerParams().type(),
+            proto::SamplerParameters::GREEDY);
+  EXPECT_EQ(engine.session_configs()[1].GetSamplerParams().type(),
+            proto::SamplerParameters::TOP_P);
+}
+
+TEST(OpenAiHandlerTest, KeepsTheConversationAcrossCompletions) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  const HttpRequest chat = Post(
+      "/v1/chat/completions",
+      R"({"messages": [{"role": "user", "content": "Hi"}]})");
+  FakeWriter first_chat;
+  handler.Handle(chat, first_chat);
+  ASSERT_EQ(first_chat.status_code, 200);
+  FakeConversation* conversation = engine.last_conversation();
+  FakeWriter completion;
+  handler.Handle(Post("/v1/completions", R"({"prompt": "Say hello"})"),
+                 completion);
+  ASSERT_EQ(completion.status_code, 200);
+  FakeWriter second_chat;
+  handler.Handle(chat, second_chat);
+  ASSERT_EQ(second_chat.status_code, 200);
+  // The chat requests share a conversation, and the completion a session.
+  EXPECT_EQ(engine.last_conversation(), conversation);
+  EXPECT_THAT(engine.session_configs(), SizeIs(2));
+}
+
+TEST(OpenAiHandlerTest, LimitsTheRequests) {
+  FakeEngine engine;
+  OpenAiHandlerOptions options;
+  options.request_timeout = absl::Seconds(30);
+  OpenAiHandler handler(&engine, options);
+  const absl::Time start = absl::Now();
+  FakeWriter writer;
+  handler.Handle(Post("/v1/chat/completions", R"({
+      "messages": [{"role": "user", "content": "Hi"}], "max_tokens": 16})"),
+                 writer);
+  ASSERT_EQ(writer.status_code, 200);
+  ASSERT_THAT(engine.session_configs(), SizeIs(1));
+  EXPECT_EQ(engine.session_configs()[0].GetMaxOutputTokens(), 16);
+  // The deadline is set for the request, and cleared after it.
+  const std::vector<absl::Time>& deadlines =
+      engine.last_conversation()->deadlines();
+  ASSERT_THAT(deadlines, SizeIs(2));
+  EXPECT_GE(deadlines[0], start + absl::Seconds(30));
+  EXPECT_LE(deadlines[0], absl::Now() + absl::Seconds(30));
+  EXPECT_EQ(deadlines[1], absl::InfiniteFuture());
+
+  FakeWriter invalid_max_tokens;
+  handler.Handle(Post("/v1/completions",
+                      R"({"prompt": "Hi", "max_tokens": 0})"),
+                 invalid_max_tokens);
+  EXPECT_EQ(invalid_max_tokens.status_code, 400);
+}
+
+TEST(OpenAiHandlerTest, ReportsTheRepliesCutByTheMaxTokens) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  FakeWriter completion;
+  handler.Handle(Post("/v1/completions",
+                      R"({"prompt": "Say hello", "max_tokens": 2})"),
+                 completion);
+  ASSERT_EQ(completion.status_code, 200);
+  const Json& choice =
+      completion.BodyJson().Find("choices")->array_value()[0];
+  EXPECT_EQ(choice.Find("text")->string_value(), "He");
+  EXPECT_EQ(choice.Find("finish_reason")->string_value(), "length");
+
+  FakeWriter chat;
+  handler.Handle(Post("/v1/chat/completions", R"({
+      "messages": [{"role": "user", "content": "Hi"}],
+      "max_completion_tokens": 2})"),
+                 chat);
+  ASSERT_EQ(chat.status_code, 200);
+  EXPECT_EQ(chat.BodyJson()
+                .Find("choices")
+                ->array_value()[0]
+                .Find("finish_reason")
+                ->string_value(),
+            "length");
+
+  FakeWriter stream;
+  handler.Handle(Post("/v1/chat/completions", R"({
+      "messages": [{"role": "user", "content": "Hi"}],
+      "max_completion_tokens": 2, "stream": true})"),
+                 stream);
+  ASSERT_THAT(stream.events, SizeIs(4));
+  const Json last = Json::Parse(stream.events[2]).value();
+  EXPECT_EQ(last.Find("choices")
+                ->array_value()[0]
+                .Find("finish_reason")
+                ->string_value(),
+            "length");
+}
+
+TEST(OpenAiHandlerTest, RejectsInvalidRequests) {
+  FakeEngine engine;
+  OpenAiHandler handler(&engine, OpenAiHandlerOptions());
+  FakeWriter invalid_json;
+  handler.Handle(Post("/v1/completions", "{"), invalid_json);
+  EXPECT_EQ(invalid_json.status_code, 400);
+  EXPECT_TRUE(invalid_json.BodyJson().Find("error")->is_object());
+
+  FakeWriter invalid_temperature;
+  handler.Handle(Post("/v1/completions",
+                      R"({"prompt": "Hi", "temperature": "hot"})"),
+                 invalid_temperature);
+  EXPECT_EQ(invalid_temperature.status_code, 400);
+
+  FakeWriter stop_sequences;
+  handler.Handle(Post("/v1/completions",
+                      R"({"prompt": "Hi", "stop": ["\n"]})"),
+                 stop_sequences);
+  EXPECT_EQ(stop_sequences.status_code, 400);
+
+  FakeWriter unknown_path;
+  handler.Handle(Post("/v1/embeddings", "{}"), unknown_path);
+  EXPECT_EQ(unknown_path.status_code, 404);
+  EXPECT_THAT(engine.session_configs(), SizeIs(0));
+}
+
+TEST(OpenAiHandlerTest, ListsTheModel) {
+  FakeEngine engine;
+  OpenAiHandlerOptions options;
+  options.model_name = "gemma";
+  OpenAiHandler handler(&engine, options);
+  FakeWriter writer;
+  handler.Handle({.method = "GET", .path = "/v1/models"}, writer);
+  ASSERT_EQ(writer.status_code, 200);
+  EXPECT_EQ(writer.BodyJson()
+                .Find("data")
+                ->array_value()[0]
+                .Find("id")
+                ->string_value(),
+            "gemma");
+}
+
+TEST(OpenAiHandlerTest, RejectsRequestsBeyondTheLimit) {
+  FakeEngine engine;
+  absl::Notification started;
+  absl::Notification release;
+  engine.set_blocking(&started, &release);
+  OpenAiHandlerOptions options;
+  options.max_pending_requests = 1;
+  OpenAiHandler handler(&engine, options);
+  const HttpRequest request = Post(
+      "/v1/chat/completions",
+      R"({"messages": [{"role": "user", "content": "Hi"}]})");
+
+  ThreadPool pool("requests", /*max_num_threads=*/1);
+  FakeWriter running;
+  ASSERT_OK(pool.Schedule([&]() { handler.Handle(request, running); }));
+  started.WaitForNotification();
+  FakeWriter rejected;
+  handler.Handle(request, rejected);
+  EXPECT_EQ(rejected.status_code, 429);
+
+  release.Notify();
+  ASSERT_OK(pool.WaitUntilDone(absl::Seconds(10)));
+  EXPECT_EQ(running.status_code, 200);
+}
+
+}  // namespace
+}  // namespace litert::lm
@@ -21,18 +21,28 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
-#include "absl/log/absl_check.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
+#include "absl/memory/memory.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/ascii.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_buffer_ref.h"  // from @litert
 #include "runtime/components/model_resources.h"
+#include "runtime/executor/executor_settings_base.h"
+#include "runtime/framework/threadpool.h"
 #include "runtime/util/memory_mapped_file.h"
 #include "runtime/util/scoped_file.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_checksum.h"
+#include "schema/core/litertlm_compression.h"
 #include "schema/core/litertlm_header_schema_generated.h"
 #include "schema/core/litertlm_read.h"
 
@@ -52,6 +62,9 @@ absl::StatusOr<std::unique_ptr<MemoryMappedFile>> CreateMemoryMapFromScopedFile(
 
 constexpr uint64_t kLitertLmHeaderMaxSize = 16 * 1024;
 
+// The maximum number of threads decompressing and verifying the sections.
+constexpr size_t kMaxNumLoaderThreads = 4;
+
 }  // namespace
 
 absl::Status LitertLmLoader::MapSections() {
@@ -69,10 +82,69 @@ absl::Status LitertLmLoader::MapSections() {
     return status;
   }
 
+  // The sections to verify lazily, by index.
+  std::unordered_map<int, schema::ChecksummedSection> checksummed_sections;
+  if (verification_mode_ != SectionVerificationMode::SECTION_VERIFICATION_NONE) {
+    const absl::string_view file_data(
+        static_cast<const char*>(memory_mapped_file_->data()),
+        memory_mapped_file_->length());
+    ASSIGN_OR_RETURN(  // NOLINT
+        auto sections_to_verify,
+        schema::GetChecksummedSections(*header.metadata, file_data));
+    if (verification_mode_ ==
+        SectionVerificationMode::SECTION_VERIFICATION_EAGER) {
+      RETURN_IF_ERROR(  // NOLINT
+          schema::VerifySectionChecksums(sections_to_verify, &GetThreadPool()));
+      ABSL_LOG(INFO) << "Verified the checksums of "
+                     << sections_to_verify.size() << " sections.";
+    } else {
+      for (const schema::ChecksummedSection& section : sections_to_verify) {
+        checksummed_sections.emplace(section.index, section);
+      }
+    }
+  }
+  // Verifies the section `index` now, if it has a checksum to verify lazily,
+  // because its data is read at load time.
+  auto verify_now = [&](int index) -> absl::Status {
+    auto it = checksummed_sections.find(index);
+    if (it == checksummed_sections.end()) {
+      return absl::OkStatus();
+    }
+    return schema::VerifySectionChecksums(absl::MakeConstSpan(&it->second, 1),
+                                          &GetThreadPool());
+  };
+
   // Loop through the sections and map them to the section buffers.
   auto sections = header.metadata->section_metadata()->objects();
+  // The zstd dictionaries are collected first, as they may come after the
+  // sections compressed with them.
+  std::vector<absl::string_view> zstd_dictionaries;
   for (size_t i = 0; i < sections->size(); ++i) {
     const schema::SectionObject* section = sections->Get(i);
+    if (section->data_type() == schema::AnySectionDataType_ZstdDictionary) {
+      RETURN_IF_ERROR(verify_now(i));  // NOLINT
+      zstd_dictionaries.push_back(absl::string_view(
+          static_cast<const char*>(memory_mapped_file_->data()) +
+              section->begin_offset(),
+          section->end_offset() - section->begin_offset()));
+    }
+  }
+  for (size_t i = 0; i < sections->size(); ++i) {
+    const schema::SectionObject* section = sections->Get(i);
+    if (schema::GetSectionCompression(section->data_type()) !=
+        schema::SectionCompression::kNone) {
+      RETURN_IF_ERROR(verify_now(i));  // NOLINT
+      ASSIGN_OR_RETURN(  // NOLINT
+          auto buffer,
+          DecompressSection(*section, zstd_dictionaries, GetThreadPool()));
+      section_buffers_[BufferKey(
+          schema::GetDecompressedSectionDataType(section->data_type()))] =
+          buffer;
+      ABSL_LOG(INFO) << "section_index: " << i << " decompressed "
+                     << EnumNameAnySectionDataType(section->data_type())
+                     << " to " << buffer.Size() << " bytes.";
+      continue;
+    }
     auto items = section->items();
     BufferKey buffer_key(section->data_type());
     // Extract the specific model type from the section items KeyValuePairs.
@@ -105,6 +177,11 @@ absl::Status LitertLmLoader::MapSections() {
     section_buffers_[buffer_key] =
         BufferRef<uint8_t>(static_cast<uint8_t*>(memory_mapped_file_->data()),
                            section->end_offset(), section->begin_offset());
+    if (auto it = checksummed_sections.find(i);
+        it != checksummed_sections.end()) {
+      absl::MutexLock lock(&mutex_);
+      unverified_sections_.insert_or_assign(buffer_key, it->second);
+    }
     ABSL_LOG(INFO) << "section_index: " << i;
     ABSL_LOG(INFO) << "section_data_type: "
                    << EnumNameAnySectionDataType(section->data_type());
@@ -114,6 +191,62 @@ absl::Status LitertLmLoader::MapSections() {
   return absl::OkStatus();
 }
 
+// static
+absl::StatusOr<std::unique_ptr<LitertLmLoader>> LitertLmLoader::Create(
+    ScopedFile model_file, SectionVerificationMode verification_mode) {
+  auto loader = absl::WrapUnique(new LitertLmLoader(
+      std::move(model_file), verification_mode, NotInitialized()));
+  RETURN_IF_ERROR(loader->Initialize());  // NOLINT
+  return loader;
+}
+
+absl::StatusOr<BufferRef<uint8_t>> LitertLmLoader::GetSection(
+    const BufferKey& key) {
+  auto buffer_it = section_buffers_.find(key);
+  if (buffer_it == section_buffers_.end()) {
+    return absl::NotFoundError(absl::StrCat(
+        "Section not found: ", EnumNameAnySectionDataType(key.data_type)));
+  }
+  // The lock is held during the verification, so that a concurrent access to
+  // the same section waits for it rather than returning it unverified.
+  absl::MutexLock lock(&mutex_);
+  if (auto it = unverified_sections_.find(key);
+      it != unverified_sections_.end()) {
+    RETURN_IF_ERROR(schema::VerifySectionChecksums(  // NOLINT
+        absl::MakeConstSpan(&it->second, 1), &GetThreadPool()));
+    unverified_sections_.erase(it);
+  }
+  return buffer_it->second;
+}
+
+ThreadPool& LitertLmLoader::GetThreadPool() {
+  if (thread_pool_ == nullptr) {
+    thread_pool_ =
+        std::make_unique<ThreadPool>("litertlm_loader", kMaxNumLoaderThreads);
+  }
+  return *thread_pool_;
+}
+
+absl::StatusOr<BufferRef<uint8_t>> LitertLmLoader::DecompressSection(
+    const schema::SectionObject& section,
+    absl::Span<const absl::string_view> zstd_dictionaries,
+    ThreadPool& thread_pool) {
+  const absl::string_view payload(
+      static_cast<const char*>(memory_mapped_file_->data()) +
+          section.begin_offset(),
+      section.end_offset() - section.begin_offset());
+  ASSIGN_OR_RETURN(const uint64_t size,  // NOLINT
+                   schema::GetDecompressedSize(payload));
+  // The buffer is allocated once with the final size, and each chunk is
+  // decompressed in place.
+  auto buffer = std::make_unique<char[]>(size);
+  RETURN_IF_ERROR(schema::DecompressSection(  // NOLINT
+      payload, schema::GetSectionCompression(section.data_type()),
+      zstd_dictionaries, &thread_pool, absl::MakeSpan(buffer.get(), size)));
+  decompressed_sections_.push_back(std::move(buffer));
+  return BufferRef<uint8_t>(decompressed_sections_.back().get(), size);
+}
+
 absl::Status LitertLmLoader::Initialize() {
   ABSL_LOG(INFO) << "LitertLmLoader::Initialize";
 
@@ -127,11 +260,10 @@ absl::Status LitertLmLoader::Initialize() {
   } else {
     ABSL_LOG(ERROR) << "Failed to create memory-mapped file: "
                     << mmap_status.status();
+    return mmap_status.status();
   }
 
-  ABSL_CHECK_OK(MapSections());
-
-  return absl::OkStatus();
+  return MapSections();
 }
 
 }  // namespace litert::lm
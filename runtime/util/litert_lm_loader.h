@@ -23,14 +23,23 @@
 #include <optional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"  // from @com_google_absl
 #include "absl/log/absl_check.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "litert/cc/litert_buffer_ref.h"  // from @litert
 #include "runtime/components/model_resources.h"
+#include "runtime/executor/executor_settings_base.h"
+#include "runtime/framework/threadpool.h"
 #include "runtime/util/memory_mapped_file.h"
 #include "runtime/util/scoped_file.h"
+#include "schema/core/litertlm_checksum.h"
 #include "schema/core/litertlm_header_schema_generated.h"
 
 namespace litert::lm {
@@ -78,38 +87,77 @@ struct BufferKeyHash {
 
 // A class to load the Litert LM model from the .litertlm file. The loader will
 // read the model header from and map the sections to the section buffers.
+//
+// The zstd and LZ4 compressed sections (e.g. SP_Tokenizer_Zstd) are
+// decompressed at load time, in parallel chunks, into buffers owned by the
+// loader, and are keyed by their uncompressed data type (e.g. SP_Tokenizer).
+//
+// The sections with a checksum in the header are verified according to
+// `verification_mode`: all of them at load time, or each of them the first
+// time it is returned. A corrupted section is reported as a DataLoss error,
+// by Create() or by the getter of the section.
 class LitertLmLoader {
  public:
   // Creates a LitertLmLoader from the model file. The loader will read the
   // model header from and map the sections to the section buffers.
-  explicit LitertLmLoader(ScopedFile model_file)
-      : model_file_(std::move(model_file)) {
+  static absl::StatusOr<std::unique_ptr<LitertLmLoader>> Create(
+      ScopedFile model_file,
+      SectionVerificationMode verification_mode =
+          SectionVerificationMode::SECTION_VERIFICATION_NONE);
+
+  // Same as Create(), but any error of the loading is fatal.
+  explicit LitertLmLoader(ScopedFile model_file,
+                          SectionVerificationMode verification_mode =
+                              SectionVerificationMode::SECTION_VERIFICATION_NONE)
+      : model_file_(std::move(model_file)),
+        verification_mode_(verification_mode) {
     ABSL_CHECK_OK(Initialize());
   }
+
+  LitertLmLoader(const LitertLmLoader&) = delete;
+  LitertLmLoader& operator=(const LitertLmLoader&) = delete;
+
   // Returns the tokenizer section buffer.
-  litert::BufferRef<uint8_t> GetTokenizer() {
-    return section_buffers_[BufferKey(
-        schema::AnySectionDataType_SP_Tokenizer)];
+  absl::StatusOr<litert::BufferRef<uint8_t>> GetTokenizer() {
+    return GetSection(BufferKey(schema::AnySectionDataType_SP_Tokenizer));
   }
 
   // Returns the TFLite model section buffer.
-  litert::BufferRef<uint8_t> GetTFLiteModel(ModelType model_type) {
-    return section_buffers_[BufferKey(
-        schema::AnySectionDataType_TFLiteModel, model_type)];
+  absl::StatusOr<litert::BufferRef<uint8_t>> GetTFLiteModel(
+      ModelType model_type) {
+    return GetSection(
+        BufferKey(schema::AnySectionDataType_TFLiteModel, model_type));
   };
 
   // Returns the tokenizer section buffer.
-  litert::BufferRef<uint8_t> GetLlmMetadata() {
-    return section_buffers_[BufferKey(
-        schema::AnySectionDataType_LlmMetadataProto)];
+  absl::StatusOr<litert::BufferRef<uint8_t>> GetLlmMetadata() {
+    return GetSection(BufferKey(schema::AnySectionDataType_LlmMetadataProto));
   }
 
  private:
+  // Only initializes the members, for Create().
+  struct NotInitialized {};
+  LitertLmLoader(ScopedFile model_file,
+                 SectionVerificationMode verification_mode, NotInitialized)
+      : model_file_(std::move(model_file)),
+        verification_mode_(verification_mode) {}
+
   // Initializes the LitertLmLoader. Includes reading the model header and
   // mapping the sections to the section buffers.
   absl::Status Initialize();
   // Maps the sections to the section buffers.
   absl::Status MapSections();
+  // Returns the section buffer of `key`, after verifying it if it was not
+  // verified yet. It is thread-safe.
+  absl::StatusOr<BufferRef<uint8_t>> GetSection(const BufferKey& key);
+  // Returns the thread pool decompressing and verifying the sections, created
+  // on the first call.
+  ThreadPool& GetThreadPool();
+  // Decompresses a compressed section into a new buffer owned by the loader.
+  absl::StatusOr<BufferRef<uint8_t>> DecompressSection(
+      const schema::SectionObject& section,
+      absl::Span<const absl::string_view> zstd_dictionaries,
+      ThreadPool& thread_pool);
   // The model file to be loaded.
   ScopedFile model_file_;
   // The model_file_ mapped to a MemoryMappedFile.
@@ -119,6 +167,17 @@ class LitertLmLoader {
   // between the TFLite models.
   ::std::unordered_map<BufferKey, BufferRef<uint8_t>, BufferKeyHash>
       section_buffers_;
+  // The buffers of the decompressed sections.
+  ::std::vector<::std::unique_ptr<char[]>> decompressed_sections_;
+  const SectionVerificationMode verification_mode_;
+  // Serializes the lazy verifications of the sections.
+  absl::Mutex mutex_;
+  // In SECTION_VERIFICATION_LAZY mode, the sections to verify on their first
+  // access. A corrupted section stays in it, so that each access fails.
+  ::std::unordered_map<BufferKey, schema::ChecksummedSection, BufferKeyHash>
+      unverified_sections_ ABSL_GUARDED_BY(mutex_);
+  // Only created if there are sections to decompress or verify.
+  ::std::unique_ptr<ThreadPool> thread_pool_;
 };
 
 }  // namespace litert::lm
@@ -18,7 +18,9 @@
 #include <utility>
 
 #include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
 #include "runtime/components/model_resources.h"
+#include "runtime/executor/executor_settings_base.h"
 #include "runtime/util/scoped_file.h"
 
 namespace litert::lm {
@@ -32,9 +34,27 @@ TEST(LitertLmLoaderTest, InitializeWithValidFile) {
   auto model_file = ScopedFile::Open(model_path.string());
   ASSERT_TRUE(model_file.ok());
   LitertLmLoader loader(std::move(model_file.value()));
-  ASSERT_GT(loader.GetTokenizer().Size(), 0);
-  ASSERT_GT(loader.GetTFLiteModel(ModelType::kTfLitePrefillDecode).Size(), 0);
-  ASSERT_GT(loader.GetLlmMetadata().Size(), 0);
+  ASSERT_GT(loader.GetTokenizer()->Size(), 0);
+  ASSERT_GT(loader.GetTFLiteModel(ModelType::kTfLitePrefillDecode)->Size(), 0);
+  ASSERT_GT(loader.GetLlmMetadata()->Size(), 0);
+}
+
+TEST(LitertLmLoaderTest, CreateWithLazyVerification) {
+  const auto model_path =
+      std::filesystem::path(::testing::SrcDir()) /
+      "litert_lm/runtime/testdata/test_lm.litertlm";
+  auto model_file = ScopedFile::Open(model_path.string());
+  ASSERT_TRUE(model_file.ok());
+  auto loader = LitertLmLoader::Create(
+      std::move(model_file.value()),
+      SectionVerificationMode::SECTION_VERIFICATION_LAZY);
+  ASSERT_TRUE(loader.ok());
+  auto tokenizer = (*loader)->GetTokenizer();
+  ASSERT_TRUE(tokenizer.ok());
+  EXPECT_GT(tokenizer->Size(), 0);
+  // A section missing from the file is reported rather than returned empty.
+  EXPECT_EQ((*loader)->GetTFLiteModel(ModelType::kTfLiteLoRA).status().code(),
+            absl::StatusCode::kNotFound);
 }
 
 }  // namespace
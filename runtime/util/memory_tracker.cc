@@ -0,0 +1,192 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/util/memory_tracker.h"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+std::ostream& operator<<(std::ostream& os, MemoryComponent component) {
+  switch (component) {
+    case MemoryComponent::kKvCache:
+      return os << "KV_CACHE";
+    case MemoryComponent::kActivations:
+      return os << "ACTIVATIONS";
+    case MemoryComponent::kSampler:
+      return os << "SAMPLER";
+    case MemoryComponent::kOther:
+      return os << "OTHER";
+  }
+  return os << "UNKNOWN";
+}
+
+size_t MemoryUsage::GetOwnerBytes(absl::string_view owner) const {
+  size_t bytes = 0;
+  for (const MemoryUsageEntry& entry : entries) {
+    if (entry.owner == owner) {
+      bytes += entry.bytes;
+    }
+  }
+  return bytes;
+}
+
+size_t MemoryUsage::GetComponentBytes(MemoryComponent component) const {
+  size_t bytes = 0;
+  for (const MemoryUsageEntry& entry : entries) {
+    if (entry.component == component) {
+      bytes += entry.bytes;
+    }
+  }
+  return bytes;
+}
+
+std::ostream& operator<<(std::ostream& os, const MemoryUsage& usage) {
+  os << "MemoryUsage: " << usage.total_bytes << " bytes";
+  if (usage.budget_bytes > 0) {
+    os << " of " << usage.budget_bytes;
+  }
+  os << std::endl;
+  for (const MemoryUsageEntry& entry : usage.entries) {
+    os << "  " << entry.owner << " " << entry.component << ": " << entry.bytes
+       << std::endl;
+  }
+  return os;
+}
+
+MemoryReservation::MemoryReservation(MemoryReservation&& other)
+    : tracker_(other.tracker_),
+      owner_(std::move(other.owner_)),
+      component_(other.component_),
+      bytes_(other.bytes_) {
+  other.tracker_ = nullptr;
+  other.bytes_ = 0;
+}
+
+MemoryReservation& MemoryReservation::operator=(MemoryReservation&& other) {
+  if (this != &other) {
+    Release();
+    tracker_ = other.tracker_;
+    owner_ = std::move(other.owner_);
+    component_ = other.component_;
+    bytes_ = other.bytes_;
+    other.tracker_ = nullptr;
+    other.bytes_ = 0;
+  }
+  return *this;
+}
+
+MemoryReservation::~MemoryReservation() { Release(); }
+
+void MemoryReservation::Release() {
+  if (tracker_ != nullptr) {
+    tracker_->Release(owner_, component_, bytes_);
+    tracker_ = nullptr;
+    bytes_ = 0;
+  }
+}
+
+absl::Status MemoryReservation::Resize(size_t bytes) {
+  if (tracker_ == nullptr) {
+    return absl::OkStatus();
+  }
+  absl::Status status = tracker_->Resize(owner_, component_, bytes_, bytes);
+  if (status.ok()) {
+    bytes_ = bytes;
+  }
+  return status;
+}
+
+absl::StatusOr<MemoryReservation> MemoryTracker::Reserve(
+    absl::string_view owner, MemoryComponent component, size_t bytes) {
+  absl::MutexLock lock(&mutex_);
+  if (budget_bytes_ > 0 && total_bytes_ + bytes > budget_bytes_) {
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "Reserving ", bytes, " bytes for ", owner, " exceeds the budget of ",
+        budget_bytes_, " bytes, ", total_bytes_, " bytes are in use."));
+  }
+  return Add(owner, component, bytes);
+}
+
+MemoryReservation MemoryTracker::Track(absl::string_view owner,
+                                       MemoryComponent component,
+                                       size_t bytes) {
+  absl::MutexLock lock(&mutex_);
+  return Add(owner, component, bytes);
+}
+
+MemoryReservation MemoryTracker::Add(absl::string_view owner,
+                                     MemoryComponent component, size_t bytes) {
+  bytes_[{std::string(owner), component}] += bytes;
+  total_bytes_ += bytes;
+  return MemoryReservation(this, std::string(owner), component, bytes);
+}
+
+absl::Status MemoryTracker::Resize(const std::string& owner,
+                                   MemoryComponent component,
+                                   size_t old_bytes, size_t new_bytes) {
+  if (new_bytes <= old_bytes) {
+    Release(owner, component, old_bytes - new_bytes);
+    return absl::OkStatus();
+  }
+  absl::MutexLock lock(&mutex_);
+  const size_t growth = new_bytes - old_bytes;
+  if (budget_bytes_ > 0 && total_bytes_ + growth > budget_bytes_) {
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "Growing ", owner, " by ", growth, " bytes exceeds the budget of ",
+        budget_bytes_, " bytes, ", total_bytes_, " bytes are in use."));
+  }
+  bytes_[{owner, component}] += growth;
+  total_bytes_ += growth;
+  return absl::OkStatus();
+}
+
+void MemoryTracker::Release(const std::string& owner,
+                            MemoryComponent component, size_t bytes) {
+  absl::MutexLock lock(&mutex_);
+  auto it = bytes_.find({owner, component});
+  if (it == bytes_.end()) {
+    return;
+  }
+  it->second -= bytes;
+  total_bytes_ -= bytes;
+  if (it->second == 0) {
+    bytes_.erase(it);
+  }
+}
+
+MemoryUsage MemoryTracker::GetUsage() const {
+  absl::MutexLock lock(&mutex_);
+  MemoryUsage usage;
+  usage.total_bytes = total_bytes_;
+  usage.budget_bytes = budget_bytes_;
+  for (const auto& [key, bytes] : bytes_) {
+    if (bytes > 0) {
+      usage.entries.push_back(MemoryUsageEntry{
+          .owner = key.first, .component = key.second, .bytes = bytes});
+    }
+  }
+  return usage;
+}
+
+}  // namespace litert::lm
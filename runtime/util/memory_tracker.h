@@ -0,0 +1,170 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_ODML_LITERT_LM_RUNTIME_UTIL_MEMORY_TRACKER_H_
+#define THIRD_PARTY_ODML_LITERT_LM_RUNTIME_UTIL_MEMORY_TRACKER_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"  // from @com_google_absl
+#include "absl/container/btree_map.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"  // from @com_google_absl
+
+namespace litert::lm {
+
+// The kinds of memory accounted by a MemoryTracker.
+enum class MemoryComponent {
+  // The KV cache of the model.
+  kKvCache,
+  // The input and output buffers of the model other than the KV cache.
+  kActivations,
+  // The buffers of the samplers.
+  kSampler,
+  // Anything else.
+  kOther,
+};
+
+std::ostream& operator<<(std::ostream& os, MemoryComponent component);
+
+// The memory accounted to one component of one owner, e.g. the KV cache of
+// the engine or the sampler of a session.
+struct MemoryUsageEntry {
+  std::string owner;
+  MemoryComponent component;
+  size_t bytes;
+};
+
+// A snapshot of the memory accounted by a MemoryTracker.
+struct MemoryUsage {
+  size_t total_bytes = 0;
+  // The budget of the tracker, or 0 for no budget.
+  size_t budget_bytes = 0;
+  // The non-empty entries, sorted by owner and component.
+  std::vector<MemoryUsageEntry> entries;
+
+  // Returns the memory accounted to `owner`, all components together.
+  size_t GetOwnerBytes(absl::string_view owner) const;
+
+  // Returns the memory accounted to `component`, all owners together.
+  size_t GetComponentBytes(MemoryComponent component) const;
+};
+
+std::ostream& operator<<(std::ostream& os, const MemoryUsage& usage);
+
+class MemoryTracker;
+
+// The memory accounted to a tracker until the reservation is destroyed. It is
+// moved around with the memory it accounts for, e.g. held by the session
+// owning the memory. An empty reservation accounts for nothing.
+class MemoryReservation {
+ public:
+  MemoryReservation() = default;
+  MemoryReservation(MemoryReservation&& other);
+  MemoryReservation& operator=(MemoryReservation&& other);
+  ~MemoryReservation();
+
+  size_t bytes() const { return bytes_; }
+
+  // Changes the memory accounted by the reservation to `bytes`, e.g. as a KV
+  // cache grows or shrinks. Growing returns a ResourceExhausted error, leaving
+  // the reservation unchanged, if the growth does not fit in the budget.
+  // Shrinking always succeeds. An empty reservation stays empty.
+  absl::Status Resize(size_t bytes);
+
+ private:
+  friend class MemoryTracker;
+
+  MemoryReservation(MemoryTracker* tracker, std::string owner,
+                    MemoryComponent component, size_t bytes)
+      : tracker_(tracker),
+        owner_(std::move(owner)),
+        component_(component),
+        bytes_(bytes) {}
+
+  // Returns the memory to the tracker, if any.
+  void Release();
+
+  MemoryTracker* tracker_ = nullptr;
+  std::string owner_;
+  MemoryComponent component_ = MemoryComponent::kOther;
+  size_t bytes_ = 0;
+};
+
+// Accounts the memory used by the owners sharing a memory budget, e.g. the
+// engine and its sessions, per owner and per component. The tracker must
+// outlive its reservations. It is thread-safe.
+//
+// Sample usage:
+//
+// MemoryTracker tracker(/*budget_bytes=*/1 << 30);
+// tracker.Track("engine", MemoryComponent::kKvCache, kv_cache_bytes);
+// ASSIGN_OR_RETURN(MemoryReservation reservation,
+//                  tracker.Reserve("session_1", MemoryComponent::kSampler,
+//                                  sampler_bytes));
+//
+class MemoryTracker {
+ public:
+  // Creates a tracker. A `budget_bytes` of 0 means no budget.
+  explicit MemoryTracker(size_t budget_bytes = 0)
+      : budget_bytes_(budget_bytes) {}
+
+  MemoryTracker(const MemoryTracker&) = delete;
+  MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+  // Accounts `bytes` to the component of the owner if they fit in the budget,
+  // and returns a ResourceExhausted error otherwise.
+  absl::StatusOr<MemoryReservation> Reserve(absl::string_view owner,
+                                            MemoryComponent component,
+                                            size_t bytes);
+
+  // Accounts `bytes` to the component of the owner regardless of the budget,
+  // e.g. for memory that is already allocated.
+  MemoryReservation Track(absl::string_view owner, MemoryComponent component,
+                          size_t bytes);
+
+  MemoryUsage GetUsage() const;
+
+ private:
+  friend class MemoryReservation;
+
+  // Changes the memory of the component of the owner from `old_bytes` to
+  // `new_bytes`, checking the growth against the budget.
+  absl::Status Resize(const std::string& owner, MemoryComponent component,
+                      size_t old_bytes, size_t new_bytes);
+
+  // Removes `bytes` from the component of the owner.
+  void Release(const std::string& owner, MemoryComponent component,
+               size_t bytes);
+
+  // Adds `bytes` to the component of the owner.
+  MemoryReservation Add(absl::string_view owner, MemoryComponent component,
+                        size_t bytes) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const size_t budget_bytes_;
+  mutable absl::Mutex mutex_;
+  size_t total_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::btree_map<std::pair<std::string, MemoryComponent>, size_t> bytes_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace litert::lm
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_RUNTIME_UTIL_MEMORY_TRACKER_H_
@@ -0,0 +1,110 @@
+// Copyright 2025 The ODML Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/util/memory_tracker.h"
+
+#include <sstream>
+#include <utility>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "runtime/util/test_utils.h"  // NOLINT
+
+namespace litert::lm {
+namespace {
+
+using ::testing::HasSubstr;
+
+TEST(MemoryTrackerTest, AccountsPerOwnerAndComponent) {
+  MemoryTracker tracker;
+  MemoryReservation kv_cache =
+      tracker.Track("engine", MemoryComponent::kKvCache, 100);
+  MemoryReservation activations =
+      tracker.Track("engine", MemoryComponent::kActivations, 20);
+  ASSERT_OK_AND_ASSIGN(
+      MemoryReservation sampler,
+      tracker.Reserve("session_1", MemoryComponent::kSampler, 5));
+
+  const MemoryUsage usage = tracker.GetUsage();
+  EXPECT_EQ(usage.total_bytes, 125);
+  EXPECT_EQ(usage.budget_bytes, 0);
+  ASSERT_EQ(usage.entries.size(), 3);
+  EXPECT_EQ(usage.entries[0].owner, "engine");
+  EXPECT_EQ(usage.entries[0].component, MemoryComponent::kKvCache);
+  EXPECT_EQ(usage.entries[2].owner, "session_1");
+  EXPECT_EQ(usage.GetOwnerBytes("engine"), 120);
+  EXPECT_EQ(usage.GetComponentBytes(MemoryComponent::kSampler), 5);
+
+  std::stringstream ss;
+  ss << usage;
+  EXPECT_THAT(ss.str(), HasSubstr("session_1 SAMPLER: 5"));
+}
+
+TEST(MemoryTrackerTest, ReservationsReleaseTheirMemory) {
+  MemoryTracker tracker;
+  {
+    MemoryReservation reservation =
+        tracker.Track("session_1", MemoryComponent::kSampler, 10);
+    // Moving the reservation keeps the memory accounted once.
+    MemoryReservation moved = std::move(reservation);
+    EXPECT_EQ(tracker.GetUsage().total_bytes, 10);
+    EXPECT_EQ(moved.bytes(), 10);
+  }
+  const MemoryUsage usage = tracker.GetUsage();
+  EXPECT_EQ(usage.total_bytes, 0);
+  EXPECT_TRUE(usage.entries.empty());
+}
+
+TEST(MemoryTrackerTest, ReserveRespectsTheBudget) {
+  MemoryTracker tracker(/*budget_bytes=*/100);
+  MemoryReservation engine =
+      tracker.Track("engine", MemoryComponent::kKvCache, 80);
+  ASSERT_OK_AND_ASSIGN(
+      MemoryReservation session_1,
+      tracker.Reserve("session_1", MemoryComponent::kSampler, 20));
+  EXPECT_THAT(tracker.Reserve("session_2", MemoryComponent::kSampler, 1),
+              testing::status::StatusIs(absl::StatusCode::kResourceExhausted));
+
+  // The memory of a destroyed session is available again.
+  session_1 = MemoryReservation();
+  EXPECT_OK(tracker.Reserve("session_2", MemoryComponent::kSampler, 20));
+  EXPECT_EQ(tracker.GetUsage().budget_bytes, 100);
+}
+
+TEST(MemoryTrackerTest, ResizeRespectsTheBudget) {
+  MemoryTracker tracker(/*budget_bytes=*/100);
+  MemoryReservation engine =
+      tracker.Track("engine", MemoryComponent::kKvCache, 50);
+  MemoryReservation sequence =
+      tracker.Track("sequence_1", MemoryComponent::kKvCache, 0);
+  ASSERT_OK(sequence.Resize(40));
+  EXPECT_THAT(sequence.Resize(60),
+              testing::status::StatusIs(absl::StatusCode::kResourceExhausted));
+  EXPECT_EQ(sequence.bytes(), 40);
+  EXPECT_EQ(tracker.GetUsage().GetOwnerBytes("sequence_1"), 40);
+
+  // Shrinking makes room for the other owners.
+  ASSERT_OK(sequence.Resize(10));
+  EXPECT_EQ(tracker.GetUsage().total_bytes, 60);
+  EXPECT_OK(tracker.Reserve("session_1", MemoryComponent::kSampler, 40));
+
+  // An empty reservation accounts for nothing.
+  MemoryReservation empty;
+  EXPECT_OK(empty.Resize(1000));
+  EXPECT_EQ(empty.bytes(), 0);
+}
+
+}  // namespace
+}  // namespace litert::lm
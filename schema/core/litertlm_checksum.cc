@@ -0,0 +1,174 @@
+#include "schema/core/litertlm_checksum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/crc/crc32c.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_header_schema_generated.h"
+
+namespace litert {
+
+namespace lm {
+
+namespace schema {
+
+namespace {
+
+// A chunk of a section, hashed independently of the other chunks.
+struct Chunk {
+  absl::string_view data;
+  absl::crc32c_t crc32c{0};
+};
+
+absl::Status CheckChecksumType(SectionChecksumType type) {
+  if (type != SectionChecksumType_NONE && type != SectionChecksumType_CRC32C) {
+    return absl::UnimplementedError(absl::StrFormat(
+        "Unsupported section checksum type: %d.", static_cast<int>(type)));
+  }
+  return absl::OkStatus();
+}
+
+// Splits `data` into chunks of kChecksumChunkSize bytes appended to `chunks`.
+void SplitIntoChunks(absl::string_view data, std::vector<Chunk>& chunks) {
+  for (size_t offset = 0; offset < data.size(); offset += kChecksumChunkSize) {
+    chunks.push_back({.data = data.substr(offset, kChecksumChunkSize)});
+  }
+}
+
+// Hashes the chunks, on `thread_pool` if not null.
+absl::Status HashChunks(absl::Span<Chunk> chunks, ThreadPool* thread_pool) {
+  for (Chunk& chunk : chunks) {
+    auto hash_chunk = [&chunk]() {
+      chunk.crc32c = absl::ComputeCrc32c(chunk.data);
+    };
+    // The chunks which cannot be scheduled are hashed inline.
+    if (thread_pool == nullptr || !thread_pool->Schedule(hash_chunk).ok()) {
+      hash_chunk();
+    }
+  }
+  if (thread_pool != nullptr) {
+    RETURN_IF_ERROR(thread_pool->WaitUntilDone(absl::InfiniteDuration()));
+  }
+  return absl::OkStatus();
+}
+
+// Combines the checksums of consecutive chunks into the checksum of their
+// concatenation.
+uint64_t CombineChunks(absl::Span<const Chunk> chunks) {
+  absl::crc32c_t crc32c{0};
+  for (const Chunk& chunk : chunks) {
+    crc32c = absl::ConcatCrc32c(crc32c, chunk.crc32c, chunk.data.size());
+  }
+  return static_cast<uint32_t>(crc32c);
+}
+
+}  // namespace
+
+absl::StatusOr<SectionChecksumType> ParseSectionChecksumType(
+    absl::string_view name) {
+  if (name == "none") return SectionChecksumType_NONE;
+  if (name == "crc32c") return SectionChecksumType_CRC32C;
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Unknown checksum type: %s. Expected none or crc32c.", name));
+}
+
+void SectionChecksumBuilder::Update(absl::string_view data) {
+  if (type_ == SectionChecksumType_CRC32C) {
+    crc32c_ = absl::ExtendCrc32c(crc32c_, data);
+  }
+}
+
+uint64_t SectionChecksumBuilder::checksum() const {
+  return type_ == SectionChecksumType_CRC32C ? static_cast<uint32_t>(crc32c_)
+                                             : 0;
+}
+
+absl::StatusOr<uint64_t> ComputeSectionChecksum(SectionChecksumType type,
+                                                absl::string_view data,
+                                                ThreadPool* thread_pool) {
+  RETURN_IF_ERROR(CheckChecksumType(type));
+  if (type == SectionChecksumType_NONE) {
+    return 0;
+  }
+  std::vector<Chunk> chunks;
+  SplitIntoChunks(data, chunks);
+  RETURN_IF_ERROR(HashChunks(absl::MakeSpan(chunks), thread_pool));
+  return CombineChunks(chunks);
+}
+
+absl::StatusOr<std::vector<ChecksummedSection>> GetChecksummedSections(
+    const LiteRTLMMetaData& metadata, absl::string_view file_data) {
+  std::vector<ChecksummedSection> sections;
+  if (metadata.section_metadata() == nullptr ||
+      metadata.section_metadata()->objects() == nullptr) {
+    return sections;
+  }
+  const auto* objects = metadata.section_metadata()->objects();
+  for (int i = 0; i < objects->size(); ++i) {
+    const SectionObject* section = objects->Get(i);
+    if (section->checksum_type() == SectionChecksumType_NONE) {
+      continue;
+    }
+    const uint64_t begin_offset = section->begin_offset();
+    const uint64_t end_offset = section->end_offset();
+    if (begin_offset > end_offset || end_offset > file_data.size()) {
+      return absl::DataLossError(absl::StrFormat(
+          "Section %d [%d, %d) is out of the file of %d bytes.", i,
+          begin_offset, end_offset, file_data.size()));
+    }
+    sections.push_back(
+        {.index = i,
+         .data = file_data.substr(begin_offset, end_offset - begin_offset),
+         .checksum_type = section->checksum_type(),
+         .checksum = section->checksum()});
+  }
+  return sections;
+}
+
+absl::Status VerifySectionChecksums(
+    absl::Span<const ChecksummedSection> sections, ThreadPool* thread_pool) {
+  // The chunks of all the sections, and the index of the first chunk of each
+  // section (with an extra end index).
+  std::vector<Chunk> chunks;
+  std::vector<size_t> first_chunks;
+  for (const ChecksummedSection& section : sections) {
+    RETURN_IF_ERROR(CheckChecksumType(section.checksum_type));
+    first_chunks.push_back(chunks.size());
+    if (section.checksum_type != SectionChecksumType_NONE) {
+      SplitIntoChunks(section.data, chunks);
+    }
+  }
+  first_chunks.push_back(chunks.size());
+  RETURN_IF_ERROR(HashChunks(absl::MakeSpan(chunks), thread_pool));
+
+  for (size_t i = 0; i < sections.size(); ++i) {
+    if (sections[i].checksum_type == SectionChecksumType_NONE) {
+      continue;
+    }
+    const uint64_t checksum = CombineChunks(absl::MakeConstSpan(chunks).subspan(
+        first_chunks[i], first_chunks[i + 1] - first_chunks[i]));
+    if (checksum != sections[i].checksum) {
+      return absl::DataLossError(absl::StrFormat(
+          "Section %d is corrupted: its %s checksum is %#x, expected %#x.",
+          sections[i].index,
+          EnumNameSectionChecksumType(sections[i].checksum_type), checksum,
+          sections[i].checksum));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace schema
+
+}  // namespace lm
+
+}  // namespace litert
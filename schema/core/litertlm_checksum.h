@@ -0,0 +1,81 @@
+#ifndef THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_CHECKSUM_H_
+#define THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/crc/crc32c.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "schema/core/litertlm_header_schema_generated.h"
+
+namespace litert {
+
+namespace lm {
+
+namespace schema {
+
+// The size of the chunks the sections are split into to be verified in
+// parallel. Large enough for the per-chunk overhead to be negligible, and
+// small enough to balance a single large section over several threads.
+constexpr size_t kChecksumChunkSize = 8 * 1024 * 1024;
+
+// Parses a checksum type name: "none" or "crc32c".
+absl::StatusOr<SectionChecksumType> ParseSectionChecksumType(
+    absl::string_view name);
+
+// Computes the checksum of a section streamed in consecutive pieces, e.g. by
+// the writer while it copies the section to the file.
+class SectionChecksumBuilder {
+ public:
+  explicit SectionChecksumBuilder(SectionChecksumType type) : type_(type) {}
+
+  void Update(absl::string_view data);
+
+  uint64_t checksum() const;
+
+ private:
+  SectionChecksumType type_;
+  absl::crc32c_t crc32c_{0};
+};
+
+// Computes the checksum of `data`. The chunks of kChecksumChunkSize bytes are
+// hashed on `thread_pool` if not null.
+absl::StatusOr<uint64_t> ComputeSectionChecksum(SectionChecksumType type,
+                                                absl::string_view data,
+                                                ThreadPool* thread_pool);
+
+// A section to verify against the checksum recorded in the header.
+struct ChecksummedSection {
+  // The index of the section, for the error messages.
+  int index;
+  // The section data, typically in a memory-mapped file.
+  absl::string_view data;
+  SectionChecksumType checksum_type;
+  uint64_t checksum;
+};
+
+// Returns the sections of `metadata` which have a checksum, with their data in
+// `file_data`, the whole LiteRT-LM file (e.g. memory-mapped). Returns a
+// DataLossError if one of them is out of the file, e.g. truncated.
+absl::StatusOr<std::vector<ChecksummedSection>> GetChecksummedSections(
+    const LiteRTLMMetaData& metadata, absl::string_view file_data);
+
+// Verifies the sections against their checksums. The chunks of all sections
+// are hashed together on `thread_pool` if not null, so that a file with one
+// large section and several small ones keeps all threads busy. Returns a
+// DataLossError naming the first mismatching section.
+absl::Status VerifySectionChecksums(
+    absl::Span<const ChecksummedSection> sections, ThreadPool* thread_pool);
+
+}  // namespace schema
+
+}  // namespace lm
+
+}  // namespace litert
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_CHECKSUM_H_
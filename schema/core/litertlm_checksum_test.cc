@@ -0,0 +1,94 @@
+#include "schema/core/litertlm_checksum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+#include "schema/core/litertlm_header_schema_generated.h"
+
+namespace litert::lm::schema {
+namespace {
+
+using ::testing::status::IsOkAndHolds;
+using ::testing::status::StatusIs;
+
+// Spans several chunks, the last one partial.
+std::string GetTestData() {
+  std::string data(2 * kChecksumChunkSize + 12345, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>((i * 2654435761u) >> 13);
+  }
+  return data;
+}
+
+TEST(LiteRTLMChecksumTest, Crc32cCheckValue) {
+  EXPECT_THAT(
+      ComputeSectionChecksum(SectionChecksumType_CRC32C, "123456789", nullptr),
+      IsOkAndHolds(0xe3069283));
+  EXPECT_THAT(ComputeSectionChecksum(SectionChecksumType_NONE, "123456789",
+                                     nullptr),
+              IsOkAndHolds(0));
+}
+
+TEST(LiteRTLMChecksumTest, ChunksAreCombined) {
+  const std::string data = GetTestData();
+  SectionChecksumBuilder builder(SectionChecksumType_CRC32C);
+  builder.Update(absl::string_view(data).substr(0, 1000));
+  builder.Update(absl::string_view(data).substr(1000));
+
+  ThreadPool thread_pool("checksum", /*max_num_threads=*/4);
+  EXPECT_THAT(
+      ComputeSectionChecksum(SectionChecksumType_CRC32C, data, &thread_pool),
+      IsOkAndHolds(builder.checksum()));
+  EXPECT_THAT(ComputeSectionChecksum(SectionChecksumType_CRC32C, data, nullptr),
+              IsOkAndHolds(builder.checksum()));
+}
+
+TEST(LiteRTLMChecksumTest, VerifySectionChecksums) {
+  std::string data = GetTestData();
+  ASSERT_OK_AND_ASSIGN(
+      const uint64_t checksum,
+      ComputeSectionChecksum(SectionChecksumType_CRC32C, data, nullptr));
+  ASSERT_OK_AND_ASSIGN(
+      const uint64_t empty_checksum,
+      ComputeSectionChecksum(SectionChecksumType_CRC32C, "", nullptr));
+  ThreadPool thread_pool("checksum", /*max_num_threads=*/4);
+  const ChecksummedSection sections[] = {
+      {.index = 0, .data = "", .checksum_type = SectionChecksumType_CRC32C,
+       .checksum = empty_checksum},
+      {.index = 1, .data = "unchecked",
+       .checksum_type = SectionChecksumType_NONE, .checksum = 0},
+      {.index = 2, .data = data, .checksum_type = SectionChecksumType_CRC32C,
+       .checksum = checksum},
+  };
+  EXPECT_OK(VerifySectionChecksums(sections, &thread_pool));
+
+  data[kChecksumChunkSize + 7] ^= 1;
+  EXPECT_THAT(VerifySectionChecksums(sections, &thread_pool),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(LiteRTLMChecksumTest, UnknownChecksumType) {
+  const ChecksummedSection sections[] = {
+      {.index = 0, .data = "data",
+       .checksum_type = static_cast<SectionChecksumType>(7), .checksum = 0}};
+  EXPECT_THAT(VerifySectionChecksums(sections, nullptr),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+TEST(LiteRTLMChecksumTest, ParseSectionChecksumType) {
+  EXPECT_THAT(ParseSectionChecksumType("none"),
+              IsOkAndHolds(SectionChecksumType_NONE));
+  EXPECT_THAT(ParseSectionChecksumType("crc32c"),
+              IsOkAndHolds(SectionChecksumType_CRC32C));
+  EXPECT_THAT(ParseSectionChecksumType("md5"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace litert::lm::schema
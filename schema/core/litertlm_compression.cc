@@ -0,0 +1,329 @@
+#include "schema/core/litertlm_compression.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "lz4.h"  // from @lz4
+#include "lz4hc.h"  // from @lz4
+#include "runtime/framework/threadpool.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_header_schema_generated.h"
+#include "zstd.h"  // from @zstd
+
+namespace litert {
+
+namespace lm {
+
+namespace schema {
+
+namespace {
+
+// The payload begins with the uncompressed size, the chunk size and the
+// number of chunks.
+constexpr size_t kPayloadHeaderSize = 3 * sizeof(uint64_t);
+
+void WriteUint64(uint64_t value, std::ostream& output) {
+  output.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint64_t ReadUint64(const char* data) {
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+// Compresses a single chunk into `compressed`, which is resized to the
+// compressed size.
+absl::Status CompressChunk(absl::string_view chunk,
+                           SectionCompression compression, int level,
+                           ZSTD_CCtx* zstd_context, std::string& compressed) {
+  switch (compression) {
+    case SectionCompression::kZstd: {
+      compressed.resize(ZSTD_compressBound(chunk.size()));
+      const size_t size =
+          ZSTD_compress2(zstd_context, compressed.data(), compressed.size(),
+                         chunk.data(), chunk.size());
+      if (ZSTD_isError(size)) {
+        return absl::InternalError(absl::StrFormat(
+            "Zstd compression failed: %s", ZSTD_getErrorName(size)));
+      }
+      compressed.resize(size);
+      return absl::OkStatus();
+    }
+    case SectionCompression::kLz4: {
+      const int bound = LZ4_compressBound(chunk.size());
+      compressed.resize(bound);
+      const int size =
+          level > 0 ? LZ4_compress_HC(chunk.data(), compressed.data(),
+                                      chunk.size(), bound, level)
+                    : LZ4_compress_default(chunk.data(), compressed.data(),
+                                           chunk.size(), bound);
+      if (size <= 0) {
+        return absl::InternalError("LZ4 compression failed.");
+      }
+      compressed.resize(size);
+      return absl::OkStatus();
+    }
+    case SectionCompression::kNone:
+      break;
+  }
+  return absl::InvalidArgumentError("No compression codec specified.");
+}
+
+// Decompresses a single chunk into `output`, which must be exactly the
+// uncompressed size of the chunk.
+absl::Status DecompressChunk(absl::string_view chunk,
+                             SectionCompression compression,
+                             absl::Span<const absl::string_view> dictionaries,
+                             absl::Span<const unsigned> dictionary_ids,
+                             absl::Span<char> output) {
+  size_t size = 0;
+  switch (compression) {
+    case SectionCompression::kZstd: {
+      const unsigned dictionary_id =
+          ZSTD_getDictID_fromFrame(chunk.data(), chunk.size());
+      absl::string_view dictionary;
+      if (dictionary_id != 0) {
+        auto it = std::find(dictionary_ids.begin(), dictionary_ids.end(),
+                            dictionary_id);
+        if (it == dictionary_ids.end()) {
+          return absl::NotFoundError(absl::StrFormat(
+              "Zstd dictionary %u not found.", dictionary_id));
+        }
+        dictionary = dictionaries[it - dictionary_ids.begin()];
+      }
+      std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(
+          ZSTD_createDCtx(), ZSTD_freeDCtx);
+      if (context == nullptr) {
+        return absl::ResourceExhaustedError(
+            "Failed to create the zstd decompression context.");
+      }
+      size = ZSTD_decompress_usingDict(
+          context.get(), output.data(), output.size(), chunk.data(),
+          chunk.size(), dictionary.data(), dictionary.size());
+      if (ZSTD_isError(size)) {
+        return absl::DataLossError(absl::StrFormat(
+            "Zstd decompression failed: %s", ZSTD_getErrorName(size)));
+      }
+      break;
+    }
+    case SectionCompression::kLz4: {
+      const int result = LZ4_decompress_safe(chunk.data(), output.data(),
+                                             chunk.size(), output.size());
+      if (result < 0) {
+        return absl::DataLossError("Invalid or incomplete LZ4 data.");
+      }
+      size = result;
+      break;
+    }
+    case SectionCompression::kNone:
+      return absl::InvalidArgumentError("No compression codec specified.");
+  }
+  if (size != output.size()) {
+    return absl::DataLossError(
+        absl::StrFormat("Decompressed %d bytes, expected %d.", size,
+                        output.size()));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<SectionCompression> ParseSectionCompression(
+    absl::string_view name) {
+  if (name == "none") return SectionCompression::kNone;
+  if (name == "zstd") return SectionCompression::kZstd;
+  if (name == "lz4") return SectionCompression::kLz4;
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Unknown compression: %s. Expected none, zstd or lz4.", name));
+}
+
+SectionCompression GetSectionCompression(AnySectionDataType data_type) {
+  switch (data_type) {
+    case AnySectionDataType_SP_Tokenizer_Zstd:
+    case AnySectionDataType_HF_Tokenizer_Zstd:
+    case AnySectionDataType_LlmMetadataProto_Zstd:
+    case AnySectionDataType_GenericBinaryData_Zstd:
+      return SectionCompression::kZstd;
+    case AnySectionDataType_GenericBinaryData_Lz4:
+      return SectionCompression::kLz4;
+    default:
+      return SectionCompression::kNone;
+  }
+}
+
+AnySectionDataType GetDecompressedSectionDataType(
+    AnySectionDataType data_type) {
+  switch (data_type) {
+    case AnySectionDataType_SP_Tokenizer_Zstd:
+      return AnySectionDataType_SP_Tokenizer;
+    case AnySectionDataType_LlmMetadataProto_Zstd:
+      return AnySectionDataType_LlmMetadataProto;
+    case AnySectionDataType_GenericBinaryData_Zstd:
+    case AnySectionDataType_GenericBinaryData_Lz4:
+      return AnySectionDataType_GenericBinaryData;
+    default:
+      return data_type;
+  }
+}
+
+absl::Status CompressSection(std::istream& input, uint64_t uncompressed_size,
+                             SectionCompression compression, int level,
+                             absl::string_view zstd_dictionary,
+                             size_t chunk_size, std::ostream& output) {
+  if (chunk_size == 0 ||
+      (compression == SectionCompression::kLz4 &&
+       chunk_size > LZ4_MAX_INPUT_SIZE)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid chunk size: %d", chunk_size));
+  }
+  std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> zstd_context(
+      nullptr, ZSTD_freeCCtx);
+  if (compression == SectionCompression::kZstd) {
+    zstd_context.reset(ZSTD_createCCtx());
+    if (zstd_context == nullptr) {
+      return absl::ResourceExhaustedError(
+          "Failed to create the zstd compression context.");
+    }
+    ZSTD_CCtx_setParameter(zstd_context.get(), ZSTD_c_compressionLevel,
+                           level != 0 ? level : ZSTD_CLEVEL_DEFAULT);
+    if (!zstd_dictionary.empty()) {
+      // Without an id, the decompressor could not tell which dictionary a
+      // frame was compressed with.
+      if (ZSTD_getDictID_fromDict(zstd_dictionary.data(),
+                                  zstd_dictionary.size()) == 0) {
+        return absl::InvalidArgumentError(
+            "The zstd dictionary has no id, e.g. it was not trained with "
+            "`zstd --train`.");
+      }
+      const size_t result = ZSTD_CCtx_loadDictionary(
+          zstd_context.get(), zstd_dictionary.data(), zstd_dictionary.size());
+      if (ZSTD_isError(result)) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Failed to load the zstd dictionary: %s",
+            ZSTD_getErrorName(result)));
+      }
+    }
+  } else if (!zstd_dictionary.empty()) {
+    return absl::InvalidArgumentError(
+        "A zstd dictionary is only supported with zstd compression.");
+  }
+
+  const uint64_t num_chunks = (uncompressed_size + chunk_size - 1) / chunk_size;
+  WriteUint64(uncompressed_size, output);
+  WriteUint64(chunk_size, output);
+  WriteUint64(num_chunks, output);
+
+  // Only one chunk is held in memory at a time.
+  std::string chunk(std::min<uint64_t>(chunk_size, uncompressed_size), '\0');
+  std::string compressed;
+  uint64_t remaining_size = uncompressed_size;
+  while (remaining_size > 0) {
+    const size_t size = std::min<uint64_t>(chunk_size, remaining_size);
+    input.read(chunk.data(), size);
+    if (input.gcount() != size) {
+      return absl::DataLossError(absl::StrFormat(
+          "Read %d bytes, expected %d.", input.gcount(), size));
+    }
+    RETURN_IF_ERROR(CompressChunk(absl::string_view(chunk.data(), size),
+                                  compression, level, zstd_context.get(),
+                                  compressed));
+    WriteUint64(compressed.size(), output);
+    output.write(compressed.data(), compressed.size());
+    remaining_size -= size;
+  }
+  if (!output) {
+    return absl::InternalError("Failed to write the compressed data.");
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<uint64_t> GetDecompressedSize(absl::string_view payload) {
+  if (payload.size() < kPayloadHeaderSize) {
+    return absl::DataLossError(
+        "Data too short to contain the compressed section header.");
+  }
+  return ReadUint64(payload.data());
+}
+
+absl::Status DecompressSection(
+    absl::string_view payload, SectionCompression compression,
+    absl::Span<const absl::string_view> zstd_dictionaries,
+    ThreadPool* thread_pool, absl::Span<char> output) {
+  ASSIGN_OR_RETURN(const uint64_t uncompressed_size,  // NOLINT
+                   GetDecompressedSize(payload));
+  const uint64_t chunk_size = ReadUint64(payload.data() + sizeof(uint64_t));
+  const uint64_t num_chunks = ReadUint64(payload.data() + 2 * sizeof(uint64_t));
+  if (output.size() != uncompressed_size) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("The output has %d bytes, expected %d.", output.size(),
+                        uncompressed_size));
+  }
+  if (chunk_size == 0 ||
+      num_chunks != (uncompressed_size + chunk_size - 1) / chunk_size) {
+    return absl::DataLossError("Invalid compressed section header.");
+  }
+
+  // Locate the chunks first, so that they can be decompressed independently.
+  std::vector<absl::string_view> chunks;
+  chunks.reserve(num_chunks);
+  size_t offset = kPayloadHeaderSize;
+  for (uint64_t i = 0; i < num_chunks; ++i) {
+    if (payload.size() - offset < sizeof(uint64_t)) {
+      return absl::DataLossError("The compressed section is truncated.");
+    }
+    const uint64_t compressed_size = ReadUint64(payload.data() + offset);
+    offset += sizeof(uint64_t);
+    if (payload.size() - offset < compressed_size) {
+      return absl::DataLossError("The compressed section is truncated.");
+    }
+    chunks.push_back(payload.substr(offset, compressed_size));
+    offset += compressed_size;
+  }
+
+  std::vector<unsigned> dictionary_ids;
+  dictionary_ids.reserve(zstd_dictionaries.size());
+  for (const auto& dictionary : zstd_dictionaries) {
+    dictionary_ids.push_back(
+        ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size()));
+  }
+
+  std::vector<absl::Status> statuses(num_chunks);
+  for (uint64_t i = 0; i < num_chunks; ++i) {
+    auto decompress_chunk = [&, i]() {
+      statuses[i] = DecompressChunk(
+          chunks[i], compression, zstd_dictionaries, dictionary_ids,
+          output.subspan(i * chunk_size, chunk_size));
+    };
+    // The chunks which cannot be scheduled are decompressed inline.
+    if (thread_pool == nullptr ||
+        !thread_pool->Schedule(decompress_chunk).ok()) {
+      decompress_chunk();
+    }
+  }
+  if (thread_pool != nullptr) {
+    RETURN_IF_ERROR(thread_pool->WaitUntilDone(absl::InfiniteDuration()));
+  }
+  for (const auto& status : statuses) {
+    RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace schema
+
+}  // namespace lm
+
+}  // namespace litert
@@ -0,0 +1,84 @@
+#ifndef THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_COMPRESSION_H_
+#define THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "schema/core/litertlm_header_schema_generated.h"
+
+namespace litert {
+
+namespace lm {
+
+namespace schema {
+
+// The compression codecs of the chunked compressed sections.
+enum class SectionCompression {
+  kNone,
+  kZstd,
+  kLz4,
+};
+
+// The default size of the uncompressed chunks. Chunks are compressed
+// independently, so that they can be decompressed in parallel.
+constexpr size_t kDefaultCompressionChunkSize = 1024 * 1024;
+
+// Parses a codec name: "none", "zstd" or "lz4".
+absl::StatusOr<SectionCompression> ParseSectionCompression(
+    absl::string_view name);
+
+// Returns the codec of the chunked compressed section data types, or kNone
+// for the other data types (including HF_Tokenizer_Zlib, whose payload is a
+// single zlib stream).
+SectionCompression GetSectionCompression(AnySectionDataType data_type);
+
+// Returns the data type of the uncompressed payload of a compressed section
+// data type, e.g. SP_Tokenizer for SP_Tokenizer_Zstd. Returns `data_type`
+// itself for the types without an uncompressed equivalent (HF tokenizers are
+// only stored compressed) and for the uncompressed types.
+AnySectionDataType GetDecompressedSectionDataType(AnySectionDataType data_type);
+
+// Compresses `uncompressed_size` bytes from `input` into `output`, reading
+// and compressing one chunk of `chunk_size` bytes at a time. The payload is
+//   [uint64 uncompressed size][uint64 chunk size][uint64 number of chunks]
+// followed, for each chunk, by [uint64 compressed size][compressed data].
+//
+// - level: The codec specific compression level, 0 for the default. For LZ4,
+//   a positive level selects the slower, high compression (HC) compressor,
+//   which decompresses as fast as the default one.
+// - zstd_dictionary: An optional dictionary for zstd. Its id is recorded in
+//   each zstd frame, so the matching dictionary can be found when
+//   decompressing.
+absl::Status CompressSection(std::istream& input, uint64_t uncompressed_size,
+                             SectionCompression compression, int level,
+                             absl::string_view zstd_dictionary,
+                             size_t chunk_size, std::ostream& output);
+
+// Returns the uncompressed size recorded in a compressed payload, so that the
+// caller can allocate the output buffer of DecompressSection().
+absl::StatusOr<uint64_t> GetDecompressedSize(absl::string_view payload);
+
+// Decompresses a payload written by CompressSection() into `output`, which
+// must be exactly GetDecompressedSize() bytes. Each chunk is decompressed in
+// place into its range of `output`, on `thread_pool` if not null.
+//
+// - zstd_dictionaries: The dictionaries the zstd chunks may refer to, matched
+//   by their ids.
+absl::Status DecompressSection(
+    absl::string_view payload, SectionCompression compression,
+    absl::Span<const absl::string_view> zstd_dictionaries,
+    ThreadPool* thread_pool, absl::Span<char> output);
+
+}  // namespace schema
+
+}  // namespace lm
+
+}  // namespace litert
+
+#endif  // THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_COMPRESSION_H_
@@ -0,0 +1,131 @@
+#include "schema/core/litertlm_compression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "runtime/util/test_utils.h"  // NOLINT
+#include "schema/core/litertlm_header_schema_generated.h"
+
+namespace litert::lm::schema {
+namespace {
+
+using ::testing::status::IsOkAndHolds;
+using ::testing::status::StatusIs;
+
+std::string GetTestData(size_t size) {
+  std::string data(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = "LiteRT-LM compressed section "[i % 29] + (i / 997) % 3;
+  }
+  return data;
+}
+
+std::string Compress(absl::string_view data, SectionCompression compression,
+                     int level = 0, size_t chunk_size = 1000) {
+  std::stringstream input{std::string(data)};
+  std::stringstream output;
+  EXPECT_OK(CompressSection(input, data.size(), compression, level,
+                            /*zstd_dictionary=*/"", chunk_size, output));
+  return output.str();
+}
+
+class LiteRTLMCompressionTest
+    : public ::testing::TestWithParam<SectionCompression> {};
+
+TEST_P(LiteRTLMCompressionTest, RoundTrip) {
+  const std::string data = GetTestData(10500);
+  const std::string payload = Compress(data, GetParam());
+  EXPECT_LT(payload.size(), data.size());
+  ASSERT_OK_AND_ASSIGN(const uint64_t size, GetDecompressedSize(payload));
+  ASSERT_EQ(size, data.size());
+
+  std::string output(size, '\0');
+  ASSERT_OK(DecompressSection(payload, GetParam(), {}, /*thread_pool=*/nullptr,
+                              absl::MakeSpan(output)));
+  EXPECT_EQ(output, data);
+}
+
+TEST_P(LiteRTLMCompressionTest, RoundTripOnThreadPool) {
+  const std::string data = GetTestData(100000);
+  const std::string payload = Compress(data, GetParam(), /*level=*/3);
+  ThreadPool thread_pool("decompression", /*max_num_threads=*/4);
+  std::string output(data.size(), '\0');
+  ASSERT_OK(DecompressSection(payload, GetParam(), {}, &thread_pool,
+                              absl::MakeSpan(output)));
+  EXPECT_EQ(output, data);
+}
+
+TEST_P(LiteRTLMCompressionTest, EmptyData) {
+  const std::string payload = Compress("", GetParam());
+  ASSERT_OK_AND_ASSIGN(const uint64_t size, GetDecompressedSize(payload));
+  EXPECT_EQ(size, 0);
+  EXPECT_OK(DecompressSection(payload, GetParam(), {}, nullptr, {}));
+}
+
+TEST_P(LiteRTLMCompressionTest, TruncatedPayloadFails) {
+  const std::string data = GetTestData(5000);
+  const std::string payload = Compress(data, GetParam());
+  std::string output(data.size(), '\0');
+  EXPECT_THAT(DecompressSection(
+                  absl::string_view(payload).substr(0, payload.size() - 1),
+                  GetParam(), {}, nullptr, absl::MakeSpan(output)),
+              StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(DecompressSection(payload, GetParam(), {}, nullptr,
+                                absl::MakeSpan(output).subspan(1)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(GetDecompressedSize("short"),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+INSTANTIATE_TEST_SUITE_P(Codecs, LiteRTLMCompressionTest,
+                         ::testing::Values(SectionCompression::kZstd,
+                                           SectionCompression::kLz4));
+
+TEST(LiteRTLMCompressionTest, ZstdDictionaryMustHaveAnId) {
+  std::stringstream input("data");
+  std::stringstream output;
+  EXPECT_THAT(CompressSection(input, 4, SectionCompression::kZstd, 0,
+                              "a raw content dictionary",
+                              kDefaultCompressionChunkSize, output),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(CompressSection(input, 4, SectionCompression::kLz4, 0,
+                              "a raw content dictionary",
+                              kDefaultCompressionChunkSize, output),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(LiteRTLMCompressionTest, ParseSectionCompression) {
+  EXPECT_THAT(ParseSectionCompression("none"),
+              IsOkAndHolds(SectionCompression::kNone));
+  EXPECT_THAT(ParseSectionCompression("zstd"),
+              IsOkAndHolds(SectionCompression::kZstd));
+  EXPECT_THAT(ParseSectionCompression("lz4"),
+              IsOkAndHolds(SectionCompression::kLz4));
+  EXPECT_THAT(ParseSectionCompression("gzip"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(LiteRTLMCompressionTest, SectionDataTypes) {
+  EXPECT_EQ(GetSectionCompression(AnySectionDataType_SP_Tokenizer_Zstd),
+            SectionCompression::kZstd);
+  EXPECT_EQ(GetSectionCompression(AnySectionDataType_GenericBinaryData_Lz4),
+            SectionCompression::kLz4);
+  EXPECT_EQ(GetSectionCompression(AnySectionDataType_HF_Tokenizer_Zlib),
+            SectionCompression::kNone);
+  EXPECT_EQ(
+      GetDecompressedSectionDataType(AnySectionDataType_LlmMetadataProto_Zstd),
+      AnySectionDataType_LlmMetadataProto);
+  EXPECT_EQ(GetDecompressedSectionDataType(AnySectionDataType_TFLiteModel),
+            AnySectionDataType_TFLiteModel);
+}
+
+}  // namespace
+}  // namespace litert::lm::schema
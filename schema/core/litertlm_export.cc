@@ -1,5 +1,6 @@
 #include "schema/core/litertlm_export.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
@@ -13,8 +14,10 @@
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
 #include "flatbuffers/buffer.h"  // from @flatbuffers
 #include "flatbuffers/flatbuffer_builder.h"  // from @flatbuffers
+#include "schema/core/litertlm_checksum.h"
 #include "schema/core/litertlm_header.h"
 #include "schema/core/litertlm_header_schema_generated.h"
 #include "schema/core/litertlm_section.h"
@@ -28,13 +31,17 @@ namespace schema {
 constexpr int kHeaderBeginByteOffset = 32;
 constexpr int kHeaderEndLocationByteOffset = 24;
 constexpr int kBlockSize = 16 * 1024;
+// The size of the chunks the sections are copied and padded with.
+constexpr size_t kCopyChunkSize = 1024 * 1024;
 
 absl::Status WriteHeader(
     flatbuffers::FlatBufferBuilder& builder, std::ostream& output_stream,
     const std::vector<KVPair>& system_metadata_map,
     const std::vector<std::vector<KVPair>>& section_items_maps,
     const std::vector<std::pair<uint64_t, uint64_t>>& section_offsets,
-    const std::vector<AnySectionDataType>& section_types) {
+    const std::vector<AnySectionDataType>& section_types,
+    SectionChecksumType checksum_type,
+    const std::vector<uint64_t>& section_checksums) {
   auto system_metadata_offset =
       CreateSystemMetadata(builder, builder.CreateVector(system_metadata_map));
 
@@ -43,7 +50,8 @@ absl::Status WriteHeader(
   for (int i = 0; i < section_types.size(); ++i) {
     auto section_object = CreateSectionObject(
         builder, builder.CreateVector(section_items_maps[i]),
-        section_offsets[i].first, section_offsets[i].second, section_types[i]);
+        section_offsets[i].first, section_offsets[i].second, section_types[i],
+        checksum_type, section_checksums[i]);
     section_objects_vector.push_back(section_object);
   }
 
@@ -68,8 +76,14 @@ absl::Status WriteHeader(
   return absl::OkStatus();
 }
 absl::Status WriteZeroPad(std::ostream& output_stream, uint64_t num_bytes) {
-  std::vector<char> padding(num_bytes, 0);  // Create a buffer of zeros
-  output_stream.write(padding.data(), num_bytes);
+  // Write from a bounded buffer of zeros, as the padding to a large alignment
+  // (e.g. 2 MB) may be large.
+  std::vector<char> padding(std::min<uint64_t>(num_bytes, kCopyChunkSize), 0);
+  while (num_bytes > 0) {
+    const uint64_t chunk_size = std::min<uint64_t>(num_bytes, padding.size());
+    output_stream.write(padding.data(), chunk_size);
+    num_bytes -= chunk_size;
+  }
   output_stream.flush();
   if (!output_stream.good()) {
     return absl::Status(absl::StatusCode::kInternal,
@@ -83,7 +97,7 @@ absl::Status PadUntilNextPageBlock(std::ostream& output_file,
   std::streampos current_position = output_file.tellp();
   size_t bytes_written = static_cast<size_t>(current_position);
   size_t required_size = (bytes_written + block_size - 1) / block_size *
-                         block_size;  // Calculate the next multiple of 16k
+                         block_size;  // Calculate the next multiple
   if (bytes_written < required_size) {
     size_t padding_needed = required_size - bytes_written;
     RETURN_IF_ERROR(WriteZeroPad(output_file, padding_needed));
@@ -91,14 +105,47 @@ absl::Status PadUntilNextPageBlock(std::ostream& output_file,
   return absl::OkStatus();
 }
 
+// Copies `num_bytes` from the section stream to the output stream in chunks
+// of `buffer.size()` bytes, adding them to `checksum`.
+absl::Status CopySectionStream(std::istream& section_stream, size_t num_bytes,
+                               std::vector<char>& buffer,
+                               SectionChecksumBuilder& checksum,
+                               std::ostream& output_stream) {
+  while (num_bytes > 0) {
+    const size_t chunk_size = std::min(num_bytes, buffer.size());
+    section_stream.read(buffer.data(), chunk_size);
+    if (section_stream.gcount() != chunk_size) {
+      return absl::Status(
+          absl::StatusCode::kInternal,
+          absl::StrFormat("Section stream ended %d bytes early.", num_bytes));
+    }
+    checksum.Update(absl::string_view(buffer.data(), chunk_size));
+    output_stream.write(buffer.data(), chunk_size);
+    if (!output_stream.good()) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Error writing section to output stream.");
+    }
+    num_bytes -= chunk_size;
+  }
+  return absl::OkStatus();
+}
+
 absl::Status MakeLiteRTLMFromSections(
     flatbuffers::FlatBufferBuilder& builder,
     const std::vector<std::unique_ptr<SectionStreamBase>>& sections,
     const std::vector<AnySectionDataType>& section_types,
     const std::vector<KVPair>& system_metadata_map,
     const std::vector<std::vector<KVPair>>& section_items_maps,
-    const std::string& out_path) {
+    const std::string& out_path, size_t section_alignment,
+    SectionChecksumType checksum_type) {
   // ** Validation **
+  if (section_alignment == 0 ||
+      (section_alignment & (section_alignment - 1)) != 0) {
+    return absl::Status(
+        absl::StatusCode::kInvalidArgument,
+        absl::StrFormat("Section alignment must be a power of two, got %d.",
+                        section_alignment));
+  }
   if (sections.empty()) {
     ABSL_LOG(ERROR) << "Input sections list is empty.";
     return absl::Status(absl::StatusCode::kInvalidArgument,
@@ -131,22 +178,29 @@ absl::Status MakeLiteRTLMFromSections(
   output_file.write(reinterpret_cast<const char*>(&LITERTLM_PATCH_VERSION),
                     sizeof(uint32_t));
 
-  // ** 1. Write zero pad until offset kBlockSize. **
+  // ** 1. Write zero pad until offset kBlockSize, reserved for the header,
+  // and then until the first aligned offset. **
   RETURN_IF_ERROR(PadUntilNextPageBlock(output_file, kBlockSize));
+  RETURN_IF_ERROR(PadUntilNextPageBlock(output_file, section_alignment));
 
   // ** 2. Write the sections. **
   std::vector<std::pair<uint64_t, uint64_t>> section_offsets;
+  std::vector<uint64_t> section_checksums;
+  std::vector<char> copy_buffer(kCopyChunkSize);
   for (size_t i = 0; i < sections.size(); ++i) {
     RETURN_IF_ERROR(sections[i]->Prepare());
     std::streampos start_byte_offset = output_file.tellp();  // capture start
-    std::istream& strm = sections[i]->GetStream();
-    output_file << strm.rdbuf();
+    SectionChecksumBuilder checksum(checksum_type);
+    RETURN_IF_ERROR(CopySectionStream(sections[i]->GetStream(),
+                                      sections[i]->BufferSize(), copy_buffer,
+                                      checksum, output_file));
+    section_checksums.push_back(checksum.checksum());
     std::streampos end_byte_offset = output_file.tellp();  // capture end
     section_offsets.push_back(
         std::make_pair(static_cast<uint64_t>(start_byte_offset),
                        static_cast<uint64_t>(end_byte_offset)));
     RETURN_IF_ERROR(sections[i]->Finalize());
-    RETURN_IF_ERROR(PadUntilNextPageBlock(output_file, kBlockSize));
+    RETURN_IF_ERROR(PadUntilNextPageBlock(output_file, section_alignment));
   }
 
   // ** 3. Write the header. **
@@ -154,7 +208,8 @@ absl::Status MakeLiteRTLMFromSections(
 
   RETURN_IF_ERROR(WriteHeader(builder, output_file, system_metadata_map,
                               section_items_maps, section_offsets,
-                              section_types));
+                              section_types, checksum_type,
+                              section_checksums));
   std::streampos header_end_pos = output_file.tellp();
   uint64_t header_end_offset = static_cast<uint64_t>(header_end_pos);
   ABSL_DLOG(INFO) << "Header End Offset is " << header_end_offset;
@@ -1,6 +1,7 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_EXPORT_H_
 #define THIRD_PARTY_ODML_LITERT_LM_SCHEMA_CORE_LITERTLM_EXPORT_H_
 
+#include <cstddef>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -23,6 +24,10 @@ namespace schema {
 using KVPair = ::flatbuffers::Offset<KeyValuePair>;
 using KVPairs = std::vector<KVPair>;
 
+// The default alignment of the sections in a LiteRT-LM file. It is also the
+// size reserved for the header at the beginning of the file.
+constexpr size_t kDefaultSectionAlignment = 16 * 1024;
+
 // Make a LiteRT-LM file from sections.
 //
 // Args:
@@ -32,6 +37,16 @@ using KVPairs = std::vector<KVPair>;
 //   system_metadata_map: a vector of system metadata key value pair.
 //   section_items_maps: a vector of key-value pairs for section metadata.
 //   out_path: output path of the LiteRT-LM file.
+//   section_alignment: the alignment of the beginning of each section. It
+//     must be a power of two. A TF Lite section aligned to the page size (or
+//     to the huge page size, e.g. 2 MB) can be memory-mapped and used in place
+//     without copying its buffers.
+//   checksum_type: the type of the checksum recorded for each section, if
+//     any, computed while the section is copied. It lets the readers detect
+//     truncated or corrupted files before using the sections.
+//
+// The sections are streamed to the output file in fixed-size chunks, so
+// large sections are never held in memory.
 //
 // Returns:
 //   absl::Status.
@@ -41,7 +56,9 @@ absl::Status MakeLiteRTLMFromSections(
     const std::vector<AnySectionDataType>& section_types,
     const std::vector<KVPair>& system_metadata_map,
     const std::vector<std::vector<KVPair>>& section_items_maps,
-    const std::string& out_path);
+    const std::string& out_path,
+    size_t section_alignment = kDefaultSectionAlignment,
+    SectionChecksumType checksum_type = SectionChecksumType_NONE);
 
 }  // end namespace schema
 }  // end namespace lm
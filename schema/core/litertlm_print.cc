@@ -5,6 +5,7 @@
 
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
 #include "schema/core/litertlm_header_schema_generated.h"
 #include "schema/core/litertlm_read.h"
 #include "schema/core/litertlm_utils.h"
@@ -158,6 +159,12 @@ absl::Status ProcessLiteRTLMFile(const std::string& litertlm_file,
       output_stream << "  Data Type:    "
                     << AnySectionDataTypeToString(sec_obj->data_type())
                     << "\n";  // Indent by 2 spaces
+      if (sec_obj->checksum_type() != SectionChecksumType_NONE) {
+        output_stream << "  Checksum:     "
+                      << EnumNameSectionChecksumType(sec_obj->checksum_type())
+                      << " " << absl::StrFormat("%#x", sec_obj->checksum())
+                      << "\n";  // Indent by 2 spaces
+      }
       output_stream
           << "\n";  // Add a newline after each section for better separation
     }
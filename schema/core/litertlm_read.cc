@@ -19,9 +19,14 @@
 #include "absl/status/statusor.h"  // from @com_google_absl
 #include "absl/strings/str_format.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "flatbuffers/verifier.h"  // from @flatbuffers
+#include "runtime/framework/threadpool.h"
 #include "runtime/util/memory_mapped_file.h"
 #include "runtime/util/scoped_file.h"
 #include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_checksum.h"
+#include "schema/core/litertlm_compression.h"
 #include "schema/core/litertlm_header.h"
 #include "schema/core/litertlm_header_schema_generated.h"
 #include "schema/core/litertlm_utils.h"
@@ -108,6 +113,74 @@ absl::Status ReadHeaderFromLiteRTLM(std::istream& litertlm_stream,
   return absl::OkStatus();
 }
 
+absl::Status VerifyLiteRTLMFile(const std::string& litertlm_path,
+                                size_t section_alignment) {
+  std::ifstream input_file_stream(litertlm_path,
+                                  std::ios::binary | std::ios::ate);
+  if (!input_file_stream.is_open()) {
+    return absl::InternalError(
+        absl::StrFormat("Could not open file: %s", litertlm_path));
+  }
+  const uint64_t file_size = input_file_stream.tellg();
+  input_file_stream.seekg(0, std::ios::beg);
+
+  // The header is read from its fixed begin offset to the header end offset.
+  constexpr uint64_t kHeaderBeginByteOffset = 32;
+  LitertlmHeader header;
+  RETURN_IF_ERROR(ReadHeaderFromLiteRTLM(input_file_stream, &header));
+  const uint64_t header_end_offset = input_file_stream.tellg();
+  flatbuffers::Verifier verifier(header.buffer.get(),
+                                 header_end_offset - kHeaderBeginByteOffset);
+  if (!VerifyLiteRTLMMetaDataBuffer(verifier) ||
+      header.metadata->section_metadata() == nullptr ||
+      header.metadata->section_metadata()->objects() == nullptr) {
+    return absl::InvalidArgumentError("The header is not a valid flatbuffer.");
+  }
+
+  uint64_t previous_end_offset = header_end_offset;
+  const auto* sections = header.metadata->section_metadata()->objects();
+  for (int i = 0; i < sections->size(); ++i) {
+    const uint64_t begin_offset = sections->Get(i)->begin_offset();
+    const uint64_t end_offset = sections->Get(i)->end_offset();
+    if (begin_offset > end_offset || end_offset > file_size) {
+      return absl::DataLossError(absl::StrFormat(
+          "Section %d [%d, %d) is out of the file of %d bytes.", i,
+          begin_offset, end_offset, file_size));
+    }
+    if (begin_offset < previous_end_offset) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Section %d begins at %d, before the end of the previous section or "
+          "the header at %d.",
+          i, begin_offset, previous_end_offset));
+    }
+    if (section_alignment > 0 && begin_offset % section_alignment != 0) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Section %d begins at %d, which is not aligned to %d bytes.", i,
+          begin_offset, section_alignment));
+    }
+    previous_end_offset = end_offset;
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<uint64_t> VerifyLiteRTLMChecksums(
+    const std::string& litertlm_path, ThreadPool* thread_pool) {
+  ASSIGN_OR_RETURN(auto mapped_file, MemoryMappedFile::Create(litertlm_path));
+  const absl::string_view file_data(
+      static_cast<const char*>(mapped_file->data()), mapped_file->length());
+  LitertlmHeader header;
+  RETURN_IF_ERROR(ReadHeaderFromLiteRTLM(mapped_file->data(),
+                                         mapped_file->length(), &header));
+  ASSIGN_OR_RETURN(const std::vector<ChecksummedSection> sections,
+                   GetChecksummedSections(*header.metadata, file_data));
+  RETURN_IF_ERROR(VerifySectionChecksums(sections, thread_pool));
+  uint64_t num_bytes = 0;
+  for (const ChecksummedSection& section : sections) {
+    num_bytes += section.data.size();
+  }
+  return num_bytes;
+}
+
 // The public function that takes a file path.
 absl::Status ReadHeaderFromLiteRTLM(const std::string& litertlm_path,
                                     LitertlmHeader* header) {
@@ -371,6 +444,52 @@ absl::Status ReadBinaryDataFromSection(const std::string& litertlm_path,
                                  std::string*)>(ReadSectionIntoBinaryData));
 }
 
+absl::Status ReadDecompressedDataFromSection(const std::string& litertlm_path,
+                                             int section_idx, std::string* data,
+                                             ThreadPool* thread_pool) {
+  LitertlmHeader header;
+  RETURN_IF_ERROR(ReadHeaderFromLiteRTLM(litertlm_path, &header));  // NOLINT
+
+  auto sections = header.metadata->section_metadata()->objects();
+  if (section_idx < 0 || section_idx >= sections->size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid section index: %d, num sections = %d",
+                        section_idx, sections->size()));
+  }
+  const SectionObject* section = sections->Get(section_idx);
+  const SectionCompression compression =
+      GetSectionCompression(section->data_type());
+  if (compression == SectionCompression::kNone) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Section %d is not a compressed section. It is: %s", section_idx,
+        AnySectionDataTypeToString(section->data_type())));
+  }
+
+  std::string payload;
+  RETURN_IF_ERROR(ReadSectionIntoBinaryData(  // NOLINT
+      litertlm_path, section->begin_offset(), section->end_offset(),
+      &payload));
+
+  std::vector<std::string> dictionaries;
+  if (compression == SectionCompression::kZstd) {
+    for (const SectionObject* other_section : *sections) {
+      if (other_section->data_type() == AnySectionDataType_ZstdDictionary) {
+        RETURN_IF_ERROR(ReadSectionIntoBinaryData(  // NOLINT
+            litertlm_path, other_section->begin_offset(),
+            other_section->end_offset(), &dictionaries.emplace_back()));
+      }
+    }
+  }
+  const std::vector<absl::string_view> dictionary_views(dictionaries.begin(),
+                                                        dictionaries.end());
+
+  ASSIGN_OR_RETURN(const uint64_t size,  // NOLINT
+                   GetDecompressedSize(payload));
+  data->resize(size);
+  return DecompressSection(payload, compression, dictionary_views,
+                           thread_pool, absl::MakeSpan(*data));
+}
+
 template <AnySectionDataType SectionT, typename T, typename... Args>
 absl::Status ReadAnyT(
     const std::string& litertlm_path, T* data,
@@ -9,6 +9,8 @@
 #include <utility>
 
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
 #include "runtime/proto/llm_metadata.pb.h"
 #include "runtime/util/memory_mapped_file.h"
 #include "schema/core/litertlm_header_schema_generated.h"
@@ -162,6 +164,22 @@ absl::Status ReadHfTokenizerJsonFromSection(const std::string& litertlm_path,
 absl::Status ReadAnyHfTokenizerJson(const std::string& litertlm_path,
                                     std::string* tokenizer_json);
 
+// Verifies the structure of a LiteRT-LM file without reading its sections:
+// the header must be a valid flatbuffer, and the sections must be within the
+// file, after the header, in order without overlapping, and begin at a
+// multiple of `section_alignment` bytes (0 to skip the alignment check).
+// Returns DataLossError if the file is truncated, and InvalidArgumentError
+// for other violations.
+absl::Status VerifyLiteRTLMFile(const std::string& litertlm_path,
+                                size_t section_alignment);
+
+// Verifies the sections of a LiteRT-LM file which have a checksum against
+// it, reading the memory-mapped file in parallel chunks on `thread_pool` if
+// not null. Returns the number of bytes verified, or DataLossError naming the
+// first corrupted section.
+absl::StatusOr<uint64_t> VerifyLiteRTLMChecksums(
+    const std::string& litertlm_path, ThreadPool* thread_pool = nullptr);
+
 // Read binary data from the specified section in the LiteRT-LM file.
 // Returns InvalidArgumentError if binary data is not found in that section.
 absl::Status ReadBinaryDataFromSection(const std::string& litertlm_path,
@@ -171,6 +189,16 @@ absl::Status ReadBinaryDataFromSection(const std::string& litertlm_path,
 // that only 1 binary data block exists in the LiteRT-LM file).
 absl::Status ReadAnyBinaryData(const std::string& litertlm_path,
                                std::string* data);
+
+// Read and decompress the data of a zstd or LZ4 compressed section (e.g.
+// SP_Tokenizer_Zstd) from the specified section in the LiteRT-LM file. The
+// zstd dictionaries are read from the ZstdDictionary sections of the file.
+// The chunks are decompressed on `thread_pool` if not null. Returns
+// InvalidArgumentError if the section is not a compressed section.
+absl::Status ReadDecompressedDataFromSection(const std::string& litertlm_path,
+                                             int section_idx, std::string* data,
+                                             ThreadPool* thread_pool = nullptr);
+
 }  // end namespace schema
 }  // end namespace lm
 }  // end namespace litert
@@ -42,6 +42,30 @@ absl::StatusOr<std::string> ReadFileToString(const std::string& filename) {
   return content;
 }
 
+TEST(LiteRTLMReadTest, VerifyLiteRTLMFile) {
+  const auto input_filename =
+      std::filesystem::path(::testing::SrcDir()) /
+      "litert_lm/schema/testdata/test_tok_tfl_llm.litertlm";
+  EXPECT_OK(VerifyLiteRTLMFile(input_filename.string(),
+                               /*section_alignment=*/16 * 1024));
+  EXPECT_THAT(VerifyLiteRTLMFile(input_filename.string(),
+                                 /*section_alignment=*/1 << 30),
+              ::testing::status::StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(LiteRTLMReadTest, VerifyTruncatedLiteRTLMFile) {
+  ASSERT_OK_AND_ASSIGN(std::string content,
+                       ReadFileToString("test_tok_tfl_llm.litertlm"));
+  const auto truncated_filename =
+      std::filesystem::path(::testing::TempDir()) / "truncated.litertlm";
+  std::ofstream output_stream(truncated_filename, std::ios::binary);
+  output_stream.write(content.data(), content.size() / 2);
+  output_stream.close();
+  EXPECT_THAT(VerifyLiteRTLMFile(truncated_filename.string(),
+                                 /*section_alignment=*/0),
+              ::testing::status::StatusIs(absl::StatusCode::kDataLoss));
+}
+
 TEST(LiteRTLMReadTest, HeaderReadFile) {
   const auto input_filename =
       std::filesystem::path(::testing::SrcDir()) /
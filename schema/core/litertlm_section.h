@@ -18,6 +18,7 @@
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/strings/str_cat.h"  // from @com_google_absl
 #include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_compression.h"
 #include "zconf.h"  // from @zlib
 
 namespace litert {
@@ -79,53 +80,42 @@ class SectionStreamBase {
   virtual size_t BufferSize() const = 0;
 };
 
-// A basic derived class for a file-backed stream. Reads the provided file
-// during the Prepare(), holds it in an internal buffer, and then provides
-// an input string stream for the caller to stream its contents.
+// A basic derived class for a file-backed stream. Opens the provided file
+// during the Prepare() and streams its contents directly from the file, so
+// that large files (e.g. multi-gigabyte TF Lite models) are never held in
+// memory.
 class FileBackedSectionStream : public SectionStreamBase {
  public:
   // Constructor: Takes the file path.
   explicit FileBackedSectionStream(const std::string& file_path)
-      : file_path_(file_path), buffer_(nullptr), buffer_size_(0) {}
+      : file_path_(file_path), buffer_size_(0) {}
 
   ~FileBackedSectionStream() override = default;
 
-  // Prepare: Reads the file and prepares the internal buffer.  This function
-  // *must* be called before using the stream.
+  // Prepare: Opens the file and gets its size.  This function *must* be
+  // called before using the stream.
   absl::Status Prepare() override {
-    if (buffer_) {
-      ABSL_LOG(INFO) << "Buffer already prepared for file: " << file_path_;
+    if (is_ready_) {
+      ABSL_LOG(INFO) << "Stream already prepared for file: " << file_path_;
       return absl::OkStatus();
     }
 
-    // Clear the stringstream before use.
-    stream_.str(std::string());
-    stream_.clear();
-
-    std::ifstream file(file_path_, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
+    file_.open(file_path_, std::ios::binary | std::ios::ate);
+    if (!file_.is_open()) {
       return absl::InternalError(
           absl::StrCat("Failed to open file: ", file_path_));
     }
 
-    buffer_size_ = static_cast<size_t>(file.tellg());  // Use size_t
-    file.seekg(0, std::ios::beg);
-    ABSL_DLOG(INFO) << "File size: " << buffer_size_ << " bytes.";
-
-    buffer_.reset(new unsigned char[buffer_size_]);
-    if (!file.read(reinterpret_cast<char*>(buffer_.get()), buffer_size_)) {
-      buffer_.reset();  // Clean up on error. Set to null
+    buffer_size_ = static_cast<size_t>(file_.tellg());  // Use size_t
+    file_.seekg(0, std::ios::beg);
+    if (!file_.good()) {
+      file_.close();
       return absl::InternalError(
-          absl::StrCat("Failed to read all data from file: ", file_path_));
+          absl::StrCat("Failed to read the size of file: ", file_path_));
     }
-    ABSL_DLOG(INFO) << "Successfully read " << buffer_size_
-                    << " bytes from file.";
+    ABSL_DLOG(INFO) << "File size: " << buffer_size_ << " bytes.";
 
-    file.close();
     is_ready_ = true;
-    stream_.write(reinterpret_cast<char*>(buffer_.get()), buffer_size_);
-    stream_.seekg(0);
-    ABSL_DLOG(INFO) << "Internal stringstream prepared.";
     return absl::OkStatus();
   }
 
@@ -134,7 +124,7 @@ class FileBackedSectionStream : public SectionStreamBase {
     if (!is_ready_) {
       ABSL_LOG(ERROR) << "Attempting to get stream before preparation.";
     }
-    return stream_;
+    return file_;
   }
 
   bool IsReady() const override { return is_ready_; }
@@ -142,14 +132,12 @@ class FileBackedSectionStream : public SectionStreamBase {
   size_t BufferSize() const override { return buffer_size_; }
 
   absl::Status Finalize() override {
-    if (buffer_) {
-      buffer_.reset();  // Release the memory
+    if (is_ready_) {
+      file_.close();
+      file_.clear();  // Clear any error flags
       buffer_size_ = 0;
       is_ready_ = false;
-      stream_.str(std::string());  // Clear the stringstream
-      stream_.clear();             // Clear any error flags
-      ABSL_LOG(INFO) << "Buffer finalized and stream reset for file: "
-                     << file_path_;
+      ABSL_LOG(INFO) << "Stream finalized for file: " << file_path_;
     } else {
       ABSL_LOG(INFO) << "Nothing to finalize. Either Prepare() was not called "
                      << "or Finalize() has already been called.";
@@ -159,10 +147,9 @@ class FileBackedSectionStream : public SectionStreamBase {
 
  private:
   std::string file_path_;
-  std::unique_ptr<unsigned char[]> buffer_;
   size_t buffer_size_;
   bool is_ready_ = false;  // Track preparation state
-  std::stringstream stream_;
+  std::ifstream file_;
 };
 
 // Class template for a stream backed by a protocol buffer.
@@ -198,9 +185,8 @@ class ProtoBufSectionStream : public SectionStreamBase {
     if (!proto_.SerializeToOstream(&stream_)) {
       return absl::InternalError("Failed to serialize protocol buffer.");
     }
-    serialized_size_ =
-        stream_.str()
-            .size();  // Get the size from the stringstream's underlying string.
+    // Get the size without copying the stringstream's underlying string.
+    serialized_size_ = proto_.ByteSizeLong();
     is_ready_ = true;
     ABSL_LOG(INFO)
         << "Protocol buffer serialized directly to stringstream, size: "
@@ -330,6 +316,77 @@ class ZlibBackendedSectionStream : public SectionStreamBase {
   bool is_ready_ = false;
 };
 
+// A stream compressing the contents of a base stream in independent chunks
+// with zstd or LZ4 (see CompressSection), so that the loader can decompress
+// them in parallel. The base stream is read one chunk at a time.
+class CompressedSectionStream : public SectionStreamBase {
+ public:
+  // - compression: The codec, kZstd or kLz4.
+  // - level: The codec specific compression level, 0 for the default.
+  // - zstd_dictionary: An optional zstd dictionary, which must also be stored
+  //   in a ZstdDictionary section of the file.
+  CompressedSectionStream(std::unique_ptr<SectionStreamBase> base_stream,
+                          SectionCompression compression, int level = 0,
+                          std::string zstd_dictionary = "",
+                          size_t chunk_size = kDefaultCompressionChunkSize)
+      : base_stream_(std::move(base_stream)),
+        compression_(compression),
+        level_(level),
+        zstd_dictionary_(std::move(zstd_dictionary)),
+        chunk_size_(chunk_size) {}
+
+  absl::Status Prepare() override {
+    if (is_ready_) {
+      ABSL_LOG(INFO) << "Stream already prepared.";
+      return absl::OkStatus();
+    }
+
+    RETURN_IF_ERROR(base_stream_->Prepare());  // NOLINT
+    compressed_stream_.str(std::string());
+    compressed_stream_.clear();
+    RETURN_IF_ERROR(CompressSection(  // NOLINT
+        base_stream_->GetStream(), base_stream_->BufferSize(), compression_,
+        level_, zstd_dictionary_, chunk_size_, compressed_stream_));
+    compressed_size_ = compressed_stream_.tellp();
+    ABSL_LOG(INFO) << "Compressed " << base_stream_->BufferSize()
+                   << " bytes to " << compressed_size_ << " bytes.";
+    RETURN_IF_ERROR(base_stream_->Finalize());  // NOLINT
+
+    is_ready_ = true;
+    return absl::OkStatus();
+  }
+
+  std::istream& GetStream() override {
+    if (!is_ready_) {
+      ABSL_LOG(ERROR) << "Attempting to get stream before preparation.";
+    }
+    return compressed_stream_;
+  }
+
+  bool IsReady() const override { return is_ready_; }
+
+  absl::Status Finalize() override {
+    compressed_stream_.str(std::string());
+    compressed_stream_.clear();
+    compressed_size_ = 0;
+    is_ready_ = false;
+    ABSL_LOG(INFO) << "Compressed section stream finalized.";
+    return absl::OkStatus();
+  }
+
+  size_t BufferSize() const override { return compressed_size_; }
+
+ private:
+  std::unique_ptr<SectionStreamBase> base_stream_;
+  const SectionCompression compression_;
+  const int level_;
+  const std::string zstd_dictionary_;
+  const size_t chunk_size_;
+  std::stringstream compressed_stream_;
+  size_t compressed_size_ = 0;
+  bool is_ready_ = false;
+};
+
 }  // end namespace schema
 }  // end namespace lm
 }  // end namespace litert
@@ -5,13 +5,16 @@
 #include <filesystem>  // NOLINT: Required for path manipulation.
 #include <fstream>
 #include <ios>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
 #include "runtime/proto/llm_metadata.pb.h"
+#include "schema/core/litertlm_compression.h"
 
 namespace litert::lm::schema {
 namespace {
@@ -137,5 +140,33 @@ TEST(LiteRTLMSectionTest, TestProtoSectionStream) {
   }
 }
 
+TEST(LiteRTLMSectionTest, TestCompressedSectionStream) {
+  const auto file_path =
+      std::filesystem::path(::testing::SrcDir()) /
+      "litert_lm/schema/testdata/attention.tflite";
+  std::ifstream original_file(file_path, std::ios::binary);
+  ASSERT_TRUE(original_file.is_open());
+  std::stringstream original;
+  original << original_file.rdbuf();
+
+  CompressedSectionStream css(
+      std::make_unique<FileBackedSectionStream>(file_path.string()),
+      SectionCompression::kZstd, /*level=*/3, /*zstd_dictionary=*/"",
+      /*chunk_size=*/4096);
+  ASSERT_TRUE(css.Prepare().ok());
+  std::stringstream compressed;
+  compressed << css.GetStream().rdbuf();
+  EXPECT_EQ(compressed.str().size(), css.BufferSize());
+  EXPECT_LT(css.BufferSize(), original.str().size());
+
+  std::string decompressed(original.str().size(), '\0');
+  ASSERT_TRUE(DecompressSection(compressed.str(), SectionCompression::kZstd,
+                                {}, /*thread_pool=*/nullptr,
+                                absl::MakeSpan(decompressed))
+                  .ok());
+  EXPECT_EQ(decompressed, original.str());
+  EXPECT_TRUE(css.Finalize().ok());
+}
+
 }  // namespace
 }  // namespace litert::lm::schema
@@ -24,6 +24,18 @@ std::string AnySectionDataTypeToString(AnySectionDataType value) {
       return "AnySectionDataType_GenericBinaryData";
     case AnySectionDataType_HF_Tokenizer_Zlib:
       return "AnySectionDataType_HF_Tokenizer_Zlib";
+    case AnySectionDataType_SP_Tokenizer_Zstd:
+      return "AnySectionDataType_SP_Tokenizer_Zstd";
+    case AnySectionDataType_HF_Tokenizer_Zstd:
+      return "AnySectionDataType_HF_Tokenizer_Zstd";
+    case AnySectionDataType_LlmMetadataProto_Zstd:
+      return "AnySectionDataType_LlmMetadataProto_Zstd";
+    case AnySectionDataType_GenericBinaryData_Zstd:
+      return "AnySectionDataType_GenericBinaryData_Zstd";
+    case AnySectionDataType_GenericBinaryData_Lz4:
+      return "AnySectionDataType_GenericBinaryData_Lz4";
+    case AnySectionDataType_ZstdDictionary:
+      return "AnySectionDataType_ZstdDictionary";
     default:
       // Handle cases for MIN/MAX or potentially invalid values.
       return "Unknown AnySectionDataType value";
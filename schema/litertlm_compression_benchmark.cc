@@ -0,0 +1,160 @@
+// This tool measures the size and the load-time (decompression) cost of a
+// section compressed with the zlib path used by HF_Tokenizer_Zlib, and with
+// the chunked zstd and LZ4 codecs of the compressed section data types.
+//
+// Example usage:
+// bazel run -c opt :litertlm_compression_benchmark -- \
+//   --input=/path/to/tokenizer.json --num_threads=4
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include "absl/flags/flag.h"  // from @com_google_absl
+#include "absl/flags/parse.h"  // from @com_google_absl
+#include "absl/log/absl_check.h"  // from @com_google_absl
+#include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_cat.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/strings/string_view.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "absl/types/span.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_compression.h"
+#include "schema/core/litertlm_section.h"
+#include "zconf.h"  // from @zlib
+
+ABSL_FLAG(std::string, input, "", "The file to compress.");
+
+ABSL_FLAG(int, iterations, 10, "The number of decompressions to average.");
+
+ABSL_FLAG(int, num_threads, 4,
+          "The number of threads decompressing the zstd and LZ4 chunks, 0 to "
+          "decompress them on the calling thread.");
+
+ABSL_FLAG(int, zstd_level, 0, "The zstd compression level, 0 for default.");
+
+ABSL_FLAG(int, lz4_level, 0,
+          "The LZ4 compression level, 0 for the default compressor and a "
+          "positive level for the high compression compressor.");
+
+namespace {
+
+using ::litert::lm::ThreadPool;
+using ::litert::lm::schema::CompressedSectionStream;
+using ::litert::lm::schema::FileBackedSectionStream;
+using ::litert::lm::schema::SectionCompression;
+using ::litert::lm::schema::SectionStreamBase;
+using ::litert::lm::schema::ZlibBackendedSectionStream;
+
+absl::StatusOr<std::string> ReadAll(SectionStreamBase& stream) {
+  RETURN_IF_ERROR(stream.Prepare());  // NOLINT
+  std::string data(stream.BufferSize(), '\0');
+  stream.GetStream().read(data.data(), data.size());
+  if (!stream.GetStream()) {
+    return absl::InternalError("Failed to read the section stream.");
+  }
+  RETURN_IF_ERROR(stream.Finalize());  // NOLINT
+  return data;
+}
+
+// Decompresses a payload of ZlibBackendedSectionStream, as the HF tokenizer
+// reader does.
+absl::Status ZlibDecompress(absl::string_view payload, std::string& output) {
+  uint64_t size;
+  std::memcpy(&size, payload.data(), sizeof(size));
+  output.resize(size);
+  uLongf output_size = size;
+  if (uncompress(reinterpret_cast<Bytef*>(output.data()), &output_size,
+                 reinterpret_cast<const Bytef*>(payload.data()) + sizeof(size),
+                 payload.size() - sizeof(size)) != Z_OK) {
+    return absl::DataLossError("Zlib decompression failed.");
+  }
+  return absl::OkStatus();
+}
+
+void PrintResult(absl::string_view name, size_t uncompressed_size,
+                 size_t compressed_size, absl::Duration decompression_time) {
+  const double seconds = absl::ToDoubleSeconds(decompression_time);
+  std::cout << absl::StrFormat(
+      "%-6s %12d bytes (%5.1f%%)  %9.3f ms  %8.1f MB/s\n", name,
+      compressed_size, 100.0 * compressed_size / uncompressed_size,
+      seconds * 1000, uncompressed_size / seconds / 1e6);
+}
+
+absl::Status MainHelper(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const std::string input = absl::GetFlag(FLAGS_input);
+  const int iterations = absl::GetFlag(FLAGS_iterations);
+  if (input.empty() || iterations <= 0) {
+    return absl::InvalidArgumentError(
+        "--input and a positive --iterations must be provided.");
+  }
+
+  FileBackedSectionStream input_stream(input);
+  ASSIGN_OR_RETURN(const std::string data, ReadAll(input_stream));  // NOLINT
+  std::cout << absl::StrFormat("%-6s %12d bytes\n", "input", data.size());
+
+  std::string output;
+  {
+    ZlibBackendedSectionStream zlib_stream(
+        std::make_unique<FileBackedSectionStream>(input));
+    ASSIGN_OR_RETURN(const std::string payload,  // NOLINT
+                     ReadAll(zlib_stream));
+    const absl::Time start = absl::Now();
+    for (int i = 0; i < iterations; ++i) {
+      RETURN_IF_ERROR(ZlibDecompress(payload, output));  // NOLINT
+    }
+    PrintResult("zlib", data.size(), payload.size(),
+                (absl::Now() - start) / iterations);
+    if (output != data) return absl::InternalError("Zlib round trip failed.");
+  }
+
+  std::unique_ptr<ThreadPool> thread_pool;
+  if (absl::GetFlag(FLAGS_num_threads) > 0) {
+    thread_pool = std::make_unique<ThreadPool>(
+        "decompression", absl::GetFlag(FLAGS_num_threads));
+  }
+  for (const auto& [name, compression, level] :
+       {std::make_tuple("zstd", SectionCompression::kZstd,
+                        absl::GetFlag(FLAGS_zstd_level)),
+        std::make_tuple("lz4", SectionCompression::kLz4,
+                        absl::GetFlag(FLAGS_lz4_level))}) {
+    CompressedSectionStream compressed_stream(
+        std::make_unique<FileBackedSectionStream>(input), compression, level);
+    ASSIGN_OR_RETURN(const std::string payload,  // NOLINT
+                     ReadAll(compressed_stream));
+    const absl::Time start = absl::Now();
+    for (int i = 0; i < iterations; ++i) {
+      // The output is sized from the payload header, as the loader does.
+      ASSIGN_OR_RETURN(const uint64_t size,  // NOLINT
+                       litert::lm::schema::GetDecompressedSize(payload));
+      output.resize(size);
+      RETURN_IF_ERROR(litert::lm::schema::DecompressSection(  // NOLINT
+          payload, compression, {}, thread_pool.get(),
+          absl::MakeSpan(output)));
+    }
+    PrintResult(name, data.size(), payload.size(),
+                (absl::Now() - start) / iterations);
+    if (output != data) {
+      return absl::InternalError(absl::StrCat(name, " round trip failed."));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ABSL_CHECK_OK(MainHelper(argc, argv));
+  return 0;
+}
@@ -37,6 +37,7 @@
 #include "absl/strings/str_split.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "runtime/proto/llm_metadata.pb.h"
+#include "schema/core/litertlm_checksum.h"
 #include "schema/core/litertlm_export.h"
 #include "schema/core/litertlm_header.h"
 #include "schema/core/litertlm_header_schema_generated.h"
@@ -69,6 +70,14 @@ ABSL_FLAG(std::string, llm_metadata_text, "",
 ABSL_FLAG(std::string, output_path, "",
           "The path for the output LiteRT-LM file.");
 
+ABSL_FLAG(uint64_t, section_alignment,
+          ::litert::lm::schema::kDefaultSectionAlignment,
+          "The alignment of the sections in bytes, e.g. 65536 for 64 KB pages "
+          "or 2097152 for 2 MB huge pages. Must be a power of two.");
+
+ABSL_FLAG(std::string, checksum, "crc32c",
+          "The checksum recorded for each section: none or crc32c.");
+
 // Flag to handle key-value pairs.  Example usage:
 // --section_metadata="tokenizer:key1=value1,key2=value2;tflite:key3=123,key4=true"
 // TODO(b/416130396): Get rid of this method of metadata creation.
@@ -92,6 +101,7 @@ using ::litert::lm::schema::CreateStringValue;
 using ::litert::lm::schema::FileBackedSectionStream;
 using ::litert::lm::schema::KVPair;
 using ::litert::lm::schema::MakeLiteRTLMFromSections;
+using ::litert::lm::schema::ParseSectionChecksumType;
 using ::litert::lm::schema::ProtoBufSectionStream;
 using ::litert::lm::schema::SectionStreamBase;
 using ::litert::lm::schema::ZlibBackendedSectionStream;
@@ -329,9 +339,16 @@ absl::Status MainHelper(int argc, char** argv) {
                          CreateStringValue(builder, builder.CreateString(
                                                         std::string("0.1"))))};
 
+  auto checksum_type =
+      ParseSectionChecksumType(absl::GetFlag(FLAGS_checksum));
+  if (!checksum_type.ok()) {
+    return checksum_type.status();
+  }
   absl::Status result =
       MakeLiteRTLMFromSections(builder, sections, section_types, system_meta,
-                               section_items_list, output_path);
+                               section_items_list, output_path,
+                               absl::GetFlag(FLAGS_section_alignment),
+                               *checksum_type);
 
   return result;
 }
@@ -4,8 +4,14 @@
 //
 // Example usage:
 // bazel run :litertlm_peek -- --litertlm_file=/path/to/your/file.litertlm
+//
+// Add --verify to check the structure of the file (and --section_alignment to
+// check the alignment of the sections), and the checksums of the sections
+// which have one, hashed by --num_threads threads.
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "absl/flags/flag.h"  // from @com_google_absl
@@ -13,14 +19,35 @@
 #include "absl/log/absl_check.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
+#include "absl/strings/str_format.h"  // from @com_google_absl
+#include "absl/time/clock.h"  // from @com_google_absl
+#include "absl/time/time.h"  // from @com_google_absl
+#include "runtime/framework/threadpool.h"
 #include "schema/core/litertlm_print.h"
+#include "schema/core/litertlm_read.h"
 
 ABSL_FLAG(std::string, litertlm_file, "",
           "The path to the LiteRT-LM file to inspect.");
 
+ABSL_FLAG(bool, verify, false,
+          "Whether to verify the structure of the file, e.g. that the sections "
+          "are within the file and aligned to --section_alignment.");
+
+ABSL_FLAG(uint64_t, section_alignment, 16 * 1024,
+          "The expected alignment of the sections in bytes, checked with "
+          "--verify.");
+
+ABSL_FLAG(int, num_threads, 4,
+          "The number of threads verifying the checksums with --verify, 0 to "
+          "verify them on the calling thread.");
+
 namespace {
 
+using litert::lm::ThreadPool;
 using litert::lm::schema::ProcessLiteRTLMFile;
+using litert::lm::schema::VerifyLiteRTLMChecksums;
+using litert::lm::schema::VerifyLiteRTLMFile;
 
 absl::Status MainHelper(int argc, char** argv) {
   absl::ParseCommandLine(argc, argv);
@@ -32,6 +59,32 @@ absl::Status MainHelper(int argc, char** argv) {
     return absl::InvalidArgumentError("--litertlm_file must be provided.");
   }
 
+  if (absl::GetFlag(FLAGS_verify)) {
+    absl::Status status = VerifyLiteRTLMFile(
+        litertlm_file, absl::GetFlag(FLAGS_section_alignment));
+    if (!status.ok()) {
+      std::cout << "Verification failed: " << status << "\n";
+      return status;
+    }
+    std::unique_ptr<ThreadPool> thread_pool;
+    if (absl::GetFlag(FLAGS_num_threads) > 0) {
+      thread_pool = std::make_unique<ThreadPool>(
+          "litertlm_verify", absl::GetFlag(FLAGS_num_threads));
+    }
+    const absl::Time start = absl::Now();
+    absl::StatusOr<uint64_t> num_bytes =
+        VerifyLiteRTLMChecksums(litertlm_file, thread_pool.get());
+    if (!num_bytes.ok()) {
+      std::cout << "Verification failed: " << num_bytes.status() << "\n";
+      return num_bytes.status();
+    }
+    const double seconds = absl::ToDoubleSeconds(absl::Now() - start);
+    std::cout << absl::StrFormat(
+        "Verification passed. Checksums of %d bytes verified in %.3f s "
+        "(%.1f MB/s).\n\n",
+        *num_bytes, seconds, seconds > 0 ? *num_bytes / seconds / 1e6 : 0.0);
+  }
+
   // Use std::cout as the output stream.
   return ProcessLiteRTLMFile(litertlm_file, std::cout);
 }
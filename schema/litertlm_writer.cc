@@ -10,6 +10,7 @@
 //   /path/to/model.tflite \
 //   /path/to/llm_metadata.pbtext \ (or binary proto via .pb or .proto)
 //   /path/to/model2.tflite \
+//   --compression=zstd /path/to/trained.zdict \ (optional)
 //   --section_metadata="tokenizer:key1=value1,key2=value2;\
 //     tflite:key3=123,key4=true;llm_metadata:key5=abc;tflite:z=9.8"
 
@@ -26,11 +27,36 @@
 #include "absl/status/status.h"  // from @com_google_absl
 #include "absl/strings/string_view.h"  // from @com_google_absl
 #include "runtime/proto/llm_metadata.pb.h"
+#include "runtime/util/status_macros.h"  // NOLINT
+#include "schema/core/litertlm_checksum.h"
+#include "schema/core/litertlm_compression.h"
+#include "schema/core/litertlm_export.h"
 #include "schema/litertlm_writer_utils.h"
 
 ABSL_FLAG(std::string, output_path, "",
           "The path for the output LiteRT-LM file.");
 
+ABSL_FLAG(uint64_t, section_alignment,
+          ::litert::lm::schema::kDefaultSectionAlignment,
+          "The alignment of the sections in bytes, e.g. 65536 for 64 KB pages "
+          "or 2097152 for 2 MB huge pages. Must be a power of two.");
+
+ABSL_FLAG(std::string, compression, "none",
+          "The compression of the sections: none, zstd or lz4. With zstd, the "
+          "tokenizers, the LLM metadata and the binary data are compressed, "
+          "with the dictionary given as a .zdict input file if any. With lz4, "
+          "only the binary data is compressed. TF Lite models are never "
+          "compressed.");
+
+ABSL_FLAG(int, compression_level, 0,
+          "The zstd or LZ4 compression level, 0 for the default. A positive "
+          "LZ4 level selects the high compression LZ4 compressor.");
+
+ABSL_FLAG(std::string, checksum, "crc32c",
+          "The checksum recorded for each section, so that truncated or "
+          "corrupted files are detected (e.g. by litertlm_peek --verify): "
+          "none or crc32c.");
+
 // Flag to handle key-value pairs. Example usage:
 // --section_metadata="tokenizer:key1=value1,key2=value2;tflite:key3=123,key4=true"
 ABSL_FLAG(std::string, section_metadata, "",
@@ -93,8 +119,16 @@ absl::Status MainHelper(int argc, char** argv) {
     ABSL_LOG(INFO) << ca;
   }
 
-  return ::litert::lm::schema::LitertLmWrite(command_args, section_metadata_str,
-                                             output_path);
+  ASSIGN_OR_RETURN(  // NOLINT
+      const auto compression, ::litert::lm::schema::ParseSectionCompression(
+                                  absl::GetFlag(FLAGS_compression)));
+  ASSIGN_OR_RETURN(  // NOLINT
+      const auto checksum_type, ::litert::lm::schema::ParseSectionChecksumType(
+                                    absl::GetFlag(FLAGS_checksum)));
+  return ::litert::lm::schema::LitertLmWrite(
+      command_args, section_metadata_str, output_path,
+      absl::GetFlag(FLAGS_section_alignment), compression,
+      absl::GetFlag(FLAGS_compression_level), checksum_type);
 }
 
 }  // namespace
@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>  // NOLINT: Required for path manipulation.
 #include <fstream>
@@ -9,8 +10,12 @@
 #include <gmock/gmock.h>  // For matchers like HasSubstr
 #include <gtest/gtest.h>
 #include "absl/status/status.h"  // from @com_google_absl
+#include "absl/status/statusor.h"  // from @com_google_absl
 #include "runtime/proto/llm_metadata.pb.h"  // For LlmMetadata
+#include "schema/core/litertlm_compression.h"
+#include "schema/core/litertlm_header_schema_generated.h"
 #include "schema/core/litertlm_print.h"
+#include "schema/core/litertlm_read.h"
 #include "schema/litertlm_writer_utils.h"
 #include "google/protobuf/text_format.h"  // from @com_google_protobuf  // For TextFormat::PrintToString
 
@@ -411,6 +416,131 @@ TEST_F(LiteRTLMWriteTest, MetadataCountMismatchTest) {
   EXPECT_THAT(result.message(), testing::HasSubstr("section_metadata (2)"));
 }
 
+// Test case: Sections aligned to a large page size.
+TEST_F(LiteRTLMWriteTest, SectionAlignmentTest) {
+  const std::string tokenizer_path = temp_dir_path_ + "/tokenizer.spiece";
+  const std::string tflite_model_path = temp_dir_path_ + "/model.tflite";
+  const std::string output_litertlm_path =
+      temp_dir_path_ + "/output_aligned.litertlm";
+
+  CreateDummyFile(tokenizer_path, "Tokenizer data");
+  CreateDummyFile(tflite_model_path, "TFLite data");
+
+  const std::vector<std::string> command_args = {tokenizer_path,
+                                                 tflite_model_path};
+  constexpr size_t kSectionAlignment = 64 * 1024;
+  const absl::Status result =
+      LitertLmWrite(command_args, /*section_metadata_str=*/"",
+                    output_litertlm_path, kSectionAlignment);
+  ASSERT_TRUE(result.ok()) << "LitertLmWrite failed: " << result.message();
+
+  const absl::Status verify_result =
+      VerifyLiteRTLMFile(output_litertlm_path, kSectionAlignment);
+  EXPECT_TRUE(verify_result.ok()) << verify_result.message();
+  // The second section begins at the second aligned offset.
+  EXPECT_EQ(std::filesystem::file_size(output_litertlm_path),
+            3 * kSectionAlignment);
+
+  EXPECT_FALSE(LitertLmWrite(command_args, /*section_metadata_str=*/"",
+                             output_litertlm_path,
+                             /*section_alignment=*/3 * 1024)
+                   .ok());
+}
+
+TEST_F(LiteRTLMWriteTest, CompressedSectionsTest) {
+  const std::string tokenizer_path = temp_dir_path_ + "/tokenizer.spiece";
+  const std::string tflite_model_path = temp_dir_path_ + "/model.tflite";
+  const std::string binary_data_path = temp_dir_path_ + "/vocab.bin";
+  const std::string output_litertlm_path =
+      temp_dir_path_ + "/output_compressed.litertlm";
+
+  const std::string binary_data(100000, 'v');
+  CreateDummyFile(tokenizer_path, "Tokenizer data");
+  CreateDummyFile(tflite_model_path, "TFLite data");
+  CreateDummyFile(binary_data_path, binary_data);
+
+  const std::vector<std::string> command_args = {
+      tokenizer_path, tflite_model_path, binary_data_path};
+  for (const auto compression :
+       {SectionCompression::kZstd, SectionCompression::kLz4}) {
+    const absl::Status result = LitertLmWrite(
+        command_args, /*section_metadata_str=*/"", output_litertlm_path,
+        kDefaultSectionAlignment, compression);
+    ASSERT_TRUE(result.ok()) << "LitertLmWrite failed: " << result.message();
+
+    LitertlmHeader header;
+    ASSERT_TRUE(ReadHeaderFromLiteRTLM(output_litertlm_path, &header).ok());
+    const auto* sections = header.metadata->section_metadata()->objects();
+    ASSERT_EQ(sections->size(), 3);
+    // LZ4 is only used for the binary data, and TF Lite models are never
+    // compressed.
+    EXPECT_EQ(sections->Get(0)->data_type(),
+              compression == SectionCompression::kZstd
+                  ? AnySectionDataType_SP_Tokenizer_Zstd
+                  : AnySectionDataType_SP_Tokenizer);
+    EXPECT_EQ(sections->Get(1)->data_type(), AnySectionDataType_TFLiteModel);
+    EXPECT_EQ(sections->Get(2)->data_type(),
+              compression == SectionCompression::kZstd
+                  ? AnySectionDataType_GenericBinaryData_Zstd
+                  : AnySectionDataType_GenericBinaryData_Lz4);
+    EXPECT_LT(sections->Get(2)->end_offset() - sections->Get(2)->begin_offset(),
+              binary_data.size());
+
+    std::string data;
+    ASSERT_TRUE(
+        ReadDecompressedDataFromSection(output_litertlm_path, 2, &data).ok());
+    EXPECT_EQ(data, binary_data);
+    EXPECT_FALSE(
+        ReadDecompressedDataFromSection(output_litertlm_path, 1, &data).ok());
+  }
+}
+
+TEST_F(LiteRTLMWriteTest, ChecksumsTest) {
+  const std::string tokenizer_path = temp_dir_path_ + "/tokenizer.spiece";
+  const std::string tflite_model_path = temp_dir_path_ + "/model.tflite";
+  const std::string output_litertlm_path =
+      temp_dir_path_ + "/output_checksums.litertlm";
+
+  CreateDummyFile(tokenizer_path, "Tokenizer data");
+  CreateDummyFile(tflite_model_path, "TFLite data");
+
+  const std::vector<std::string> command_args = {tokenizer_path,
+                                                 tflite_model_path};
+  const absl::Status result = LitertLmWrite(
+      command_args, /*section_metadata_str=*/"", output_litertlm_path,
+      kDefaultSectionAlignment, SectionCompression::kNone,
+      /*compression_level=*/0, SectionChecksumType_CRC32C);
+  ASSERT_TRUE(result.ok()) << "LitertLmWrite failed: " << result.message();
+
+  LitertlmHeader header;
+  ASSERT_TRUE(ReadHeaderFromLiteRTLM(output_litertlm_path, &header).ok());
+  const auto* sections = header.metadata->section_metadata()->objects();
+  ASSERT_EQ(sections->size(), 2);
+  for (const auto* section : *sections) {
+    EXPECT_EQ(section->checksum_type(), SectionChecksumType_CRC32C);
+  }
+  EXPECT_NE(sections->Get(0)->checksum(), sections->Get(1)->checksum());
+
+  const absl::StatusOr<uint64_t> verified_size =
+      VerifyLiteRTLMChecksums(output_litertlm_path);
+  ASSERT_TRUE(verified_size.ok()) << verified_size.status().message();
+  EXPECT_EQ(*verified_size, std::string("Tokenizer data").size() +
+                                std::string("TFLite data").size());
+
+  // Corrupts the first byte of the TF Lite model.
+  {
+    std::fstream file(output_litertlm_path,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(sections->Get(1)->begin_offset());
+    file << 'X';
+  }
+  const absl::StatusOr<uint64_t> corrupted =
+      VerifyLiteRTLMChecksums(output_litertlm_path);
+  EXPECT_EQ(corrupted.status().code(), absl::StatusCode::kDataLoss);
+  EXPECT_THAT(corrupted.status().message(),
+              testing::HasSubstr("Section 1 is corrupted"));
+}
+
 }  // namespace
 }  // namespace schema
 }  // namespace lm
@@ -34,6 +34,8 @@ constexpr char kTfliteSectionName[] = "tflite";
 constexpr char kLlmMetadataSectionName[] = "llm_metadata";
 constexpr char kBinaryDataSectionName[] = "binary_data";
 constexpr char kHfTokenizerZlibSectionName[] = "hf_tokenizer_zlib";
+constexpr char kHfTokenizerZstdSectionName[] = "hf_tokenizer_zstd";
+constexpr char kZstdDictionarySectionName[] = "zstd_dictionary";
 
 using ::litert::lm::proto::LlmMetadata;
 
@@ -91,7 +93,11 @@ std::string GetFileExtension(const std::string& filename) {
 
 absl::Status LitertLmWrite(const std::vector<std::string>& command_args,
                            const std::string& section_metadata_str,
-                           const std::string& output_path) {
+                           const std::string& output_path,
+                           size_t section_alignment,
+                           SectionCompression compression,
+                           int compression_level,
+                           SectionChecksumType checksum_type) {
   std::vector<std::unique_ptr<SectionStreamBase>> sections;
   std::vector<AnySectionDataType> section_types;
   // To store the order of section names derived from input filenames.
@@ -102,6 +108,44 @@ absl::Status LitertLmWrite(const std::vector<std::string>& command_args,
         "At least one input file must be provided.");
   }
 
+  // The zstd dictionary is needed to compress the sections which may come
+  // before it.
+  std::string zstd_dictionary;
+  for (const auto& filename : command_args) {
+    if (GetFileExtension(filename) != ".zdict") continue;
+    if (compression != SectionCompression::kZstd || !zstd_dictionary.empty()) {
+      return absl::InvalidArgumentError(
+          "A single .zdict file may be provided, with zstd compression only.");
+    }
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs.is_open()) {
+      return absl::NotFoundError(
+          absl::StrCat("Could not open zstd dictionary file: ", filename));
+    }
+    zstd_dictionary.assign(std::istreambuf_iterator<char>(ifs),
+                           std::istreambuf_iterator<char>());
+  }
+
+  // Adds a section, compressed as `zstd_type` with zstd compression, or as
+  // `lz4_type` with LZ4 compression if not NONE.
+  auto add_section = [&](std::unique_ptr<SectionStreamBase> section,
+                         AnySectionDataType type, AnySectionDataType zstd_type,
+                         AnySectionDataType lz4_type =
+                             AnySectionDataType_NONE) {
+    if (compression == SectionCompression::kZstd) {
+      section = std::make_unique<CompressedSectionStream>(
+          std::move(section), compression, compression_level, zstd_dictionary);
+      type = zstd_type;
+    } else if (compression == SectionCompression::kLz4 &&
+               lz4_type != AnySectionDataType_NONE) {
+      section = std::make_unique<CompressedSectionStream>(
+          std::move(section), compression, compression_level);
+      type = lz4_type;
+    }
+    sections.push_back(std::move(section));
+    section_types.push_back(type);
+  };
+
   for (const auto& filename : command_args) {
     std::string extension = GetFileExtension(filename);
     ABSL_LOG(INFO) << "Processing file: " << filename
@@ -125,9 +169,10 @@ absl::Status LitertLmWrite(const std::vector<std::string>& command_args,
             "Failed to parse LlmMetadata protobuf from binary file: ",
             filename));
       }
-      sections.push_back(std::make_unique<ProtoBufSectionStream<LlmMetadata>>(
-          llm_metadata_proto));
-      section_types.push_back(AnySectionDataType_LlmMetadataProto);
+      add_section(std::make_unique<ProtoBufSectionStream<LlmMetadata>>(
+                      llm_metadata_proto),
+                  AnySectionDataType_LlmMetadataProto,
+                  AnySectionDataType_LlmMetadataProto_Zstd);
       section_name_order.push_back(kLlmMetadataSectionName);
 #if !defined(__ANDROID__) && !defined(OS_IOS)
     } else if (extension == ".pbtext" || extension == ".prototext") {
@@ -144,15 +189,21 @@ absl::Status LitertLmWrite(const std::vector<std::string>& command_args,
         return absl::InvalidArgumentError(absl::StrCat(
             "Failed to parse LlmMetadata protobuf from text file: ", filename));
       }
-      sections.push_back(std::make_unique<ProtoBufSectionStream<LlmMetadata>>(
-          llm_metadata_proto));
-      section_types.push_back(AnySectionDataType_LlmMetadataProto);
+      add_section(std::make_unique<ProtoBufSectionStream<LlmMetadata>>(
+                      llm_metadata_proto),
+                  AnySectionDataType_LlmMetadataProto,
+                  AnySectionDataType_LlmMetadataProto_Zstd);
       section_name_order.push_back(kLlmMetadataSectionName);
 #endif  // !defined(__ANDROID__) && !defined(OS_IOS)
     } else if (extension == ".spiece") {
-      sections.push_back(std::make_unique<FileBackedSectionStream>(filename));
-      section_types.push_back(AnySectionDataType_SP_Tokenizer);
+      add_section(std::make_unique<FileBackedSectionStream>(filename),
+                  AnySectionDataType_SP_Tokenizer,
+                  AnySectionDataType_SP_Tokenizer_Zstd);
       section_name_order.push_back(kTokenizerSectionName);
+    } else if (extension == ".zdict") {
+      sections.push_back(std::make_unique<FileBackedSectionStream>(filename));
+      section_types.push_back(AnySectionDataType_ZstdDictionary);
+      section_name_order.push_back(kZstdDictionarySectionName);
     } else if (extension == ".json") {
       if (!filename.ends_with("tokenizer.json")) {
         return absl::InvalidArgumentError(
@@ -160,16 +211,26 @@ absl::Status LitertLmWrite(const std::vector<std::string>& command_args,
                          ". Only tokenizer.json is supported."));
       }
       auto tokenizer_json = std::make_unique<FileBackedSectionStream>(filename);
-      sections.push_back(std::make_unique<ZlibBackendedSectionStream>(
-          std::move(tokenizer_json)));
-      section_types.push_back(AnySectionDataType_HF_Tokenizer_Zlib);
-      section_name_order.push_back(kHfTokenizerZlibSectionName);
+      if (compression == SectionCompression::kZstd) {
+        sections.push_back(std::make_unique<CompressedSectionStream>(
+            std::move(tokenizer_json), compression, compression_level,
+            zstd_dictionary));
+        section_types.push_back(AnySectionDataType_HF_Tokenizer_Zstd);
+        section_name_order.push_back(kHfTokenizerZstdSectionName);
+      } else {
+        sections.push_back(std::make_unique<ZlibBackendedSectionStream>(
+            std::move(tokenizer_json)));
+        section_types.push_back(AnySectionDataType_HF_Tokenizer_Zlib);
+        section_name_order.push_back(kHfTokenizerZlibSectionName);
+      }
     } else {
       // TODO(b/421217080) Writer should export what happened.
       ABSL_LOG(WARNING) << "Unknown extension for: " << filename
                         << ". Storing as binary data.";
-      sections.push_back(std::make_unique<FileBackedSectionStream>(filename));
-      section_types.push_back(AnySectionDataType_GenericBinaryData);
+      add_section(std::make_unique<FileBackedSectionStream>(filename),
+                  AnySectionDataType_GenericBinaryData,
+                  AnySectionDataType_GenericBinaryData_Zstd,
+                  AnySectionDataType_GenericBinaryData_Lz4);
       section_name_order.push_back(kBinaryDataSectionName);
     }
   }
@@ -263,7 +324,8 @@ absl::Status LitertLmWrite(const std::vector<std::string>& command_args,
           builder, builder.CreateString(std::string("The ODML Authors"))))};
 
   return MakeLiteRTLMFromSections(builder, sections, section_types, system_meta,
-                                  section_items_list, output_path);
+                                  section_items_list, output_path,
+                                  section_alignment, checksum_type);
 }
 
 }  // namespace litert::lm::schema
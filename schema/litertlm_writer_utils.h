@@ -1,5 +1,6 @@
 #ifndef THIRD_PARTY_ODML_LITERT_LM_SCHEMA_LITERTLM_WRITER_UTILS_H_
 #define THIRD_PARTY_ODML_LITERT_LM_SCHEMA_LITERTLM_WRITER_UTILS_H_
+#include <cstddef>
 #include <ios>
 #include <iostream>
 #include <string>
@@ -8,12 +9,34 @@
 #include "absl/log/absl_check.h"  // from @com_google_absl
 #include "absl/log/absl_log.h"  // from @com_google_absl
 #include "absl/status/status.h"  // from @com_google_absl
+#include "schema/core/litertlm_compression.h"
+#include "schema/core/litertlm_export.h"
+#include "schema/core/litertlm_header_schema_generated.h"
 
 namespace litert::lm::schema {
 
+// Writes a LiteRT-LM file from the files in `command_args`, with the sections
+// aligned to `section_alignment` bytes (see MakeLiteRTLMFromSections).
+//
+// With zstd `compression`, the tokenizers, the LlmMetadata and the binary
+// data are stored in zstd compressed sections, compressed with the
+// dictionary given as a `.zdict` file if any (which is stored in a
+// ZstdDictionary section). With LZ4 `compression`, only the binary data is
+// compressed. The TF Lite models are never compressed, so that they can be
+// memory-mapped. `compression_level` is the codec specific level, 0 for the
+// default.
+//
+// Each section gets a `checksum_type` checksum of its (compressed) data, unless
+// it is SectionChecksumType_NONE.
 absl::Status LitertLmWrite(const std::vector<std::string>& command_args,
                            const std::string& section_metadata_str,
-                           const std::string& output_path);
+                           const std::string& output_path,
+                           size_t section_alignment = kDefaultSectionAlignment,
+                           SectionCompression compression =
+                               SectionCompression::kNone,
+                           int compression_level = 0,
+                           SectionChecksumType checksum_type =
+                               SectionChecksumType_NONE);
 
 }  // namespace litert::lm::schema
 #endif  // THIRD_PARTY_ODML_LITERT_LM_SCHEMA_LITERTLM_WRITER_UTILS_HU